@@ -0,0 +1,30 @@
+#include "AlignedArena.h"
+
+//==============================================================================
+void AlignedArena::allocate(size_t numBytes)
+{
+    release();
+
+    if (numBytes == 0)
+        return;
+
+    // HeapBlock only guarantees malloc's alignment, so over-allocate and round up
+    block.calloc(numBytes + alignment - 1);
+    const auto address = reinterpret_cast<std::uintptr_t>(block.get());
+    base = block.get() + ((alignment - address % alignment) % alignment);
+    size = numBytes;
+}
+
+void AlignedArena::release() noexcept
+{
+    block.free();
+    base = nullptr;
+    size = 0;
+    used = 0;
+}
+
+void AlignedArena::rewind(size_t mark) noexcept
+{
+    jassert(mark <= used);
+    used = juce::jmin(mark, used);
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+ * One cache-line-aligned block that a processor's stages take their
+ * audio-thread buffers from, so an instance's working memory sits in a single
+ * allocation instead of one heap block per buffer.
+ *
+ * Arrays are handed out in order, each starting on a new cache line, so no
+ * two buffers share a line. Nothing is freed on its own: rewind() hands out
+ * the memory after a mark again, and allocate() replaces the whole block.
+ */
+class AlignedArena
+{
+public:
+    //==============================================================================
+    static constexpr size_t alignment = 64;
+
+    AlignedArena() = default;
+
+    /** Bytes an array of count Ts takes up in the arena. */
+    template <typename T>
+    static constexpr size_t getBytes(int count) noexcept
+    {
+        const size_t bytes = static_cast<size_t>(count > 0 ? count : 0) * sizeof(T);
+        return (bytes + alignment - 1) & ~(alignment - 1);
+    }
+
+    /** Replaces the block with a zeroed one of numBytes. Not real-time safe;
+        everything taken from the old block becomes invalid. */
+    void allocate(size_t numBytes);
+
+    /** Frees the block. */
+    void release() noexcept;
+
+    /** Takes the next count Ts. The arena must have been allocated large
+        enough; running out is a bug and returns nullptr. */
+    template <typename T>
+    T* take(int count) noexcept
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "Arena memory is never constructed or destroyed");
+        static_assert(alignof(T) <= alignment, "Arrays are only aligned to cache lines");
+
+        const size_t bytes = getBytes<T>(count);
+
+        if (bytes > size - used)
+        {
+            jassertfalse;
+            return nullptr;
+        }
+
+        auto* result = reinterpret_cast<T*>(base + used);
+        used += bytes;
+        return result;
+    }
+
+    /** The position of the next array, to pass to rewind(). */
+    size_t getMark() const noexcept { return used; }
+
+    /** Hands out the memory from mark onwards again. Whatever was taken
+        after the mark must no longer be used. */
+    void rewind(size_t mark) noexcept;
+
+    size_t getSize() const noexcept { return size; }
+    size_t getUsed() const noexcept { return used; }
+
+private:
+    //==============================================================================
+    juce::HeapBlock<char> block;
+    char* base { nullptr };
+    size_t size { 0 };
+    size_t used { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AlignedArena)
+};
@@ -0,0 +1,133 @@
+#include "AudioFileInput.h"
+
+#if JUCE_LINUX || JUCE_BSD || JUCE_MAC
+ #include <fcntl.h>
+ #include <unistd.h>
+#endif
+
+//==============================================================================
+AudioFileInput::AudioFileInput()
+{
+    formatManager.registerBasicFormats();
+}
+
+AudioFileInput::~AudioFileInput()
+{
+    close();
+}
+
+//==============================================================================
+bool AudioFileInput::open(const juce::File& file, juce::Range<juce::int64> sampleRange)
+{
+    close();
+
+    if ((wavFormat.canHandleFile(file) || aiffFormat.canHandleFile(file)) && openMapped(file, sampleRange))
+        return true;
+
+    streamReader.reset(formatManager.createReaderFor(file));
+    return streamReader != nullptr;
+}
+
+void AudioFileInput::close() noexcept
+{
+    mappedReader.reset();
+    streamReader.reset();
+
+   #if JUCE_LINUX || JUCE_BSD || JUCE_MAC
+    if (adviceHandle >= 0)
+        ::close(adviceHandle);
+   #endif
+
+    adviceHandle = -1;
+    fileSize = 0;
+    advisedUpTo = 0;
+}
+
+juce::AudioFormatReader* AudioFileInput::getReader() const noexcept
+{
+    if (mappedReader != nullptr)
+        return mappedReader.get();
+
+    return streamReader.get();
+}
+
+bool AudioFileInput::read(juce::AudioBuffer<float>& buffer, int numSamples, juce::int64 position)
+{
+    auto* reader = getReader();
+
+    if (reader == nullptr)
+        return false;
+
+    if (mappedReader != nullptr)
+        adviseReadahead(position + numSamples);
+
+    return reader->read(&buffer, 0, numSamples, position, true, true);
+}
+
+//==============================================================================
+bool AudioFileInput::openMapped(const juce::File& file, juce::Range<juce::int64> sampleRange)
+{
+    auto& format = wavFormat.canHandleFile(file) ? static_cast<juce::AudioFormat&>(wavFormat) : aiffFormat;
+    mappedReader.reset(format.createMemoryMappedReader(file));
+
+    // JUCE converts up to 32-bit samples from mapped memory, not 64-bit floats
+    if (mappedReader == nullptr || mappedReader->bitsPerSample > 32)
+    {
+        mappedReader.reset();
+        return false;
+    }
+
+    const auto range = sampleRange.getIntersectionWith({ 0, mappedReader->lengthInSamples });
+
+    if (range.isEmpty() || ! mappedReader->mapSectionOfFile(range))
+    {
+        mappedReader.reset();
+        return false;
+    }
+
+    fileSize = file.getSize();
+
+   #if JUCE_LINUX || JUCE_BSD || JUCE_MAC
+    adviceHandle = ::open(file.getFullPathName().toRawUTF8(), O_RDONLY);
+   #endif
+
+    // The first request starts a little before the range, since the header
+    // shifts the data from its proportional position (see adviseReadahead())
+    const auto start = static_cast<juce::int64>(static_cast<double>(fileSize) * static_cast<double>(range.getStart())
+                                                / static_cast<double>(mappedReader->lengthInSamples));
+    advisedUpTo = juce::jmax(static_cast<juce::int64>(0), start - readaheadBytes / 4);
+    adviseReadahead(range.getStart());
+
+    return true;
+}
+
+void AudioFileInput::adviseReadahead(juce::int64 position) noexcept
+{
+    if (adviceHandle < 0 || advisedUpTo >= fileSize)
+        return;
+
+    // The samples fill the file but for the header and metadata chunks, so
+    // the proportional position is close enough for a hint. Requests are
+    // contiguous, so an estimate that is off only changes how far ahead
+    // the file is fetched, never what
+    const auto filePosition = static_cast<juce::int64>(static_cast<double>(fileSize) * static_cast<double>(position)
+                                                       / static_cast<double>(mappedReader->lengthInSamples));
+
+    // Ask again once less than half the window is left
+    if (advisedUpTo - filePosition > readaheadBytes / 2)
+        return;
+
+    const auto end = juce::jmin(fileSize, filePosition + readaheadBytes);
+
+    if (end <= advisedUpTo)
+        return;
+
+   #if JUCE_LINUX || JUCE_BSD
+    posix_fadvise(adviceHandle, static_cast<off_t>(advisedUpTo), static_cast<off_t>(end - advisedUpTo), POSIX_FADV_WILLNEED);
+   #elif JUCE_MAC
+    radvisory advice { static_cast<off_t>(advisedUpTo), static_cast<int>(end - advisedUpTo) };
+    fcntl(adviceHandle, F_RDADVISE, &advice);
+   #endif
+
+    advisedUpTo = end;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+ * Reads an audio file for offline processing, memory-mapped where the format
+ * allows it.
+ *
+ * WAV (including RF64) and AIFF files with PCM or 32-bit float samples are
+ * mapped, and each block is converted straight from the mapped pages into
+ * the caller's buffer: no read() copy into an intermediate buffer. As reading
+ * moves forward, the operating system is asked to fetch the next stretch of
+ * the file ahead of it (on Linux, BSD and macOS; Windows gets no hints).
+ * Other formats, and files that can't be mapped, go through the usual
+ * streaming reader.
+ *
+ * One input can open any number of files in turn, so a worker keeps its
+ * formats and reader memory from file to file.
+ */
+class AudioFileInput
+{
+public:
+    //==============================================================================
+    AudioFileInput();
+    ~AudioFileInput();
+
+    /** Opens a file to read the samples in sampleRange, the whole file by
+        default; only that part is mapped. Closes the previous file first.
+        Returns false if the file can't be read at all. */
+    bool open(const juce::File& file,
+              juce::Range<juce::int64> sampleRange = { 0, std::numeric_limits<juce::int64>::max() });
+
+    /** Closes the file and unmaps it. */
+    void close() noexcept;
+
+    /** The open file's reader, for its rate, channels, length and metadata;
+        nullptr if nothing is open. */
+    juce::AudioFormatReader* getReader() const noexcept;
+
+    bool isMemoryMapped() const noexcept { return mappedReader != nullptr; }
+
+    /** Converts numSamples from position into the start of buffer's channels.
+        position must lie in the range given to open(). */
+    bool read(juce::AudioBuffer<float>& buffer, int numSamples, juce::int64 position);
+
+private:
+    //==============================================================================
+    // How far ahead of the read position the file is requested
+    static constexpr juce::int64 readaheadBytes = 32 * 1024 * 1024;
+
+    bool openMapped(const juce::File& file, juce::Range<juce::int64> sampleRange);
+    void adviseReadahead(juce::int64 position) noexcept;
+
+    juce::AudioFormatManager formatManager;
+    juce::WavAudioFormat wavFormat;
+    juce::AiffAudioFormat aiffFormat;
+
+    std::unique_ptr<juce::MemoryMappedAudioFormatReader> mappedReader;
+    std::unique_ptr<juce::AudioFormatReader> streamReader;
+
+    // Readahead requests for the mapped file, where the platform takes them
+    int adviceHandle { -1 };
+    juce::int64 fileSize { 0 };
+    juce::int64 advisedUpTo { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AudioFileInput)
+};
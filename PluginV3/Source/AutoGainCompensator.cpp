@@ -0,0 +1,129 @@
+#include "AutoGainCompensator.h"
+
+namespace
+{
+    constexpr double integrationTimeSeconds = 3.0;
+    constexpr double smoothingTimeSeconds = 0.3;
+    constexpr float maximumCompensationDb = 24.0f;
+
+    // Mean square energy of a K-weighted signal at the -70 LUFS absolute gate
+    const double gateEnergy = std::pow(10.0, (-70.0 + 0.691) / 10.0);
+
+    /** Sums the squares of one K-weighted channel. */
+    double filterAndSum(KWeightingFilter& filter, const float* data, int numSamples) noexcept
+    {
+        double sum = 0.0;
+
+        for (int sample = 0; sample < numSamples; ++sample)
+        {
+            const float weighted = filter.processSample(data[sample]);
+            sum += static_cast<double>(weighted) * weighted;
+        }
+
+        return sum;
+    }
+}
+
+//==============================================================================
+void AutoGainCompensator::prepare(double newSampleRate)
+{
+    sampleRate = newSampleRate;
+
+    for (auto& filter : inputFilters)
+        filter.prepare(sampleRate);
+
+    for (auto& filter : outputFilters)
+        filter.prepare(sampleRate);
+
+    reset();
+}
+
+void AutoGainCompensator::reset() noexcept
+{
+    for (auto& filter : inputFilters)
+        filter.reset();
+
+    for (auto& filter : outputFilters)
+        filter.reset();
+
+    blockInputEnergy = blockOutputEnergy = 0.0;
+    inputEnergy = outputEnergy = 0.0;
+    hasMeasurement = false;
+
+    targetGain = currentGain = 1.0f;
+    compensationDb.store(0.0f, std::memory_order_relaxed);
+}
+
+//==============================================================================
+void AutoGainCompensator::measureInput(const float* const* channels, int numChannels, int numSamples) noexcept
+{
+    numChannels = juce::jmin(numChannels, maxChannels);
+
+    for (int channel = 0; channel < numChannels; ++channel)
+        blockInputEnergy += filterAndSum(inputFilters[static_cast<size_t>(channel)], channels[channel], numSamples);
+}
+
+void AutoGainCompensator::measureOutput(const float* const* channels, int numChannels, int numSamples,
+                                        const float* channelGains) noexcept
+{
+    numChannels = juce::jmin(numChannels, maxChannels);
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        const double gain = channelGains[channel];
+        blockOutputEnergy += gain * gain * filterAndSum(outputFilters[static_cast<size_t>(channel)], channels[channel], numSamples);
+    }
+}
+
+float AutoGainCompensator::getNextGain(bool enabled, int numSamples) noexcept
+{
+    if (numSamples <= 0)
+        return currentGain;
+
+    const double blockSeconds = numSamples / sampleRate;
+
+    if (enabled)
+    {
+        // Running average with the same time constant whatever the block size
+        const double meanInput = blockInputEnergy / numSamples;
+        const double meanOutput = blockOutputEnergy / numSamples;
+
+        if (hasMeasurement)
+        {
+            const double weight = 1.0 - std::exp(-blockSeconds / integrationTimeSeconds);
+            inputEnergy += weight * (meanInput - inputEnergy);
+            outputEnergy += weight * (meanOutput - outputEnergy);
+        }
+        else
+        {
+            inputEnergy = meanInput;
+            outputEnergy = meanOutput;
+            hasMeasurement = true;
+        }
+
+        // Hold the last gain through silence rather than chasing noise
+        if (inputEnergy > gateEnergy && outputEnergy > gateEnergy)
+        {
+            const float ratioDb = static_cast<float>(10.0 * std::log10(inputEnergy / outputEnergy));
+            targetGain = juce::Decibels::decibelsToGain(juce::jlimit(-maximumCompensationDb, maximumCompensationDb, ratioDb));
+        }
+    }
+    else
+    {
+        // Glide back to unity, then stop exactly on it so the bypassed path is untouched
+        targetGain = 1.0f;
+        hasMeasurement = false;
+        inputEnergy = outputEnergy = 0.0;
+    }
+
+    blockInputEnergy = blockOutputEnergy = 0.0;
+
+    const float smoothing = static_cast<float>(1.0 - std::exp(-blockSeconds / smoothingTimeSeconds));
+    currentGain += smoothing * (targetGain - currentGain);
+
+    if (! enabled && std::abs(currentGain - 1.0f) < 1.0e-4f)
+        currentGain = 1.0f;
+
+    compensationDb.store(juce::Decibels::gainToDecibels(currentGain), std::memory_order_relaxed);
+    return currentGain;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "LoudnessMeter.h"
+
+//==============================================================================
+/**
+ * Loudness-matching gain for level-matched A/B comparisons.
+ *
+ * The input and the processed signal are K-weighted and their mean square
+ * is integrated with a ~3 s time constant (about the BS.1770 short-term
+ * window) as a running average updated once per block. The compensating
+ * gain is the ratio of the two, limited to +/-24 dB, held while either side
+ * is below the -70 LUFS gate, and smoothed before it is handed back to be
+ * folded into the channel gains. There is no latency, and the per-sample
+ * cost is two K-weighting filters per channel.
+ *
+ * The processed signal is measured before the channel gains are applied;
+ * since BS.1770 sums channel energies, its loudness after gain is the
+ * per-channel energy scaled by the squared gain, so the compensation never
+ * feeds back into its own measurement.
+ */
+class AutoGainCompensator
+{
+public:
+    //==============================================================================
+    static constexpr int maxChannels = 2;
+
+    void prepare(double sampleRate);
+
+    /** Forgets the measurements and returns to unity gain. */
+    void reset() noexcept;
+
+    /** K-weights the unprocessed input of a block. */
+    void measureInput(const float* const* channels, int numChannels, int numSamples) noexcept;
+
+    /** K-weights the processed signal of a block before its channel gains,
+        which are given separately. */
+    void measureOutput(const float* const* channels, int numChannels, int numSamples,
+                       const float* channelGains) noexcept;
+
+    /** Folds the block's measurements into the running loudness and returns
+        the compensating gain for the end of the block. When disabled, the
+        gain glides back to exactly 1 and the measurements are cleared. */
+    float getNextGain(bool enabled, int numSamples) noexcept;
+
+    /** True while a gain other than unity is being applied. */
+    bool isCompensating() const noexcept { return currentGain != 1.0f; }
+
+    /** The gain most recently returned, in dB. Safe to call from any thread. */
+    float getCompensationDb() const noexcept { return compensationDb.load(std::memory_order_relaxed); }
+
+private:
+    //==============================================================================
+    double sampleRate { 44100.0 };
+
+    std::array<KWeightingFilter, maxChannels> inputFilters;
+    std::array<KWeightingFilter, maxChannels> outputFilters;
+
+    // Block energy sums, then their running averages
+    double blockInputEnergy { 0.0 };
+    double blockOutputEnergy { 0.0 };
+    double inputEnergy { 0.0 };
+    double outputEnergy { 0.0 };
+    bool hasMeasurement { false };
+
+    float targetGain { 1.0f };
+    float currentGain { 1.0f };
+    std::atomic<float> compensationDb { 0.0f };
+};
@@ -0,0 +1,434 @@
+#include "BatchProcessor.h"
+#include "DspKernels.h"
+
+namespace
+{
+   #if JUCE_USE_SIMD
+    template <typename Type>
+    using Vector = juce::dsp::SIMDRegister<Type>;
+   #else
+    template <typename Type>
+    struct Vector
+    {
+        static constexpr size_t SIMDNumElements = 1;
+        Type value;
+
+        static Vector expand(Type newValue) noexcept              { return { newValue }; }
+        static Vector fromRawArray(const Type* values) noexcept   { return { *values }; }
+        void copyToRawArray(Type* values) const noexcept          { *values = value; }
+
+        static Vector max(Vector a, Vector b) noexcept            { return { juce::jmax(a.value, b.value) }; }
+        static Vector abs(Vector a) noexcept                      { return { std::abs(a.value) }; }
+
+        Vector operator+(Vector other) const noexcept { return { value + other.value }; }
+        Vector operator-(Vector other) const noexcept { return { value - other.value }; }
+        Vector operator*(Vector other) const noexcept { return { value * other.value }; }
+    };
+   #endif
+
+    /** One value per lane, held as a row of vectors. */
+    template <typename Type>
+    struct LaneRow
+    {
+        using Register = Vector<Type>;
+        static constexpr int width = static_cast<int>(Register::SIMDNumElements);
+        static constexpr int numRegisters = BatchProcessor::numLanes / width;
+        static_assert(BatchProcessor::numLanes % width == 0, "lanes have to fill whole vectors");
+
+        Register registers[numRegisters];
+
+        static LaneRow load(const Type* values) noexcept
+        {
+            LaneRow row;
+            for (int i = 0; i < numRegisters; ++i)
+                row.registers[i] = Register::fromRawArray(values + i * width);
+            return row;
+        }
+
+        static LaneRow expand(Type value) noexcept
+        {
+            LaneRow row;
+            for (auto& r : row.registers)
+                r = Register::expand(value);
+            return row;
+        }
+
+        void store(Type* values) const noexcept
+        {
+            for (int i = 0; i < numRegisters; ++i)
+                registers[i].copyToRawArray(values + i * width);
+        }
+
+        template <typename Operation>
+        static LaneRow combine(const LaneRow& a, const LaneRow& b, Operation&& operation) noexcept
+        {
+            LaneRow row;
+            for (int i = 0; i < numRegisters; ++i)
+                row.registers[i] = operation(a.registers[i], b.registers[i]);
+            return row;
+        }
+
+        LaneRow operator+(const LaneRow& other) const noexcept { return combine(*this, other, [](Register a, Register b) { return a + b; }); }
+        LaneRow operator-(const LaneRow& other) const noexcept { return combine(*this, other, [](Register a, Register b) { return a - b; }); }
+        LaneRow operator*(const LaneRow& other) const noexcept { return combine(*this, other, [](Register a, Register b) { return a * b; }); }
+
+        static LaneRow max(const LaneRow& a, const LaneRow& b) noexcept
+        {
+            return combine(a, b, [](Register x, Register y) { return Register::max(x, y); });
+        }
+
+        LaneRow abs() const noexcept
+        {
+            LaneRow row;
+            for (int i = 0; i < numRegisters; ++i)
+                row.registers[i] = Register::abs(registers[i]);
+            return row;
+        }
+    };
+
+    using FloatRow = LaneRow<float>;
+    using DoubleRow = LaneRow<double>;
+
+    // SIMDRegister has no conversions between float and double, so these go
+    // through memory; the compiler turns the short loops into vector converts
+    DoubleRow toDouble(const float* values) noexcept
+    {
+        alignas(AlignedArena::alignment) double converted[BatchProcessor::numLanes];
+
+        for (int lane = 0; lane < BatchProcessor::numLanes; ++lane)
+            converted[lane] = static_cast<double>(values[lane]);
+
+        return DoubleRow::load(converted);
+    }
+
+    /** Rounds every lane to float precision, as KWeightingFilter's output is. */
+    DoubleRow roundToFloat(const DoubleRow& row) noexcept
+    {
+        alignas(AlignedArena::alignment) double values[BatchProcessor::numLanes];
+        row.store(values);
+
+        for (auto& value : values)
+            value = static_cast<double>(static_cast<float>(value));
+
+        return DoubleRow::load(values);
+    }
+}
+
+//==============================================================================
+bool BatchProcessor::readSettings(juce::AudioProcessorValueTreeState& apvts, Settings& settings, juce::String& reason)
+{
+    auto value = [&apvts](const char* parameterID)
+    {
+        const auto* parameter = apvts.getRawParameterValue(parameterID);
+        return parameter != nullptr ? parameter->load() : 0.0f;
+    };
+
+    if (value("left_delay") != 0.0f || value("right_delay") != 0.0f || value("phase_offset") != 0.0f)
+        reason = "the channel delays and phase offset need the delay line";
+    else if (juce::roundToInt(value("width_mode")) != 0 && value("width_amount") > 0.0f)
+        reason = "the width stage needs the delay line";
+    else if (juce::roundToInt(value("hpf_mode")) != 0)
+        reason = "the low cut filter is on";
+    else if (value("auto_gain") > 0.5f)
+        reason = "auto gain follows each file";
+    else if (juce::roundToInt(value("safety_mode")) != 0)
+        reason = "output safety is on";
+
+    if (reason.isNotEmpty())
+        return false;
+
+    // As PluginV3AudioProcessor::getTargetLeftGain() and getTargetRightGain()
+    const float masterGain = value("master_gain");
+    settings.leftGain = (value("invert_left") > 0.5f ? -1.0f : 1.0f) * value("left_gain") * masterGain;
+    settings.rightGain = (value("invert_right") > 0.5f ? -1.0f : 1.0f) * value("right_gain") * masterGain;
+
+    settings.useMidSide = value("use_mid_side") > 0.5f;
+    settings.midGain = value("mid_gain");
+    settings.sideGain = value("side_gain");
+    return true;
+}
+
+//==============================================================================
+void BatchProcessor::prepare(const Settings& newSettings, double sampleRate, int newMaximumBlockSize)
+{
+    settings = newSettings;
+    maximumBlockSize = juce::jmax(1, newMaximumBlockSize);
+
+    const int numValues = maximumBlockSize * numLanes;
+    storage.allocate(2 * AlignedArena::getBytes<float>(numValues));
+    leftData = storage.take<float>(numValues);
+    rightData = storage.take<float>(numValues);
+    laneSamples.fill(0);
+
+    weighting.prepare(sampleRate);
+
+    for (auto& meter : loudnessMeters)
+        meter.prepare(sampleRate);
+
+    oversamplingFactor = TruePeakDetector::getOversamplingFactorForRate(sampleRate);
+    interpolator = TruePeakDetector::getInterpolator(oversamplingFactor);
+    historyPosition = 0;
+
+    // The same kernels as a processor's prepareToPlay picks
+    DspKernels::selectInstructionSet();
+
+    for (int lane = 0; lane < numLanes; ++lane)
+        startLane(lane);
+}
+
+void BatchProcessor::startLane(int lane) noexcept
+{
+    jassert(juce::isPositiveAndBelow(lane, numLanes));
+    const auto index = static_cast<size_t>(lane);
+
+    for (int channel = 0; channel < 2; ++channel)
+    {
+        meters.shelf[channel].z1[index] = meters.shelf[channel].z2[index] = 0.0;
+        meters.highPass[channel].z1[index] = meters.highPass[channel].z2[index] = 0.0;
+        meters.weightedSums[channel][index] = 0.0;
+
+        for (auto& past : meters.history[channel])
+            past[index] = 0.0f;
+    }
+
+    loudnessMeters[index].reset();
+    meters.samplePeaks[index] = meters.truePeaks[index] = 0.0f;
+    meters.sumsLeftRight[index] = meters.sumsLeftSquared[index] = meters.sumsRightSquared[index] = 0.0;
+}
+
+//==============================================================================
+void BatchProcessor::setLaneInput(int lane, const float* left, const float* right, int numSamples) noexcept
+{
+    jassert(juce::isPositiveAndBelow(lane, numLanes) && numSamples <= maximumBlockSize);
+    numSamples = juce::jlimit(0, maximumBlockSize, numSamples);
+
+    for (int sample = 0; sample < numSamples; ++sample)
+    {
+        leftData[sample * numLanes + lane] = left[sample];
+        rightData[sample * numLanes + lane] = right[sample];
+    }
+
+    laneSamples[static_cast<size_t>(lane)] = numSamples;
+}
+
+void BatchProcessor::getLaneOutput(int lane, float* left, float* right, int numSamples) const noexcept
+{
+    jassert(juce::isPositiveAndBelow(lane, numLanes) && numSamples <= maximumBlockSize);
+    numSamples = juce::jlimit(0, maximumBlockSize, numSamples);
+
+    for (int sample = 0; sample < numSamples; ++sample)
+    {
+        left[sample] = leftData[sample * numLanes + lane];
+        right[sample] = rightData[sample * numLanes + lane];
+    }
+}
+
+BatchProcessor::LaneResult BatchProcessor::getLaneResult(int lane) const noexcept
+{
+    jassert(juce::isPositiveAndBelow(lane, numLanes));
+    const auto index = static_cast<size_t>(lane);
+
+    LaneResult result;
+    result.samplePeak = meters.samplePeaks[index];
+    result.truePeak = meters.truePeaks[index];
+    result.integratedLoudness = loudnessMeters[index].getIntegratedLoudness();
+    result.sumLeftRight = meters.sumsLeftRight[index];
+    result.sumLeftSquared = meters.sumsLeftSquared[index];
+    result.sumRightSquared = meters.sumsRightSquared[index];
+    return result;
+}
+
+//==============================================================================
+void BatchProcessor::process() noexcept
+{
+    const int numSamples = *std::max_element(laneSamples.begin(), laneSamples.end());
+
+    if (numSamples == 0)
+        return;
+
+    // Lanes that ended early or got no input carry silence
+    for (int lane = 0; lane < numLanes; ++lane)
+    {
+        for (int sample = laneSamples[static_cast<size_t>(lane)]; sample < numSamples; ++sample)
+            leftData[sample * numLanes + lane] = rightData[sample * numLanes + lane] = 0.0f;
+    }
+
+    // The gains are the same for every lane, so the interleaved block goes
+    // through the processor's own kernels in one pass, denormals flushed as in
+    // processBlock
+    {
+        juce::ScopedNoDenormals noDenormals;
+        const int numValues = numSamples * numLanes;
+
+        if (settings.useMidSide)
+            DspKernels::applyMidSideGain(leftData, rightData, numValues, settings.midGain, settings.sideGain);
+
+        DspKernels::applyGain(leftData, numValues, settings.leftGain, false);
+        DspKernels::applyGain(rightData, numValues, settings.rightGain, false);
+    }
+
+    // Meter in runs that end wherever any lane's sub-block or input ends, so
+    // each lane's weighted sums are split where its own LoudnessMeter would
+    // split them. Lanes past their input are masked out.
+    for (auto& sums : meters.weightedSums)
+        sums.fill(0.0);
+
+    runStart.fill(0);
+    int position = 0;
+
+    while (position < numSamples)
+    {
+        Lanes<bool> active;
+        int end = numSamples;
+
+        for (size_t lane = 0; lane < numLanes; ++lane)
+        {
+            active[lane] = position < laneSamples[lane];
+
+            if (active[lane])
+                end = juce::jmin(end, laneSamples[lane], runStart[lane] + loudnessMeters[lane].getSamplesToSubBlockEnd());
+        }
+
+        measure(position, end, active);
+
+        for (size_t lane = 0; lane < numLanes; ++lane)
+        {
+            if (! active[lane])
+                continue;
+
+            auto& meter = loudnessMeters[lane];
+            const int runLength = end - runStart[lane];
+
+            if (end == laneSamples[lane] || runLength == meter.getSamplesToSubBlockEnd())
+            {
+                const double sums[] = { meters.weightedSums[0][lane], meters.weightedSums[1][lane] };
+                meter.addWeightedSums(sums, 2, runLength);
+
+                meters.weightedSums[0][lane] = meters.weightedSums[1][lane] = 0.0;
+                runStart[lane] = end;
+            }
+        }
+
+        position = end;
+    }
+
+    laneSamples.fill(0);
+}
+
+//==============================================================================
+void BatchProcessor::measure(int start, int end, const Lanes<bool>& active) noexcept
+{
+    // Each row operation is the scalar meters' arithmetic, in the same order,
+    // for every lane at once. Inactive lanes are multiplied by zero, so they
+    // add nothing to the sums and raise no peaks.
+    alignas(AlignedArena::alignment) float maskValues[numLanes];
+    alignas(AlignedArena::alignment) double maskDoubleValues[numLanes];
+
+    for (size_t lane = 0; lane < numLanes; ++lane)
+    {
+        maskValues[lane] = active[lane] ? 1.0f : 0.0f;
+        maskDoubleValues[lane] = active[lane] ? 1.0 : 0.0;
+    }
+
+    const auto mask = FloatRow::load(maskValues);
+    const auto maskDouble = DoubleRow::load(maskDoubleValues);
+
+    const auto& shelf = weighting.getShelf();
+    const auto& highPass = weighting.getHighPass();
+    const auto shelfB0 = DoubleRow::expand(shelf.b0), shelfB1 = DoubleRow::expand(shelf.b1), shelfB2 = DoubleRow::expand(shelf.b2);
+    const auto shelfA1 = DoubleRow::expand(shelf.a1), shelfA2 = DoubleRow::expand(shelf.a2);
+    const auto highPassB0 = DoubleRow::expand(highPass.b0), highPassB1 = DoubleRow::expand(highPass.b1), highPassB2 = DoubleRow::expand(highPass.b2);
+    const auto highPassA1 = DoubleRow::expand(highPass.a1), highPassA2 = DoubleRow::expand(highPass.a2);
+
+    // The state stays in registers for the run; the true-peak history is read from memory
+    DoubleRow shelfZ1[2], shelfZ2[2], highPassZ1[2], highPassZ2[2], weightedSums[2];
+
+    for (int channel = 0; channel < 2; ++channel)
+    {
+        shelfZ1[channel] = DoubleRow::load(meters.shelf[channel].z1.data());
+        shelfZ2[channel] = DoubleRow::load(meters.shelf[channel].z2.data());
+        highPassZ1[channel] = DoubleRow::load(meters.highPass[channel].z1.data());
+        highPassZ2[channel] = DoubleRow::load(meters.highPass[channel].z2.data());
+        weightedSums[channel] = DoubleRow::load(meters.weightedSums[channel].data());
+    }
+
+    auto samplePeaks = FloatRow::load(meters.samplePeaks.data());
+    auto truePeaks = FloatRow::load(meters.truePeaks.data());
+    auto sumsLeftRight = DoubleRow::load(meters.sumsLeftRight.data());
+    auto sumsLeftSquared = DoubleRow::load(meters.sumsLeftSquared.data());
+    auto sumsRightSquared = DoubleRow::load(meters.sumsRightSquared.data());
+
+    const float* coefficients = interpolator->data();
+    int position = historyPosition;
+
+    for (int sample = start; sample < end; ++sample)
+    {
+        const float* frames[2] = { leftData + sample * numLanes, rightData + sample * numLanes };
+        const DoubleRow inputs[2] = { toDouble(frames[0]), toDouble(frames[1]) };
+
+        sumsLeftRight = sumsLeftRight + inputs[0] * inputs[1] * maskDouble;
+        sumsLeftSquared = sumsLeftSquared + inputs[0] * inputs[0] * maskDouble;
+        sumsRightSquared = sumsRightSquared + inputs[1] * inputs[1] * maskDouble;
+
+        if (oversamplingFactor > 1)
+            position = (position == 0 ? tapsPerPhase : position) - 1;
+
+        for (int channel = 0; channel < 2; ++channel)
+        {
+            // KWeightingFilter::processSample
+            const auto& x = inputs[channel];
+            const auto shelved = shelfB0 * x + shelfZ1[channel];
+            shelfZ1[channel] = shelfB1 * x - shelfA1 * shelved + shelfZ2[channel];
+            shelfZ2[channel] = shelfB2 * x - shelfA2 * shelved;
+
+            const auto filtered = highPassB0 * shelved + highPassZ1[channel];
+            highPassZ1[channel] = highPassB1 * shelved - highPassA1 * filtered + highPassZ2[channel];
+            highPassZ2[channel] = highPassB2 * shelved - highPassA2 * filtered;
+
+            const auto weighted = roundToFloat(filtered);
+            weightedSums[channel] = weightedSums[channel] + weighted * weighted * maskDouble;
+
+            const auto magnitudes = FloatRow::load(frames[channel]).abs() * mask;
+            samplePeaks = FloatRow::max(samplePeaks, magnitudes);
+
+            // TruePeakDetector::process
+            if (oversamplingFactor > 1)
+            {
+                auto& channelHistory = meters.history[channel];
+                std::copy(frames[channel], frames[channel] + numLanes, channelHistory[static_cast<size_t>(position)].begin());
+                std::copy(frames[channel], frames[channel] + numLanes, channelHistory[static_cast<size_t>(position + tapsPerPhase)].begin());
+
+                for (int phase = 0; phase < oversamplingFactor; ++phase)
+                {
+                    const float* phaseCoefficients = coefficients + phase * tapsPerPhase;
+                    auto sum = FloatRow::expand(0.0f);
+
+                    for (int k = 0; k < tapsPerPhase; ++k)
+                        sum = sum + FloatRow::expand(phaseCoefficients[k]) * FloatRow::load(channelHistory[static_cast<size_t>(position + k)].data());
+
+                    truePeaks = FloatRow::max(truePeaks, sum.abs() * mask);
+                }
+            }
+
+            // The true peak is never below the sample peak
+            truePeaks = FloatRow::max(truePeaks, magnitudes);
+        }
+    }
+
+    for (int channel = 0; channel < 2; ++channel)
+    {
+        shelfZ1[channel].store(meters.shelf[channel].z1.data());
+        shelfZ2[channel].store(meters.shelf[channel].z2.data());
+        highPassZ1[channel].store(meters.highPass[channel].z1.data());
+        highPassZ2[channel].store(meters.highPass[channel].z2.data());
+        weightedSums[channel].store(meters.weightedSums[channel].data());
+    }
+
+    samplePeaks.store(meters.samplePeaks.data());
+    truePeaks.store(meters.truePeaks.data());
+    sumsLeftRight.store(meters.sumsLeftRight.data());
+    sumsLeftSquared.store(meters.sumsLeftSquared.data());
+    sumsRightSquared.store(meters.sumsRightSquared.data());
+
+    historyPosition = position;
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "AlignedArena.h"
+#include "LoudnessMeter.h"
+#include "TruePeakDetector.h"
+
+//==============================================================================
+/**
+ * Processes and meters several independent stereo files at once, one file
+ * per lane, for offline rendering of many files with the same settings.
+ *
+ * Samples are stored lane-interleaved (sample s of lane l at
+ * [s * numLanes + l]), so one vector holds the same sample position of
+ * several files: the K-weighting and true-peak filters of all lanes advance
+ * together as juce::dsp::SIMDRegister rows instead of one file at a time.
+ *
+ * Only settings whose processing is a per-sample matrix are supported: mid/side
+ * gains, polarity and channel gains. The output and the meter readings are
+ * bit-identical to running each file through its own PluginV3AudioProcessor
+ * and the offline renderer's meters with the same block size, which
+ * PluginV3Regression --batch-only checks.
+ */
+class BatchProcessor
+{
+public:
+    //==============================================================================
+    static constexpr int numLanes = 8;
+
+    struct Settings
+    {
+        // Channel gains with polarity and master gain folded in
+        float leftGain = 1.0f;
+        float rightGain = 1.0f;
+
+        bool useMidSide = false;
+        float midGain = 1.0f;
+        float sideGain = 1.0f;
+    };
+
+    /** Reads the settings from a processor's parameters. Returns false, with
+        the reason, if they use a stage the batch can't run: delays, phase
+        offset, width, low cut, auto gain or output safety. */
+    static bool readSettings(juce::AudioProcessorValueTreeState& apvts, Settings& settings, juce::String& reason);
+
+    //==============================================================================
+    BatchProcessor() = default;
+
+    /** Sets up every lane for one sample rate. Not real-time safe. */
+    void prepare(const Settings& newSettings, double sampleRate, int maximumBlockSize);
+
+    /** Clears a lane's filters and meters for a new file. */
+    void startLane(int lane) noexcept;
+
+    /** Copies the next block of a lane's file in. Lanes without input for a
+        block are processed as silence and not metered. */
+    void setLaneInput(int lane, const float* left, const float* right, int numSamples) noexcept;
+
+    /** Processes and meters the current block of every lane. */
+    void process() noexcept;
+
+    /** Copies a lane's processed block out. */
+    void getLaneOutput(int lane, float* left, float* right, int numSamples) const noexcept;
+
+    //==============================================================================
+    struct LaneResult
+    {
+        float samplePeak = 0.0f;
+        float truePeak = 0.0f;
+        float integratedLoudness = 0.0f;
+
+        // Sums of L*R, L*L and R*R over the whole file, for the correlation
+        double sumLeftRight = 0.0;
+        double sumLeftSquared = 0.0;
+        double sumRightSquared = 0.0;
+    };
+
+    /** Meter readings for everything since the lane's startLane(). */
+    LaneResult getLaneResult(int lane) const noexcept;
+
+private:
+    //==============================================================================
+    template <typename Type>
+    using Lanes = std::array<Type, numLanes>;
+
+    static constexpr int tapsPerPhase = TruePeakDetector::tapsPerPhase;
+
+    struct BiquadStates
+    {
+        Lanes<double> z1 {}, z2 {};
+    };
+
+    // Per-lane meter state, vector-aligned so measure() can load it as rows
+    struct alignas(AlignedArena::alignment) LaneMeters
+    {
+        // K-weighting states, and the weighted sums of each lane's current
+        // run, handed to its LoudnessMeter at sub-block ends
+        BiquadStates shelf[2], highPass[2];
+        Lanes<double> weightedSums[2] {};
+
+        // True-peak history, written twice as in TruePeakDetector
+        std::array<Lanes<float>, 2 * tapsPerPhase> history[2] {};
+
+        Lanes<float> samplePeaks {}, truePeaks {};
+        Lanes<double> sumsLeftRight {}, sumsLeftSquared {}, sumsRightSquared {};
+    };
+
+    void measure(int start, int end, const Lanes<bool>& active) noexcept;
+
+    Settings settings;
+    int maximumBlockSize { 0 };
+
+    // Lane-interleaved audio for one block
+    AlignedArena storage;
+    float* leftData { nullptr };
+    float* rightData { nullptr };
+    Lanes<int> laneSamples {};
+
+    // One filter's K-weighting coefficients serve every lane
+    KWeightingFilter weighting;
+    std::array<LoudnessMeter, numLanes> loudnessMeters;
+    Lanes<int> runStart {};
+
+    int oversamplingFactor { 1 };
+    std::shared_ptr<const std::vector<float>> interpolator;
+    int historyPosition { 0 };
+
+    LaneMeters meters;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(BatchProcessor)
+};
@@ -0,0 +1,126 @@
+#include "CrossCorrelator.h"
+
+//==============================================================================
+CrossCorrelator::CrossCorrelator(int windowOrder)
+    : windowSize(1 << windowOrder),
+      fftSize(2 << windowOrder), // Zero-padded to twice the window so lags don't wrap around
+      fft(SharedTables::getFft(windowOrder + 1)),
+      window(SharedTables::getHannWindow(1 << windowOrder))
+{
+    // The real-only FFT works in place on buffers of twice the transform size
+    firstSpectrum.allocate(static_cast<size_t>(2 * fftSize), true);
+    secondSpectrum.allocate(static_cast<size_t>(2 * fftSize), true);
+    crossSpectrum.allocate(static_cast<size_t>(fftSize / 2 + 1), true);
+}
+
+//==============================================================================
+void CrossCorrelator::reset() noexcept
+{
+    std::fill(crossSpectrum.get(), crossSpectrum.get() + fftSize / 2 + 1, std::complex<float>());
+    numFrames = 0;
+}
+
+bool CrossCorrelator::loadWindowed(float* destination, const float* source) const noexcept
+{
+    juce::FloatVectorOperations::multiply(destination, source, window->data(), windowSize);
+    juce::FloatVectorOperations::clear(destination + windowSize, 2 * fftSize - windowSize);
+
+    // Report near-silent frames, the phase transform would only correlate noise
+    float energy = 0.0f;
+    for (int i = 0; i < windowSize; ++i)
+        energy += destination[i] * destination[i];
+
+    return energy >= 1.0e-6f * static_cast<float>(windowSize);
+}
+
+void CrossCorrelator::addFrame(const float* first, const float* second) noexcept
+{
+    if (! loadWindowed(firstSpectrum.get(), first) || ! loadWindowed(secondSpectrum.get(), second))
+        return;
+
+    fft->performRealOnlyForwardTransform(firstSpectrum.get(), true);
+    fft->performRealOnlyForwardTransform(secondSpectrum.get(), true);
+
+    // Accumulate conj(X) * Y, the phase transform is applied to the average
+    auto* firstBins = reinterpret_cast<const std::complex<float>*>(firstSpectrum.get());
+    auto* secondBins = reinterpret_cast<const std::complex<float>*>(secondSpectrum.get());
+
+    for (int bin = 0; bin <= fftSize / 2; ++bin)
+        crossSpectrum[bin] += std::conj(firstBins[bin]) * secondBins[bin];
+
+    ++numFrames;
+}
+
+void CrossCorrelator::decay(float factor) noexcept
+{
+    for (int bin = 0; bin <= fftSize / 2; ++bin)
+        crossSpectrum[bin] *= factor;
+}
+
+CrossCorrelator::Result CrossCorrelator::computeResult(int maxLagSamples) noexcept
+{
+    Result result;
+
+    if (numFrames == 0)
+        return result;
+
+    maxLagSamples = juce::jlimit(1, windowSize - 1, maxLagSamples);
+
+    // Phase transform weighting: keep only the phase of each cross spectrum bin
+    auto* weightedBins = reinterpret_cast<std::complex<float>*>(firstSpectrum.get());
+
+    for (int bin = 0; bin <= fftSize / 2; ++bin)
+    {
+        const auto cross = crossSpectrum[bin];
+        const float magnitude = std::abs(cross);
+        weightedBins[bin] = magnitude > 1.0e-20f ? cross / magnitude : std::complex<float>();
+    }
+
+    fft->performRealOnlyInverseTransform(firstSpectrum.get());
+
+    // Negative lags live at the end of the circular correlation
+    const float* correlation = firstSpectrum.get();
+    auto valueAtLag = [this, correlation](int lag)
+    {
+        return correlation[lag >= 0 ? lag : fftSize + lag];
+    };
+
+    int peakLag = 0;
+    float peakValue = 0.0f;
+
+    for (int lag = -maxLagSamples; lag <= maxLagSamples; ++lag)
+    {
+        const float value = valueAtLag(lag);
+        if (std::abs(value) > std::abs(peakValue))
+        {
+            peakValue = value;
+            peakLag = lag;
+        }
+    }
+
+    // Parabolic interpolation around the peak for a sub-sample estimate
+    float fraction = 0.0f;
+    if (std::abs(peakLag) < maxLagSamples)
+    {
+        const float before = std::abs(valueAtLag(peakLag - 1));
+        const float centre = std::abs(peakValue);
+        const float after = std::abs(valueAtLag(peakLag + 1));
+        const float denominator = before - 2.0f * centre + after;
+
+        if (std::abs(denominator) > 1.0e-12f)
+            fraction = juce::jlimit(-0.5f, 0.5f, 0.5f * (before - after) / denominator);
+    }
+
+    result.valid = true;
+    result.lagSamples = static_cast<float>(peakLag) + fraction;
+    result.invertedPolarity = peakValue < 0.0f;
+    result.confidence = juce::jlimit(0.0f, 1.0f, std::abs(peakValue));
+    return result;
+}
+
+CrossCorrelator::Result CrossCorrelator::process(const float* first, const float* second, int maxLagSamples) noexcept
+{
+    reset();
+    addFrame(first, second);
+    return computeResult(maxLagSamples);
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "SharedTables.h"
+
+//==============================================================================
+/**
+ * Generalised cross-correlation with phase transform (GCC-PHAT).
+ *
+ * Estimates the relative delay and polarity between two signals. Frames are
+ * accumulated into an averaged cross spectrum one at a time, so the work can
+ * be spread over many small steps. All buffers are allocated up front, so
+ * the correlator can be driven from a background thread without allocating.
+ * The FFT and window come from SharedTables.
+ */
+class CrossCorrelator
+{
+public:
+    //==============================================================================
+    struct Result
+    {
+        bool valid = false;
+
+        /** Delay of the second signal relative to the first, in samples.
+            Positive values mean the second signal arrives late. */
+        float lagSamples = 0.0f;
+
+        /** True if the correlation peak is negative (opposite polarity). */
+        bool invertedPolarity = false;
+
+        /** Height of the GCC-PHAT peak (0 to 1), usable as a confidence value. */
+        float confidence = 0.0f;
+    };
+
+    //==============================================================================
+    /** Creates a correlator for analysis frames of 2^windowOrder samples. */
+    explicit CrossCorrelator(int windowOrder);
+
+    /** Returns the number of samples each frame holds per signal. */
+    int getWindowSize() const noexcept { return windowSize; }
+
+    //==============================================================================
+    /** Clears the accumulated cross spectrum. */
+    void reset() noexcept;
+
+    /** Adds one frame of getWindowSize() samples from each signal to the
+        averaged cross spectrum. Near-silent frames are skipped. */
+    void addFrame(const float* first, const float* second) noexcept;
+
+    /** Scales down the accumulated cross spectrum, so older frames fade out
+        while tracking. */
+    void decay(float factor) noexcept;
+
+    /** Returns the number of frames accumulated since the last reset(). */
+    int getNumFrames() const noexcept { return numFrames; }
+
+    /** Finds the correlation peak in the range [-maxLagSamples, maxLagSamples]. */
+    Result computeResult(int maxLagSamples) noexcept;
+
+    /** Correlates a single pair of frames. */
+    Result process(const float* first, const float* second, int maxLagSamples) noexcept;
+
+private:
+    int windowSize;
+    int fftSize;
+    int numFrames { 0 };
+
+    std::shared_ptr<const juce::dsp::FFT> fft;
+    std::shared_ptr<const std::vector<float>> window;
+    juce::HeapBlock<float> firstSpectrum;
+    juce::HeapBlock<float> secondSpectrum;
+    juce::HeapBlock<std::complex<float>> crossSpectrum;
+
+    bool loadWindowed(float* destination, const float* source) const noexcept;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CrossCorrelator)
+};
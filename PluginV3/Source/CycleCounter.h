@@ -0,0 +1,45 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <chrono>
+
+#if JUCE_INTEL
+ #if JUCE_MSVC
+  #include <intrin.h>
+ #else
+  #include <x86intrin.h>
+ #endif
+#endif
+
+//==============================================================================
+/**
+ * Cheap timestamps for profiling.
+ *
+ * readCycles() uses the x86 time-stamp counter, which ticks at the CPU's
+ * nominal frequency whatever the current clock speed is. Other architectures
+ * have no portable equivalent, so it returns 0 there and isAvailable is false.
+ */
+struct CycleCounter
+{
+   #if JUCE_INTEL
+    static constexpr bool isAvailable = true;
+   #else
+    static constexpr bool isAvailable = false;
+   #endif
+
+    static inline juce::uint64 readCycles() noexcept
+    {
+       #if JUCE_INTEL
+        return static_cast<juce::uint64>(__rdtsc());
+       #else
+        return 0;
+       #endif
+    }
+
+    /** Monotonic time in nanoseconds. */
+    static inline juce::int64 readNanoseconds() noexcept
+    {
+        using namespace std::chrono;
+        return static_cast<juce::int64>(duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count());
+    }
+};
@@ -0,0 +1,245 @@
+#include "DelayAligner.h"
+
+//==============================================================================
+DelayAligner::DelayAligner()
+    : juce::Thread("Delay Aligner")
+{
+}
+
+DelayAligner::~DelayAligner()
+{
+    release();
+    cancelPendingUpdate();
+}
+
+//==============================================================================
+void DelayAligner::prepare(double sampleRate, int maxLagSamples)
+{
+    release();
+
+    // Frames of roughly 50ms, but always long enough to see the whole lag range
+    const int targetWindowSize = juce::jmax(juce::roundToInt(sampleRate * 0.05), 4 * maxLagSamples);
+    int windowOrder = 10;
+    while ((1 << windowOrder) < targetWindowSize)
+        ++windowOrder;
+
+    if (correlator == nullptr || correlator->getWindowSize() != (1 << windowOrder))
+    {
+        correlator = std::make_unique<CrossCorrelator>(windowOrder);
+
+        const int windowSize = correlator->getWindowSize();
+        frameBuffer.setSize(2, windowSize);
+        captureBuffer.setSize(2, 8 * windowSize);
+        captureFifo.setTotalSize(8 * windowSize);
+    }
+
+    maxLag = maxLagSamples;
+
+    // Each result covers roughly a second of audio, but averages at least a
+    // few frames when long lag ranges need long frames
+    const int hopSize = correlator->getWindowSize() / 2;
+    framesPerResult = juce::jmax(4, juce::roundToInt(sampleRate / hopSize));
+
+    captureFifo.reset();
+    startThread(juce::Thread::Priority::low);
+}
+
+void DelayAligner::release()
+{
+    stopThread(2000);
+    capturing.store(false);
+    analysing.store(false);
+}
+
+void DelayAligner::writeDownmix(float* destination, const float* const* channels, int numChannels,
+                                int sourceOffset, int numSamples) noexcept
+{
+    if (numSamples <= 0)
+        return;
+
+    const float scale = 1.0f / static_cast<float>(numChannels);
+    juce::FloatVectorOperations::copyWithMultiply(destination, channels[0] + sourceOffset, scale, numSamples);
+
+    for (int channel = 1; channel < numChannels; ++channel)
+        juce::FloatVectorOperations::addWithMultiply(destination, channels[channel] + sourceOffset, scale, numSamples);
+}
+
+void DelayAligner::pushSamples(const float* const* firstChannels, int numFirstChannels,
+                               const float* const* secondChannels, int numSecondChannels,
+                               int numSamples) noexcept
+{
+    if (! capturing.load(std::memory_order_acquire) || numFirstChannels <= 0 || numSecondChannels <= 0)
+        return;
+
+    int start1, size1, start2, size2;
+    captureFifo.prepareToWrite(numSamples, start1, size1, start2, size2);
+
+    // Never wait for the analysis thread; a gap just restarts frame assembly
+    if (size1 + size2 < numSamples)
+        captureOverflowed.store(true);
+
+    writeDownmix(captureBuffer.getWritePointer(0, start1), firstChannels, numFirstChannels, 0, size1);
+    writeDownmix(captureBuffer.getWritePointer(1, start1), secondChannels, numSecondChannels, 0, size1);
+    writeDownmix(captureBuffer.getWritePointer(0, start2), firstChannels, numFirstChannels, size1, size2);
+    writeDownmix(captureBuffer.getWritePointer(1, start2), secondChannels, numSecondChannels, size1, size2);
+
+    captureFifo.finishedWrite(size1 + size2);
+}
+
+//==============================================================================
+void DelayAligner::requestAnalysis() noexcept
+{
+    // The analysis thread polls for requests, so nothing here can block
+    analysisRequested.store(true);
+    analysing.store(true);
+}
+
+void DelayAligner::setContinuousTracking(bool shouldTrack) noexcept
+{
+    continuousTracking.store(shouldTrack);
+}
+
+void DelayAligner::setTrackingInterval(double seconds) noexcept
+{
+    trackingIntervalMs.store(juce::jmax(0, juce::roundToInt(seconds * 1000.0)));
+}
+
+CrossCorrelator::Result DelayAligner::getLastResult() const
+{
+    const juce::SpinLock::ScopedLockType lock(resultLock);
+    return lastResult;
+}
+
+//==============================================================================
+bool DelayAligner::readNextHop()
+{
+    const int windowSize = frameBuffer.getNumSamples();
+    const int hopSize = windowSize / 2;
+
+    if (captureOverflowed.exchange(false))
+        frameFill = 0;
+
+    if (captureFifo.getNumReady() < hopSize)
+        return false;
+
+    // Slide the frame by half a window and append the next hop
+    for (int channel = 0; channel < 2; ++channel)
+    {
+        auto* frame = frameBuffer.getWritePointer(channel);
+        juce::FloatVectorOperations::copy(frame, frame + hopSize, windowSize - hopSize);
+    }
+
+    int start1, size1, start2, size2;
+    captureFifo.prepareToRead(hopSize, start1, size1, start2, size2);
+
+    for (int channel = 0; channel < 2; ++channel)
+    {
+        auto* destination = frameBuffer.getWritePointer(channel, windowSize - hopSize);
+        juce::FloatVectorOperations::copy(destination, captureBuffer.getReadPointer(channel, start1), size1);
+        juce::FloatVectorOperations::copy(destination + size1, captureBuffer.getReadPointer(channel, start2), size2);
+    }
+
+    captureFifo.finishedRead(size1 + size2);
+    frameFill = juce::jmin(windowSize, frameFill + hopSize);
+    return true;
+}
+
+void DelayAligner::publishResult(const CrossCorrelator::Result& result)
+{
+    {
+        const juce::SpinLock::ScopedLockType lock(resultLock);
+        lastResult = result;
+    }
+
+    triggerAsyncUpdate();
+}
+
+void DelayAligner::run()
+{
+    bool tracking = false;
+
+    while (! threadShouldExit())
+    {
+        const bool requested = analysisRequested.exchange(false);
+
+        if (! requested && ! continuousTracking.load())
+        {
+            tracking = false;
+            wait(100);
+            continue;
+        }
+
+        analysing.store(true);
+
+        // Start from an empty FIFO and frame so old audio can't leak into the result
+        captureFifo.finishedRead(captureFifo.getNumReady());
+        captureOverflowed.store(false);
+        frameFill = 0;
+
+        // A tracking burst keeps half the weight of the ones before it, so
+        // the result follows changes without jumping on one noisy burst
+        if (requested || ! tracking)
+            correlator->reset();
+        else
+            correlator->decay(0.5f);
+
+        capturing.store(true, std::memory_order_release);
+        const bool completed = analyseUntilResult();
+        capturing.store(false);
+
+        if (! analysisRequested.load())
+            analysing.store(false);
+
+        tracking = completed && continuousTracking.load();
+
+        if (tracking)
+            waitForNextBurst();
+    }
+}
+
+bool DelayAligner::analyseUntilResult()
+{
+    int framesSinceResult = 0;
+
+    while (! threadShouldExit())
+    {
+        if (analysisRequested.load())
+            return false;
+
+        if (! readNextHop())
+        {
+            wait(10);
+            continue;
+        }
+
+        if (frameFill < frameBuffer.getNumSamples())
+            continue;
+
+        correlator->addFrame(frameBuffer.getReadPointer(0), frameBuffer.getReadPointer(1));
+
+        if (++framesSinceResult < framesPerResult)
+            continue;
+
+        publishResult(correlator->computeResult(maxLag));
+        return true;
+    }
+
+    return false;
+}
+
+void DelayAligner::waitForNextBurst()
+{
+    // Capture is off meanwhile; a requested analysis or switching tracking
+    // off ends the wait early
+    const auto end = juce::Time::getMillisecondCounter() + static_cast<juce::uint32>(trackingIntervalMs.load());
+
+    while (! threadShouldExit() && ! analysisRequested.load() && continuousTracking.load()
+           && juce::Time::getMillisecondCounter() < end)
+        wait(50);
+}
+
+void DelayAligner::handleAsyncUpdate()
+{
+    if (onResult != nullptr)
+        onResult(getLastResult());
+}
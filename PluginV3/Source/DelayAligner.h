@@ -0,0 +1,100 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "CrossCorrelator.h"
+
+//==============================================================================
+/**
+ * Measures the delay and polarity between two signals in the background.
+ *
+ * The audio thread only downmixes its input into a lock-free FIFO while an
+ * analysis is running. A dedicated thread consumes the FIFO in half-window
+ * hops and feeds overlapping frames to a CrossCorrelator one at a time, so
+ * the cost is spread evenly; results are delivered on the message thread
+ * through onResult.
+ *
+ * Continuous tracking runs in bursts: one result's worth of audio is
+ * captured and analysed, then capture stays off for the tracking interval
+ * before the next burst, so most of the time the audio thread does nothing.
+ */
+class DelayAligner : private juce::Thread,
+                     private juce::AsyncUpdater
+{
+public:
+    //==============================================================================
+    DelayAligner();
+    ~DelayAligner() override;
+
+    //==============================================================================
+    /** Allocates the analysis buffers and starts the analysis thread.
+        Must not be called from the audio thread. */
+    void prepare(double sampleRate, int maxLagSamples);
+
+    /** Stops the analysis thread. */
+    void release();
+
+    /** Adds samples from both signals while an analysis is running, each one
+        downmixed from the given channels. Does nothing otherwise; safe to
+        call from the audio thread. */
+    void pushSamples(const float* const* firstChannels, int numFirstChannels,
+                     const float* const* secondChannels, int numSecondChannels,
+                     int numSamples) noexcept;
+
+    //==============================================================================
+    /** Requests a fresh analysis, discarding any frames gathered so far.
+        Safe to call from any thread. */
+    void requestAnalysis() noexcept;
+
+    /** Keeps re-analysing while enabled. Safe to call from any thread. */
+    void setContinuousTracking(bool shouldTrack) noexcept;
+
+    /** Sets the idle time between tracking bursts (2s by default). Safe to
+        call from any thread. */
+    void setTrackingInterval(double seconds) noexcept;
+
+    /** Returns true while audio is being captured or analysed. */
+    bool isAnalysing() const noexcept { return analysing.load(); }
+
+    /** Returns the most recent analysis result. */
+    CrossCorrelator::Result getLastResult() const;
+
+    /** Called on the message thread each time an analysis completes. */
+    std::function<void(const CrossCorrelator::Result&)> onResult;
+
+private:
+    //==============================================================================
+    void run() override;
+    void handleAsyncUpdate() override;
+
+    bool readNextHop();
+    bool analyseUntilResult();
+    void waitForNextBurst();
+    void publishResult(const CrossCorrelator::Result& result);
+
+    static void writeDownmix(float* destination, const float* const* channels, int numChannels,
+                             int sourceOffset, int numSamples) noexcept;
+
+    std::unique_ptr<CrossCorrelator> correlator;
+    int maxLag { 0 };
+    int framesPerResult { 1 };
+
+    // Downmixed input, written by the audio thread and read by the analysis thread
+    juce::AbstractFifo captureFifo { 1 };
+    juce::AudioBuffer<float> captureBuffer;
+    std::atomic<bool> capturing { false };
+    std::atomic<bool> captureOverflowed { false };
+
+    // Frame assembly on the analysis thread
+    juce::AudioBuffer<float> frameBuffer;
+    int frameFill { 0 };
+
+    std::atomic<bool> analysisRequested { false };
+    std::atomic<bool> continuousTracking { false };
+    std::atomic<int> trackingIntervalMs { 2000 };
+    std::atomic<bool> analysing { false };
+
+    juce::SpinLock resultLock;
+    CrossCorrelator::Result lastResult;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DelayAligner)
+};
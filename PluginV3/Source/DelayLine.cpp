@@ -0,0 +1,325 @@
+#include "DelayLine.h"
+#include "DspKernels.h"
+
+namespace
+{
+    struct WidthTap
+    {
+        float position;     // Fraction of the width delay
+        float gain;
+    };
+
+    constexpr WidthTap haasTaps[] = { { 1.0f, 1.0f } };
+
+    // Velvet-noise style decorrelator: unit energy, alternating signs so the
+    // low end doesn't build up, at spacings that avoid common ratios
+    constexpr WidthTap diffuseTaps[] = { { 0.23f, 0.62f }, { 0.47f, -0.52f }, { 0.71f, 0.45f }, { 1.0f, -0.38f } };
+}
+
+//==============================================================================
+void DelayLine::prepare(int maximumDelaySamples, int crossfadeLengthSamples, int maximumWidthDelaySamples)
+{
+    ownStorage.allocate(getArenaBytes(maximumDelaySamples, maximumWidthDelaySamples));
+    prepare(maximumDelaySamples, crossfadeLengthSamples, maximumWidthDelaySamples, ownStorage);
+}
+
+void DelayLine::prepare(int maximumDelaySamples, int crossfadeLengthSamples, int maximumWidthDelaySamples,
+                        AlignedArena& arena)
+{
+    if (&arena != &ownStorage)
+        ownStorage.release();
+
+    maximumDelay = juce::jmax(0, maximumDelaySamples);
+    maximumWidthDelay = juce::jmax(0, maximumWidthDelaySamples);
+    crossfadeLength = juce::jmax(1, crossfadeLengthSamples);
+    bufferLength = getBufferLength(maximumDelay, maximumWidthDelay);
+
+    for (auto& ring : rings)
+        ring = arena.take<float>(bufferLength);
+
+    // Without storage, process() leaves the audio untouched
+    if (rings[maxChannels - 1] == nullptr)
+        bufferLength = 0;
+
+    reset();
+}
+
+size_t DelayLine::getArenaBytes(int maximumDelaySamples, int maximumWidthDelaySamples) noexcept
+{
+    return maxChannels * AlignedArena::getBytes<float>(getBufferLength(maximumDelaySamples, maximumWidthDelaySamples));
+}
+
+int DelayLine::getBufferLength(int maximumDelaySamples, int maximumWidthDelaySamples) noexcept
+{
+    // Each sample is written before it is read, so the ring only needs the
+    // longest channel delay plus the widener taps behind it, plus the
+    // neighbour used for fractional interpolation
+    return juce::jmax(0, maximumDelaySamples) + juce::jmax(0, maximumWidthDelaySamples) + 2;
+}
+
+void DelayLine::reset() noexcept
+{
+    if (bufferLength > 0)
+        for (auto* ring : rings)
+            juce::FloatVectorOperations::clear(ring, bufferLength);
+
+    writePosition = 0;
+
+    for (auto& state : channelStates)
+        state = ChannelState();
+
+    widthMode = Width::off;
+    appliedWidth = 0.0f;
+    appliedWidthDelay = 0.0f;
+}
+
+bool DelayLine::isActive() const noexcept
+{
+    for (const auto& state : channelStates)
+        if (state.fading || state.currentDelay > 0.0f)
+            return true;
+
+    return appliedWidth > 0.0f;
+}
+
+//==============================================================================
+float DelayLine::readSample(const float* ring, int writeIndex, float delaySamples) const noexcept
+{
+    const int delayIntegerSamples = static_cast<int>(delaySamples);
+    const float delayFraction = delaySamples - static_cast<float>(delayIntegerSamples);
+
+    int readPos = writeIndex - delayIntegerSamples;
+    if (readPos < 0)
+        readPos += bufferLength;
+
+    // Linear interpolation towards the older neighbour
+    const int olderPos = readPos > 0 ? readPos - 1 : bufferLength - 1;
+    return ring[readPos] + delayFraction * (ring[olderPos] - ring[readPos]);
+}
+
+void DelayLine::readRun(const float* ring, int writeIndex, int delayIntegerSamples, float delayFraction,
+                        float* destination, int numSamples) const noexcept
+{
+    int readPos = writeIndex - delayIntegerSamples;
+    if (readPos < 0)
+        readPos += bufferLength;
+
+    for (int done = 0; done < numSamples;)
+    {
+        // The older neighbour of the first slot wraps to the end of the ring
+        if (readPos == 0)
+        {
+            destination[done++] = ring[0] + delayFraction * (ring[bufferLength - 1] - ring[0]);
+            readPos = 1;
+            continue;
+        }
+
+        // Same interpolation as readSample, over the slots up to the wrap
+        const int count = juce::jmin(numSamples - done, bufferLength - readPos);
+        DspKernels::interpolate(ring + readPos, destination + done, count, delayFraction);
+
+        done += count;
+        readPos += count;
+
+        if (readPos == bufferLength)
+            readPos = 0;
+    }
+}
+
+float DelayLine::readHead(ChannelState& state, const float* ring, int writeIndex) const noexcept
+{
+    if (! state.fading)
+        return readSample(ring, writeIndex, state.currentDelay);
+
+    const float fadeIn = static_cast<float>(state.fadePosition) / static_cast<float>(crossfadeLength);
+    const float oldHead = readSample(ring, writeIndex, state.currentDelay);
+    const float newHead = readSample(ring, writeIndex, state.nextDelay);
+
+    if (++state.fadePosition >= crossfadeLength)
+    {
+        state.currentDelay = state.nextDelay;
+        state.fading = false;
+    }
+
+    return oldHead + fadeIn * (newHead - oldHead);
+}
+
+void DelayLine::latchTarget(ChannelState& state, float targetDelaySamples) const noexcept
+{
+    const float target = juce::jlimit(0.0f, static_cast<float>(maximumDelay), targetDelaySamples);
+
+    // Latch a new target once any running crossfade has finished
+    if (! state.fading && std::abs(target - state.currentDelay) > 1.0e-4f)
+    {
+        state.nextDelay = target;
+        state.fadePosition = 0;
+        state.fading = true;
+    }
+}
+
+void DelayLine::process(float* const* channels, int numChannels, int numSamples,
+                        const float* targetDelaysSamples) noexcept
+{
+    if (bufferLength == 0)
+        return;
+
+    numChannels = juce::jmin(numChannels, maxChannels);
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        auto& state = channelStates[static_cast<size_t>(channel)];
+        auto* data = channels[channel];
+        auto* ring = rings[static_cast<size_t>(channel)];
+
+        latchTarget(state, targetDelaysSamples[channel]);
+
+        int writeIndex = writePosition;
+        int sample = 0;
+
+        // Crossfade between the old and the new read head
+        for (; state.fading && sample < numSamples; ++sample)
+        {
+            ring[writeIndex] = data[sample];
+
+            const float fadeIn = static_cast<float>(state.fadePosition) / static_cast<float>(crossfadeLength);
+            const float oldHead = readSample(ring, writeIndex, state.currentDelay);
+            const float newHead = readSample(ring, writeIndex, state.nextDelay);
+            data[sample] = oldHead + fadeIn * (newHead - oldHead);
+
+            if (++state.fadePosition >= crossfadeLength)
+            {
+                state.currentDelay = state.nextDelay;
+                state.fading = false;
+            }
+
+            if (++writeIndex == bufferLength)
+                writeIndex = 0;
+        }
+
+        if (state.currentDelay > 0.0f)
+        {
+            // Steady state: store a run of input, then read it back delayed in
+            // one pass. A run must not overwrite anything it still has to read.
+            const int delayIntegerSamples = static_cast<int>(state.currentDelay);
+            const float delayFraction = state.currentDelay - static_cast<float>(delayIntegerSamples);
+            const int maximumRun = bufferLength - delayIntegerSamples - 1;
+
+            while (sample < numSamples)
+            {
+                const int run = juce::jmin(numSamples - sample, bufferLength - writeIndex, maximumRun);
+                juce::FloatVectorOperations::copy(ring + writeIndex, data + sample, run);
+                readRun(ring, writeIndex, delayIntegerSamples, delayFraction, data + sample, run);
+
+                sample += run;
+                writeIndex += run;
+
+                if (writeIndex == bufferLength)
+                    writeIndex = 0;
+            }
+        }
+        else
+        {
+            // No delay: keep the history up to date so a later change
+            // crossfades from real audio, but leave the samples untouched
+            for (; sample < numSamples; ++sample)
+            {
+                ring[writeIndex] = data[sample];
+
+                if (++writeIndex == bufferLength)
+                    writeIndex = 0;
+            }
+        }
+    }
+
+    writePosition = (writePosition + numSamples) % bufferLength;
+}
+
+//==============================================================================
+void DelayLine::process(float* const* channels, int numChannels, int numSamples,
+                        const float* targetDelaysSamples, const Width& width) noexcept
+{
+    // A mode change fades the old taps out before the new ones fade in
+    if (width.mode != widthMode && appliedWidth <= 0.0f)
+        widthMode = width.mode;
+
+    const float targetWidth = width.mode == widthMode && widthMode != Width::off
+                                  ? juce::jlimit(0.0f, 1.0f, width.amount)
+                                  : 0.0f;
+
+    if (bufferLength == 0 || numChannels < 2 || (targetWidth <= 0.0f && appliedWidth <= 0.0f))
+    {
+        process(channels, numChannels, numSamples, targetDelaysSamples);
+        return;
+    }
+
+    const float targetWidthDelay = juce::jlimit(1.0f, static_cast<float>(juce::jmax(1, maximumWidthDelay)), width.delaySamples);
+
+    // Fading in: start the taps where they'll be rather than sweeping them there
+    if (appliedWidth <= 0.0f)
+        appliedWidthDelay = targetWidthDelay;
+
+    processWidth(channels[0], channels[1], numSamples, targetDelaysSamples, targetWidth, targetWidthDelay);
+}
+
+void DelayLine::processWidth(float* left, float* right, int numSamples, const float* targetDelaysSamples,
+                             float targetWidth, float targetWidthDelay) noexcept
+{
+    auto& leftState = channelStates[0];
+    auto& rightState = channelStates[1];
+    latchTarget(leftState, targetDelaysSamples[0]);
+    latchTarget(rightState, targetDelaysSamples[1]);
+
+    auto* leftRing = rings[0];
+    auto* rightRing = rings[1];
+
+    const auto* taps = widthMode == Width::diffuse ? diffuseTaps : haasTaps;
+    const int numTaps = widthMode == Width::diffuse ? static_cast<int>(std::size(diffuseTaps))
+                                                    : static_cast<int>(std::size(haasTaps));
+
+    // Ramp the side gain and the tap spacing over the block
+    const float widthStep = (targetWidth - appliedWidth) / static_cast<float>(numSamples);
+    const float delayStep = (targetWidthDelay - appliedWidthDelay) / static_cast<float>(numSamples);
+    float widthGain = appliedWidth;
+    float widthDelay = appliedWidthDelay;
+    int writeIndex = writePosition;
+
+    // Both channels in one pass: the delayed heads and the widener taps
+    // read the same freshly written ring positions
+    for (int sample = 0; sample < numSamples; ++sample)
+    {
+        leftRing[writeIndex] = left[sample];
+        rightRing[writeIndex] = right[sample];
+
+        const float leftOut = readHead(leftState, leftRing, writeIndex);
+        const float rightOut = readHead(rightState, rightRing, writeIndex);
+
+        // Taps sit behind each channel's own delay, so the side signal
+        // follows the aligned mid rather than the raw input
+        float side = 0.0f;
+
+        for (int tap = 0; tap < numTaps; ++tap)
+        {
+            const float tapDelay = widthDelay * taps[tap].position;
+            side += taps[tap].gain * (readSample(leftRing, writeIndex, leftState.currentDelay + tapDelay)
+                                      + readSample(rightRing, writeIndex, rightState.currentDelay + tapDelay));
+        }
+
+        side *= 0.5f * widthGain;
+        left[sample] = leftOut + side;
+        right[sample] = rightOut - side;
+
+        widthGain += widthStep;
+        widthDelay += delayStep;
+
+        if (++writeIndex == bufferLength)
+            writeIndex = 0;
+    }
+
+    appliedWidth = targetWidth;
+    appliedWidthDelay = targetWidthDelay;
+
+    if (appliedWidth <= 0.0f)
+        widthMode = Width::off;
+
+    writePosition = (writePosition + numSamples) % bufferLength;
+}
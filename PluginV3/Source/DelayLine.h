@@ -0,0 +1,114 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "AlignedArena.h"
+
+//==============================================================================
+/**
+ * A stereo delay line with independent per-channel delays.
+ *
+ * Storage is sized once in prepare() for the configured maximum delay, so
+ * memory grows with the range actually in use. It can come from the owner's
+ * AlignedArena, or from a block of the delay line's own. When a channel's delay
+ * changes, the output crossfades from the old read head to the new one
+ * instead of sweeping the read position (which would bend the pitch).
+ *
+ * The same ring also feeds an optional stereo widener: a Haas-delayed or
+ * diffused copy of the mid signal is added to L and subtracted from R, read
+ * from extra taps in the one fused loop that delays both channels. The mono
+ * sum is untouched, so widening never comb-filters in mono.
+ */
+class DelayLine
+{
+public:
+    //==============================================================================
+    static constexpr int maxChannels = 2;
+
+    struct Width
+    {
+        enum Mode
+        {
+            off,
+            haas,       // One tap at delaySamples
+            diffuse     // Sparse taps of alternating sign spread over delaySamples
+        };
+
+        Mode mode = off;
+        float amount = 0.0f;            // Gain of the injected side signal, 0 to 1
+        float delaySamples = 0.0f;
+    };
+
+    DelayLine() = default;
+
+    /** Allocates storage for delays of up to maximumDelaySamples, plus
+        maximumWidthDelaySamples for the widener taps, and clears it. Not
+        real-time safe. */
+    void prepare(int maximumDelaySamples, int crossfadeLengthSamples, int maximumWidthDelaySamples = 0);
+
+    /** As above, taking the storage from arena, which must have at least
+        getArenaBytes() left. The arena has to outlive the delay line's use. */
+    void prepare(int maximumDelaySamples, int crossfadeLengthSamples, int maximumWidthDelaySamples,
+                 AlignedArena& arena);
+
+    /** The arena space prepare() takes for the given delays. */
+    static size_t getArenaBytes(int maximumDelaySamples, int maximumWidthDelaySamples) noexcept;
+
+    /** Clears the stored audio and snaps all read heads to zero delay. */
+    void reset() noexcept;
+
+    /** Returns the longest delay the current storage can provide. */
+    int getMaximumDelaySamples() const noexcept { return maximumDelay; }
+
+    /** Returns true if any channel is delayed or still crossfading. */
+    bool isActive() const noexcept;
+
+    //==============================================================================
+    /** Delays each channel in place. Target delays are in samples and are
+        clamped to the allocated maximum; a changed target starts a crossfade. */
+    void process(float* const* channels, int numChannels, int numSamples,
+                 const float* targetDelaysSamples) noexcept;
+
+    /** As above, and widens stereo input. Width changes ramp over the block;
+        a mode change first fades the old mode out. */
+    void process(float* const* channels, int numChannels, int numSamples,
+                 const float* targetDelaysSamples, const Width& width) noexcept;
+
+private:
+    //==============================================================================
+    struct ChannelState
+    {
+        float currentDelay = 0.0f;
+        float nextDelay = 0.0f;
+        int fadePosition = 0;
+        bool fading = false;
+    };
+
+    float readSample(const float* ring, int writeIndex, float delaySamples) const noexcept;
+    void readRun(const float* ring, int writeIndex, int delayIntegerSamples, float delayFraction,
+                 float* destination, int numSamples) const noexcept;
+    float readHead(ChannelState& state, const float* ring, int writeIndex) const noexcept;
+    void latchTarget(ChannelState& state, float targetDelaySamples) const noexcept;
+    void processWidth(float* left, float* right, int numSamples, const float* targetDelaysSamples,
+                      float targetWidth, float targetWidthDelay) noexcept;
+
+    static int getBufferLength(int maximumDelaySamples, int maximumWidthDelaySamples) noexcept;
+
+    // Used when prepared without an arena
+    AlignedArena ownStorage;
+
+    std::array<float*, maxChannels> rings {};
+    int bufferLength { 0 };
+    int writePosition { 0 };
+    int maximumDelay { 0 };
+    int maximumWidthDelay { 0 };
+    int crossfadeLength { 1 };
+
+    // Widener state at the end of the last block
+    Width::Mode widthMode { Width::off };
+    float appliedWidth { 0.0f };
+    float appliedWidthDelay { 0.0f };
+
+    std::array<ChannelState, maxChannels> channelStates;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DelayLine)
+};
@@ -0,0 +1,66 @@
+#include "DiagnosticsPanel.h"
+
+//==============================================================================
+DiagnosticsPanel::DiagnosticsPanel()
+{
+    setInterceptsMouseClicks(false, false);
+}
+
+void DiagnosticsPanel::update(const StageProfiler& profiler, int blockSize)
+{
+    for (int stage = 0; stage < StageProfiler::numStages; ++stage)
+        statistics[static_cast<size_t>(stage)] = profiler.getStatistics(static_cast<StageProfiler::Stage>(stage));
+
+    instanceNumber = profiler.getInstanceNumber();
+    currentBlockSize = blockSize;
+    repaint();
+}
+
+//==============================================================================
+void DiagnosticsPanel::paint(juce::Graphics& g)
+{
+    auto bounds = getLocalBounds().toFloat();
+
+    g.setColour(juce::Colours::black.withAlpha(0.85f));
+    g.fillRoundedRectangle(bounds, 5.0f);
+    g.setColour(juce::Colours::white.withAlpha(0.3f));
+    g.drawRoundedRectangle(bounds.reduced(0.5f), 5.0f, 1.0f);
+
+    auto area = getLocalBounds().reduced(10, 6);
+    const int rowHeight = 18;
+
+    g.setFont(juce::Font(juce::FontOptions(juce::Font::getDefaultMonospacedFontName(), 12.0f, juce::Font::plain)));
+
+    const auto& totalStatistics = statistics[StageProfiler::total];
+    g.setColour(juce::Colours::orange);
+    g.drawText("Instance #" + juce::String(instanceNumber) + " - last " + juce::String(totalStatistics.numBlocks)
+                   + " blocks of " + juce::String(currentBlockSize) + " samples, " + StageProfiler::getTickUnit(),
+               area.removeFromTop(rowHeight), juce::Justification::centredLeft, true);
+
+    // Stage, then min/mean/p99 per block and mean per sample
+    auto drawRow = [&](const juce::String& name, const juce::StringArray& values, juce::Colour colour)
+    {
+        auto row = area.removeFromTop(rowHeight);
+        g.setColour(colour);
+        g.drawText(name, row.removeFromLeft(row.getWidth() / 4), juce::Justification::centredLeft, true);
+
+        const int columnWidth = row.getWidth() / values.size();
+        for (const auto& value : values)
+            g.drawText(value, row.removeFromLeft(columnWidth), juce::Justification::centredRight, true);
+    };
+
+    drawRow("Stage", { "min", "mean", "p99", "mean/sample" }, juce::Colours::grey);
+
+    for (int stage = 0; stage < StageProfiler::numStages; ++stage)
+    {
+        const auto& stats = statistics[static_cast<size_t>(stage)];
+        const double perSample = currentBlockSize > 0 ? stats.meanTicks / currentBlockSize : 0.0;
+
+        drawRow(StageProfiler::getStageName(static_cast<StageProfiler::Stage>(stage)),
+                { juce::String(juce::roundToInt(stats.minTicks)),
+                  juce::String(juce::roundToInt(stats.meanTicks)),
+                  juce::String(juce::roundToInt(stats.p99Ticks)),
+                  juce::String(perSample, 1) },
+                stage == StageProfiler::total ? juce::Colours::white : juce::Colours::lightgrey);
+    }
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "StageProfiler.h"
+
+//==============================================================================
+/**
+ * Hidden overlay listing per-stage processBlock timings for this instance.
+ * Toggled from the editor with Ctrl/Cmd+Shift+D or an Alt-click on the title.
+ */
+class DiagnosticsPanel : public juce::Component
+{
+public:
+    //==============================================================================
+    DiagnosticsPanel();
+
+    void paint(juce::Graphics& g) override;
+
+    /** Refreshes the figures from the profiler; blockSize converts block
+        totals to per-sample values. */
+    void update(const StageProfiler& profiler, int blockSize);
+
+private:
+    std::array<StageProfiler::Statistics, StageProfiler::numStages> statistics;
+    int instanceNumber = 0;
+    int currentBlockSize = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DiagnosticsPanel)
+};
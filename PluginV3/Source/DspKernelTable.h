@@ -0,0 +1,50 @@
+#pragma once
+
+#include "DspKernels.h"
+
+#if defined (__x86_64__) || defined (_M_X64) || defined (__i386__) || defined (_M_IX86)
+ #define PLUGINV3_KERNELS_X86 1
+#else
+ #define PLUGINV3_KERNELS_X86 0
+#endif
+
+// Compiles one function for an instruction set the rest of the build may not
+// assume. MSVC accepts any intrinsic without this, and never fuses them, so it
+// needs neither the attribute nor the barrier that keeps a product rounded.
+#if defined (_MSC_VER) && ! defined (__clang__)
+ #define PLUGINV3_TARGET(isa)
+ #define PLUGINV3_ROUNDING_BARRIER(value, constraint)
+#else
+ #define PLUGINV3_TARGET(isa) __attribute__((target(isa)))
+ #define PLUGINV3_ROUNDING_BARRIER(value, constraint) asm ("" : constraint (value))
+#endif
+
+//==============================================================================
+/**
+ * One instruction set's implementation of the DspKernels functions. Internal
+ * to DspKernels*.cpp; everything else calls through DspKernels.h.
+ */
+struct DspKernelTable
+{
+    DspKernels::InstructionSet instructionSet;
+
+    void (*applyGain)(float* data, int numSamples, float gain) noexcept;
+    void (*applyGainRamp)(float* data, int numSamples, float startGain, float endGain) noexcept;
+    void (*applyMidSideGain)(float* left, float* right, int numSamples, float midGain, float sideGain) noexcept;
+    void (*applyMidSideGainRamp)(float* left, float* right, int numSamples,
+                                 float startMidGain, float endMidGain,
+                                 float startSideGain, float endSideGain) noexcept;
+    float (*findPeak)(const float* data, int numSamples) noexcept;
+    void (*measureLevels)(const float* left, const float* right, int numSamples, DspKernels::Levels& levels) noexcept;
+    void (*interpolate)(const float* source, float* destination, int numSamples, float fraction) noexcept;
+};
+
+#if PLUGINV3_KERNELS_X86
+// Defined in DspKernelsSSE2.cpp, DspKernelsAVX2.cpp and DspKernelsAVX512.cpp
+namespace DspKernels
+{
+    namespace sse2   { const DspKernelTable& getKernelTable() noexcept; }
+    namespace avx2   { const DspKernelTable& getKernelTable() noexcept; }
+    namespace avx512 { const DspKernelTable& getKernelTable() noexcept; }
+}
+#endif
@@ -0,0 +1,322 @@
+#include "DspKernelTable.h"
+
+#if PLUGINV3_KERNELS_X86
+ #if JUCE_MSVC
+  #include <intrin.h>
+ #else
+  #include <cpuid.h>
+ #endif
+#endif
+
+//==============================================================================
+// The plain C++ kernels: the reference every variant has to match, and what
+// runs on other architectures
+namespace
+{
+    void applyGain(float* data, int numSamples, float gain) noexcept
+    {
+        for (int sample = 0; sample < numSamples; ++sample)
+            data[sample] *= gain;
+    }
+
+    void applyGainRamp(float* data, int numSamples, float startGain, float endGain) noexcept
+    {
+        if (numSamples <= 0)
+            return;
+
+        const float increment = (endGain - startGain) / static_cast<float>(numSamples);
+
+        for (int sample = 0; sample < numSamples - 1; ++sample)
+            data[sample] *= startGain + increment * static_cast<float>(sample + 1);
+
+        data[numSamples - 1] *= endGain;
+    }
+
+    void applyMidSideGain(float* left, float* right, int numSamples, float midGain, float sideGain) noexcept
+    {
+        for (int sample = 0; sample < numSamples; ++sample)
+        {
+            // Convert L/R to Mid/Side
+            const float mid = (left[sample] + right[sample]) * 0.5f;
+            const float side = (right[sample] - left[sample]) * 0.5f;
+
+            // Apply Mid/Side gain
+            const float processedMid = mid * midGain;
+            const float processedSide = side * sideGain;
+
+            // Convert back to L/R
+            left[sample] = processedMid - processedSide;
+            right[sample] = processedMid + processedSide;
+        }
+    }
+
+    void applyMidSideGainRamp(float* left, float* right, int numSamples,
+                              float startMidGain, float endMidGain,
+                              float startSideGain, float endSideGain) noexcept
+    {
+        if (numSamples <= 0)
+            return;
+
+        const float midIncrement = (endMidGain - startMidGain) / static_cast<float>(numSamples);
+        const float sideIncrement = (endSideGain - startSideGain) / static_cast<float>(numSamples);
+
+        for (int sample = 0; sample < numSamples; ++sample)
+        {
+            const bool last = sample == numSamples - 1;
+            const float midGain = last ? endMidGain : startMidGain + midIncrement * static_cast<float>(sample + 1);
+            const float sideGain = last ? endSideGain : startSideGain + sideIncrement * static_cast<float>(sample + 1);
+
+            const float mid = (left[sample] + right[sample]) * 0.5f;
+            const float side = (right[sample] - left[sample]) * 0.5f;
+
+            const float processedMid = mid * midGain;
+            const float processedSide = side * sideGain;
+
+            left[sample] = processedMid - processedSide;
+            right[sample] = processedMid + processedSide;
+        }
+    }
+
+    float findPeak(const float* data, int numSamples) noexcept
+    {
+        float peak = 0.0f;
+
+        for (int sample = 0; sample < numSamples; ++sample)
+            peak = std::max(peak, std::abs(data[sample]));
+
+        return peak;
+    }
+
+    void measureLevels(const float* left, const float* right, int numSamples, DspKernels::Levels& levels) noexcept
+    {
+        levels = {};
+
+        for (int sample = 0; sample < numSamples; ++sample)
+        {
+            const float l = left[sample];
+            levels.peak[0] = std::max(levels.peak[0], std::abs(l));
+            levels.sumSquares[0] += static_cast<double>(l) * l;
+
+            if (right != nullptr)
+            {
+                const float r = right[sample];
+                levels.peak[1] = std::max(levels.peak[1], std::abs(r));
+                levels.sumSquares[1] += static_cast<double>(r) * r;
+                levels.sumProduct += static_cast<double>(l) * r;
+            }
+        }
+    }
+
+    void interpolate(const float* source, float* destination, int numSamples, float fraction) noexcept
+    {
+        for (int sample = 0; sample < numSamples; ++sample)
+            destination[sample] = source[sample] + fraction * (source[sample - 1] - source[sample]);
+    }
+
+    constexpr DspKernelTable genericKernels {
+        DspKernels::InstructionSet::generic,
+        applyGain,
+        applyGainRamp,
+        applyMidSideGain,
+        applyMidSideGainRamp,
+        findPeak,
+        measureLevels,
+        interpolate
+    };
+
+    //==============================================================================
+    // Until the first prepareToPlay, the kernels every machine can run
+    std::atomic<const DspKernelTable*> activeKernels { &genericKernels };
+    std::atomic<int> forcedInstructionSet { -1 };
+
+    const DspKernelTable& getKernelTable(DspKernels::InstructionSet instructionSet) noexcept
+    {
+        switch (instructionSet)
+        {
+           #if PLUGINV3_KERNELS_X86
+            case DspKernels::InstructionSet::sse2:      return DspKernels::sse2::getKernelTable();
+            case DspKernels::InstructionSet::avx2:      return DspKernels::avx2::getKernelTable();
+            case DspKernels::InstructionSet::avx512:    return DspKernels::avx512::getKernelTable();
+           #endif
+            default:                                    return genericKernels;
+        }
+    }
+
+   #if PLUGINV3_KERNELS_X86
+    struct CpuidRegisters
+    {
+        unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+    };
+
+    CpuidRegisters readCpuid(unsigned int leaf) noexcept
+    {
+        CpuidRegisters registers;
+
+       #if JUCE_MSVC
+        int values[4] {};
+        __cpuidex(values, static_cast<int>(leaf), 0);
+        registers = { static_cast<unsigned int>(values[0]), static_cast<unsigned int>(values[1]),
+                      static_cast<unsigned int>(values[2]), static_cast<unsigned int>(values[3]) };
+       #else
+        __cpuid_count(leaf, 0, registers.eax, registers.ebx, registers.ecx, registers.edx);
+       #endif
+
+        return registers;
+    }
+
+    /** The register state the OS saves on a context switch (XCR0). Only valid
+        once CPUID has reported OSXSAVE. */
+    juce::uint64 readEnabledRegisterState() noexcept
+    {
+       #if JUCE_MSVC
+        return _xgetbv(0);
+       #else
+        unsigned int low = 0, high = 0;
+        asm volatile ("xgetbv" : "=a" (low), "=d" (high) : "c" (0));
+        return (static_cast<juce::uint64>(high) << 32) | low;
+       #endif
+    }
+   #endif
+
+    DspKernels::InstructionSet detectInstructionSet() noexcept
+    {
+       #if PLUGINV3_KERNELS_X86
+        using DspKernels::InstructionSet;
+
+        const auto maximumLeaf = readCpuid(0).eax;
+        const auto features = readCpuid(1);
+
+        if ((features.edx & (1u << 26)) == 0)
+            return InstructionSet::generic;
+
+        // A CPU with AVX still can't use it unless the OS saves the wider registers
+        const bool hasAvx = (features.ecx & (1u << 27)) != 0 && (features.ecx & (1u << 28)) != 0;
+
+        if (! hasAvx || maximumLeaf < 7)
+            return InstructionSet::sse2;
+
+        const auto registerState = readEnabledRegisterState();
+        const auto extendedFeatures = readCpuid(7);
+
+        if ((registerState & 0x6) != 0x6 || (extendedFeatures.ebx & (1u << 5)) == 0)
+            return InstructionSet::sse2;
+
+        // AVX-512F, with the opmask and all 32 ZMM registers saved
+        if ((extendedFeatures.ebx & (1u << 16)) != 0 && (registerState & 0xe6) == 0xe6)
+            return InstructionSet::avx512;
+
+        return InstructionSet::avx2;
+       #else
+        return DspKernels::InstructionSet::generic;
+       #endif
+    }
+}
+
+//==============================================================================
+DspKernels::InstructionSet DspKernels::getBestInstructionSet() noexcept
+{
+    static const auto best = detectInstructionSet();
+    return best;
+}
+
+DspKernels::InstructionSet DspKernels::selectInstructionSet() noexcept
+{
+    auto instructionSet = getBestInstructionSet();
+    const int forced = forcedInstructionSet.load();
+
+    if (forced >= 0)
+    {
+        instructionSet = juce::jmin(instructionSet, static_cast<InstructionSet>(forced));
+    }
+    else
+    {
+        InstructionSet fromEnvironment;
+
+        if (parseInstructionSet(juce::SystemStats::getEnvironmentVariable("PLUGINV3_ISA", {}), fromEnvironment))
+            instructionSet = juce::jmin(instructionSet, fromEnvironment);
+    }
+
+    activeKernels.store(&getKernelTable(instructionSet));
+    return instructionSet;
+}
+
+void DspKernels::forceInstructionSet(InstructionSet instructionSet) noexcept
+{
+    forcedInstructionSet.store(static_cast<int>(instructionSet));
+}
+
+void DspKernels::clearForcedInstructionSet() noexcept
+{
+    forcedInstructionSet.store(-1);
+}
+
+DspKernels::InstructionSet DspKernels::getActiveInstructionSet() noexcept
+{
+    return activeKernels.load()->instructionSet;
+}
+
+const char* DspKernels::getInstructionSetName(InstructionSet instructionSet) noexcept
+{
+    switch (instructionSet)
+    {
+        case InstructionSet::sse2:      return "sse2";
+        case InstructionSet::avx2:      return "avx2";
+        case InstructionSet::avx512:    return "avx512";
+        case InstructionSet::generic:
+        default:                        return "generic";
+    }
+}
+
+bool DspKernels::parseInstructionSet(const juce::String& name, InstructionSet& instructionSet) noexcept
+{
+    for (const auto candidate : { InstructionSet::generic, InstructionSet::sse2, InstructionSet::avx2, InstructionSet::avx512 })
+    {
+        if (name.trim().equalsIgnoreCase(getInstructionSetName(candidate)))
+        {
+            instructionSet = candidate;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+//==============================================================================
+void DspKernels::applyGain(float* data, int numSamples, float gain, bool invertPolarity) noexcept
+{
+    activeKernels.load(std::memory_order_relaxed)->applyGain(data, numSamples, invertPolarity ? -gain : gain);
+}
+
+void DspKernels::applyGainRamp(float* data, int numSamples, float startGain, float endGain) noexcept
+{
+    activeKernels.load(std::memory_order_relaxed)->applyGainRamp(data, numSamples, startGain, endGain);
+}
+
+void DspKernels::applyMidSideGain(float* left, float* right, int numSamples, float midGain, float sideGain) noexcept
+{
+    activeKernels.load(std::memory_order_relaxed)->applyMidSideGain(left, right, numSamples, midGain, sideGain);
+}
+
+void DspKernels::applyMidSideGainRamp(float* left, float* right, int numSamples,
+                                      float startMidGain, float endMidGain,
+                                      float startSideGain, float endSideGain) noexcept
+{
+    activeKernels.load(std::memory_order_relaxed)->applyMidSideGainRamp(left, right, numSamples,
+                                                                        startMidGain, endMidGain,
+                                                                        startSideGain, endSideGain);
+}
+
+float DspKernels::findPeak(const float* data, int numSamples) noexcept
+{
+    return activeKernels.load(std::memory_order_relaxed)->findPeak(data, numSamples);
+}
+
+void DspKernels::measureLevels(const float* left, const float* right, int numSamples, Levels& levels) noexcept
+{
+    activeKernels.load(std::memory_order_relaxed)->measureLevels(left, right, numSamples, levels);
+}
+
+void DspKernels::interpolate(const float* source, float* destination, int numSamples, float fraction) noexcept
+{
+    activeKernels.load(std::memory_order_relaxed)->interpolate(source, destination, numSamples, fraction);
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+ * The per-sample stages of PluginV3AudioProcessor::processBlock as free
+ * functions, so they can be timed and checked in isolation. The channel
+ * delay stage is DelayLine::process.
+ *
+ * Every kernel is compiled for several instruction sets in the same binary,
+ * and the widest one the CPU and OS support is selected at prepareToPlay.
+ * The variants round exactly like the generic code (no fused multiply-adds),
+ * so the audio output is bit-identical whichever one runs. Only the meter
+ * sums may differ in their last bits, as the lanes add in a different order.
+ */
+namespace DspKernels
+{
+    //==============================================================================
+    enum class InstructionSet
+    {
+        generic,    // Plain C++, whatever the compiler makes of it
+        sse2,
+        avx2,
+        avx512
+    };
+
+    /** The widest instruction set this build and machine can run. */
+    InstructionSet getBestInstructionSet() noexcept;
+
+    /** Picks the kernels for the best instruction set, or for the forced one
+        if set (see forceInstructionSet), and returns the choice. Called from
+        prepareToPlay; the kernels are shared by every instance in the process. */
+    InstructionSet selectInstructionSet() noexcept;
+
+    /** Forces a variant for testing and comparisons. A set wider than the
+        machine supports falls back to the best it does. Takes effect with the
+        next selectInstructionSet. Without a forced set, the PLUGINV3_ISA
+        environment variable (generic, sse2, avx2 or avx512) is used, if set. */
+    void forceInstructionSet(InstructionSet instructionSet) noexcept;
+    void clearForcedInstructionSet() noexcept;
+
+    /** The instruction set of the kernels currently in use. */
+    InstructionSet getActiveInstructionSet() noexcept;
+
+    const char* getInstructionSetName(InstructionSet instructionSet) noexcept;
+
+    /** Parses a name returned by getInstructionSetName. */
+    bool parseInstructionSet(const juce::String& name, InstructionSet& instructionSet) noexcept;
+
+    //==============================================================================
+    /** Multiplies a channel by gain, negated when invertPolarity is set.
+        Negating the gain is bit-identical to inverting and then scaling. */
+    void applyGain(float* data, int numSamples, float gain, bool invertPolarity) noexcept;
+
+    /** Multiplies a channel by a gain moving linearly from startGain towards
+        endGain, reaching endGain on the last sample. */
+    void applyGainRamp(float* data, int numSamples, float startGain, float endGain) noexcept;
+
+    /** Scales the mid and side components of a stereo pair in place. */
+    void applyMidSideGain(float* left, float* right, int numSamples, float midGain, float sideGain) noexcept;
+
+    /** As applyMidSideGain, with both gains ramping linearly over the block. */
+    void applyMidSideGainRamp(float* left, float* right, int numSamples,
+                              float startMidGain, float endMidGain,
+                              float startSideGain, float endSideGain) noexcept;
+
+    /** Returns the largest absolute sample value. */
+    float findPeak(const float* data, int numSamples) noexcept;
+
+    /** Peaks, sums of squares and the L/R product sum of a block, in one pass.
+        With right == nullptr only the left values are filled in. */
+    struct Levels
+    {
+        float peak[2] {};
+        double sumSquares[2] {};
+        double sumProduct = 0.0;
+    };
+
+    void measureLevels(const float* left, const float* right, int numSamples, Levels& levels) noexcept;
+
+    /** Reads a fractional delay: destination[i] = source[i] + fraction *
+        (source[i - 1] - source[i]), so source[-1] must be readable. This is
+        the steady-state read of DelayLine. */
+    void interpolate(const float* source, float* destination, int numSamples, float fraction) noexcept;
+}
@@ -0,0 +1,80 @@
+#include "DspKernelTable.h"
+
+#if PLUGINV3_KERNELS_X86
+
+#include <immintrin.h>
+
+#define PLUGINV3_KERNEL_TARGET PLUGINV3_TARGET("avx2")
+#define PLUGINV3_KERNEL_SET DspKernels::InstructionSet::avx2
+
+namespace DspKernels
+{
+namespace avx2
+{
+    //==============================================================================
+    /** The vector operations DspKernelsVariant.h is written in, eight lanes
+        wide. FMA is left out of the target on purpose: see rounded(). */
+    struct Vec
+    {
+        using Float = __m256;
+        static constexpr int size = 8;
+
+        PLUGINV3_KERNEL_TARGET static Float load(const float* source) noexcept     { return _mm256_loadu_ps(source); }
+        PLUGINV3_KERNEL_TARGET static void store(float* destination, Float value) noexcept { _mm256_storeu_ps(destination, value); }
+        PLUGINV3_KERNEL_TARGET static Float set(float value) noexcept              { return _mm256_set1_ps(value); }
+        PLUGINV3_KERNEL_TARGET static Float add(Float a, Float b) noexcept         { return _mm256_add_ps(a, b); }
+        PLUGINV3_KERNEL_TARGET static Float sub(Float a, Float b) noexcept         { return _mm256_sub_ps(a, b); }
+        PLUGINV3_KERNEL_TARGET static Float mul(Float a, Float b) noexcept         { return _mm256_mul_ps(a, b); }
+        PLUGINV3_KERNEL_TARGET static Float abs(Float a) noexcept                  { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+        PLUGINV3_KERNEL_TARGET static Float max(Float a, Float b) noexcept         { return _mm256_max_ps(a, b); }
+
+        PLUGINV3_KERNEL_TARGET static Float steps() noexcept
+        {
+            return _mm256_setr_ps(1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f);
+        }
+
+        PLUGINV3_KERNEL_TARGET static float maxOf(Float a) noexcept
+        {
+            auto half = _mm_max_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1));
+            half = _mm_max_ps(half, _mm_movehl_ps(half, half));
+            half = _mm_max_ss(half, _mm_shuffle_ps(half, half, 1));
+            return _mm_cvtss_f32(half);
+        }
+
+        PLUGINV3_KERNEL_TARGET static float maxAbs(float value, float peak) noexcept
+        {
+            const float magnitude = value < 0.0f ? -value : value;
+            return magnitude > peak ? magnitude : peak;
+        }
+
+        PLUGINV3_KERNEL_TARGET static Float rounded(Float value) noexcept  { PLUGINV3_ROUNDING_BARRIER(value, "+x"); return value; }
+        PLUGINV3_KERNEL_TARGET static float rounded(float value) noexcept  { PLUGINV3_ROUNDING_BARRIER(value, "+x"); return value; }
+
+        struct Sums
+        {
+            PLUGINV3_KERNEL_TARGET Sums() noexcept : low(_mm256_setzero_pd()), high(_mm256_setzero_pd()) {}
+
+            PLUGINV3_KERNEL_TARGET void addProducts(Float a, Float b) noexcept
+            {
+                low = _mm256_add_pd(low, _mm256_mul_pd(_mm256_cvtps_pd(_mm256_castps256_ps128(a)),
+                                                       _mm256_cvtps_pd(_mm256_castps256_ps128(b))));
+                high = _mm256_add_pd(high, _mm256_mul_pd(_mm256_cvtps_pd(_mm256_extractf128_ps(a, 1)),
+                                                         _mm256_cvtps_pd(_mm256_extractf128_ps(b, 1))));
+            }
+
+            PLUGINV3_KERNEL_TARGET double total() const noexcept
+            {
+                const auto sum = _mm256_add_pd(low, high);
+                const auto half = _mm_add_pd(_mm256_castpd256_pd128(sum), _mm256_extractf128_pd(sum, 1));
+                return _mm_cvtsd_f64(_mm_add_sd(half, _mm_unpackhi_pd(half, half)));
+            }
+
+            __m256d low, high;
+        };
+    };
+
+   #include "DspKernelsVariant.h"
+}
+}
+
+#endif
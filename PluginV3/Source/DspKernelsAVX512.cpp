@@ -0,0 +1,75 @@
+#include "DspKernelTable.h"
+
+#if PLUGINV3_KERNELS_X86
+
+#include <immintrin.h>
+
+#define PLUGINV3_KERNEL_TARGET PLUGINV3_TARGET("avx512f")
+#define PLUGINV3_KERNEL_SET DspKernels::InstructionSet::avx512
+
+namespace DspKernels
+{
+namespace avx512
+{
+    //==============================================================================
+    /** The vector operations DspKernelsVariant.h is written in, sixteen lanes
+        wide. AVX-512F implies FMA, so rounded() matters most here. */
+    struct Vec
+    {
+        using Float = __m512;
+        static constexpr int size = 16;
+
+        PLUGINV3_KERNEL_TARGET static Float load(const float* source) noexcept     { return _mm512_loadu_ps(source); }
+        PLUGINV3_KERNEL_TARGET static void store(float* destination, Float value) noexcept { _mm512_storeu_ps(destination, value); }
+        PLUGINV3_KERNEL_TARGET static Float set(float value) noexcept              { return _mm512_set1_ps(value); }
+        PLUGINV3_KERNEL_TARGET static Float add(Float a, Float b) noexcept         { return _mm512_add_ps(a, b); }
+        PLUGINV3_KERNEL_TARGET static Float sub(Float a, Float b) noexcept         { return _mm512_sub_ps(a, b); }
+        PLUGINV3_KERNEL_TARGET static Float mul(Float a, Float b) noexcept         { return _mm512_mul_ps(a, b); }
+        PLUGINV3_KERNEL_TARGET static Float abs(Float a) noexcept                  { return _mm512_abs_ps(a); }
+        PLUGINV3_KERNEL_TARGET static Float max(Float a, Float b) noexcept         { return _mm512_max_ps(a, b); }
+
+        PLUGINV3_KERNEL_TARGET static Float steps() noexcept
+        {
+            return _mm512_setr_ps(1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f,
+                                  9.0f, 10.0f, 11.0f, 12.0f, 13.0f, 14.0f, 15.0f, 16.0f);
+        }
+
+        PLUGINV3_KERNEL_TARGET static float maxOf(Float a) noexcept                { return _mm512_reduce_max_ps(a); }
+
+        PLUGINV3_KERNEL_TARGET static float maxAbs(float value, float peak) noexcept
+        {
+            const float magnitude = value < 0.0f ? -value : value;
+            return magnitude > peak ? magnitude : peak;
+        }
+
+        PLUGINV3_KERNEL_TARGET static Float rounded(Float value) noexcept  { PLUGINV3_ROUNDING_BARRIER(value, "+v"); return value; }
+        PLUGINV3_KERNEL_TARGET static float rounded(float value) noexcept  { PLUGINV3_ROUNDING_BARRIER(value, "+v"); return value; }
+
+        struct Sums
+        {
+            PLUGINV3_KERNEL_TARGET Sums() noexcept : low(_mm512_setzero_pd()), high(_mm512_setzero_pd()) {}
+
+            PLUGINV3_KERNEL_TARGET void addProducts(Float a, Float b) noexcept
+            {
+                low = _mm512_add_pd(low, _mm512_mul_pd(_mm512_cvtps_pd(lowHalf(a)), _mm512_cvtps_pd(lowHalf(b))));
+                high = _mm512_add_pd(high, _mm512_mul_pd(_mm512_cvtps_pd(highHalf(a)), _mm512_cvtps_pd(highHalf(b))));
+            }
+
+            PLUGINV3_KERNEL_TARGET double total() const noexcept  { return _mm512_reduce_add_pd(_mm512_add_pd(low, high)); }
+
+            // Only AVX-512DQ can extract eight floats directly
+            PLUGINV3_KERNEL_TARGET static __m256 lowHalf(Float a) noexcept   { return _mm512_castps512_ps256(a); }
+            PLUGINV3_KERNEL_TARGET static __m256 highHalf(Float a) noexcept
+            {
+                return _mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(a), 1));
+            }
+
+            __m512d low, high;
+        };
+    };
+
+   #include "DspKernelsVariant.h"
+}
+}
+
+#endif
@@ -0,0 +1,76 @@
+#include "DspKernelTable.h"
+
+#if PLUGINV3_KERNELS_X86
+
+#include <immintrin.h>
+
+#define PLUGINV3_KERNEL_TARGET PLUGINV3_TARGET("sse2")
+#define PLUGINV3_KERNEL_SET DspKernels::InstructionSet::sse2
+
+namespace DspKernels
+{
+namespace sse2
+{
+    //==============================================================================
+    /** The vector operations DspKernelsVariant.h is written in, four lanes wide. */
+    struct Vec
+    {
+        using Float = __m128;
+        static constexpr int size = 4;
+
+        PLUGINV3_KERNEL_TARGET static Float load(const float* source) noexcept     { return _mm_loadu_ps(source); }
+        PLUGINV3_KERNEL_TARGET static void store(float* destination, Float value) noexcept { _mm_storeu_ps(destination, value); }
+        PLUGINV3_KERNEL_TARGET static Float set(float value) noexcept              { return _mm_set1_ps(value); }
+        PLUGINV3_KERNEL_TARGET static Float add(Float a, Float b) noexcept         { return _mm_add_ps(a, b); }
+        PLUGINV3_KERNEL_TARGET static Float sub(Float a, Float b) noexcept         { return _mm_sub_ps(a, b); }
+        PLUGINV3_KERNEL_TARGET static Float mul(Float a, Float b) noexcept         { return _mm_mul_ps(a, b); }
+        PLUGINV3_KERNEL_TARGET static Float abs(Float a) noexcept                  { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+
+        /** Lane-wise a > b ? a : b, so a NaN in a is skipped. */
+        PLUGINV3_KERNEL_TARGET static Float max(Float a, Float b) noexcept         { return _mm_max_ps(a, b); }
+
+        /** 1, 2, 3, 4: the ramp steps of the lanes. */
+        PLUGINV3_KERNEL_TARGET static Float steps() noexcept                       { return _mm_setr_ps(1.0f, 2.0f, 3.0f, 4.0f); }
+
+        PLUGINV3_KERNEL_TARGET static float maxOf(Float a) noexcept
+        {
+            a = _mm_max_ps(a, _mm_movehl_ps(a, a));
+            a = _mm_max_ss(a, _mm_shuffle_ps(a, a, 1));
+            return _mm_cvtss_f32(a);
+        }
+
+        PLUGINV3_KERNEL_TARGET static float maxAbs(float value, float peak) noexcept
+        {
+            const float magnitude = value < 0.0f ? -value : value;
+            return magnitude > peak ? magnitude : peak;
+        }
+
+        PLUGINV3_KERNEL_TARGET static Float rounded(Float value) noexcept  { PLUGINV3_ROUNDING_BARRIER(value, "+x"); return value; }
+        PLUGINV3_KERNEL_TARGET static float rounded(float value) noexcept  { PLUGINV3_ROUNDING_BARRIER(value, "+x"); return value; }
+
+        /** Double-precision sums of lane products. */
+        struct Sums
+        {
+            PLUGINV3_KERNEL_TARGET Sums() noexcept : low(_mm_setzero_pd()), high(_mm_setzero_pd()) {}
+
+            PLUGINV3_KERNEL_TARGET void addProducts(Float a, Float b) noexcept
+            {
+                low = _mm_add_pd(low, _mm_mul_pd(_mm_cvtps_pd(a), _mm_cvtps_pd(b)));
+                high = _mm_add_pd(high, _mm_mul_pd(_mm_cvtps_pd(_mm_movehl_ps(a, a)), _mm_cvtps_pd(_mm_movehl_ps(b, b))));
+            }
+
+            PLUGINV3_KERNEL_TARGET double total() const noexcept
+            {
+                const auto sum = _mm_add_pd(low, high);
+                return _mm_cvtsd_f64(_mm_add_sd(sum, _mm_unpackhi_pd(sum, sum)));
+            }
+
+            __m128d low, high;
+        };
+    };
+
+   #include "DspKernelsVariant.h"
+}
+}
+
+#endif
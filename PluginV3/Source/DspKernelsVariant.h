@@ -0,0 +1,220 @@
+// The DspKernels bodies for one x86 instruction set. Deliberately no include
+// guard: each DspKernels<ISA>.cpp includes it once, inside its own namespace,
+// after defining
+//
+//   PLUGINV3_KERNEL_TARGET   the function attribute enabling the instruction set
+//   PLUGINV3_KERNEL_SET      its DspKernels::InstructionSet
+//   Vec                      the vector operations (see DspKernelsSSE2.cpp)
+//
+// Products that feed an addition pass through Vec::rounded, which stops the
+// compiler fusing them into multiply-adds, so every variant rounds exactly
+// like the generic code, tails included. Peaks skip NaNs the way std::max
+// does in the generic code.
+
+namespace
+{
+    PLUGINV3_KERNEL_TARGET void applyGain(float* data, int numSamples, float gain) noexcept
+    {
+        const auto gains = Vec::set(gain);
+        int sample = 0;
+
+        for (; sample + Vec::size <= numSamples; sample += Vec::size)
+            Vec::store(data + sample, Vec::mul(Vec::load(data + sample), gains));
+
+        for (; sample < numSamples; ++sample)
+            data[sample] *= gain;
+    }
+
+    PLUGINV3_KERNEL_TARGET void applyGainRamp(float* data, int numSamples, float startGain, float endGain) noexcept
+    {
+        if (numSamples <= 0)
+            return;
+
+        const float increment = (endGain - startGain) / static_cast<float>(numSamples);
+        const auto starts = Vec::set(startGain);
+        const auto increments = Vec::set(increment);
+        const int numRamped = numSamples - 1;
+        int sample = 0;
+
+        // Gain at sample n is start + increment * (n + 1), as in the generic code
+        for (; sample + Vec::size <= numRamped; sample += Vec::size)
+        {
+            const auto steps = Vec::add(Vec::set(static_cast<float>(sample)), Vec::steps());
+            const auto gains = Vec::add(starts, Vec::rounded(Vec::mul(increments, steps)));
+            Vec::store(data + sample, Vec::mul(Vec::load(data + sample), gains));
+        }
+
+        for (; sample < numRamped; ++sample)
+            data[sample] *= startGain + Vec::rounded(increment * static_cast<float>(sample + 1));
+
+        data[numSamples - 1] *= endGain;
+    }
+
+    PLUGINV3_KERNEL_TARGET void applyMidSideGain(float* left, float* right, int numSamples, float midGain, float sideGain) noexcept
+    {
+        const auto halves = Vec::set(0.5f);
+        const auto midGains = Vec::set(midGain);
+        const auto sideGains = Vec::set(sideGain);
+        int sample = 0;
+
+        for (; sample + Vec::size <= numSamples; sample += Vec::size)
+        {
+            const auto l = Vec::load(left + sample);
+            const auto r = Vec::load(right + sample);
+            const auto mid = Vec::rounded(Vec::mul(Vec::mul(Vec::add(l, r), halves), midGains));
+            const auto side = Vec::rounded(Vec::mul(Vec::mul(Vec::sub(r, l), halves), sideGains));
+            Vec::store(left + sample, Vec::sub(mid, side));
+            Vec::store(right + sample, Vec::add(mid, side));
+        }
+
+        for (; sample < numSamples; ++sample)
+        {
+            const float mid = Vec::rounded((left[sample] + right[sample]) * 0.5f * midGain);
+            const float side = Vec::rounded((right[sample] - left[sample]) * 0.5f * sideGain);
+            left[sample] = mid - side;
+            right[sample] = mid + side;
+        }
+    }
+
+    PLUGINV3_KERNEL_TARGET void applyMidSideGainRamp(float* left, float* right, int numSamples,
+                                                     float startMidGain, float endMidGain,
+                                                     float startSideGain, float endSideGain) noexcept
+    {
+        if (numSamples <= 0)
+            return;
+
+        const float midIncrement = (endMidGain - startMidGain) / static_cast<float>(numSamples);
+        const float sideIncrement = (endSideGain - startSideGain) / static_cast<float>(numSamples);
+        const auto halves = Vec::set(0.5f);
+        const int numRamped = numSamples - 1;
+        int sample = 0;
+
+        for (; sample + Vec::size <= numRamped; sample += Vec::size)
+        {
+            const auto steps = Vec::add(Vec::set(static_cast<float>(sample)), Vec::steps());
+            const auto midGains = Vec::add(Vec::set(startMidGain), Vec::rounded(Vec::mul(Vec::set(midIncrement), steps)));
+            const auto sideGains = Vec::add(Vec::set(startSideGain), Vec::rounded(Vec::mul(Vec::set(sideIncrement), steps)));
+
+            const auto l = Vec::load(left + sample);
+            const auto r = Vec::load(right + sample);
+            const auto mid = Vec::rounded(Vec::mul(Vec::mul(Vec::add(l, r), halves), midGains));
+            const auto side = Vec::rounded(Vec::mul(Vec::mul(Vec::sub(r, l), halves), sideGains));
+            Vec::store(left + sample, Vec::sub(mid, side));
+            Vec::store(right + sample, Vec::add(mid, side));
+        }
+
+        for (; sample < numSamples; ++sample)
+        {
+            const bool last = sample == numRamped;
+            const float midGain = last ? endMidGain : startMidGain + Vec::rounded(midIncrement * static_cast<float>(sample + 1));
+            const float sideGain = last ? endSideGain : startSideGain + Vec::rounded(sideIncrement * static_cast<float>(sample + 1));
+
+            const float mid = Vec::rounded((left[sample] + right[sample]) * 0.5f * midGain);
+            const float side = Vec::rounded((right[sample] - left[sample]) * 0.5f * sideGain);
+            left[sample] = mid - side;
+            right[sample] = mid + side;
+        }
+    }
+
+    PLUGINV3_KERNEL_TARGET float findPeak(const float* data, int numSamples) noexcept
+    {
+        auto peaks = Vec::set(0.0f);
+        int sample = 0;
+
+        for (; sample + Vec::size <= numSamples; sample += Vec::size)
+            peaks = Vec::max(Vec::abs(Vec::load(data + sample)), peaks);
+
+        float peak = Vec::maxOf(peaks);
+
+        for (; sample < numSamples; ++sample)
+            peak = Vec::maxAbs(data[sample], peak);
+
+        return peak;
+    }
+
+    PLUGINV3_KERNEL_TARGET void measureLevels(const float* left, const float* right, int numSamples,
+                                              DspKernels::Levels& levels) noexcept
+    {
+        // Products of two floats are exact in double, so only the order of the sums varies
+        auto peaksLeft = Vec::set(0.0f), peaksRight = Vec::set(0.0f);
+        Vec::Sums sumsLeft, sumsRight, sumsProduct;
+        int sample = 0;
+
+        if (right == nullptr)
+        {
+            for (; sample + Vec::size <= numSamples; sample += Vec::size)
+            {
+                const auto l = Vec::load(left + sample);
+                peaksLeft = Vec::max(Vec::abs(l), peaksLeft);
+                sumsLeft.addProducts(l, l);
+            }
+        }
+        else
+        {
+            for (; sample + Vec::size <= numSamples; sample += Vec::size)
+            {
+                const auto l = Vec::load(left + sample);
+                const auto r = Vec::load(right + sample);
+                peaksLeft = Vec::max(Vec::abs(l), peaksLeft);
+                peaksRight = Vec::max(Vec::abs(r), peaksRight);
+                sumsLeft.addProducts(l, l);
+                sumsRight.addProducts(r, r);
+                sumsProduct.addProducts(l, r);
+            }
+        }
+
+        levels = {};
+        levels.peak[0] = Vec::maxOf(peaksLeft);
+        levels.peak[1] = Vec::maxOf(peaksRight);
+        levels.sumSquares[0] = sumsLeft.total();
+        levels.sumSquares[1] = sumsRight.total();
+        levels.sumProduct = sumsProduct.total();
+
+        for (; sample < numSamples; ++sample)
+        {
+            const float l = left[sample];
+            levels.peak[0] = Vec::maxAbs(l, levels.peak[0]);
+            levels.sumSquares[0] += static_cast<double>(l) * l;
+
+            if (right != nullptr)
+            {
+                const float r = right[sample];
+                levels.peak[1] = Vec::maxAbs(r, levels.peak[1]);
+                levels.sumSquares[1] += static_cast<double>(r) * r;
+                levels.sumProduct += static_cast<double>(l) * r;
+            }
+        }
+    }
+
+    PLUGINV3_KERNEL_TARGET void interpolate(const float* source, float* destination, int numSamples, float fraction) noexcept
+    {
+        const auto fractions = Vec::set(fraction);
+        int sample = 0;
+
+        for (; sample + Vec::size <= numSamples; sample += Vec::size)
+        {
+            const auto newer = Vec::load(source + sample);
+            const auto older = Vec::load(source + sample - 1);
+            Vec::store(destination + sample, Vec::add(newer, Vec::rounded(Vec::mul(fractions, Vec::sub(older, newer)))));
+        }
+
+        for (; sample < numSamples; ++sample)
+            destination[sample] = source[sample] + Vec::rounded(fraction * (source[sample - 1] - source[sample]));
+    }
+}
+
+const DspKernelTable& getKernelTable() noexcept
+{
+    static constexpr DspKernelTable table {
+        PLUGINV3_KERNEL_SET,
+        applyGain,
+        applyGainRamp,
+        applyMidSideGain,
+        applyMidSideGainRamp,
+        findPeak,
+        measureLevels,
+        interpolate
+    };
+
+    return table;
+}
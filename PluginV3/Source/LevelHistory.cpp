@@ -0,0 +1,144 @@
+#include "LevelHistory.h"
+
+//==============================================================================
+void LevelHistory::Bin::merge(const Bin& other) noexcept
+{
+    peakMin = juce::jmin(peakMin, other.peakMin);
+    peakMax = juce::jmax(peakMax, other.peakMax);
+    rmsMin = juce::jmin(rmsMin, other.rmsMin);
+    rmsMax = juce::jmax(rmsMax, other.rmsMax);
+    correlationMin = juce::jmin(correlationMin, other.correlationMin);
+    correlationMax = juce::jmax(correlationMax, other.correlationMax);
+}
+
+//==============================================================================
+LevelHistory::LevelHistory()
+{
+    reset();
+}
+
+void LevelHistory::reset() noexcept
+{
+    for (auto& level : levels)
+    {
+        level.bins.fill(Bin());
+        level.numWritten = 0;
+        level.pending = Bin();
+        level.numPending = 0;
+    }
+
+    currentBin = Bin();
+    currentSeconds = 0.0;
+    currentEnergy.fill(0.0);
+}
+
+double LevelHistory::getBinSeconds(int level) noexcept
+{
+    double seconds = baseBinSeconds;
+
+    for (int i = 0; i < level; ++i)
+        seconds *= mergeFactor;
+
+    return seconds;
+}
+
+double LevelHistory::getMaximumDurationSeconds() noexcept
+{
+    return getBinSeconds(numLevels - 1) * binsPerLevel;
+}
+
+//==============================================================================
+void LevelHistory::addFrame(const MeterFrame& frame) noexcept
+{
+    double remaining = frame.getDurationSeconds();
+
+    if (remaining <= 0.0)
+        return;
+
+    Bin frameBin;
+    frameBin.peakMin = frameBin.peakMax = frame.getMaxPeak();
+    frameBin.correlationMin = frameBin.correlationMax = frame.correlation;
+
+    // A long block spreads over several base bins, a short one shares a bin
+    // with its neighbours
+    while (remaining > 0.0)
+    {
+        const double taken = juce::jmin(remaining, baseBinSeconds - currentSeconds);
+
+        currentBin.merge(frameBin);
+        currentSeconds += taken;
+        remaining -= taken;
+
+        for (int channel = 0; channel < MeterFrame::maxChannels; ++channel)
+            currentEnergy[static_cast<size_t>(channel)] += static_cast<double>(frame.rms[channel]) * frame.rms[channel] * taken;
+
+        if (currentSeconds < baseBinSeconds * 0.999)
+            continue;
+
+        // RMS of the louder channel over exactly this bin
+        const double energy = juce::jmax(currentEnergy[0], currentEnergy[1]);
+        currentBin.rmsMin = currentBin.rmsMax = static_cast<float>(std::sqrt(energy / currentSeconds));
+
+        commitBin(0, currentBin);
+
+        currentBin = Bin();
+        currentSeconds = 0.0;
+        currentEnergy.fill(0.0);
+    }
+}
+
+void LevelHistory::commitBin(int levelIndex, const Bin& bin) noexcept
+{
+    auto& level = levels[static_cast<size_t>(levelIndex)];
+    level.bins[static_cast<size_t>(level.numWritten % binsPerLevel)] = bin;
+    ++level.numWritten;
+
+    if (levelIndex + 1 >= numLevels)
+        return;
+
+    level.pending.merge(bin);
+
+    if (++level.numPending == mergeFactor)
+    {
+        const Bin merged = level.pending;
+        level.pending = Bin();
+        level.numPending = 0;
+        commitBin(levelIndex + 1, merged);
+    }
+}
+
+//==============================================================================
+void LevelHistory::render(double durationSeconds, Bin* columns, int numColumns) const noexcept
+{
+    if (numColumns <= 0 || durationSeconds <= 0.0)
+        return;
+
+    const double columnSeconds = durationSeconds / numColumns;
+
+    // The coarsest level that still gives every column at least one bin
+    int levelIndex = 0;
+
+    while (levelIndex + 1 < numLevels && getBinSeconds(levelIndex + 1) <= columnSeconds)
+        ++levelIndex;
+
+    const auto& level = levels[static_cast<size_t>(levelIndex)];
+    const double binSeconds = getBinSeconds(levelIndex);
+    const juce::int64 available = juce::jmin(level.numWritten, static_cast<juce::int64>(binsPerLevel));
+
+    for (int column = 0; column < numColumns; ++column)
+    {
+        // Age range of the column, counted back from the newest bin
+        const double oldestAge = durationSeconds - column * columnSeconds;
+        const double newestAge = oldestAge - columnSeconds;
+
+        const auto newestBin = static_cast<juce::int64>(std::floor(newestAge / binSeconds));
+        const auto oldestBin = juce::jmax(newestBin, static_cast<juce::int64>(std::ceil(oldestAge / binSeconds)) - 1);
+
+        Bin result;
+
+        for (auto age = newestBin; age <= oldestBin && age < available; ++age)
+            result.merge(level.bins[static_cast<size_t>((level.numWritten - 1 - age) % binsPerLevel)]);
+
+        columns[column] = result;
+    }
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "MeterFrame.h"
+
+//==============================================================================
+/**
+ * Scrolling history of peak, RMS and correlation in constant memory.
+ *
+ * Meter frames are resampled into 10 ms base bins, each holding the min/max
+ * envelope of the three readings (RMS is exact over the bin). Every level
+ * of the pyramid merges four bins of the level below and keeps its own ring
+ * of the most recent bins, so the four levels cover about 10 s, 41 s,
+ * 2.7 min and 11 min. Drawing a time span picks the coarsest level that
+ * still has at least one bin per column, which bounds the work per column
+ * however far the view is zoomed out.
+ *
+ * Not thread-safe: frames are added and history is read on the same
+ * (message) thread.
+ */
+class LevelHistory
+{
+public:
+    //==============================================================================
+    static constexpr double baseBinSeconds = 0.01;
+    static constexpr int binsPerLevel = 1024;
+    static constexpr int numLevels = 4;
+    static constexpr int mergeFactor = 4;
+
+    /** Min/max envelope of the readings over a stretch of time. */
+    struct Bin
+    {
+        float peakMin = std::numeric_limits<float>::max();
+        float peakMax = 0.0f;
+        float rmsMin = std::numeric_limits<float>::max();
+        float rmsMax = 0.0f;
+        float correlationMin = 1.0f;
+        float correlationMax = -1.0f;
+
+        bool isEmpty() const noexcept { return peakMin > peakMax; }
+        void merge(const Bin& other) noexcept;
+    };
+
+    LevelHistory();
+
+    /** Forgets everything. */
+    void reset() noexcept;
+
+    /** Adds a processed block. */
+    void addFrame(const MeterFrame& frame) noexcept;
+
+    /** Longest span the history can show, in seconds. */
+    static double getMaximumDurationSeconds() noexcept;
+
+    /** Fills one bin per column covering the last durationSeconds, oldest
+        first. Columns before the start of the history are left empty. */
+    void render(double durationSeconds, Bin* columns, int numColumns) const noexcept;
+
+private:
+    //==============================================================================
+    struct Level
+    {
+        std::array<Bin, binsPerLevel> bins;
+        juce::int64 numWritten = 0;     // Total bins ever written
+        Bin pending;                    // Partial merge for the next level up
+        int numPending = 0;
+    };
+
+    static double getBinSeconds(int level) noexcept;
+    void commitBin(int level, const Bin& bin) noexcept;
+
+    std::array<Level, numLevels> levels;
+
+    // The base bin being filled
+    Bin currentBin;
+    double currentSeconds { 0.0 };
+    std::array<double, MeterFrame::maxChannels> currentEnergy {};
+};
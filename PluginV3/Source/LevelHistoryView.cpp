@@ -0,0 +1,111 @@
+#include "LevelHistoryView.h"
+
+namespace
+{
+    constexpr double spanSeconds[] = { 10.0, 30.0, 60.0, 300.0, 600.0 };
+    constexpr float floorDb = -60.0f;
+
+    /** Maps a linear level onto the -60 to 0 dB scale, 0 to 1. */
+    float levelToProportion(float level) noexcept
+    {
+        return juce::jmap(juce::Decibels::gainToDecibels(level, floorDb), floorDb, 0.0f, 0.0f, 1.0f);
+    }
+}
+
+//==============================================================================
+LevelHistoryView::LevelHistoryView(const LevelHistory& historyToShow)
+    : history(historyToShow)
+{
+    // Item IDs follow the span index + 1
+    spanBox.addItemList({ "10 s", "30 s", "1 min", "5 min", "10 min" }, 1);
+    spanBox.setSelectedId(1, juce::dontSendNotification);
+    spanBox.setTooltip("Time span of the level history");
+    spanBox.onChange = [this]() {
+        const int index = spanBox.getSelectedId() - 1;
+
+        if (juce::isPositiveAndBelow(index, static_cast<int>(std::size(spanSeconds))))
+            setDurationSeconds(spanSeconds[index]);
+    };
+    addAndMakeVisible(spanBox);
+}
+
+void LevelHistoryView::setDurationSeconds(double newDurationSeconds)
+{
+    durationSeconds = juce::jlimit(1.0, LevelHistory::getMaximumDurationSeconds(), newDurationSeconds);
+    repaint();
+}
+
+void LevelHistoryView::resized()
+{
+    spanBox.setBounds(getLocalBounds().removeFromTop(24).removeFromRight(80).reduced(2));
+
+    // One bin per pixel column
+    columns.resize(static_cast<size_t>(juce::jmax(0, getWidth() - 12)));
+}
+
+//==============================================================================
+void LevelHistoryView::paint(juce::Graphics& g)
+{
+    auto bounds = getLocalBounds().toFloat();
+
+    g.setColour(juce::Colours::black.withAlpha(0.85f));
+    g.fillRoundedRectangle(bounds, 5.0f);
+    g.setColour(juce::Colours::white.withAlpha(0.3f));
+    g.drawRoundedRectangle(bounds.reduced(0.5f), 5.0f, 1.0f);
+
+    auto area = getLocalBounds().reduced(6);
+    g.setColour(juce::Colours::lightgrey);
+    g.setFont(12.0f);
+    g.drawText("Level history", area.removeFromTop(18), juce::Justification::centredLeft, true);
+
+    auto correlationArea = area.removeFromBottom(area.getHeight() / 5).toFloat();
+    area.removeFromBottom(4);
+    auto levelArea = area.toFloat();
+
+    // dB grid
+    g.setColour(juce::Colours::white.withAlpha(0.15f));
+    for (float db : { -6.0f, -12.0f, -24.0f, -48.0f })
+    {
+        const float y = levelArea.getBottom() - levelArea.getHeight() * juce::jmap(db, floorDb, 0.0f, 0.0f, 1.0f);
+        g.drawHorizontalLine(juce::roundToInt(y), levelArea.getX(), levelArea.getRight());
+    }
+
+    g.drawHorizontalLine(juce::roundToInt(correlationArea.getCentreY()), correlationArea.getX(), correlationArea.getRight());
+
+    const int numColumns = juce::jmin(static_cast<int>(columns.size()), static_cast<int>(levelArea.getWidth()));
+
+    if (numColumns <= 0)
+        return;
+
+    history.render(durationSeconds, columns.data(), numColumns);
+
+    auto levelY = [&levelArea](float level)
+    {
+        return levelArea.getBottom() - levelArea.getHeight() * levelToProportion(level);
+    };
+
+    auto correlationY = [&correlationArea](float correlation)
+    {
+        return correlationArea.getCentreY() - correlationArea.getHeight() * 0.5f * correlation;
+    };
+
+    for (int column = 0; column < numColumns; ++column)
+    {
+        const auto& bin = columns[static_cast<size_t>(column)];
+
+        if (bin.isEmpty())
+            continue;
+
+        const float x = levelArea.getX() + static_cast<float>(column);
+
+        g.setColour(juce::Colours::orange.withAlpha(0.7f));
+        g.drawVerticalLine(juce::roundToInt(x), levelY(bin.peakMax), juce::jmax(levelY(bin.peakMin), levelY(bin.peakMax) + 1.0f));
+
+        g.setColour(juce::Colours::green.brighter(0.2f));
+        g.drawVerticalLine(juce::roundToInt(x), levelY(bin.rmsMax), juce::jmax(levelY(bin.rmsMin), levelY(bin.rmsMax) + 1.0f));
+
+        g.setColour(bin.correlationMin < 0.0f ? juce::Colours::red : juce::Colours::cyan);
+        g.drawVerticalLine(juce::roundToInt(x), correlationY(bin.correlationMax),
+                           juce::jmax(correlationY(bin.correlationMin), correlationY(bin.correlationMax) + 1.0f));
+    }
+}
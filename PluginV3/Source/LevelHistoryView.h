@@ -0,0 +1,34 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "LevelHistory.h"
+
+//==============================================================================
+/**
+ * Scrolling view of a LevelHistory: the peak envelope and RMS band of the
+ * louder channel on a dB scale, with the L/R correlation range in a strip
+ * underneath. The span is chosen from 10 s to 10 min.
+ */
+class LevelHistoryView : public juce::Component
+{
+public:
+    //==============================================================================
+    explicit LevelHistoryView(const LevelHistory& history);
+
+    void paint(juce::Graphics& g) override;
+    void resized() override;
+
+    /** The time span shown across the width, in seconds. */
+    void setDurationSeconds(double newDurationSeconds);
+    double getDurationSeconds() const noexcept { return durationSeconds; }
+
+private:
+    //==============================================================================
+    const LevelHistory& history;
+    double durationSeconds { 10.0 };
+
+    juce::ComboBox spanBox;
+    std::vector<LevelHistory::Bin> columns;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LevelHistoryView)
+};
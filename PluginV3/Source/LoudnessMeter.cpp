@@ -0,0 +1,220 @@
+#include "LoudnessMeter.h"
+
+//==============================================================================
+void KWeightingFilter::prepare(double sampleRate)
+{
+    // Bilinear designs of the BS.1770 reference filters, which are only
+    // specified as coefficients at 48kHz
+    {
+        const double f0 = 1681.974450955533;
+        const double gainDb = 3.999843853973347;
+        const double q = 0.7071752369554196;
+
+        const double k = std::tan(juce::MathConstants<double>::pi * f0 / sampleRate);
+        const double vh = std::pow(10.0, gainDb / 20.0);
+        const double vb = std::pow(vh, 0.4996667741545416);
+        const double a0 = 1.0 + k / q + k * k;
+
+        shelf.b0 = (vh + vb * k / q + k * k) / a0;
+        shelf.b1 = 2.0 * (k * k - vh) / a0;
+        shelf.b2 = (vh - vb * k / q + k * k) / a0;
+        shelf.a1 = 2.0 * (k * k - 1.0) / a0;
+        shelf.a2 = (1.0 - k / q + k * k) / a0;
+    }
+
+    {
+        const double f0 = 38.13547087602444;
+        const double q = 0.5003270373238773;
+
+        const double k = std::tan(juce::MathConstants<double>::pi * f0 / sampleRate);
+        const double a0 = 1.0 + k / q + k * k;
+
+        highPass.b0 = 1.0;
+        highPass.b1 = -2.0;
+        highPass.b2 = 1.0;
+        highPass.a1 = 2.0 * (k * k - 1.0) / a0;
+        highPass.a2 = (1.0 - k / q + k * k) / a0;
+    }
+
+    reset();
+}
+
+void KWeightingFilter::reset() noexcept
+{
+    shelf.z1 = shelf.z2 = 0.0;
+    highPass.z1 = highPass.z2 = 0.0;
+}
+
+//==============================================================================
+void LoudnessHistogram::reset() noexcept
+{
+    blockCounts.fill(0);
+    energySums.fill(0.0);
+    totalBlocks = 0;
+}
+
+void LoudnessHistogram::addBlock(double energy) noexcept
+{
+    const float loudness = LoudnessMeter::energyToLoudness(energy);
+
+    if (loudness <= minimumLoudness)
+        return;
+
+    const int bin = juce::jlimit(0, numBins - 1,
+                                 static_cast<int>((loudness - minimumLoudness) * 10.0f));
+
+    ++blockCounts[static_cast<size_t>(bin)];
+    energySums[static_cast<size_t>(bin)] += energy;
+    ++totalBlocks;
+}
+
+void LoudnessHistogram::merge(const LoudnessHistogram& other) noexcept
+{
+    for (size_t bin = 0; bin < blockCounts.size(); ++bin)
+    {
+        blockCounts[bin] += other.blockCounts[bin];
+        energySums[bin] += other.energySums[bin];
+    }
+
+    totalBlocks += other.totalBlocks;
+}
+
+float LoudnessHistogram::getIntegratedLoudness() const noexcept
+{
+    if (totalBlocks == 0)
+        return -std::numeric_limits<float>::infinity();
+
+    double totalEnergy = 0.0;
+    for (const auto energy : energySums)
+        totalEnergy += energy;
+
+    // Relative gate 10 LU below the absolute-gated level; bins are 0.1 LU wide
+    const float relativeGate = LoudnessMeter::energyToLoudness(totalEnergy / static_cast<double>(totalBlocks)) - 10.0f;
+    const int firstBin = juce::jlimit(0, numBins,
+                                      static_cast<int>(std::ceil((relativeGate - minimumLoudness) * 10.0f)));
+
+    juce::int64 gatedBlocks = 0;
+    double gatedEnergy = 0.0;
+
+    for (int bin = firstBin; bin < numBins; ++bin)
+    {
+        gatedBlocks += blockCounts[static_cast<size_t>(bin)];
+        gatedEnergy += energySums[static_cast<size_t>(bin)];
+    }
+
+    if (gatedBlocks == 0)
+        return -std::numeric_limits<float>::infinity();
+
+    return LoudnessMeter::energyToLoudness(gatedEnergy / static_cast<double>(gatedBlocks));
+}
+
+//==============================================================================
+void LoudnessMeter::prepare(double sampleRate)
+{
+    for (auto& filter : filters)
+        filter.prepare(sampleRate);
+
+    samplesPerSubBlock = getSamplesPerSubBlock(sampleRate);
+    reset();
+}
+
+void LoudnessMeter::reset() noexcept
+{
+    for (auto& filter : filters)
+        filter.reset();
+
+    subBlockFill = 0;
+    subBlockEnergy = 0.0;
+    subBlockEnergies.fill(0.0);
+    subBlockIndex = 0;
+    numCompleteSubBlocks = 0;
+    histogram.reset();
+}
+
+int LoudnessMeter::getSamplesPerSubBlock(double sampleRate) noexcept
+{
+    return juce::jmax(1, juce::roundToInt(sampleRate * 0.1));
+}
+
+float LoudnessMeter::energyToLoudness(double energy) noexcept
+{
+    if (energy <= 0.0)
+        return -std::numeric_limits<float>::infinity();
+
+    return static_cast<float>(-0.691 + 10.0 * std::log10(energy));
+}
+
+double LoudnessMeter::getRecentEnergy(int numRecentSubBlocks) const noexcept
+{
+    const int count = juce::jmin(numRecentSubBlocks, numCompleteSubBlocks);
+    if (count == 0)
+        return 0.0;
+
+    double sum = 0.0;
+    int index = subBlockIndex;
+
+    for (int i = 0; i < count; ++i)
+    {
+        index = (index == 0 ? numSubBlocks : index) - 1;
+        sum += subBlockEnergies[static_cast<size_t>(index)];
+    }
+
+    // Windows are averaged over their full length, so a meter that has only
+    // just started reads low rather than jumping
+    return sum / static_cast<double>(numRecentSubBlocks);
+}
+
+//==============================================================================
+void LoudnessMeter::process(const float* const* channels, int numChannels, int numSamples) noexcept
+{
+    numChannels = juce::jmin(numChannels, maxChannels);
+    int position = 0;
+
+    while (position < numSamples)
+    {
+        const int count = juce::jmin(numSamples - position, getSamplesToSubBlockEnd());
+        double sums[maxChannels] = {};
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            auto& filter = filters[static_cast<size_t>(channel)];
+            const float* data = channels[channel] + position;
+            double sum = 0.0;
+
+            for (int i = 0; i < count; ++i)
+            {
+                const double weighted = filter.processSample(data[i]);
+                sum += weighted * weighted;
+            }
+
+            sums[channel] = sum;
+        }
+
+        addWeightedSums(sums, numChannels, count);
+        position += count;
+    }
+}
+
+void LoudnessMeter::addWeightedSums(const double* channelSums, int numChannels, int numSamples) noexcept
+{
+    jassert(numSamples <= getSamplesToSubBlockEnd());
+
+    // Left and right both carry a weight of 1.0
+    for (int channel = 0; channel < juce::jmin(numChannels, maxChannels); ++channel)
+        subBlockEnergy += channelSums[channel];
+
+    subBlockFill += numSamples;
+
+    if (subBlockFill < samplesPerSubBlock)
+        return;
+
+    subBlockEnergies[static_cast<size_t>(subBlockIndex)] = subBlockEnergy / static_cast<double>(samplesPerSubBlock);
+    subBlockIndex = (subBlockIndex + 1) % numSubBlocks;
+    numCompleteSubBlocks = juce::jmin(numCompleteSubBlocks + 1, numSubBlocks);
+    subBlockFill = 0;
+    subBlockEnergy = 0.0;
+
+    // 400ms gating blocks with 75% overlap, one per completed sub-block
+    if (numCompleteSubBlocks >= 4)
+        histogram.addBlock(getRecentEnergy(4));
+}
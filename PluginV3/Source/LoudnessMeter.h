@@ -0,0 +1,160 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+ * ITU-R BS.1770 K-weighting: a high shelf followed by a high-pass, both as
+ * double-precision biquads designed for the actual sample rate.
+ */
+class KWeightingFilter
+{
+public:
+    //==============================================================================
+    void prepare(double sampleRate);
+    void reset() noexcept;
+
+    /** Filters one sample. */
+    inline float processSample(float input) noexcept
+    {
+        const double shelved = shelf.process(static_cast<double>(input));
+        return static_cast<float>(highPass.process(shelved));
+    }
+
+    //==============================================================================
+    struct Biquad
+    {
+        double b0 = 1.0, b1 = 0.0, b2 = 0.0, a1 = 0.0, a2 = 0.0;
+        double z1 = 0.0, z2 = 0.0;
+
+        // Transposed direct form II
+        inline double process(double x) noexcept
+        {
+            const double y = b0 * x + z1;
+            z1 = b1 * x - a1 * y + z2;
+            z2 = b2 * x - a2 * y;
+            return y;
+        }
+    };
+
+    /** The designed stages, for code filtering many signals with the same
+        coefficients (BatchProcessor). */
+    const Biquad& getShelf() const noexcept { return shelf; }
+    const Biquad& getHighPass() const noexcept { return highPass; }
+
+private:
+    Biquad shelf;
+    Biquad highPass;
+};
+
+//==============================================================================
+/**
+ * Histogram of gating block energies used for integrated loudness.
+ *
+ * Blocks are binned at 0.1 LU between -70 and +5 LUFS, keeping the exact
+ * energy sum of each bin. Memory stays fixed however long the programme is,
+ * and histograms from separate segments can be merged exactly.
+ */
+class LoudnessHistogram
+{
+public:
+    //==============================================================================
+    static constexpr float minimumLoudness = -70.0f;
+    static constexpr float maximumLoudness = 5.0f;
+    static constexpr int numBins = 750;
+
+    void reset() noexcept;
+
+    /** Adds one gating block by its mean square energy. Blocks below the
+        absolute gate are ignored. */
+    void addBlock(double energy) noexcept;
+
+    /** Adds all blocks from another histogram. */
+    void merge(const LoudnessHistogram& other) noexcept;
+
+    /** Returns the gated integrated loudness in LUFS, or -infinity if no
+        block passed the absolute gate. */
+    float getIntegratedLoudness() const noexcept;
+
+    /** Returns the number of blocks above the absolute gate. */
+    juce::int64 getNumBlocks() const noexcept { return totalBlocks; }
+
+private:
+    std::array<juce::int64, numBins> blockCounts {};
+    std::array<double, numBins> energySums {};
+    juce::int64 totalBlocks { 0 };
+};
+
+//==============================================================================
+/**
+ * ITU-R BS.1770 / EBU R128 loudness meter for mono or stereo signals.
+ *
+ * Energy is accumulated in 100ms sub-blocks, giving momentary (400ms) and
+ * short-term (3s) loudness and a gated integrated value. Nothing allocates
+ * after prepare(), so it can run on the audio thread.
+ */
+class LoudnessMeter
+{
+public:
+    //==============================================================================
+    static constexpr int maxChannels = 2;
+
+    LoudnessMeter() = default;
+
+    void prepare(double sampleRate);
+    void reset() noexcept;
+
+    /** Clears the integrated loudness but keeps the filters and the recent
+        sub-blocks, so measuring can start part way into a programme after a
+        warm-up. The next gating block is the one ending at the next sub-block. */
+    void resetIntegrated() noexcept { histogram.reset(); }
+
+    /** Measures a block of audio. */
+    void process(const float* const* channels, int numChannels, int numSamples) noexcept;
+
+    /** Adds the summed squares of numSamples K-weighted samples per channel,
+        filtered elsewhere (BatchProcessor meters many files at once this way).
+        numSamples must not run past getSamplesToSubBlockEnd(). */
+    void addWeightedSums(const double* channelSums, int numChannels, int numSamples) noexcept;
+
+    /** Samples left until the current 100ms sub-block is complete. */
+    int getSamplesToSubBlockEnd() const noexcept { return samplesPerSubBlock - subBlockFill; }
+
+    /** The length of a 100ms sub-block at a sample rate. Gating blocks start on
+        multiples of it from the start of the measurement. */
+    static int getSamplesPerSubBlock(double sampleRate) noexcept;
+
+    //==============================================================================
+    /** Loudness of the last 400ms in LUFS. */
+    float getMomentaryLoudness() const noexcept { return energyToLoudness(getRecentEnergy(4)); }
+
+    /** Loudness of the last 3s in LUFS. */
+    float getShortTermLoudness() const noexcept { return energyToLoudness(getRecentEnergy(numSubBlocks)); }
+
+    /** Gated loudness of everything measured since the last reset(), in LUFS. */
+    float getIntegratedLoudness() const noexcept { return histogram.getIntegratedLoudness(); }
+
+    /** Returns the gating histogram behind the integrated loudness. */
+    const LoudnessHistogram& getHistogram() const noexcept { return histogram; }
+
+    /** Converts a mean square energy to LUFS. */
+    static float energyToLoudness(double energy) noexcept;
+
+private:
+    // 30 sub-blocks of 100ms cover the 3s short-term window
+    static constexpr int numSubBlocks = 30;
+
+    double getRecentEnergy(int numRecentSubBlocks) const noexcept;
+
+    std::array<KWeightingFilter, maxChannels> filters;
+
+    int samplesPerSubBlock { 4410 };
+    int subBlockFill { 0 };
+    double subBlockEnergy { 0.0 };
+
+    std::array<double, numSubBlocks> subBlockEnergies {};
+    int subBlockIndex { 0 };
+    int numCompleteSubBlocks { 0 };
+
+    LoudnessHistogram histogram;
+};
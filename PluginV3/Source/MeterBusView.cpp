@@ -0,0 +1,121 @@
+#include "MeterBusView.h"
+
+namespace
+{
+    constexpr int rowHeight = 18;
+
+    /** Entries that haven't published for this long are shown as idle. */
+    constexpr juce::int64 idleMilliseconds = 1000;
+}
+
+//==============================================================================
+MeterBusView::MeterBusView(const MeterBusPublisher& publisherToShow)
+    : publisher(publisherToShow)
+{
+}
+
+void MeterBusView::refresh()
+{
+    if (const auto* bus = publisher.getBus())
+        entries = bus->getEntries();
+    repaint();
+}
+
+//==============================================================================
+void MeterBusView::paint(juce::Graphics& g)
+{
+    auto bounds = getLocalBounds().toFloat();
+
+    g.setColour(juce::Colours::black.withAlpha(0.85f));
+    g.fillRoundedRectangle(bounds, 5.0f);
+    g.setColour(juce::Colours::white.withAlpha(0.3f));
+    g.drawRoundedRectangle(bounds.reduced(0.5f), 5.0f, 1.0f);
+
+    auto area = getLocalBounds().reduced(8, 6);
+    g.setFont(12.0f);
+
+    const auto* bus = publisher.getBus();
+
+    if (bus == nullptr || ! bus->isAvailable())
+    {
+        g.setColour(juce::Colours::lightgrey);
+        g.drawText("Shared metering is unavailable", area, juce::Justification::centred, true);
+        return;
+    }
+
+    // Columns: name, L/R peak bars, loudness, correlation, balance
+    auto layoutRow = [](juce::Rectangle<int> row)
+    {
+        std::array<juce::Rectangle<int>, 5> cells;
+        cells[0] = row.removeFromLeft(row.getWidth() / 4);
+        cells[4] = row.removeFromRight(60);
+        cells[3] = row.removeFromRight(70);
+        cells[2] = row.removeFromRight(60);
+        cells[1] = row.reduced(4, 0);
+        return cells;
+    };
+
+    auto header = layoutRow(area.removeFromTop(rowHeight));
+    g.setColour(juce::Colours::grey);
+    g.drawText("Track (" + juce::String(entries.size()) + ")", header[0], juce::Justification::centredLeft, true);
+    g.drawText("Peak L/R", header[1], juce::Justification::centredLeft, true);
+    g.drawText("LUFS", header[2], juce::Justification::centredRight, true);
+    g.drawText("Corr", header[3], juce::Justification::centredRight, true);
+    g.drawText("Bal", header[4], juce::Justification::centredRight, true);
+
+    const int maxRows = area.getHeight() / rowHeight;
+    const int ownSlot = publisher.getSlot();
+
+    for (int index = 0; index < entries.size() && index < maxRows; ++index)
+    {
+        const auto& entry = entries.getReference(index);
+        const auto& reading = entry.reading;
+        const bool idle = entry.ageMilliseconds > idleMilliseconds;
+        auto cells = layoutRow(area.removeFromTop(rowHeight));
+
+        g.setColour(entry.slot == ownSlot ? juce::Colours::orange
+                                          : juce::Colours::lightgrey.withAlpha(idle ? 0.5f : 1.0f));
+        g.drawText(entry.name, cells[0], juce::Justification::centredLeft, true);
+
+        if (idle)
+        {
+            g.drawText("idle", cells[1], juce::Justification::centredLeft, true);
+            continue;
+        }
+
+        // Two thin peak bars on the same -60 to 0 dB scale as the main meters
+        auto bars = cells[1].toFloat().reduced(0.0f, 3.0f);
+        const float barHeight = bars.getHeight() / 2.0f;
+
+        for (int channel = 0; channel < MeterFrame::maxChannels; ++channel)
+        {
+            auto bar = bars.removeFromTop(barHeight).reduced(0.0f, 0.5f);
+            const float db = juce::Decibels::gainToDecibels(reading.peak[channel], -60.0f);
+            const float proportion = juce::jmap(db, -60.0f, 0.0f, 0.0f, 1.0f);
+
+            g.setColour(juce::Colours::darkgrey);
+            g.fillRect(bar);
+            g.setColour(db > -1.0f ? juce::Colours::red : db > -12.0f ? juce::Colours::yellow : juce::Colours::green);
+            g.fillRect(bar.withWidth(bar.getWidth() * proportion));
+        }
+
+        g.setColour(juce::Colours::lightgrey);
+        g.drawText(reading.loudness > -70.0f ? juce::String(reading.loudness, 1) : juce::String("-inf"),
+                   cells[2], juce::Justification::centredRight, true);
+
+        g.setColour(reading.correlation < 0.0f ? juce::Colours::red : juce::Colours::cyan);
+        g.drawText(juce::String(reading.correlation, 2), cells[3], juce::Justification::centredRight, true);
+
+        g.setColour(juce::Colours::lightgrey);
+        const int balancePercent = juce::roundToInt(reading.balance * 100.0f);
+        g.drawText(balancePercent == 0 ? juce::String("C")
+                                       : juce::String(std::abs(balancePercent)) + (balancePercent < 0 ? " L" : " R"),
+                   cells[4], juce::Justification::centredRight, true);
+    }
+
+    if (entries.size() > maxRows)
+    {
+        g.setColour(juce::Colours::grey);
+        g.drawText("+" + juce::String(entries.size() - maxRows) + " more", area, juce::Justification::centredLeft, true);
+    }
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "SharedMeterBus.h"
+
+//==============================================================================
+/**
+ * Overview of every instance publishing to the SharedMeterBus: one row per
+ * track with its peaks, momentary loudness, correlation and balance. This
+ * instance's own row is highlighted.
+ */
+class MeterBusView : public juce::Component
+{
+public:
+    //==============================================================================
+    explicit MeterBusView(const MeterBusPublisher& publisher);
+
+    void paint(juce::Graphics& g) override;
+
+    /** Polls the bus and repaints. Call at UI rate while visible. */
+    void refresh();
+
+private:
+    //==============================================================================
+    const MeterBusPublisher& publisher;
+    juce::Array<SharedMeterBus::Entry> entries;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MeterBusView)
+};
@@ -0,0 +1,73 @@
+#include "MeterFrame.h"
+#include "DspKernels.h"
+
+//==============================================================================
+MeterFrame MeterFrame::measure(const float* left, const float* right, int numSamples) noexcept
+{
+    MeterFrame frame;
+    frame.numSamples = numSamples;
+    frame.numChannels = right != nullptr ? 2 : 1;
+
+    if (numSamples <= 0)
+        return frame;
+
+    // Peaks and sums in one pass, in the widest instruction set available
+    DspKernels::Levels levels;
+    DspKernels::measureLevels(left, right, numSamples, levels);
+
+    if (right == nullptr)
+    {
+        frame.peak[0] = frame.peak[1] = levels.peak[0];
+        frame.rms[0] = frame.rms[1] = static_cast<float>(std::sqrt(levels.sumSquares[0] / numSamples));
+        frame.correlation = levels.sumSquares[0] > 0.0 ? 1.0f : 0.0f;
+        return frame;
+    }
+
+    frame.peak[0] = levels.peak[0];
+    frame.peak[1] = levels.peak[1];
+    frame.rms[0] = static_cast<float>(std::sqrt(levels.sumSquares[0] / numSamples));
+    frame.rms[1] = static_cast<float>(std::sqrt(levels.sumSquares[1] / numSamples));
+
+    const double energyProduct = levels.sumSquares[0] * levels.sumSquares[1];
+    frame.correlation = energyProduct > 0.0
+                            ? static_cast<float>(juce::jlimit(-1.0, 1.0, levels.sumProduct / std::sqrt(energyProduct)))
+                            : 0.0f;
+    return frame;
+}
+
+float MeterFrame::getMaxPeak() const noexcept
+{
+    return numChannels > 1 ? juce::jmax(peak[0], peak[1]) : peak[0];
+}
+
+float MeterFrame::getMaxRms() const noexcept
+{
+    return numChannels > 1 ? juce::jmax(rms[0], rms[1]) : rms[0];
+}
+
+//==============================================================================
+bool MeterFrameFifo::push(const MeterFrame& frame) noexcept
+{
+    int start1, size1, start2, size2;
+    fifo.prepareToWrite(1, start1, size1, start2, size2);
+
+    if (size1 + size2 == 0)
+        return false;
+
+    frames[static_cast<size_t>(size1 > 0 ? start1 : start2)] = frame;
+    fifo.finishedWrite(1);
+    return true;
+}
+
+bool MeterFrameFifo::pop(MeterFrame& frame) noexcept
+{
+    int start1, size1, start2, size2;
+    fifo.prepareToRead(1, start1, size1, start2, size2);
+
+    if (size1 + size2 == 0)
+        return false;
+
+    frame = frames[static_cast<size_t>(size1 > 0 ? start1 : start2)];
+    fifo.finishedRead(1);
+    return true;
+}
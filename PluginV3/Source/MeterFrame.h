@@ -0,0 +1,63 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+ * The meter readings of one processed block: per-channel peak and RMS of
+ * the output, and the L/R correlation. Plain data, so frames can be copied
+ * through FIFOs and shared memory as they are.
+ */
+struct MeterFrame
+{
+    static constexpr int maxChannels = 2;
+
+    juce::int64 samplePosition = 0;     // Samples processed before this block
+    double sampleRate = 44100.0;
+    int numSamples = 0;
+    int numChannels = 0;
+
+    float peak[maxChannels] {};         // Linear, largest absolute sample
+    float rms[maxChannels] {};          // Linear
+    float correlation = 0.0f;           // -1 to +1, 0 when either channel is silent
+
+    /** Measures a block in one pass. right may be nullptr for mono, which
+        reads as fully correlated. */
+    static MeterFrame measure(const float* left, const float* right, int numSamples) noexcept;
+
+    /** The louder of the channel peaks. */
+    float getMaxPeak() const noexcept;
+
+    /** The louder of the channel RMS values. */
+    float getMaxRms() const noexcept;
+
+    /** Duration of the block in seconds. */
+    double getDurationSeconds() const noexcept { return sampleRate > 0.0 ? numSamples / sampleRate : 0.0; }
+};
+
+//==============================================================================
+/**
+ * Single-producer, single-consumer queue of meter frames, written by the
+ * audio thread. A full queue drops frames rather than waiting.
+ */
+class MeterFrameFifo
+{
+public:
+    //==============================================================================
+    static constexpr int capacity = 1024;
+
+    /** Adds a frame; returns false if the queue was full. Safe to call from
+        the audio thread. */
+    bool push(const MeterFrame& frame) noexcept;
+
+    /** Takes the oldest frame; returns false if the queue was empty. */
+    bool pop(MeterFrame& frame) noexcept;
+
+    /** Empties the queue. Only safe while neither side is running. */
+    void reset() noexcept { fifo.reset(); }
+
+private:
+    //==============================================================================
+    juce::AbstractFifo fifo { capacity };
+    std::array<MeterFrame, capacity> frames;
+};
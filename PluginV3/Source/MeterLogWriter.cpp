@@ -0,0 +1,283 @@
+#include "MeterLogWriter.h"
+
+namespace
+{
+    constexpr int magicNumber = 0x4d335650;     // "PV3M"
+    constexpr int formatVersion = 1;
+    constexpr int writeBufferSize = 1 << 20;
+    constexpr int pollIntervalMs = 20;
+
+    // Offset of the two counts filled in by stop()
+    constexpr juce::int64 countsOffset = 28;
+
+    juce::String toDecibelText(float level)
+    {
+        return level > 0.0f ? juce::String(juce::Decibels::gainToDecibels(level, -200.0f), 2) : juce::String("-inf");
+    }
+
+    /** Returns false if the stream couldn't take all of it. */
+    bool writeRecord(juce::OutputStream& stream, const MeterLogWriter::Record& record)
+    {
+        bool ok = stream.writeInt64(record.samplePosition)
+               && stream.writeInt64(record.hostTimeSamples)
+               && stream.writeInt(record.numSamples);
+
+        for (float value : record.peak)
+            ok = ok && stream.writeFloat(value);
+
+        for (float value : record.truePeak)
+            ok = ok && stream.writeFloat(value);
+
+        for (float value : record.rms)
+            ok = ok && stream.writeFloat(value);
+
+        return ok
+            && stream.writeFloat(record.momentaryLoudness)
+            && stream.writeFloat(record.shortTermLoudness)
+            && stream.writeFloat(record.correlation);
+    }
+}
+
+//==============================================================================
+MeterLogWriter::MeterLogWriter()
+    : juce::Thread("PluginV3 meter log")
+{
+    records.allocate(static_cast<size_t>(queueCapacity), true);
+}
+
+MeterLogWriter::~MeterLogWriter()
+{
+    stop();
+}
+
+bool MeterLogWriter::start(const juce::File& file, double sampleRate, int numChannels, juce::String& error)
+{
+    stop();
+
+    file.deleteFile();
+    auto newStream = std::make_unique<juce::FileOutputStream>(file, writeBufferSize);
+
+    if (! newStream->openedOk())
+    {
+        error = "Couldn't create " + file.getFullPathName() + ": " + newStream->getStatus().getErrorMessage();
+        return false;
+    }
+
+    newStream->writeInt(magicNumber);
+    newStream->writeShort(static_cast<short>(formatVersion));
+    newStream->writeShort(static_cast<short>(recordSize));
+    newStream->writeDouble(sampleRate);
+    newStream->writeInt(numChannels);
+    newStream->writeInt64(juce::Time::currentTimeMillis());
+    newStream->writeInt64(0);
+    newStream->writeInt64(0);
+    jassert(newStream->getPosition() == headerSize);
+
+    logFile = file;
+    stream = std::move(newStream);
+    queue.reset();
+    numWritten = 0;
+    numDropped = 0;
+    failed = false;
+    writeError = {};
+
+    recording.store(true, std::memory_order_release);
+    startThread(juce::Thread::Priority::background);
+    return true;
+}
+
+void MeterLogWriter::stop()
+{
+    if (stream == nullptr)
+        return;
+
+    recording.store(false, std::memory_order_release);
+    signalThreadShouldExit();
+    stopThread(2000);
+
+    // Whatever the audio thread queued before the flag went down
+    drainQueue();
+
+    // After a failed write the counts are left out, so readers count the
+    // records that made it into the file from its length
+    if (! failed.load(std::memory_order_acquire))
+    {
+        stream->setPosition(countsOffset);
+
+        if (! stream->writeInt64(numWritten.load()) || ! stream->writeInt64(numDropped.load()))
+            writeFailed();
+
+        stream->flush();
+    }
+
+    stream.reset();
+}
+
+juce::String MeterLogWriter::getError() const
+{
+    return failed.load(std::memory_order_acquire) ? writeError : juce::String();
+}
+
+//==============================================================================
+void MeterLogWriter::push(const Record& record) noexcept
+{
+    if (! recording.load(std::memory_order_acquire))
+        return;
+
+    int start1, size1, start2, size2;
+    queue.prepareToWrite(1, start1, size1, start2, size2);
+
+    // Never wait for the disk
+    if (size1 + size2 == 0)
+    {
+        numDropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    records[size1 > 0 ? start1 : start2] = record;
+    queue.finishedWrite(1);
+}
+
+void MeterLogWriter::run()
+{
+    while (! threadShouldExit() && ! failed.load(std::memory_order_acquire))
+    {
+        drainQueue();
+        wait(pollIntervalMs);
+    }
+}
+
+void MeterLogWriter::drainQueue()
+{
+    int start1, size1, start2, size2;
+    queue.prepareToRead(queue.getNumReady(), start1, size1, start2, size2);
+
+    // Only records the stream took are counted; after a failed write the
+    // rest of the queue is discarded
+    juce::int64 numRecordsWritten = 0;
+
+    auto writeRange = [this, &numRecordsWritten](int start, int size)
+    {
+        for (int index = start; index < start + size && ! failed.load(std::memory_order_relaxed); ++index)
+        {
+            if (writeRecord(*stream, records[index]))
+                ++numRecordsWritten;
+            else
+                writeFailed();
+        }
+    };
+
+    writeRange(start1, size1);
+    writeRange(start2, size2);
+    queue.finishedRead(size1 + size2);
+    numWritten.fetch_add(numRecordsWritten);
+}
+
+void MeterLogWriter::writeFailed()
+{
+    const auto status = stream->getStatus();
+    writeError = "Couldn't write " + logFile.getFullPathName()
+               + (status.failed() ? ": " + status.getErrorMessage() : juce::String());
+
+    // The audio thread stops queuing and the writer thread stops draining
+    failed.store(true, std::memory_order_release);
+    recording.store(false, std::memory_order_release);
+}
+
+//==============================================================================
+bool MeterLogWriter::readHeader(juce::InputStream& input, Header& header)
+{
+    if (input.getNumBytesRemaining() < headerSize || input.readInt() != magicNumber)
+        return false;
+
+    const int version = input.readShort();
+    const int storedRecordSize = input.readShort();
+
+    // Later versions may only append to a record
+    if (version < 1 || storedRecordSize < recordSize)
+        return false;
+
+    header.sampleRate = input.readDouble();
+    header.numChannels = input.readInt();
+    header.startTime = input.readInt64();
+    header.numRecords = input.readInt64();
+    header.numDropped = input.readInt64();
+    header.storedRecordSize = storedRecordSize;
+
+    // A log that was never closed has no counts; take them from its length
+    if (header.numRecords == 0)
+        header.numRecords = input.getNumBytesRemaining() / storedRecordSize;
+
+    return true;
+}
+
+bool MeterLogWriter::readRecord(juce::InputStream& input, const Header& header, Record& record)
+{
+    if (input.getNumBytesRemaining() < header.storedRecordSize)
+        return false;
+
+    record.samplePosition = input.readInt64();
+    record.hostTimeSamples = input.readInt64();
+    record.numSamples = input.readInt();
+
+    for (float& value : record.peak)
+        value = input.readFloat();
+
+    for (float& value : record.truePeak)
+        value = input.readFloat();
+
+    for (float& value : record.rms)
+        value = input.readFloat();
+
+    record.momentaryLoudness = input.readFloat();
+    record.shortTermLoudness = input.readFloat();
+    record.correlation = input.readFloat();
+
+    // Fields this version doesn't know about
+    if (header.storedRecordSize > recordSize)
+        input.skipNextBytes(header.storedRecordSize - recordSize);
+
+    return true;
+}
+
+bool MeterLogWriter::convertToCsv(const juce::File& log, juce::OutputStream& csv, juce::String& error)
+{
+    juce::FileInputStream input(log);
+
+    if (! input.openedOk())
+    {
+        error = "Couldn't open " + log.getFullPathName();
+        return false;
+    }
+
+    juce::BufferedInputStream bufferedInput(input, writeBufferSize);
+    Header header;
+
+    if (! readHeader(bufferedInput, header))
+    {
+        error = log.getFileName() + " is not a PluginV3 meter log";
+        return false;
+    }
+
+    csv << "sample_position,host_time_samples,time_seconds,num_samples,"
+           "peak_l_dbfs,peak_r_dbfs,true_peak_l_dbtp,true_peak_r_dbtp,rms_l_dbfs,rms_r_dbfs,"
+           "momentary_lufs,short_term_lufs,correlation\n";
+
+    Record record;
+
+    while (readRecord(bufferedInput, header, record))
+    {
+        csv << juce::String(record.samplePosition) << ','
+            << juce::String(record.hostTimeSamples) << ','
+            << juce::String(record.samplePosition / header.sampleRate, 4) << ','
+            << juce::String(record.numSamples) << ','
+            << toDecibelText(record.peak[0]) << ',' << toDecibelText(record.peak[1]) << ','
+            << toDecibelText(record.truePeak[0]) << ',' << toDecibelText(record.truePeak[1]) << ','
+            << toDecibelText(record.rms[0]) << ',' << toDecibelText(record.rms[1]) << ','
+            << juce::String(record.momentaryLoudness, 2) << ','
+            << juce::String(record.shortTermLoudness, 2) << ','
+            << juce::String(record.correlation, 4) << '\n';
+    }
+
+    return true;
+}
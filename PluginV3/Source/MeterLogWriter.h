@@ -0,0 +1,116 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "MeterFrame.h"
+
+//==============================================================================
+/**
+ * Streams per-block meter readings to a compact binary log for offline QA.
+ *
+ * The audio thread pushes fixed-size records into a lock-free queue and
+ * never waits: if the disk stalls long enough to fill the queue (about
+ * ten seconds of 32-sample blocks at 96kHz), records are dropped and
+ * counted, and the gap shows in their sample positions. A background thread
+ * drains the queue through a large write buffer. If a write fails, the log
+ * stops recording and getError() says why.
+ *
+ * File layout, little-endian:
+ *   header  "PV3M", int16 version, int16 record size, double sample rate,
+ *           int32 channels, int64 start time (ms since epoch),
+ *           int64 records written, int64 records dropped
+ *   records int64 sample position, int64 host time in samples (-1 if
+ *           unknown), int32 block length, float peak[2], true peak[2],
+ *           rms[2] (linear), float momentary and short-term loudness (LUFS),
+ *           float correlation
+ *
+ * The two counts are filled in when recording stops; a log cut short by a
+ * crash still reads, with its records counted from the file size.
+ */
+class MeterLogWriter : private juce::Thread
+{
+public:
+    //==============================================================================
+    struct Record
+    {
+        juce::int64 samplePosition = 0;
+        juce::int64 hostTimeSamples = -1;
+        int numSamples = 0;
+        float peak[MeterFrame::maxChannels] {};
+        float truePeak[MeterFrame::maxChannels] {};
+        float rms[MeterFrame::maxChannels] {};
+        float momentaryLoudness = -100.0f;
+        float shortTermLoudness = -100.0f;
+        float correlation = 0.0f;
+    };
+
+    struct Header
+    {
+        double sampleRate = 0.0;
+        int numChannels = 0;
+        juce::int64 startTime = 0;
+        juce::int64 numRecords = 0;
+        juce::int64 numDropped = 0;
+
+        // Bytes per record in this log: later versions may append fields,
+        // which readRecord() skips
+        int storedRecordSize = recordSize;
+    };
+
+    static constexpr int queueCapacity = 1 << 15;
+    static constexpr int headerSize = 44;
+    static constexpr int recordSize = 56;
+
+    MeterLogWriter();
+    ~MeterLogWriter() override;
+
+    //==============================================================================
+    /** Creates the log and starts the writer thread. Message thread only. */
+    bool start(const juce::File& file, double sampleRate, int numChannels, juce::String& error);
+
+    /** Writes out everything queued, completes the header and closes the log. */
+    void stop();
+
+    bool isRecording() const noexcept { return recording.load(std::memory_order_acquire); }
+
+    /** Why the log stopped by itself, or an empty string while it hasn't.
+        Message thread only. */
+    juce::String getError() const;
+
+    /** Queues a record. Wait-free; safe to call from the audio thread. */
+    void push(const Record& record) noexcept;
+
+    juce::int64 getNumWritten() const noexcept { return numWritten.load(); }
+    juce::int64 getNumDropped() const noexcept { return numDropped.load(); }
+    juce::File getFile() const { return logFile; }
+
+    //==============================================================================
+    /** Reads a log's header; returns false if it isn't a meter log. */
+    static bool readHeader(juce::InputStream& input, Header& header);
+
+    /** Reads the next record of a log with the given header; returns false
+        at the end of the log. */
+    static bool readRecord(juce::InputStream& input, const Header& header, Record& record);
+
+    /** Writes a log out as CSV, levels in dBFS. */
+    static bool convertToCsv(const juce::File& log, juce::OutputStream& csv, juce::String& error);
+
+private:
+    //==============================================================================
+    void run() override;
+    void drainQueue();
+    void writeFailed();
+
+    juce::File logFile;
+    std::unique_ptr<juce::FileOutputStream> stream;
+
+    juce::AbstractFifo queue { queueCapacity };
+    juce::HeapBlock<Record> records;
+
+    std::atomic<bool> recording { false };
+    std::atomic<bool> failed { false };
+    juce::String writeError;    // Set once, before failed
+    std::atomic<juce::int64> numWritten { 0 };
+    std::atomic<juce::int64> numDropped { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MeterLogWriter)
+};
@@ -0,0 +1,367 @@
+#include "MonoCompatAnalyser.h"
+
+namespace
+{
+    // 4096-sample frames: ~5Hz bins at the analysis rate, enough for the lowest octave
+    constexpr int windowOrder = 12;
+
+    // The analysis stream keeps everything below ~10kHz
+    constexpr double minimumAnalysisRate = 20000.0;
+
+    // Averaging per frame; frames arrive ~10 times a second, so ~1s of memory
+    constexpr float spectrumDecay = 0.9f;
+
+    // Mic spacings up to ~3m
+    constexpr double maxDelayMs = 10.0;
+
+    constexpr float minimumDelayConfidence = 0.1f;
+    constexpr float minimumImprovementDb = 1.0f;
+
+    float toDecibels(double monoPower, double channelPower)
+    {
+        return static_cast<float>(10.0 * std::log10(juce::jmax(1.0e-4, monoPower / channelPower)));
+    }
+}
+
+//==============================================================================
+MonoCompatAnalyser::MonoCompatAnalyser()
+    : juce::Thread("Mono Compatibility")
+{
+}
+
+MonoCompatAnalyser::~MonoCompatAnalyser()
+{
+    release();
+}
+
+//==============================================================================
+void MonoCompatAnalyser::prepare(double sampleRate)
+{
+    release();
+
+    decimationFactor = 1;
+    while (sampleRate / (2 * decimationFactor) >= minimumAnalysisRate)
+        decimationFactor *= 2;
+
+    analysisSampleRate = sampleRate / decimationFactor;
+
+    if (fft == nullptr)
+    {
+        const int windowSize = 1 << windowOrder;
+
+        // The plan and window are shared with every other analyser of this size
+        fft = SharedTables::getFft(windowOrder);
+        window = SharedTables::getHannWindow(windowSize);
+        correlator = std::make_unique<CrossCorrelator>(windowOrder);
+
+        frameBuffer.setSize(2, windowSize);
+        captureBuffer.setSize(2, 8 * windowSize);
+        captureFifo.setTotalSize(8 * windowSize);
+
+        // The real-only FFT works in place on buffers of twice the transform size
+        leftSpectrum.allocate(static_cast<size_t>(2 * windowSize), true);
+        rightSpectrum.allocate(static_cast<size_t>(2 * windowSize), true);
+        leftPower.allocate(static_cast<size_t>(windowSize / 2 + 1), true);
+        rightPower.allocate(static_cast<size_t>(windowSize / 2 + 1), true);
+        crossSpectrum.allocate(static_cast<size_t>(windowSize / 2 + 1), true);
+    }
+
+    const int windowSize = frameBuffer.getNumSamples();
+
+    for (int band = 0; band <= numBands; ++band)
+        bandBins[static_cast<size_t>(band)] = juce::jlimit(1, windowSize / 2,
+                                                           juce::roundToInt(bandEdges[band] * windowSize / analysisSampleRate));
+
+    leftSum = rightSum = 0.0f;
+    decimationCount = 0;
+    captureFifo.reset();
+    restartRequested.store(true);
+    startThread(juce::Thread::Priority::low);
+}
+
+void MonoCompatAnalyser::release()
+{
+    stopThread(2000);
+}
+
+void MonoCompatAnalyser::setEnabled(bool shouldBeEnabled) noexcept
+{
+    if (shouldBeEnabled && ! enabled.load())
+        restartRequested.store(true);
+
+    enabled.store(shouldBeEnabled, std::memory_order_release);
+}
+
+void MonoCompatAnalyser::restart() noexcept
+{
+    restartRequested.store(true);
+
+    // Don't leave a stale recommendation up until the analysis thread catches up
+    const juce::SpinLock::ScopedLockType lock(resultLock);
+    lastResult = {};
+}
+
+void MonoCompatAnalyser::pushSamples(const float* left, const float* right, int numSamples) noexcept
+{
+    if (! enabled.load(std::memory_order_acquire))
+        return;
+
+    const int numOutput = (decimationCount + numSamples) / decimationFactor;
+
+    int start1, size1, start2, size2;
+    captureFifo.prepareToWrite(numOutput, start1, size1, start2, size2);
+
+    // Never wait for the analysis thread; a gap just restarts frame assembly
+    if (size1 + size2 < numOutput)
+    {
+        captureOverflowed.store(true);
+        return;
+    }
+
+    // Averaging is a crude anti-aliasing filter, but aliases only land above
+    // the highest band and add little to the band powers
+    const float scale = 1.0f / static_cast<float>(decimationFactor);
+    auto* leftOutput = captureBuffer.getWritePointer(0);
+    auto* rightOutput = captureBuffer.getWritePointer(1);
+    int written = 0;
+
+    for (int sample = 0; sample < numSamples; ++sample)
+    {
+        leftSum += left[sample];
+        rightSum += right[sample];
+
+        if (++decimationCount < decimationFactor)
+            continue;
+
+        const int index = written < size1 ? start1 + written : start2 + written - size1;
+        leftOutput[index] = leftSum * scale;
+        rightOutput[index] = rightSum * scale;
+
+        leftSum = rightSum = 0.0f;
+        decimationCount = 0;
+        ++written;
+    }
+
+    captureFifo.finishedWrite(written);
+}
+
+MonoCompatAnalyser::Result MonoCompatAnalyser::getLastResult() const
+{
+    const juce::SpinLock::ScopedLockType lock(resultLock);
+    return lastResult;
+}
+
+//==============================================================================
+void MonoCompatAnalyser::run()
+{
+    while (! threadShouldExit())
+    {
+        if (! enabled.load())
+        {
+            wait(100);
+            continue;
+        }
+
+        if (restartRequested.exchange(false))
+        {
+            // Start from an empty FIFO and empty spectra so no old audio counts
+            captureFifo.finishedRead(captureFifo.getNumReady());
+            captureOverflowed.store(false);
+            frameFill = 0;
+            numFrames = 0;
+
+            const int numBins = frameBuffer.getNumSamples() / 2 + 1;
+            juce::FloatVectorOperations::clear(leftPower.get(), numBins);
+            juce::FloatVectorOperations::clear(rightPower.get(), numBins);
+            std::fill(crossSpectrum.get(), crossSpectrum.get() + numBins, std::complex<float>());
+            correlator->reset();
+
+            const juce::SpinLock::ScopedLockType lock(resultLock);
+            lastResult = {};
+        }
+
+        if (! readNextHop())
+        {
+            wait(20);
+            continue;
+        }
+
+        if (frameFill < frameBuffer.getNumSamples())
+            continue;
+
+        analyseFrame();
+
+        if (numFrames > 0)
+        {
+            const auto result = computeResult();
+            const juce::SpinLock::ScopedLockType lock(resultLock);
+            lastResult = result;
+        }
+    }
+}
+
+bool MonoCompatAnalyser::readNextHop()
+{
+    const int windowSize = frameBuffer.getNumSamples();
+    const int hopSize = windowSize / 2;
+
+    if (captureOverflowed.exchange(false))
+        frameFill = 0;
+
+    if (captureFifo.getNumReady() < hopSize)
+        return false;
+
+    // Slide the frame by half a window and append the next hop
+    for (int channel = 0; channel < 2; ++channel)
+    {
+        auto* frame = frameBuffer.getWritePointer(channel);
+        juce::FloatVectorOperations::copy(frame, frame + hopSize, windowSize - hopSize);
+    }
+
+    int start1, size1, start2, size2;
+    captureFifo.prepareToRead(hopSize, start1, size1, start2, size2);
+
+    for (int channel = 0; channel < 2; ++channel)
+    {
+        auto* destination = frameBuffer.getWritePointer(channel, windowSize - hopSize);
+        juce::FloatVectorOperations::copy(destination, captureBuffer.getReadPointer(channel, start1), size1);
+        juce::FloatVectorOperations::copy(destination + size1, captureBuffer.getReadPointer(channel, start2), size2);
+    }
+
+    captureFifo.finishedRead(size1 + size2);
+    frameFill = juce::jmin(windowSize, frameFill + hopSize);
+    return true;
+}
+
+void MonoCompatAnalyser::analyseFrame() noexcept
+{
+    const int windowSize = frameBuffer.getNumSamples();
+    const int numBins = windowSize / 2 + 1;
+
+    float energy = 0.0f;
+
+    for (int channel = 0; channel < 2; ++channel)
+    {
+        auto* spectrum = channel == 0 ? leftSpectrum.get() : rightSpectrum.get();
+        juce::FloatVectorOperations::multiply(spectrum, frameBuffer.getReadPointer(channel), window->data(), windowSize);
+        juce::FloatVectorOperations::clear(spectrum + windowSize, windowSize);
+
+        for (int i = 0; i < windowSize; ++i)
+            energy += spectrum[i] * spectrum[i];
+    }
+
+    // Hold the last result through silence instead of fading it out
+    if (energy < 1.0e-7f * static_cast<float>(windowSize))
+        return;
+
+    fft->performRealOnlyForwardTransform(leftSpectrum.get(), true);
+    fft->performRealOnlyForwardTransform(rightSpectrum.get(), true);
+
+    auto* leftBins = reinterpret_cast<const std::complex<float>*>(leftSpectrum.get());
+    auto* rightBins = reinterpret_cast<const std::complex<float>*>(rightSpectrum.get());
+
+    // Same conj(L) * R convention as the correlator
+    for (int bin = 0; bin < numBins; ++bin)
+    {
+        leftPower[bin] = leftPower[bin] * spectrumDecay + std::norm(leftBins[bin]);
+        rightPower[bin] = rightPower[bin] * spectrumDecay + std::norm(rightBins[bin]);
+        crossSpectrum[bin] = crossSpectrum[bin] * spectrumDecay + std::conj(leftBins[bin]) * rightBins[bin];
+    }
+
+    correlator->decay(spectrumDecay);
+    correlator->addFrame(frameBuffer.getReadPointer(0), frameBuffer.getReadPointer(1));
+    ++numFrames;
+}
+
+MonoCompatAnalyser::Result MonoCompatAnalyser::computeResult() noexcept
+{
+    Result result;
+    const int windowSize = frameBuffer.getNumSamples();
+
+    // Delaying L by the measured lag rotates each cross spectrum bin by
+    // +2*pi*bin*lag/N, so the delayed sums come straight from the spectra
+    const auto delayEstimate = correlator->computeResult(juce::roundToInt(maxDelayMs * analysisSampleRate / 1000.0));
+    const bool delayUsable = delayEstimate.valid
+                             && delayEstimate.confidence >= minimumDelayConfidence
+                             && std::abs(delayEstimate.lagSamples) >= 0.25f;
+    const double lag = delayUsable ? delayEstimate.lagSamples : 0.0;
+
+    result.delayMs = static_cast<float>(lag * 1000.0 / analysisSampleRate);
+    result.delayConfidence = delayEstimate.confidence;
+
+    std::array<double, numBands> bandPowers {};
+    double maximumPower = 0.0;
+
+    for (int band = 0; band < numBands; ++band)
+    {
+        auto& output = result.bands[static_cast<size_t>(band)];
+        double leftTotal = 0.0, rightTotal = 0.0, crossTotal = 0.0, delayedCrossTotal = 0.0;
+
+        for (int bin = bandBins[static_cast<size_t>(band)]; bin < bandBins[static_cast<size_t>(band + 1)]; ++bin)
+        {
+            leftTotal += leftPower[bin];
+            rightTotal += rightPower[bin];
+            crossTotal += crossSpectrum[bin].real();
+
+            const double phase = juce::MathConstants<double>::twoPi * bin * lag / windowSize;
+            delayedCrossTotal += crossSpectrum[bin].real() * std::cos(phase) - crossSpectrum[bin].imag() * std::sin(phase);
+        }
+
+        const double channelPower = leftTotal + rightTotal;
+        bandPowers[static_cast<size_t>(band)] = channelPower;
+        maximumPower = juce::jmax(maximumPower, channelPower);
+
+        if (leftTotal <= 0.0 || rightTotal <= 0.0)
+            continue;
+
+        output.correlation = static_cast<float>(juce::jlimit(-1.0, 1.0, crossTotal / std::sqrt(leftTotal * rightTotal)));
+        output.monoSumDb[none] = toDecibels(channelPower + 2.0 * crossTotal, channelPower);
+        output.monoSumDb[flipPolarity] = toDecibels(channelPower - 2.0 * crossTotal, channelPower);
+        output.monoSumDb[delay] = toDecibels(channelPower + 2.0 * delayedCrossTotal, channelPower);
+        output.monoSumDb[delayAndFlipPolarity] = toDecibels(channelPower - 2.0 * delayedCrossTotal, channelPower);
+    }
+
+    // Judge only bands within 40dB of the loudest one
+    std::array<double, 4> meanSumDb {};
+    int numActive = 0;
+
+    for (int band = 0; band < numBands; ++band)
+    {
+        auto& output = result.bands[static_cast<size_t>(band)];
+        output.active = bandPowers[static_cast<size_t>(band)] > 1.0e-4 * maximumPower && maximumPower > 0.0;
+
+        if (! output.active)
+            continue;
+
+        for (size_t option = 0; option < meanSumDb.size(); ++option)
+            meanSumDb[option] += output.monoSumDb[option];
+
+        if (result.worstBand < 0 || output.correlation < result.bands[static_cast<size_t>(result.worstBand)].correlation)
+            result.worstBand = band;
+
+        ++numActive;
+    }
+
+    if (numActive == 0)
+        return result;
+
+    result.valid = true;
+
+    // Without a clear delay the delayed sums equal the others, so skip them
+    const int numOptions = delayUsable ? 4 : 2;
+    int best = none;
+
+    for (int option = 1; option < numOptions; ++option)
+        if (meanSumDb[static_cast<size_t>(option)] > meanSumDb[static_cast<size_t>(best)])
+            best = option;
+
+    const float improvementDb = static_cast<float>((meanSumDb[static_cast<size_t>(best)] - meanSumDb[none]) / numActive);
+
+    if (improvementDb >= minimumImprovementDb)
+    {
+        result.recommendation = static_cast<Recommendation>(best);
+        result.improvementDb = improvementDb;
+    }
+
+    return result;
+}
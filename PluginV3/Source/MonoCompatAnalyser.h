@@ -0,0 +1,132 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "CrossCorrelator.h"
+
+//==============================================================================
+/**
+ * Estimates, per octave band, how much a stereo signal loses when summed to
+ * mono, and whether flipping one channel's polarity or delaying one channel
+ * would make the sum fuller.
+ *
+ * The audio thread only averages its output down to a ~20-24kHz analysis
+ * stream and pushes it into a lock-free FIFO, and only while the analysis is
+ * enabled. A background thread turns overlapping frames into exponentially
+ * averaged per-band auto and cross spectra, and drives a CrossCorrelator on
+ * the same frames for the inter-channel delay. The sum with each candidate
+ * correction is then evaluated from the cross spectra directly, so no audio
+ * is reprocessed to compare them.
+ */
+class MonoCompatAnalyser : private juce::Thread
+{
+public:
+    //==============================================================================
+    static constexpr int numBands = 8;
+
+    /** Lower edge of each band in Hz; the last band ends at bandEdges[numBands]. */
+    static constexpr float bandEdges[numBands + 1] = { 30.0f, 60.0f, 120.0f, 250.0f, 500.0f,
+                                                       1000.0f, 2000.0f, 4000.0f, 8000.0f };
+
+    enum Recommendation
+    {
+        none,
+        flipPolarity,
+        delay,
+        delayAndFlipPolarity
+    };
+
+    struct Band
+    {
+        bool active = false;            // Enough level to judge
+        float correlation = 0.0f;       // -1 (cancels) to +1 (sums coherently)
+
+        /** Mono sum relative to the summed channel powers, in dB: +3 when
+            the channels are identical, 0 when unrelated, very negative when
+            they cancel. Index by Recommendation. */
+        std::array<float, 4> monoSumDb {};
+    };
+
+    struct Result
+    {
+        bool valid = false;
+        std::array<Band, numBands> bands;
+
+        /** Delay of R relative to L in milliseconds (positive: R is late),
+            as measured on the analysis stream. */
+        float delayMs = 0.0f;
+        float delayConfidence = 0.0f;
+
+        /** The correction with the fullest mono sum, and its mean gain over
+            the active bands. none if nothing helps by at least 1dB. */
+        Recommendation recommendation = none;
+        float improvementDb = 0.0f;
+
+        /** Band with the lowest correlation, or -1 if no band is active. */
+        int worstBand = -1;
+    };
+
+    //==============================================================================
+    MonoCompatAnalyser();
+    ~MonoCompatAnalyser() override;
+
+    /** Allocates the analysis buffers and starts the analysis thread.
+        Must not be called from the audio thread. */
+    void prepare(double sampleRate);
+
+    /** Stops the analysis thread. */
+    void release();
+
+    /** Starts or stops the analysis; results restart from scratch each time
+        it is enabled. Safe to call from any thread. */
+    void setEnabled(bool shouldBeEnabled) noexcept;
+
+    bool isEnabled() const noexcept { return enabled.load(std::memory_order_relaxed); }
+
+    /** Discards everything measured so far, e.g. after a correction. */
+    void restart() noexcept;
+
+    /** Adds a stereo block while enabled. Wait-free; safe to call from the
+        audio thread. */
+    void pushSamples(const float* left, const float* right, int numSamples) noexcept;
+
+    /** Returns the most recent result. */
+    Result getLastResult() const;
+
+private:
+    //==============================================================================
+    void run() override;
+
+    bool readNextHop();
+    void analyseFrame() noexcept;
+    Result computeResult() noexcept;
+
+    double analysisSampleRate { 22050.0 };
+    int decimationFactor { 1 };
+
+    // Audio thread decimation state
+    float leftSum { 0.0f }, rightSum { 0.0f };
+    int decimationCount { 0 };
+
+    juce::AbstractFifo captureFifo { 1 };
+    juce::AudioBuffer<float> captureBuffer;
+    std::atomic<bool> enabled { false };
+    std::atomic<bool> restartRequested { false };
+    std::atomic<bool> captureOverflowed { false };
+
+    // Analysis thread state
+    std::shared_ptr<const juce::dsp::FFT> fft;
+    std::unique_ptr<CrossCorrelator> correlator;
+    juce::AudioBuffer<float> frameBuffer;
+    int frameFill { 0 };
+    std::shared_ptr<const std::vector<float>> window;
+    juce::HeapBlock<float> leftSpectrum, rightSpectrum;
+    juce::HeapBlock<float> leftPower, rightPower;
+    juce::HeapBlock<std::complex<float>> crossSpectrum;
+    std::array<int, numBands + 1> bandBins {};
+    int numFrames { 0 };
+
+    juce::SpinLock resultLock;
+    Result lastResult;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MonoCompatAnalyser)
+};
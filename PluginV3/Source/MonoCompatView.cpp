@@ -0,0 +1,132 @@
+#include "MonoCompatView.h"
+
+namespace
+{
+    constexpr int headerHeight = 20;
+    constexpr int labelHeight = 12;
+
+    juce::String formatFrequency(float hz)
+    {
+        return hz >= 1000.0f ? juce::String(hz / 1000.0f, 0) + "k" : juce::String(juce::roundToInt(hz));
+    }
+}
+
+//==============================================================================
+MonoCompatView::MonoCompatView()
+{
+    applyButton.setButtonText("Apply");
+    applyButton.setTooltip("Apply the recommended polarity and delay change");
+    applyButton.onClick = [this]() {
+        if (onApply != nullptr)
+            onApply(result);
+    };
+    addChildComponent(applyButton);
+}
+
+void MonoCompatView::setResult(const MonoCompatAnalyser::Result& newResult)
+{
+    result = newResult;
+    applyButton.setVisible(result.valid && result.recommendation != MonoCompatAnalyser::none);
+    repaint();
+}
+
+juce::String MonoCompatView::describe(const MonoCompatAnalyser::Result& result)
+{
+    // The late channel is the one to keep, so the early one gets delayed
+    const juce::String delayText = "Delay " + juce::String(result.delayMs >= 0.0f ? "L " : "R ")
+                                   + juce::String(std::abs(result.delayMs), 2) + " ms";
+
+    switch (result.recommendation)
+    {
+        case MonoCompatAnalyser::flipPolarity:           return "Flip R polarity";
+        case MonoCompatAnalyser::delay:                  return delayText;
+        case MonoCompatAnalyser::delayAndFlipPolarity:   return delayText + ", flip R";
+        case MonoCompatAnalyser::none:
+        default:                                         return {};
+    }
+}
+
+//==============================================================================
+void MonoCompatView::resized()
+{
+    applyButton.setBounds(getLocalBounds().reduced(4).removeFromTop(headerHeight - 2).removeFromRight(50));
+}
+
+void MonoCompatView::paint(juce::Graphics& g)
+{
+    auto bounds = getLocalBounds().toFloat();
+
+    g.setColour(juce::Colours::black.withAlpha(0.85f));
+    g.fillRoundedRectangle(bounds, 5.0f);
+    g.setColour(juce::Colours::white.withAlpha(0.3f));
+    g.drawRoundedRectangle(bounds.reduced(0.5f), 5.0f, 1.0f);
+
+    auto area = getLocalBounds().reduced(6, 4);
+    auto header = area.removeFromTop(headerHeight);
+    g.setFont(12.0f);
+
+    // Recommendation, or the overall state when nothing would help
+    juce::String headline;
+    auto headlineColour = juce::Colours::lightgrey;
+
+    if (! result.valid)
+    {
+        headline = "Listening...";
+    }
+    else if (result.recommendation != MonoCompatAnalyser::none)
+    {
+        headline = describe(result) + ": +" + juce::String(result.improvementDb, 1) + " dB in mono";
+        headlineColour = juce::Colours::orange;
+        header.removeFromRight(54);
+    }
+    else if (result.worstBand >= 0 && result.bands[static_cast<size_t>(result.worstBand)].correlation < 0.0f)
+    {
+        headline = "Cancels in mono, no simple fix";
+        headlineColour = juce::Colours::red;
+    }
+    else
+    {
+        headline = "Mono compatible";
+        headlineColour = juce::Colours::lightgreen;
+    }
+
+    g.setColour(headlineColour);
+    g.drawText(headline, header, juce::Justification::centredLeft, true);
+
+    // One correlation bar per band, up from the centre line when in phase
+    auto labels = area.removeFromBottom(labelHeight);
+    const float columnWidth = static_cast<float>(area.getWidth()) / MonoCompatAnalyser::numBands;
+    const float centreY = static_cast<float>(area.getCentreY());
+    const float halfHeight = static_cast<float>(area.getHeight()) / 2.0f;
+
+    g.setColour(juce::Colours::white.withAlpha(0.2f));
+    g.drawHorizontalLine(juce::roundToInt(centreY), static_cast<float>(area.getX()), static_cast<float>(area.getRight()));
+
+    g.setFont(10.0f);
+
+    for (int band = 0; band < MonoCompatAnalyser::numBands; ++band)
+    {
+        const auto& bandResult = result.bands[static_cast<size_t>(band)];
+        const float x = static_cast<float>(area.getX()) + band * columnWidth;
+        const auto column = juce::Rectangle<float>(x, static_cast<float>(area.getY()), columnWidth, static_cast<float>(area.getHeight()))
+                                .reduced(columnWidth * 0.2f, 0.0f);
+
+        if (result.valid && bandResult.active)
+        {
+            const float barHeight = halfHeight * std::abs(bandResult.correlation);
+            const auto bar = bandResult.correlation >= 0.0f
+                                 ? column.withTop(centreY - barHeight).withBottom(centreY)
+                                 : column.withTop(centreY).withHeight(barHeight);
+
+            g.setColour(bandResult.correlation < -0.2f ? juce::Colours::red
+                        : bandResult.correlation < 0.2f ? juce::Colours::yellow
+                                                        : juce::Colours::cyan);
+            g.fillRect(bar);
+        }
+
+        g.setColour(juce::Colours::grey);
+        g.drawText(formatFrequency(MonoCompatAnalyser::bandEdges[band]),
+                   juce::Rectangle<float>(x, static_cast<float>(labels.getY()), columnWidth, static_cast<float>(labelHeight)),
+                   juce::Justification::centred, false);
+    }
+}
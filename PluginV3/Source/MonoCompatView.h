@@ -0,0 +1,37 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "MonoCompatAnalyser.h"
+
+//==============================================================================
+/**
+ * Per-band mono compatibility, shown over the stereo placement display: one
+ * bar per octave band for the L/R correlation, red where the band cancels
+ * in mono, and the correction the analyser recommends with a button to
+ * apply it.
+ */
+class MonoCompatView : public juce::Component
+{
+public:
+    //==============================================================================
+    MonoCompatView();
+
+    void paint(juce::Graphics& g) override;
+    void resized() override;
+
+    /** Shows a new analysis result. */
+    void setResult(const MonoCompatAnalyser::Result& newResult);
+
+    /** Called when the recommendation's Apply button is clicked. */
+    std::function<void(const MonoCompatAnalyser::Result&)> onApply;
+
+    /** Describes a recommendation, e.g. "Delay L 0.42 ms". */
+    static juce::String describe(const MonoCompatAnalyser::Result& result);
+
+private:
+    //==============================================================================
+    MonoCompatAnalyser::Result result;
+    juce::TextButton applyButton;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MonoCompatView)
+};
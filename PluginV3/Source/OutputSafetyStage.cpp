@@ -0,0 +1,249 @@
+#include "OutputSafetyStage.h"
+
+namespace
+{
+    constexpr int maximumOversamplingStages = 3;
+
+    // Whole base-rate samples of lookahead, so the latency stays an integer
+    int getLookaheadBaseSamples(double sampleRate) noexcept
+    {
+        return juce::jmax(1, juce::roundToInt(OutputSafetyStage::lookaheadSeconds * sampleRate));
+    }
+
+    size_t getLimiterBytes(int numChannels, int lookaheadSamples) noexcept
+    {
+        // The window spans the lookahead plus the current sample
+        const int queueCapacity = lookaheadSamples + 1;
+
+        return AlignedArena::getBytes<float*>(numChannels)
+             + static_cast<size_t>(numChannels) * AlignedArena::getBytes<float>(lookaheadSamples)
+             + 2 * AlignedArena::getBytes<float>(queueCapacity)
+             + AlignedArena::getBytes<juce::int64>(queueCapacity);
+    }
+}
+
+//==============================================================================
+void OutputSafetyStage::prepare(double sampleRate, int newMaximumBlockSize, int numChannels,
+                                Mode newMode, int oversamplingIndex, AlignedArena& arena)
+{
+    mode = newMode;
+    numPreparedChannels = juce::jmax(1, numChannels);
+    maximumBlockSize = juce::jmax(1, newMaximumBlockSize);
+    latencySamples = 0;
+    oversampling.reset();
+    gainReductionDb.store(0.0f, std::memory_order_relaxed);
+
+    lookaheadChannels = nullptr;
+    minimumValues = nullptr;
+    minimumPositions = nullptr;
+    boxHistory = nullptr;
+
+    if (mode == off)
+        return;
+
+    // Integer latency so it can be reported exactly to the host
+    const int stages = juce::jlimit(1, maximumOversamplingStages, oversamplingIndex + 1);
+    oversampling = std::make_unique<juce::dsp::Oversampling<float>>(
+        static_cast<size_t>(numPreparedChannels), static_cast<size_t>(stages),
+        juce::dsp::Oversampling<float>::filterHalfBandFIREquiripple, true, true);
+    oversampling->initProcessing(static_cast<size_t>(maximumBlockSize));
+
+    const int factor = 1 << stages;
+    oversampledRate = sampleRate * factor;
+    latencySamples = juce::roundToInt(oversampling->getLatencyInSamples());
+
+    if (mode == limiter)
+    {
+        const int lookaheadBaseSamples = getLookaheadBaseSamples(sampleRate);
+        lookaheadSamples = lookaheadBaseSamples * factor;
+
+        // An arena sized with getArenaBytes() always has room
+        if (arena.getSize() - arena.getUsed() < getLimiterBytes(numPreparedChannels, lookaheadSamples))
+        {
+            jassertfalse;
+            mode = off;
+            oversampling.reset();
+            latencySamples = 0;
+            return;
+        }
+
+        latencySamples += lookaheadBaseSamples;
+
+        lookaheadChannels = arena.take<float*>(numPreparedChannels);
+
+        for (int channel = 0; channel < numPreparedChannels; ++channel)
+            lookaheadChannels[channel] = arena.take<float>(lookaheadSamples);
+
+        queueCapacity = lookaheadSamples + 1;
+        minimumValues = arena.take<float>(queueCapacity);
+        minimumPositions = arena.take<juce::int64>(queueCapacity);
+        boxHistory = arena.take<float>(queueCapacity);
+
+        releaseCoefficient = static_cast<float>(1.0 - std::exp(-1.0 / (releaseSeconds * oversampledRate)));
+    }
+
+    reset();
+}
+
+size_t OutputSafetyStage::getArenaBytes(double sampleRate, int numChannels) noexcept
+{
+    // Only the limiter takes arena space, most of it at the highest oversampling
+    const int lookaheadSamples = getLookaheadBaseSamples(sampleRate) << maximumOversamplingStages;
+    return getLimiterBytes(juce::jmax(1, numChannels), lookaheadSamples);
+}
+
+void OutputSafetyStage::reset() noexcept
+{
+    if (oversampling != nullptr)
+        oversampling->reset();
+
+    if (lookaheadChannels != nullptr)
+        for (int channel = 0; channel < numPreparedChannels; ++channel)
+            juce::FloatVectorOperations::clear(lookaheadChannels[channel], lookaheadSamples);
+
+    lookaheadIndex = 0;
+
+    queueHead = 0;
+    queueSize = 0;
+    samplePosition = 0;
+    limiterGain = 1.0f;
+
+    // The box filter starts as if it had only seen unity gain
+    if (boxHistory != nullptr)
+        for (int i = 0; i < queueCapacity; ++i)
+            boxHistory[i] = 1.0f;
+
+    boxSum = queueCapacity;
+    gainReductionDb.store(0.0f, std::memory_order_relaxed);
+}
+
+//==============================================================================
+void OutputSafetyStage::process(juce::AudioBuffer<float>& buffer, int numChannels, int numSamples, float ceilingDb) noexcept
+{
+    if (mode == off || oversampling == nullptr)
+        return;
+
+    numChannels = juce::jmin(numChannels, numPreparedChannels, buffer.getNumChannels());
+    jassert(numChannels == numPreparedChannels);
+
+    const float ceiling = juce::Decibels::decibelsToGain(ceilingDb);
+    blockMinimumGain = 1.0f;
+
+    // Hosts may exceed the announced block size, so work in chunks that fit the filters
+    for (int start = 0; start < numSamples; start += maximumBlockSize)
+    {
+        const int chunkSize = juce::jmin(maximumBlockSize, numSamples - start);
+        juce::dsp::AudioBlock<float> block(buffer.getArrayOfWritePointers(), static_cast<size_t>(numChannels),
+                                           static_cast<size_t>(start), static_cast<size_t>(chunkSize));
+
+        auto oversampledBlock = oversampling->processSamplesUp(block);
+
+        if (mode == softClip)
+            processSoftClip(oversampledBlock, ceiling);
+        else
+            processLimiter(oversampledBlock, ceiling);
+
+        oversampling->processSamplesDown(block);
+
+        // Downsampling ripple can overshoot by a fraction of a dB
+        for (int channel = 0; channel < numChannels; ++channel)
+            juce::FloatVectorOperations::clip(block.getChannelPointer(static_cast<size_t>(channel)),
+                                              block.getChannelPointer(static_cast<size_t>(channel)),
+                                              -ceiling, ceiling, chunkSize);
+    }
+
+    gainReductionDb.store(juce::Decibels::gainToDecibels(blockMinimumGain), std::memory_order_relaxed);
+}
+
+void OutputSafetyStage::processSoftClip(juce::dsp::AudioBlock<float>& block, float ceiling) noexcept
+{
+    // Linear up to half the ceiling, then a tanh shoulder towards the ceiling
+    // with a continuous slope at the knee
+    const float knee = ceiling * 0.5f;
+    const float range = ceiling - knee;
+
+    for (size_t channel = 0; channel < block.getNumChannels(); ++channel)
+    {
+        auto* data = block.getChannelPointer(channel);
+
+        for (size_t sample = 0; sample < block.getNumSamples(); ++sample)
+        {
+            const float input = data[sample];
+            const float magnitude = std::abs(input);
+
+            if (magnitude <= knee)
+                continue;
+
+            const float shaped = knee + range * std::tanh((magnitude - knee) / range);
+            data[sample] = std::copysign(shaped, input);
+            blockMinimumGain = juce::jmin(blockMinimumGain, shaped / magnitude);
+        }
+    }
+}
+
+void OutputSafetyStage::processLimiter(juce::dsp::AudioBlock<float>& block, float ceiling) noexcept
+{
+    const int numChannels = static_cast<int>(block.getNumChannels());
+    const int numSamples = static_cast<int>(block.getNumSamples());
+
+    for (int sample = 0; sample < numSamples; ++sample)
+    {
+        // Linked gain that keeps every channel of this sample under the ceiling
+        float peak = 0.0f;
+        for (int channel = 0; channel < numChannels; ++channel)
+            peak = juce::jmax(peak, std::abs(block.getSample(channel, sample)));
+
+        const float requiredGain = peak > ceiling ? ceiling / peak : 1.0f;
+
+        // Minimum over the window: drop queued values that have left the window,
+        // then those that can no longer be the minimum
+        while (queueSize > 0 && minimumPositions[queueHead] <= samplePosition - queueCapacity)
+        {
+            queueHead = (queueHead + 1) % queueCapacity;
+            --queueSize;
+        }
+
+        while (queueSize > 0)
+        {
+            const int back = (queueHead + queueSize - 1) % queueCapacity;
+
+            if (minimumValues[back] < requiredGain)
+                break;
+
+            --queueSize;
+        }
+
+        const int tail = (queueHead + queueSize) % queueCapacity;
+        minimumValues[tail] = requiredGain;
+        minimumPositions[tail] = samplePosition;
+        ++queueSize;
+
+        const float heldGain = minimumValues[queueHead];
+
+        // Box filter of the same length, so the gain is down in time for the peak
+        const int boxIndex = static_cast<int>(samplePosition % queueCapacity);
+        boxSum += heldGain - boxHistory[boxIndex];
+        boxHistory[boxIndex] = heldGain;
+        const float smoothedGain = juce::jmin(1.0f, static_cast<float>(boxSum / queueCapacity));
+
+        // Instant attack (already smoothed), one-pole release
+        if (smoothedGain < limiterGain)
+            limiterGain = smoothedGain;
+        else
+            limiterGain += releaseCoefficient * (smoothedGain - limiterGain);
+
+        blockMinimumGain = juce::jmin(blockMinimumGain, limiterGain);
+
+        // Emit the delayed sample with the gain computed for it
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            auto* delayed = lookaheadChannels[channel];
+            const float output = delayed[lookaheadIndex] * limiterGain;
+            delayed[lookaheadIndex] = block.getSample(channel, sample);
+            block.setSample(channel, sample, output);
+        }
+
+        lookaheadIndex = (lookaheadIndex + 1) % lookaheadSamples;
+        ++samplePosition;
+    }
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "AlignedArena.h"
+
+//==============================================================================
+/**
+ * Optional last stage that keeps the output below a ceiling.
+ *
+ * The signal is oversampled 2x, 4x or 8x with cascaded half-band polyphase
+ * FIR filters (juce::dsp::Oversampling), then either soft clipped or run
+ * through a linked lookahead limiter at the oversampled rate, so
+ * inter-sample peaks are caught as well. A final clamp after downsampling
+ * guarantees the ceiling against filter ripple.
+ *
+ * The limiter takes the gain each sample needs, holds its minimum over the
+ * lookahead window and smooths that with a box filter of the same length,
+ * so the gain has fully reached its target when the peak comes out of the
+ * lookahead delay. Release is a one-pole recovery.
+ */
+class OutputSafetyStage
+{
+public:
+    //==============================================================================
+    enum Mode
+    {
+        off,
+        softClip,
+        limiter
+    };
+
+    static constexpr double lookaheadSeconds = 0.001;
+    static constexpr double releaseSeconds = 0.05;
+
+    /** Allocates the oversampling filters for the mode and takes the limiter
+        buffers from arena, which must have getArenaBytes() left.
+        oversamplingIndex 0, 1 and 2 select 2x, 4x and 8x. Not real-time safe. */
+    void prepare(double sampleRate, int maximumBlockSize, int numChannels, Mode newMode, int oversamplingIndex,
+                 AlignedArena& arena);
+
+    /** The arena space prepare() takes at most, for any mode and oversampling. */
+    static size_t getArenaBytes(double sampleRate, int numChannels) noexcept;
+
+    /** Clears the filters, lookahead and gain state. */
+    void reset() noexcept;
+
+    Mode getMode() const noexcept { return mode; }
+
+    /** Latency in samples at the base rate; zero when off. */
+    int getLatencySamples() const noexcept { return latencySamples; }
+
+    /** Processes the first numChannels channels in place. */
+    void process(juce::AudioBuffer<float>& buffer, int numChannels, int numSamples, float ceilingDb) noexcept;
+
+    /** Largest gain reduction in the most recent block, in dB (0 or negative).
+        Safe to call from any thread. */
+    float getGainReductionDb() const noexcept { return gainReductionDb.load(std::memory_order_relaxed); }
+
+private:
+    //==============================================================================
+    void processSoftClip(juce::dsp::AudioBlock<float>& block, float ceiling) noexcept;
+    void processLimiter(juce::dsp::AudioBlock<float>& block, float ceiling) noexcept;
+
+    Mode mode { off };
+    int numPreparedChannels { 0 };
+    int maximumBlockSize { 0 };
+    int latencySamples { 0 };
+    double oversampledRate { 44100.0 };
+
+    std::unique_ptr<juce::dsp::Oversampling<float>> oversampling;
+
+    // Limiter state, at the oversampled rate. The buffers live in the arena.
+    int lookaheadSamples { 0 };
+    float** lookaheadChannels { nullptr };
+    int lookaheadIndex { 0 };
+
+    // Sliding-window minimum of the required gain, as a monotonic queue
+    float* minimumValues { nullptr };
+    juce::int64* minimumPositions { nullptr };
+    int queueHead { 0 };
+    int queueSize { 0 };
+    int queueCapacity { 1 };
+
+    // Box filter over the held minimum
+    float* boxHistory { nullptr };
+    double boxSum { 0.0 };
+
+    juce::int64 samplePosition { 0 };
+    float limiterGain { 1.0f };
+    float releaseCoefficient { 0.0f };
+
+    float blockMinimumGain { 1.0f };
+    std::atomic<float> gainReductionDb { 0.0f };
+};
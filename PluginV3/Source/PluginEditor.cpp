@@ -3,7 +3,8 @@
 
 //==============================================================================
 PluginV3AudioProcessorEditor::PluginV3AudioProcessorEditor (PluginV3AudioProcessor& p)
-    : AudioProcessorEditor (&p), audioProcessor (p)
+    : AudioProcessorEditor (&p), audioProcessor (p), levelHistoryView (p.getLevelHistory()),
+      meterBusView (p.getMeterBus()), spectrumView (p.getSpectrumAnalyser())
 {
     // Set up the level meters
     leftMeter.setVertical(true);
@@ -209,6 +210,149 @@ PluginV3AudioProcessorEditor::PluginV3AudioProcessorEditor (PluginV3AudioProcess
     stereoPlacementLabel.setJustificationType(juce::Justification::centred);
     addAndMakeVisible(stereoPlacementLabel);
     
+    // Mono compatibility analysis replaces the placement display while shown
+    monoCompatButton.setButtonText("Mono");
+    monoCompatButton.setTooltip("Check how each band sums to mono, and whether a polarity flip or delay would help");
+    monoCompatButton.setClickingTogglesState(true);
+    monoCompatButton.setColour(juce::TextButton::buttonOnColourId, juce::Colours::orange.darker(0.2f));
+    monoCompatButton.onClick = [this]() {
+        const bool show = monoCompatButton.getToggleState();
+        audioProcessor.setMonoAnalysisEnabled(show);
+        monoCompatView.setResult({});
+        monoCompatView.setVisible(show);
+    };
+    addAndMakeVisible(monoCompatButton);
+    
+    monoCompatView.onApply = [this](const MonoCompatAnalyser::Result& result) {
+        audioProcessor.applyMonoCompatRecommendation(result);
+        monoCompatView.setResult({});
+    };
+    addChildComponent(monoCompatView);
+    
+    // Set up the analyze & align controls
+    alignButton.setButtonText("Analyze & Align");
+    alignButton.setColour(juce::TextButton::buttonColourId, juce::Colours::darkcyan.darker(0.3f));
+    alignButton.onClick = [this]() {
+        audioProcessor.analyseAlignment();
+    };
+    addAndMakeVisible(alignButton);
+    
+    trackAlignmentButton.setButtonText("Track");
+    trackAlignmentButton.setColour(juce::ToggleButton::tickColourId, juce::Colours::cyan);
+    trackAlignmentButton.setColour(juce::ToggleButton::tickDisabledColourId, juce::Colours::darkgrey);
+    addAndMakeVisible(trackAlignmentButton);
+    
+    // Item IDs follow the choice index + 1, as expected by ComboBoxAttachment
+    alignSourceBox.addItemList({ "L/R", "Sidechain" }, 1);
+    alignSourceBox.setTooltip("Align L against R, or the main input against the sidechain");
+    addAndMakeVisible(alignSourceBox);
+    
+    alignmentStatusLabel.setJustificationType(juce::Justification::centredLeft);
+    alignmentStatusLabel.setColour(juce::Label::textColourId, juce::Colours::lightgrey);
+    addAndMakeVisible(alignmentStatusLabel);
+    
+    // Set up the per-channel delay sliders
+    auto setupDelaySlider = [this](juce::Slider& slider, juce::Label& label, const juce::String& text) {
+        slider.setSliderStyle(juce::Slider::SliderStyle::LinearHorizontal);
+        slider.setTextBoxStyle(juce::Slider::TextBoxRight, false, 70, 20);
+        slider.setTextValueSuffix(" ms");
+        slider.setDoubleClickReturnValue(true, 0.0);
+        slider.setColour(juce::Slider::thumbColourId, juce::Colours::cyan);
+        slider.setColour(juce::Slider::trackColourId, juce::Colours::lightblue.withAlpha(0.6f));
+        addAndMakeVisible(slider);
+        
+        label.setText(text, juce::dontSendNotification);
+        label.setJustificationType(juce::Justification::centredRight);
+        addAndMakeVisible(label);
+    };
+    
+    setupDelaySlider(leftDelaySlider, leftDelayLabel, "L Delay");
+    setupDelaySlider(rightDelaySlider, rightDelayLabel, "R Delay");
+    
+    // The range sets the longest usable delay (and how much memory it takes)
+    delayRangeBox.addItemList({ "10 ms", "100 ms", "500 ms", "1 s", "2 s" }, 1);
+    delayRangeBox.setTooltip("Maximum channel delay");
+    addAndMakeVisible(delayRangeBox);
+    
+    // Low cut: DC blocker or subsonic high-pass with its slope and frequency
+    lowCutLabel.setText("Low Cut", juce::dontSendNotification);
+    lowCutLabel.setJustificationType(juce::Justification::centredLeft);
+    addAndMakeVisible(lowCutLabel);
+    
+    lowCutModeBox.addItemList({ "Off", "DC Block", "6 dB/oct", "12 dB/oct", "18 dB/oct", "24 dB/oct" }, 1);
+    lowCutModeBox.setTooltip("Remove DC offset and subsonic content from the input");
+    addAndMakeVisible(lowCutModeBox);
+    
+    lowCutFrequencySlider.setSliderStyle(juce::Slider::SliderStyle::LinearHorizontal);
+    lowCutFrequencySlider.setTextBoxStyle(juce::Slider::TextBoxRight, false, 70, 20);
+    lowCutFrequencySlider.setTextValueSuffix(" Hz");
+    lowCutFrequencySlider.setDoubleClickReturnValue(true, 20.0);
+    lowCutFrequencySlider.setColour(juce::Slider::thumbColourId, juce::Colours::cyan);
+    lowCutFrequencySlider.setColour(juce::Slider::trackColourId, juce::Colours::lightblue.withAlpha(0.6f));
+    lowCutFrequencySlider.setTooltip("Low cut frequency (not used by the DC blocker)");
+    addAndMakeVisible(lowCutFrequencySlider);
+    
+    // Stereo width: mode, amount, delay time and mono safety
+    widthLabel.setText("Width", juce::dontSendNotification);
+    widthLabel.setJustificationType(juce::Justification::centredLeft);
+    addAndMakeVisible(widthLabel);
+    
+    widthModeBox.addItemList({ "Off", "Haas", "Diffuse" }, 1);
+    widthModeBox.setTooltip("Widen with a delayed (Haas) or diffused copy of the mid; the mono sum is unchanged");
+    addAndMakeVisible(widthModeBox);
+    
+    widthAmountSlider.setSliderStyle(juce::Slider::SliderStyle::LinearHorizontal);
+    widthAmountSlider.setTextBoxStyle(juce::Slider::TextBoxRight, false, 55, 20);
+    widthAmountSlider.setTextValueSuffix(" %");
+    widthAmountSlider.setDoubleClickReturnValue(true, 50.0);
+    widthAmountSlider.setColour(juce::Slider::thumbColourId, juce::Colours::cyan);
+    widthAmountSlider.setColour(juce::Slider::trackColourId, juce::Colours::lightblue.withAlpha(0.6f));
+    widthAmountSlider.setTooltip("Width amount");
+    addAndMakeVisible(widthAmountSlider);
+    
+    widthTimeSlider.setSliderStyle(juce::Slider::SliderStyle::LinearHorizontal);
+    widthTimeSlider.setTextBoxStyle(juce::Slider::TextBoxRight, false, 55, 20);
+    widthTimeSlider.setTextValueSuffix(" ms");
+    widthTimeSlider.setDoubleClickReturnValue(true, 12.0);
+    widthTimeSlider.setColour(juce::Slider::thumbColourId, juce::Colours::cyan);
+    widthTimeSlider.setColour(juce::Slider::trackColourId, juce::Colours::lightblue.withAlpha(0.6f));
+    widthTimeSlider.setTooltip("Haas delay, or the spread of the diffuse taps");
+    addAndMakeVisible(widthTimeSlider);
+    
+    widthMonoSafeButton.setButtonText("Mono Safe");
+    widthMonoSafeButton.setTooltip("Pull the width back while the output correlation is clearly negative");
+    addAndMakeVisible(widthMonoSafeButton);
+    
+    widthSafetyLabel.setJustificationType(juce::Justification::centredRight);
+    widthSafetyLabel.setColour(juce::Label::textColourId, juce::Colours::lightgrey);
+    addAndMakeVisible(widthSafetyLabel);
+    
+    // Output safety stage: mode, oversampling factor and ceiling
+    safetyLabel.setText("Output", juce::dontSendNotification);
+    safetyLabel.setJustificationType(juce::Justification::centredLeft);
+    addAndMakeVisible(safetyLabel);
+    
+    safetyModeBox.addItemList({ "Off", "Soft Clip", "Limiter" }, 1);
+    safetyModeBox.setTooltip("Oversampled soft clipper or true-peak limiter on the output (adds latency)");
+    addAndMakeVisible(safetyModeBox);
+    
+    safetyOversamplingBox.addItemList({ "2x", "4x", "8x" }, 1);
+    safetyOversamplingBox.setTooltip("Oversampling factor of the output safety stage");
+    addAndMakeVisible(safetyOversamplingBox);
+    
+    safetyCeilingSlider.setSliderStyle(juce::Slider::SliderStyle::LinearHorizontal);
+    safetyCeilingSlider.setTextBoxStyle(juce::Slider::TextBoxRight, false, 70, 20);
+    safetyCeilingSlider.setTextValueSuffix(" dB");
+    safetyCeilingSlider.setDoubleClickReturnValue(true, -1.0);
+    safetyCeilingSlider.setColour(juce::Slider::thumbColourId, juce::Colours::orange);
+    safetyCeilingSlider.setColour(juce::Slider::trackColourId, juce::Colours::orange.withAlpha(0.4f));
+    safetyCeilingSlider.setTooltip("Output ceiling");
+    addAndMakeVisible(safetyCeilingSlider);
+    
+    safetyReductionLabel.setJustificationType(juce::Justification::centredRight);
+    safetyReductionLabel.setColour(juce::Label::textColourId, juce::Colours::lightgrey);
+    addAndMakeVisible(safetyReductionLabel);
+    
     // Connect controls to parameters
     masterGainAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
         audioProcessor.getAPVTS(), "master_gain", masterGainKnob);
@@ -237,16 +381,152 @@ PluginV3AudioProcessorEditor::PluginV3AudioProcessorEditor (PluginV3AudioProcess
     enableMidSideAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(
         audioProcessor.getAPVTS(), "use_mid_side", enableMidSideButton);
     
+    trackAlignmentAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(
+        audioProcessor.getAPVTS(), "align_tracking", trackAlignmentButton);
+    
+    alignSourceAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(
+        audioProcessor.getAPVTS(), "align_source", alignSourceBox);
+    
+    leftDelayAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
+        audioProcessor.getAPVTS(), "left_delay", leftDelaySlider);
+    
+    rightDelayAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
+        audioProcessor.getAPVTS(), "right_delay", rightDelaySlider);
+    
+    delayRangeAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(
+        audioProcessor.getAPVTS(), "delay_range", delayRangeBox);
+    
+    autoGainAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(
+        audioProcessor.getAPVTS(), "auto_gain", autoGainButton);
+    
+    widthModeAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(
+        audioProcessor.getAPVTS(), "width_mode", widthModeBox);
+    
+    widthAmountAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
+        audioProcessor.getAPVTS(), "width_amount", widthAmountSlider);
+    
+    widthTimeAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
+        audioProcessor.getAPVTS(), "width_time", widthTimeSlider);
+    
+    widthMonoSafeAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(
+        audioProcessor.getAPVTS(), "width_mono_safe", widthMonoSafeButton);
+    
+    safetyModeAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(
+        audioProcessor.getAPVTS(), "safety_mode", safetyModeBox);
+    
+    safetyOversamplingAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(
+        audioProcessor.getAPVTS(), "safety_oversampling", safetyOversamplingBox);
+    
+    lowCutModeAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(
+        audioProcessor.getAPVTS(), "hpf_mode", lowCutModeBox);
+    
+    lowCutFrequencyAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
+        audioProcessor.getAPVTS(), "hpf_frequency", lowCutFrequencySlider);
+    
+    safetyCeilingAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
+        audioProcessor.getAPVTS(), "safety_ceiling", safetyCeilingSlider);
+    
+    // Preset bank: factory presets straight away, user presets once the background scan finishes
+    presetBox.setTextWhenNothingSelected("Presets");
+    presetBox.onChange = [this]() {
+        const int index = presetBox.getSelectedId() - 1;
+        
+        if (juce::isPositiveAndBelow(index, presetList.size()))
+            audioProcessor.getPresetManager().loadPreset(presetList.getReference(index));
+    };
+    addAndMakeVisible(presetBox);
+    
+    savePresetButton.setButtonText("Save");
+    savePresetButton.onClick = [this]() { showSavePresetDialog(); };
+    addAndMakeVisible(savePresetButton);
+    
+    // Loudness matching for fair A/B comparisons; the applied gain is shown in the button text
+    autoGainButton.setButtonText("Auto Gain");
+    autoGainButton.setTooltip("Match the output loudness to the input");
+    autoGainButton.setColour(juce::ToggleButton::tickColourId, juce::Colours::orange);
+    autoGainButton.setColour(juce::ToggleButton::tickDisabledColourId, juce::Colours::darkgrey);
+    addAndMakeVisible(autoGainButton);
+    
+    // Snapshot slots switch instantly; an unused slot starts as a copy of the current one
+    for (int slot = 0; slot < PresetManager::numSnapshots; ++slot)
+    {
+        auto& button = snapshotButtons[static_cast<size_t>(slot)];
+        button.setButtonText(juce::String::charToString(static_cast<juce::juce_wchar>('A' + slot)));
+        button.setTooltip("Snapshot " + button.getButtonText() + " (Shift-click copies the current settings here)");
+        button.setColour(juce::TextButton::buttonOnColourId, juce::Colours::orange.darker(0.2f));
+        button.onClick = [this, slot]() {
+            auto& presetManager = audioProcessor.getPresetManager();
+            
+            if (juce::ModifierKeys::currentModifiers.isShiftDown())
+                presetManager.copyActiveSnapshotTo(slot);
+            else
+                presetManager.selectSnapshot(slot);
+            
+            updateSnapshotButtons();
+        };
+        addAndMakeVisible(button);
+    }
+    
+    audioProcessor.getPresetManager().addChangeListener(this);
+    refreshPresetList();
+    updateSnapshotButtons();
+    
+    // Level history overlay, toggled from the alignment row
+    historyButton.setButtonText("History");
+    historyButton.setTooltip("Show the peak, RMS and correlation history");
+    historyButton.setClickingTogglesState(true);
+    historyButton.setColour(juce::TextButton::buttonOnColourId, juce::Colours::orange.darker(0.2f));
+    historyButton.onClick = [this]() {
+        showOverlay(historyButton.getToggleState() ? &levelHistoryView : nullptr);
+    };
+    addAndMakeVisible(historyButton);
+    addChildComponent(levelHistoryView);
+    
+    // Track overview across instances, sharing the space with the history
+    tracksButton.setButtonText("Tracks");
+    tracksButton.setTooltip("Show the levels, loudness and phase of every instance on this machine");
+    tracksButton.setClickingTogglesState(true);
+    tracksButton.setColour(juce::TextButton::buttonOnColourId, juce::Colours::orange.darker(0.2f));
+    tracksButton.onClick = [this]() {
+        showOverlay(tracksButton.getToggleState() ? &meterBusView : nullptr);
+    };
+    addAndMakeVisible(tracksButton);
+    addChildComponent(meterBusView);
+    
+    // Output spectrum, in the same place
+    spectrumButton.setButtonText("Spectrum");
+    spectrumButton.setTooltip("Show the L/R or M/S spectrum of the output");
+    spectrumButton.setClickingTogglesState(true);
+    spectrumButton.setColour(juce::TextButton::buttonOnColourId, juce::Colours::orange.darker(0.2f));
+    spectrumButton.onClick = [this]() {
+        showOverlay(spectrumButton.getToggleState() ? &spectrumView : nullptr);
+    };
+    addAndMakeVisible(spectrumButton);
+    addChildComponent(spectrumView);
+    
+    // Meter log for offline QA
+    meterLogButton.setButtonText("Log");
+    meterLogButton.setTooltip("Record per-block peak, true peak, RMS, loudness and correlation to a file");
+    meterLogButton.setColour(juce::TextButton::buttonOnColourId, juce::Colours::red.darker(0.3f));
+    meterLogButton.onClick = [this]() { toggleMeterLog(); };
+    addAndMakeVisible(meterLogButton);
+    
+    // Diagnostics overlay, hidden until toggled with Ctrl/Cmd+Shift+D or Alt-click on the title
+    addChildComponent(diagnosticsPanel);
+    setWantsKeyboardFocus(true);
+    
     // Start the timer for faster meter updates
     startTimerHz(60); // 60fps for smoother animation
     
     // Set editor size - increased height to ensure everything fits properly
-    setSize (650, 600);
+    setSize (650, 824);
 }
 
 PluginV3AudioProcessorEditor::~PluginV3AudioProcessorEditor()
 {
     stopTimer();
+    audioProcessor.getPresetManager().removeChangeListener(this);
+    audioProcessor.setMonoAnalysisEnabled(false);
 }
 
 //==============================================================================
@@ -269,9 +549,76 @@ void PluginV3AudioProcessorEditor::resized()
 {
     auto bounds = getLocalBounds().reduced(10);
     
+    // The diagnostics overlay covers the top of the editor when shown
+    diagnosticsPanel.setBounds(bounds.withTrimmedTop(30).removeFromTop(198).reduced(20, 0));
+    
+    // The history overlay covers the controls next to the meters when shown
+    levelHistoryView.setBounds(bounds.withTrimmedTop(30).withTrimmedRight(120).removeFromTop(260).reduced(10, 0));
+    meterBusView.setBounds(levelHistoryView.getBounds());
+    spectrumView.setBounds(levelHistoryView.getBounds());
+    
     // Reserve space for the title
     bounds.removeFromTop(30);
     
+    // Alignment strip along the bottom edge: delays below, analysis above
+    auto delayRow = bounds.removeFromBottom(36).reduced(5, 5);
+    delayRangeBox.setBounds(delayRow.removeFromLeft(80));
+    auto leftDelayBounds = delayRow.removeFromLeft(delayRow.getWidth() / 2);
+    leftDelayLabel.setBounds(leftDelayBounds.removeFromLeft(60));
+    leftDelaySlider.setBounds(leftDelayBounds.reduced(5, 0));
+    rightDelayLabel.setBounds(delayRow.removeFromLeft(60));
+    rightDelaySlider.setBounds(delayRow.reduced(5, 0));
+    
+    auto widthRow = bounds.removeFromBottom(36).reduced(5, 3);
+    widthLabel.setBounds(widthRow.removeFromLeft(55));
+    widthModeBox.setBounds(widthRow.removeFromLeft(110).reduced(0, 2));
+    widthRow.removeFromLeft(5);
+    widthSafetyLabel.setBounds(widthRow.removeFromRight(60));
+    widthMonoSafeButton.setBounds(widthRow.removeFromRight(95));
+    widthAmountSlider.setBounds(widthRow.removeFromLeft(widthRow.getWidth() / 2).reduced(5, 0));
+    widthTimeSlider.setBounds(widthRow.reduced(5, 0));
+    
+    auto lowCutRow = bounds.removeFromBottom(36).reduced(5, 3);
+    lowCutLabel.setBounds(lowCutRow.removeFromLeft(55));
+    lowCutModeBox.setBounds(lowCutRow.removeFromLeft(110).reduced(0, 2));
+    lowCutRow.removeFromLeft(5);
+    spectrumButton.setBounds(lowCutRow.removeFromRight(75));
+    lowCutFrequencySlider.setBounds(lowCutRow.reduced(5, 0));
+    
+    auto safetyRow = bounds.removeFromBottom(36).reduced(5, 3);
+    safetyLabel.setBounds(safetyRow.removeFromLeft(55));
+    safetyModeBox.setBounds(safetyRow.removeFromLeft(110).reduced(0, 2));
+    safetyRow.removeFromLeft(5);
+    safetyOversamplingBox.setBounds(safetyRow.removeFromLeft(60).reduced(0, 2));
+    safetyReductionLabel.setBounds(safetyRow.removeFromRight(110));
+    safetyCeilingSlider.setBounds(safetyRow.reduced(5, 0));
+    
+    auto presetRow = bounds.removeFromBottom(36).reduced(5, 3);
+    presetBox.setBounds(presetRow.removeFromLeft(220).reduced(0, 2));
+    presetRow.removeFromLeft(5);
+    savePresetButton.setBounds(presetRow.removeFromLeft(60));
+    presetRow.removeFromLeft(10);
+    autoGainButton.setBounds(presetRow.removeFromLeft(160));
+    
+    for (auto it = snapshotButtons.rbegin(); it != snapshotButtons.rend(); ++it)
+    {
+        it->setBounds(presetRow.removeFromRight(36));
+        presetRow.removeFromRight(4);
+    }
+    
+    auto alignmentRow = bounds.removeFromBottom(36).reduced(5, 3);
+    alignButton.setBounds(alignmentRow.removeFromLeft(130));
+    alignmentRow.removeFromLeft(10);
+    trackAlignmentButton.setBounds(alignmentRow.removeFromLeft(70));
+    alignSourceBox.setBounds(alignmentRow.removeFromLeft(100).reduced(0, 2));
+    tracksButton.setBounds(alignmentRow.removeFromRight(65));
+    alignmentRow.removeFromRight(4);
+    historyButton.setBounds(alignmentRow.removeFromRight(65));
+    alignmentRow.removeFromRight(4);
+    meterLogButton.setBounds(alignmentRow.removeFromRight(45));
+    alignmentRow.removeFromLeft(10);
+    alignmentStatusLabel.setBounds(alignmentRow);
+    
     // Create sections for our layout
     auto meterSection = bounds.removeFromRight(120); // Wider to accommodate equal-sized meters
     
@@ -298,8 +645,11 @@ void PluginV3AudioProcessorEditor::resized()
     
     // Position the stereo placement visualization
     auto stereoPlacementBounds = stereoPlacementSection.reduced(15);
-    stereoPlacementLabel.setBounds(stereoPlacementBounds.removeFromTop(20));
+    auto stereoPlacementHeader = stereoPlacementBounds.removeFromTop(20);
+    monoCompatButton.setBounds(stereoPlacementHeader.removeFromRight(50).reduced(0, 1));
+    stereoPlacementLabel.setBounds(stereoPlacementHeader.withTrimmedLeft(50));
     stereoPlacement.setBounds(stereoPlacementBounds);
+    monoCompatView.setBounds(stereoPlacementBounds);
     
     // Right side of top row for master gain and phase offset
     auto masterAndPhaseSection = topRow;
@@ -389,4 +739,236 @@ void PluginV3AudioProcessorEditor::timerCallback()
     
     // Update the stereo placement visualization
     stereoPlacement.setLevels(leftLevel, rightLevel);
+    
+    // Update the alignment status
+    alignmentStatusLabel.setText(getAlignmentStatusText(), juce::dontSendNotification);
+    
+    // Show the loudness-matching gain while it's in use
+    const float autoGainDb = audioProcessor.getAutoGainDb();
+    autoGainButton.setButtonText(std::abs(autoGainDb) >= 0.05f
+                                     ? "Auto Gain (" + juce::String(autoGainDb, 1) + " dB)"
+                                     : juce::String("Auto Gain"));
+    
+    // Gain reduction of the output safety stage
+    const float safetyReductionDb = audioProcessor.getSafetyGainReductionDb();
+    safetyReductionLabel.setText(safetyReductionDb <= -0.05f ? "GR " + juce::String(safetyReductionDb, 1) + " dB"
+                                                             : juce::String(),
+                                 juce::dontSendNotification);
+    
+    // How far mono safety has pulled the width back
+    const float widthSafetyGain = audioProcessor.getWidthSafetyGain();
+    widthSafetyLabel.setText(widthSafetyGain < 0.99f ? "-" + juce::String(juce::roundToInt((1.0f - widthSafetyGain) * 100.0f)) + " %"
+                                                     : juce::String(),
+                             juce::dontSendNotification);
+    
+    // Meter log progress
+    const auto& meterLog = audioProcessor.getMeterLog();
+    meterLogButton.setToggleState(meterLog.isRecording(), juce::dontSendNotification);
+    
+    if (meterLog.isRecording())
+        meterLogButton.setTooltip("Logging to " + meterLog.getFile().getFileName() + ": "
+                                  + juce::String(meterLog.getNumWritten()) + " blocks written, "
+                                  + juce::String(meterLog.getNumDropped()) + " dropped. Click to stop.");
+    else if (meterLogWasRecording && meterLog.getError().isNotEmpty())
+    {
+        // The log stopped by itself: the disk is full or went away
+        meterLogButton.setTooltip("Meter log stopped: " + meterLog.getError());
+        juce::AlertWindow::showMessageBoxAsync(juce::MessageBoxIconType::WarningIcon, "Meter Log", meterLog.getError());
+    }
+    
+    meterLogWasRecording = meterLog.isRecording();
+    
+    // Scroll the level history or poll the metering bus while shown
+    if ((levelHistoryView.isVisible() || meterBusView.isVisible()) && --historyRefreshCountdown <= 0)
+    {
+        if (levelHistoryView.isVisible())
+            levelHistoryView.repaint();
+        else
+            meterBusView.refresh();
+        
+        historyRefreshCountdown = 4;
+    }
+    
+    // The spectrum redraws only what changed, so it can follow every tick
+    if (spectrumView.isVisible())
+        spectrumView.refresh();
+    
+    // Mono compatibility results arrive about ten times a second
+    if (monoCompatView.isVisible() && --monoCompatRefreshCountdown <= 0)
+    {
+        monoCompatView.setResult(audioProcessor.getMonoCompatResult());
+        monoCompatRefreshCountdown = 3;
+    }
+    
+    // Refresh the diagnostics a few times a second while they're shown
+    if (diagnosticsPanel.isVisible() && --diagnosticsRefreshCountdown <= 0)
+    {
+        diagnosticsPanel.update(audioProcessor.getStageProfiler(), audioProcessor.getBlockSize());
+        diagnosticsRefreshCountdown = 15;
+    }
+}
+
+bool PluginV3AudioProcessorEditor::keyPressed(const juce::KeyPress& key)
+{
+    if (key == juce::KeyPress('d', juce::ModifierKeys::commandModifier | juce::ModifierKeys::shiftModifier, 0))
+    {
+        toggleDiagnostics();
+        return true;
+    }
+    
+    return false;
+}
+
+void PluginV3AudioProcessorEditor::mouseDown(const juce::MouseEvent& event)
+{
+    // Alt-click on the title, for hosts that keep keyboard focus to themselves
+    if (event.mods.isAltDown() && event.y < 30)
+        toggleDiagnostics();
+}
+
+void PluginV3AudioProcessorEditor::showOverlay(juce::Component* overlay)
+{
+    // The history, track overview and spectrum share one place, so only one shows
+    levelHistoryView.setVisible(overlay == &levelHistoryView);
+    meterBusView.setVisible(overlay == &meterBusView);
+    spectrumView.setVisible(overlay == &spectrumView);
+    historyButton.setToggleState(overlay == &levelHistoryView, juce::dontSendNotification);
+    tracksButton.setToggleState(overlay == &meterBusView, juce::dontSendNotification);
+    spectrumButton.setToggleState(overlay == &spectrumView, juce::dontSendNotification);
+    historyRefreshCountdown = 0;
+}
+
+void PluginV3AudioProcessorEditor::toggleMeterLog()
+{
+    if (audioProcessor.getMeterLog().isRecording())
+    {
+        audioProcessor.stopMeterLog();
+        meterLogButton.setToggleState(false, juce::dontSendNotification);
+        meterLogButton.setTooltip("Record per-block peak, true peak, RMS, loudness and correlation to a file");
+        return;
+    }
+    
+    const auto defaultFile = juce::File::getSpecialLocation(juce::File::userDocumentsDirectory)
+                                 .getChildFile("PluginV3 " + juce::Time::getCurrentTime().formatted("%Y-%m-%d %H-%M-%S"))
+                                 .withFileExtension("pv3meter");
+    
+    meterLogChooser = std::make_unique<juce::FileChooser>("Record Meter Log", defaultFile, "*.pv3meter");
+    
+    juce::Component::SafePointer<PluginV3AudioProcessorEditor> safeThis(this);
+    
+    meterLogChooser->launchAsync(juce::FileBrowserComponent::saveMode | juce::FileBrowserComponent::canSelectFiles
+                                     | juce::FileBrowserComponent::warnAboutOverwriting,
+                                 [safeThis](const juce::FileChooser& chooser) {
+        const auto file = chooser.getResult();
+        
+        if (safeThis == nullptr || file == juce::File())
+            return;
+        
+        juce::String error;
+        
+        if (! safeThis->audioProcessor.startMeterLog(file.withFileExtension("pv3meter"), error))
+            juce::AlertWindow::showMessageBoxAsync(juce::MessageBoxIconType::WarningIcon, "Meter Log", error);
+    });
+}
+
+void PluginV3AudioProcessorEditor::toggleDiagnostics()
+{
+    diagnosticsPanel.setVisible(! diagnosticsPanel.isVisible());
+    diagnosticsPanel.toFront(false);
+    diagnosticsRefreshCountdown = 0;
+}
+
+void PluginV3AudioProcessorEditor::changeListenerCallback(juce::ChangeBroadcaster* source)
+{
+    juce::ignoreUnused(source);
+    
+    refreshPresetList();
+    updateSnapshotButtons();
+}
+
+void PluginV3AudioProcessorEditor::refreshPresetList()
+{
+    presetList = audioProcessor.getPresetManager().getPresets();
+    presetBox.clear(juce::dontSendNotification);
+    
+    // Item IDs are the list index + 1
+    bool addedUserHeading = false;
+    presetBox.addSectionHeading("Factory");
+    
+    for (int i = 0; i < presetList.size(); ++i)
+    {
+        const auto& preset = presetList.getReference(i);
+        
+        if (preset.factoryIndex < 0 && ! addedUserHeading)
+        {
+            presetBox.addSeparator();
+            presetBox.addSectionHeading("User");
+            addedUserHeading = true;
+        }
+        
+        presetBox.addItem(preset.name, i + 1);
+    }
+}
+
+void PluginV3AudioProcessorEditor::updateSnapshotButtons()
+{
+    const int activeSnapshot = audioProcessor.getPresetManager().getActiveSnapshot();
+    
+    for (int slot = 0; slot < PresetManager::numSnapshots; ++slot)
+        snapshotButtons[static_cast<size_t>(slot)].setToggleState(slot == activeSnapshot, juce::dontSendNotification);
+}
+
+void PluginV3AudioProcessorEditor::showSavePresetDialog()
+{
+    auto* window = new juce::AlertWindow("Save Preset", "Save the current settings as a user preset:",
+                                         juce::MessageBoxIconType::NoIcon, this);
+    window->addTextEditor("name", "My Preset", "Name");
+    window->addButton("Save", 1, juce::KeyPress(juce::KeyPress::returnKey));
+    window->addButton("Cancel", 0, juce::KeyPress(juce::KeyPress::escapeKey));
+    
+    juce::Component::SafePointer<PluginV3AudioProcessorEditor> safeThis(this);
+    
+    window->enterModalState(true, juce::ModalCallbackFunction::create([safeThis, window](int result) {
+        if (result != 1 || safeThis == nullptr)
+            return;
+        
+        if (! safeThis->audioProcessor.getPresetManager().saveUserPreset(window->getTextEditorContents("name")))
+            juce::AlertWindow::showMessageBoxAsync(juce::MessageBoxIconType::WarningIcon, "Save Preset",
+                                                   "The preset could not be saved.");
+    }), true);
+}
+
+juce::String PluginV3AudioProcessorEditor::getAlignmentStatusText() const
+{
+    const bool toSidechain = audioProcessor.isAligningToSidechain();
+    
+    if (toSidechain && ! audioProcessor.isSidechainConnected())
+        return "No sidechain connected";
+    
+    if (audioProcessor.isAlignmentAnalysisRunning())
+        return "Analysing...";
+    
+    const auto result = audioProcessor.getLastAlignmentResult();
+    
+    if (! result.valid)
+        return {};
+    
+    const double sampleRate = audioProcessor.getSampleRate();
+    const double lagMs = sampleRate > 0.0 ? 1000.0 * std::abs(result.lagSamples) / sampleRate : 0.0;
+    
+    // Lags are measured for R relative to L, or main relative to the sidechain
+    const juce::String subject = toSidechain ? "Main" : "R";
+    
+    juce::String text;
+    if (std::abs(result.lagSamples) < 0.05f)
+        text = toSidechain ? "Main aligned to sidechain" : "L/R aligned";
+    else if (result.lagSamples < 0.0f)
+        text = subject + " early by " + juce::String(lagMs, 2) + " ms";
+    else
+        text = subject + " late by " + juce::String(lagMs, 2) + " ms" + (toSidechain ? " (can't advance)" : "");
+    
+    if (result.invertedPolarity)
+        text += ", polarity inverted";
+    
+    return text + " (" + juce::String(juce::roundToInt(result.confidence * 100.0f)) + "%)";
 }
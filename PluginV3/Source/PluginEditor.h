@@ -3,6 +3,11 @@
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
 #include "LevelMeter.h"
+#include "DiagnosticsPanel.h"
+#include "LevelHistoryView.h"
+#include "MeterBusView.h"
+#include "MonoCompatView.h"
+#include "SpectrumView.h"
 
 //==============================================================================
 // Stereo Placement Visualization Component
@@ -102,7 +107,8 @@ private:
 /**
 */
 class PluginV3AudioProcessorEditor  : public juce::AudioProcessorEditor,
-                                     private juce::Timer
+                                     private juce::Timer,
+                                     private juce::ChangeListener
 {
 public:
     PluginV3AudioProcessorEditor (PluginV3AudioProcessor&);
@@ -113,8 +119,23 @@ public:
     void resized() override;
     
     void timerCallback() override;
+    
+    bool keyPressed(const juce::KeyPress& key) override;
+    void mouseDown(const juce::MouseEvent& event) override;
 
 private:
+    // Builds the status text shown next to the align button
+    juce::String getAlignmentStatusText() const;
+    
+    // Shows or hides the per-stage timing overlay
+    void toggleDiagnostics();
+    
+    // Preset bank and snapshot slots
+    void changeListenerCallback(juce::ChangeBroadcaster* source) override;
+    void refreshPresetList();
+    void updateSnapshotButtons();
+    void showSavePresetDialog();
+    
     // This reference is provided as a quick way for your editor to
     // access the processor object that created it.
     PluginV3AudioProcessor& audioProcessor;
@@ -155,6 +176,76 @@ private:
     StereoPlacementComponent stereoPlacement;
     juce::Label stereoPlacementLabel;
     
+    // Per-band mono compatibility, shown over the stereo placement when toggled
+    juce::TextButton monoCompatButton;
+    MonoCompatView monoCompatView;
+    int monoCompatRefreshCountdown = 0;
+    
+    // Automatic delay/polarity alignment controls
+    juce::TextButton alignButton;
+    juce::ToggleButton trackAlignmentButton;
+    juce::ComboBox alignSourceBox;
+    juce::Label alignmentStatusLabel;
+    
+    // Per-channel delay controls
+    juce::Slider leftDelaySlider;
+    juce::Slider rightDelaySlider;
+    juce::Label leftDelayLabel;
+    juce::Label rightDelayLabel;
+    juce::ComboBox delayRangeBox;
+    
+    // Preset bank and A/B/C/D snapshots
+    juce::ComboBox presetBox;
+    juce::TextButton savePresetButton;
+    juce::ToggleButton autoGainButton;
+    std::array<juce::TextButton, PresetManager::numSnapshots> snapshotButtons;
+    juce::Array<PresetManager::PresetInfo> presetList;
+    
+    // DC blocker / subsonic filter controls
+    juce::Label lowCutLabel;
+    juce::ComboBox lowCutModeBox;
+    juce::Slider lowCutFrequencySlider;
+    
+    // Stereo width controls
+    juce::Label widthLabel;
+    juce::ComboBox widthModeBox;
+    juce::Slider widthAmountSlider;
+    juce::Slider widthTimeSlider;
+    juce::ToggleButton widthMonoSafeButton;
+    juce::Label widthSafetyLabel;
+    
+    // Output safety stage controls
+    juce::Label safetyLabel;
+    juce::ComboBox safetyModeBox;
+    juce::ComboBox safetyOversamplingBox;
+    juce::Slider safetyCeilingSlider;
+    juce::Label safetyReductionLabel;
+    
+    // Scrolling level history, shown over the controls when toggled
+    juce::TextButton historyButton;
+    LevelHistoryView levelHistoryView;
+    int historyRefreshCountdown = 0;
+    
+    // Overview of every instance on the machine, from the shared metering bus
+    juce::TextButton tracksButton;
+    MeterBusView meterBusView;
+    
+    // L/R or M/S spectra, sharing the overlay area
+    juce::TextButton spectrumButton;
+    SpectrumView spectrumView;
+    
+    void showOverlay(juce::Component* overlay);
+    
+    // Starts or stops the binary meter log
+    juce::TextButton meterLogButton;
+    std::unique_ptr<juce::FileChooser> meterLogChooser;
+    bool meterLogWasRecording = false;
+    void toggleMeterLog();
+    
+    // Hidden per-stage timing overlay
+    DiagnosticsPanel diagnosticsPanel;
+    int diagnosticsRefreshCountdown = 0;
+    
     // Parameter attachments
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> masterGainAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> leftGainAttachment;
@@ -165,6 +256,21 @@ private:
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> midGainAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> sideGainAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> enableMidSideAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> trackAlignmentAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> alignSourceAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> leftDelayAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> rightDelayAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> delayRangeAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> autoGainAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> lowCutModeAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> lowCutFrequencyAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> widthModeAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> widthAmountAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> widthTimeAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> widthMonoSafeAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> safetyModeAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> safetyOversamplingAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> safetyCeilingAttachment;
     
     // UI customization
     juce::Colour backgroundColour { juce::Colours::darkgrey.darker(0.8f) };
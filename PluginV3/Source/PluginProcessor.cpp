@@ -7,11 +7,14 @@ PluginV3AudioProcessor::PluginV3AudioProcessor()
                      #if ! JucePlugin_IsMidiEffect
                       #if ! JucePlugin_IsSynth
                        .withInput  ("Input",  juce::AudioChannelSet::stereo(), true)
+                       .withInput  ("Sidechain", juce::AudioChannelSet::stereo(), false)
                       #endif
                        .withOutput ("Output", juce::AudioChannelSet::stereo(), true)
                      #endif
                        ),
-       apvts (*this, nullptr, "Parameters", createParameterLayout())
+       apvts (*this, nullptr, "Parameters", createParameterLayout()),
+       // Only hosted instances publish; the offline tools create processors directly
+       meterBus (wrapperType != wrapperType_Undefined)
 {
     // Add parameter listeners
     apvts.addParameterListener("master_gain", this);
@@ -20,9 +23,35 @@ PluginV3AudioProcessor::PluginV3AudioProcessor()
     apvts.addParameterListener("invert_left", this);
     apvts.addParameterListener("invert_right", this);
     apvts.addParameterListener("phase_offset", this);
+    apvts.addParameterListener("left_delay", this);
+    apvts.addParameterListener("right_delay", this);
+    apvts.addParameterListener("delay_range", this);
     apvts.addParameterListener("mid_gain", this);
     apvts.addParameterListener("side_gain", this);
     apvts.addParameterListener("use_mid_side", this);
+    apvts.addParameterListener("hpf_mode", this);
+    apvts.addParameterListener("hpf_frequency", this);
+    apvts.addParameterListener("auto_gain", this);
+    apvts.addParameterListener("safety_mode", this);
+    apvts.addParameterListener("safety_oversampling", this);
+    apvts.addParameterListener("safety_ceiling", this);
+    apvts.addParameterListener("align_tracking", this);
+    apvts.addParameterListener("align_source", this);
+    apvts.addParameterListener("width_mode", this);
+    apvts.addParameterListener("width_amount", this);
+    apvts.addParameterListener("width_time", this);
+    apvts.addParameterListener("width_mono_safe", this);
+    
+    delayAligner.onResult = [this](const CrossCorrelator::Result& result)
+    {
+        applyAlignmentResult(result);
+    };
+    
+    // Until the host names the track
+    meterBus.setName("PluginV3 #" + juce::String(stageProfiler.getInstanceNumber()));
+    
+    // Keeps the level history and the metering bus running whether or not the editor is open
+    startTimerHz(30);
 }
 
 PluginV3AudioProcessor::~PluginV3AudioProcessor()
@@ -34,9 +63,31 @@ PluginV3AudioProcessor::~PluginV3AudioProcessor()
     apvts.removeParameterListener("invert_left", this);
     apvts.removeParameterListener("invert_right", this);
     apvts.removeParameterListener("phase_offset", this);
+    apvts.removeParameterListener("left_delay", this);
+    apvts.removeParameterListener("right_delay", this);
+    apvts.removeParameterListener("delay_range", this);
     apvts.removeParameterListener("mid_gain", this);
     apvts.removeParameterListener("side_gain", this);
     apvts.removeParameterListener("use_mid_side", this);
+    apvts.removeParameterListener("hpf_mode", this);
+    apvts.removeParameterListener("hpf_frequency", this);
+    apvts.removeParameterListener("auto_gain", this);
+    apvts.removeParameterListener("safety_mode", this);
+    apvts.removeParameterListener("safety_oversampling", this);
+    apvts.removeParameterListener("safety_ceiling", this);
+    apvts.removeParameterListener("align_tracking", this);
+    apvts.removeParameterListener("align_source", this);
+    apvts.removeParameterListener("width_mode", this);
+    apvts.removeParameterListener("width_amount", this);
+    apvts.removeParameterListener("width_time", this);
+    apvts.removeParameterListener("width_mono_safe", this);
+    
+    stopTimer();
+    cancelPendingUpdate();
+    meterLog.stop();
+    delayAligner.onResult = nullptr;
+    delayAligner.release();
+    monoAnalyser.release();
 }
 
 juce::AudioProcessorValueTreeState::ParameterLayout PluginV3AudioProcessor::createParameterLayout()
@@ -83,6 +134,29 @@ juce::AudioProcessorValueTreeState::ParameterLayout PluginV3AudioProcessor::crea
         juce::NormalisableRange<float>(0.0f, 360.0f, 0.1f), // min, max, step
         0.0f);                                     // Default value (0 degrees)
     
+    // Create per-channel delay parameters (in milliseconds), used for alignment.
+    // The usable maximum is limited by the delay range below.
+    auto leftDelayParam = std::make_unique<juce::AudioParameterFloat>(
+        "left_delay",                              // Parameter ID
+        "Left Delay",                              // Parameter name
+        juce::NormalisableRange<float>(0.0f, 2000.0f, 0.001f, 0.3f), // min, max, step, skew
+        0.0f);                                     // Default value (no delay)
+    
+    auto rightDelayParam = std::make_unique<juce::AudioParameterFloat>(
+        "right_delay",                             // Parameter ID
+        "Right Delay",                             // Parameter name
+        juce::NormalisableRange<float>(0.0f, 2000.0f, 0.001f, 0.3f), // min, max, step, skew
+        0.0f);                                     // Default value (no delay)
+    
+    // Maximum channel delay. This sets how much delay memory is allocated, so it
+    // isn't automatable: changing it reallocates off the audio thread.
+    auto delayRangeParam = std::make_unique<juce::AudioParameterChoice>(
+        "delay_range",                             // Parameter ID
+        "Delay Range",                             // Parameter name
+        juce::StringArray { "10 ms", "100 ms", "500 ms", "1 s", "2 s" }, // Choices
+        0,                                         // Default value (10 ms)
+        juce::AudioParameterChoiceAttributes().withAutomatable(false));
+    
     // Create Mid/Side gain parameters
     auto midGainParam = std::make_unique<juce::AudioParameterFloat>(
         "mid_gain",                                // Parameter ID
@@ -102,15 +176,110 @@ juce::AudioProcessorValueTreeState::ParameterLayout PluginV3AudioProcessor::crea
         "Enable Mid/Side",                         // Parameter name
         false);                                    // Default value (disabled)
     
+    // DC blocker / subsonic high-pass ahead of the M/S and polarity stages
+    auto hpfModeParam = std::make_unique<juce::AudioParameterChoice>(
+        "hpf_mode",                                // Parameter ID
+        "Low Cut",                                 // Parameter name
+        juce::StringArray { "Off", "DC Block", "6 dB/oct", "12 dB/oct", "18 dB/oct", "24 dB/oct" }, // Choices
+        0);                                        // Default value (off)
+    
+    auto hpfFrequencyParam = std::make_unique<juce::AudioParameterFloat>(
+        "hpf_frequency",                           // Parameter ID
+        "Low Cut Frequency",                       // Parameter name
+        juce::NormalisableRange<float>(10.0f, 200.0f, 0.1f, 0.5f), // min, max, step, skew
+        20.0f);                                    // Default value (20 Hz)
+    
+    // Toggle to match the output loudness to the input, for fair A/B comparisons
+    auto autoGainParam = std::make_unique<juce::AudioParameterBool>(
+        "auto_gain",                               // Parameter ID
+        "Auto Gain",                               // Parameter name
+        false);                                    // Default value (disabled)
+    
+    // Output safety stage. Mode and oversampling change the latency reported to
+    // the host, so like the delay range they aren't automatable.
+    auto safetyModeParam = std::make_unique<juce::AudioParameterChoice>(
+        "safety_mode",                             // Parameter ID
+        "Output Safety",                           // Parameter name
+        juce::StringArray { "Off", "Soft Clip", "Limiter" }, // Choices
+        0,                                         // Default value (off)
+        juce::AudioParameterChoiceAttributes().withAutomatable(false));
+    
+    auto safetyOversamplingParam = std::make_unique<juce::AudioParameterChoice>(
+        "safety_oversampling",                     // Parameter ID
+        "Safety Oversampling",                     // Parameter name
+        juce::StringArray { "2x", "4x", "8x" },    // Choices
+        1,                                         // Default value (4x)
+        juce::AudioParameterChoiceAttributes().withAutomatable(false));
+    
+    // Output ceiling for the safety stage (in dB)
+    auto safetyCeilingParam = std::make_unique<juce::AudioParameterFloat>(
+        "safety_ceiling",                          // Parameter ID
+        "Safety Ceiling",                          // Parameter name
+        juce::NormalisableRange<float>(-12.0f, 0.0f, 0.1f), // min, max, step
+        -1.0f);                                    // Default value (-1 dB)
+    
+    // Toggle to keep re-running the L/R alignment analysis in the background
+    auto alignTrackingParam = std::make_unique<juce::AudioParameterBool>(
+        "align_tracking",                          // Parameter ID
+        "Align Tracking",                          // Parameter name
+        false);                                    // Default value (disabled)
+    
+    // What the alignment analysis compares: L against R, or the main input against the sidechain
+    auto alignSourceParam = std::make_unique<juce::AudioParameterChoice>(
+        "align_source",                            // Parameter ID
+        "Align Source",                            // Parameter name
+        juce::StringArray { "L/R", "Sidechain" },  // Choices
+        0);                                        // Default value (L/R)
+    
+    // Stereo width: a Haas delay or a diffuse copy of the mid, added to L and taken from R
+    auto widthModeParam = std::make_unique<juce::AudioParameterChoice>(
+        "width_mode",                              // Parameter ID
+        "Width Mode",                              // Parameter name
+        juce::StringArray { "Off", "Haas", "Diffuse" }, // Choices
+        0);                                        // Default value (off)
+    
+    auto widthAmountParam = std::make_unique<juce::AudioParameterFloat>(
+        "width_amount",                            // Parameter ID
+        "Width Amount",                            // Parameter name
+        juce::NormalisableRange<float>(0.0f, 100.0f, 0.1f), // min, max, step
+        50.0f);                                    // Default value (50%)
+    
+    auto widthTimeParam = std::make_unique<juce::AudioParameterFloat>(
+        "width_time",                              // Parameter ID
+        "Width Time",                              // Parameter name
+        juce::NormalisableRange<float>(1.0f, 30.0f, 0.01f, 0.5f), // min, max, step, skew
+        12.0f);                                    // Default value (12 ms)
+    
+    // Toggle to pull the width back while the output correlation goes negative
+    auto widthMonoSafeParam = std::make_unique<juce::AudioParameterBool>(
+        "width_mono_safe",                         // Parameter ID
+        "Width Mono Safe",                         // Parameter name
+        true);                                     // Default value (enabled)
+    
     layout.add(std::move(masterGainParam));
     layout.add(std::move(leftGainParam));
     layout.add(std::move(rightGainParam));
     layout.add(std::move(invertLeftParam));
     layout.add(std::move(invertRightParam));
     layout.add(std::move(phaseOffsetParam));
+    layout.add(std::move(leftDelayParam));
+    layout.add(std::move(rightDelayParam));
+    layout.add(std::move(delayRangeParam));
     layout.add(std::move(midGainParam));
     layout.add(std::move(sideGainParam));
     layout.add(std::move(useMidSideParam));
+    layout.add(std::move(hpfModeParam));
+    layout.add(std::move(hpfFrequencyParam));
+    layout.add(std::move(autoGainParam));
+    layout.add(std::move(safetyModeParam));
+    layout.add(std::move(safetyOversamplingParam));
+    layout.add(std::move(safetyCeilingParam));
+    layout.add(std::move(alignTrackingParam));
+    layout.add(std::move(alignSourceParam));
+    layout.add(std::move(widthModeParam));
+    layout.add(std::move(widthAmountParam));
+    layout.add(std::move(widthTimeParam));
+    layout.add(std::move(widthMonoSafeParam));
     
     return layout;
 }
@@ -129,38 +298,108 @@ void PluginV3AudioProcessor::parameterChanged(const juce::String& parameterID, f
         invertRightPhase = newValue > 0.5f;
     else if (parameterID == "phase_offset")
         phaseOffset = newValue;
+    else if (parameterID == "left_delay")
+        leftDelayMs = newValue;
+    else if (parameterID == "right_delay")
+        rightDelayMs = newValue;
+    else if (parameterID == "delay_range")
+    {
+        delayRangeIndex = juce::jlimit(0, numDelayRanges - 1, juce::roundToInt(newValue));
+        
+        // Resizing the delay memory has to happen away from the audio thread
+        delayRangeChanged = true;
+        triggerAsyncUpdate();
+    }
     else if (parameterID == "mid_gain")
         midGain = newValue;
     else if (parameterID == "side_gain")
         sideGain = newValue;
     else if (parameterID == "use_mid_side")
         useMidSideProcessing = newValue > 0.5f;
+    else if (parameterID == "hpf_mode")
+        lowCutMode = static_cast<SubsonicFilter::Mode>(juce::jlimit(0, 5, juce::roundToInt(newValue)));
+    else if (parameterID == "hpf_frequency")
+        lowCutFrequency = newValue;
+    else if (parameterID == "auto_gain")
+        autoGainEnabled = newValue > 0.5f;
+    else if (parameterID == "safety_mode" || parameterID == "safety_oversampling")
+    {
+        // New filters and a new latency, both set up on the message thread
+        safetyChanged = true;
+        triggerAsyncUpdate();
+    }
+    else if (parameterID == "safety_ceiling")
+        safetyCeilingDb = newValue;
+    else if (parameterID == "align_tracking")
+        delayAligner.setContinuousTracking(newValue > 0.5f);
+    else if (parameterID == "align_source")
+    {
+        alignToSidechain = newValue > 0.5f;
+        
+        // Restart a running analysis so frames from both sources never mix
+        if (delayAligner.isAnalysing())
+            delayAligner.requestAnalysis();
+    }
+    else if (parameterID == "width_mode")
+        widthMode = static_cast<DelayLine::Width::Mode>(juce::jlimit(0, 2, juce::roundToInt(newValue)));
+    else if (parameterID == "width_amount")
+        widthAmount = newValue / 100.0f;
+    else if (parameterID == "width_time")
+        widthTimeMs = newValue;
+    else if (parameterID == "width_mono_safe")
+        widthMonoSafe = newValue > 0.5f;
 }
 
-void PluginV3AudioProcessor::processMidSide(juce::AudioBuffer<float>& buffer, int numSamples)
+void PluginV3AudioProcessor::processMidSide(juce::AudioBuffer<float>& buffer, int numSamples,
+                                            float targetMidGain, float targetSideGain)
 {
     // This only works with stereo audio
     if (buffer.getNumChannels() < 2)
         return;
     
-    auto* leftChannel = buffer.getWritePointer(0);
-    auto* rightChannel = buffer.getWritePointer(1);
-    
-    // Process each sample
-    for (int sample = 0; sample < numSamples; ++sample)
+    if (appliedMidGain == targetMidGain && appliedSideGain == targetSideGain)
+        DspKernels::applyMidSideGain(buffer.getWritePointer(0), buffer.getWritePointer(1),
+                                     numSamples, targetMidGain, targetSideGain);
+    else
+        DspKernels::applyMidSideGainRamp(buffer.getWritePointer(0), buffer.getWritePointer(1), numSamples,
+                                         appliedMidGain, targetMidGain, appliedSideGain, targetSideGain);
+}
+
+void PluginV3AudioProcessor::applyChannelGain(float* channelData, int numSamples, float targetGain, float& appliedGain) noexcept
+{
+    if (targetGain == appliedGain)
     {
-        // Convert L/R to Mid/Side
-        const float mid = (leftChannel[sample] + rightChannel[sample]) * 0.5f;
-        const float side = (rightChannel[sample] - leftChannel[sample]) * 0.5f;
-        
-        // Apply Mid/Side gain
-        const float processedMid = mid * midGain;
-        const float processedSide = side * sideGain;
-        
-        // Convert back to L/R
-        leftChannel[sample] = processedMid - processedSide;
-        rightChannel[sample] = processedMid + processedSide;
+        DspKernels::applyGain(channelData, numSamples, targetGain, false);
+        return;
     }
+    
+    DspKernels::applyGainRamp(channelData, numSamples, appliedGain, targetGain);
+    appliedGain = targetGain;
+}
+
+void PluginV3AudioProcessor::applySnapshot(const PresetManager::SnapshotValues& values) noexcept
+{
+    masterGain = values[PresetManager::masterGainValue];
+    leftGain = values[PresetManager::leftGainValue];
+    rightGain = values[PresetManager::rightGainValue];
+    invertLeftPhase = values[PresetManager::invertLeftValue] > 0.5f;
+    invertRightPhase = values[PresetManager::invertRightValue] > 0.5f;
+    phaseOffset = values[PresetManager::phaseOffsetValue];
+    leftDelayMs = values[PresetManager::leftDelayValue];
+    rightDelayMs = values[PresetManager::rightDelayValue];
+    midGain = values[PresetManager::midGainValue];
+    sideGain = values[PresetManager::sideGainValue];
+    useMidSideProcessing = values[PresetManager::useMidSideValue] > 0.5f;
+    autoGainEnabled = values[PresetManager::autoGainValue] > 0.5f;
+    safetyCeilingDb = values[PresetManager::safetyCeilingValue];
+    lowCutMode = static_cast<SubsonicFilter::Mode>(
+        juce::jlimit(0, 5, juce::roundToInt(values[PresetManager::lowCutModeValue])));
+    lowCutFrequency = values[PresetManager::lowCutFrequencyValue];
+    widthMode = static_cast<DelayLine::Width::Mode>(
+        juce::jlimit(0, 2, juce::roundToInt(values[PresetManager::widthModeValue])));
+    widthAmount = values[PresetManager::widthAmountValue] / 100.0f;
+    widthTimeMs = values[PresetManager::widthTimeValue];
+    widthMonoSafe = values[PresetManager::widthMonoSafeValue] > 0.5f;
 }
 
 float PluginV3AudioProcessor::getPhaseOffsetDelaySamples() const
@@ -170,21 +409,172 @@ float PluginV3AudioProcessor::getPhaseOffsetDelaySamples() const
     return (phaseOffset / 360.0f) * (sampleRate / 100.0f); // Limit to max 10ms at 360 degrees
 }
 
-void PluginV3AudioProcessor::updateDelayBufferSize(int samplesPerBlock)
+float PluginV3AudioProcessor::getDelayRangeMs() const
 {
-    // Calculate max delay needed (10ms max)
-    int maxDelaySamples = juce::roundToInt(sampleRate * 0.01f); // 10ms
+    static constexpr float rangesMs[numDelayRanges] = { 10.0f, 100.0f, 500.0f, 1000.0f, 2000.0f };
+    return rangesMs[delayRangeIndex];
+}
+
+int PluginV3AudioProcessor::getMaximumDelaySamples() const
+{
+    // Only what the selected range needs, plus the 10ms phase offset
+    return juce::roundToInt((getDelayRangeMs() + 10.0f) * sampleRate / 1000.0f);
+}
+
+int PluginV3AudioProcessor::getMaximumWidthDelaySamples() const
+{
+    // The width taps read up to 30ms behind the channel delay
+    return juce::roundToInt(sampleRate * 0.03f) + 1;
+}
+
+void PluginV3AudioProcessor::prepareArena()
+{
+    // The safety stage goes last, so a mode change can take its part again
+    // without disturbing the delay line. Its part is sized for the largest
+    // setting; only a new delay range needs a new block.
+    arena.allocate(DelayLine::getArenaBytes(getMaximumDelaySamples(), getMaximumWidthDelaySamples())
+                   + OutputSafetyStage::getArenaBytes(sampleRate, juce::jmax(1, getMainBusNumOutputChannels())));
     
-    // Ensure buffer is at least twice the block size + maximum delay
-    delayBufferLength = 2 * samplesPerBlock + maxDelaySamples;
+    prepareDelayLine();
+    safetyArenaMark = arena.getMark();
+    prepareSafetyStage();
+}
+
+void PluginV3AudioProcessor::prepareDelayLine()
+{
+    // Delay changes crossfade between read heads over 20ms
+    delayLine.prepare(getMaximumDelaySamples(), juce::roundToInt(sampleRate * 0.02f), getMaximumWidthDelaySamples(), arena);
     
-    // Create or resize the delay buffer if needed
-    if (delayBuffer == nullptr || delayBuffer->getNumSamples() < delayBufferLength)
+    // Alignment searches the delay range, capped so analysis frames stay short
+    const float maxLagMs = juce::jmin(getDelayRangeMs(), 500.0f);
+    delayAligner.prepare(sampleRate, juce::roundToInt(maxLagMs * sampleRate / 1000.0f));
+}
+
+void PluginV3AudioProcessor::prepareSafetyStage()
+{
+    const auto mode = static_cast<OutputSafetyStage::Mode>(
+        juce::jlimit(0, 2, juce::roundToInt(apvts.getRawParameterValue("safety_mode")->load())));
+    const int oversamplingIndex = juce::roundToInt(apvts.getRawParameterValue("safety_oversampling")->load());
+    
+    arena.rewind(safetyArenaMark);
+    outputSafety.prepare(sampleRate, maximumBlockSize, juce::jmax(1, getMainBusNumOutputChannels()),
+                         mode, oversamplingIndex, arena);
+    setLatencySamples(outputSafety.getLatencySamples());
+}
+
+void PluginV3AudioProcessor::handleAsyncUpdate()
+{
+    // Only reallocate once the host has told us the sample rate
+    if (! isPrepared)
+        return;
+    
+    const bool rangeChanged = delayRangeChanged.exchange(false);
+    const bool safetyStageChanged = safetyChanged.exchange(false);
+    
+    suspendProcessing(true);
+    
+    // A new range needs a block of another size, so everything in the arena
+    // is prepared again; the safety stage's part can be retaken on its own
+    if (rangeChanged)
+        prepareArena();
+    else if (safetyStageChanged)
+        prepareSafetyStage();
+    
+    suspendProcessing(false);
+}
+
+void PluginV3AudioProcessor::timerCallback()
+{
+    MeterFrame frame;
+    
+    while (meterFrames.pop(frame))
+        levelHistory.addFrame(frame);
+    
+    meterBus.heartbeat();
+}
+
+void PluginV3AudioProcessor::updateTrackProperties(const TrackProperties& properties)
+{
+    if (properties.name.has_value() && properties.name->isNotEmpty())
+        meterBus.setName(*properties.name);
+}
+
+void PluginV3AudioProcessor::applyAlignmentResult(const CrossCorrelator::Result& result)
+{
+    // Ignore windows that didn't correlate clearly (noise, silence, unrelated sources)
+    if (! result.valid || result.confidence < 0.1f)
+        return;
+    
+    const float lagMs = result.lagSamples * 1000.0f / sampleRate;
+    float newLeftDelayMs = 0.0f;
+    float newRightDelayMs = 0.0f;
+    
+    if (alignToSidechain)
     {
-        delayBuffer.reset(new juce::AudioBuffer<float>(2, delayBufferLength));
-        delayBuffer->clear();
-        delayBufferPos = 0;
+        // The lag is main relative to the reference. A late main signal can't
+        // be advanced, so only an early one gets delayed (both channels together)
+        newLeftDelayMs = newRightDelayMs = juce::jmax(0.0f, -lagMs);
+        
+        setParameterFromAnalysis("invert_left", result.invertedPolarity ? 1.0f : 0.0f);
+        setParameterFromAnalysis("invert_right", result.invertedPolarity ? 1.0f : 0.0f);
     }
+    else
+    {
+        // The lag is R relative to L: delay whichever channel arrives first
+        newLeftDelayMs = juce::jmax(0.0f, lagMs);
+        newRightDelayMs = juce::jmax(0.0f, -lagMs);
+        
+        setParameterFromAnalysis("invert_right", result.invertedPolarity ? 1.0f : 0.0f);
+    }
+    
+    // Avoid chasing sub-sample jitter while tracking continuously
+    const float minimumChangeMs = 0.25f * 1000.0f / sampleRate;
+    
+    if (std::abs(newLeftDelayMs - leftDelayMs) > minimumChangeMs)
+        setParameterFromAnalysis("left_delay", newLeftDelayMs);
+    
+    if (std::abs(newRightDelayMs - rightDelayMs) > minimumChangeMs)
+        setParameterFromAnalysis("right_delay", newRightDelayMs);
+    
+    // The measured delays are absolute, so any manual offset would misalign them again
+    if (phaseOffset > 0.0f)
+        setParameterFromAnalysis("phase_offset", 0.0f);
+}
+
+void PluginV3AudioProcessor::applyMonoCompatRecommendation(const MonoCompatAnalyser::Result& result)
+{
+    if (! result.valid || result.recommendation == MonoCompatAnalyser::none)
+        return;
+    
+    // The analysis sees the output, so its corrections are relative to the current settings
+    if (result.recommendation == MonoCompatAnalyser::flipPolarity
+        || result.recommendation == MonoCompatAnalyser::delayAndFlipPolarity)
+        setParameterFromAnalysis("invert_right", invertRightPhase ? 0.0f : 1.0f);
+    
+    if (result.recommendation == MonoCompatAnalyser::delay
+        || result.recommendation == MonoCompatAnalyser::delayAndFlipPolarity)
+    {
+        // A late R means L needs more delay than R, whichever way they're set now
+        const float difference = leftDelayMs - rightDelayMs + result.delayMs;
+        setParameterFromAnalysis("left_delay", juce::jmax(0.0f, difference));
+        setParameterFromAnalysis("right_delay", juce::jmax(0.0f, -difference));
+    }
+    
+    // Measure the corrected signal from scratch
+    monoAnalyser.restart();
+}
+
+void PluginV3AudioProcessor::setParameterFromAnalysis(const juce::String& parameterID, float newValue)
+{
+    auto* param = apvts.getParameter(parameterID);
+    
+    // Unchanged values aren't sent, so tracking doesn't write automation on every result
+    if (param == nullptr || param->getValue() == param->convertTo0to1(newValue))
+        return;
+    
+    param->beginChangeGesture();
+    param->setValueNotifyingHost(param->convertTo0to1(newValue));
+    param->endChangeGesture();
 }
 
 //==============================================================================
@@ -227,24 +617,27 @@ double PluginV3AudioProcessor::getTailLengthSeconds() const
 
 int PluginV3AudioProcessor::getNumPrograms()
 {
-    return 1;   // NB: some hosts don't cope very well if you tell them there are 0 programs,
-                // so this should be at least 1, even if you're not really implementing programs.
+    // Host programs are the factory presets; user presets live in the editor
+    return PresetManager::getNumFactoryPresets();
 }
 
 int PluginV3AudioProcessor::getCurrentProgram()
 {
-    return 0;
+    return presetManager.getLastFactoryPreset();
 }
 
 void PluginV3AudioProcessor::setCurrentProgram (int index)
 {
-    juce::ignoreUnused(index);
+    // Some hosts re-select the current program after restoring a session,
+    // which mustn't throw away the restored settings. Any later change,
+    // including re-selecting the current program, loads the preset.
+    if (! stateJustRestored.exchange(false))
+        presetManager.loadFactoryPreset(index);
 }
 
 const juce::String PluginV3AudioProcessor::getProgramName (int index)
 {
-    juce::ignoreUnused(index);
-    return {};
+    return PresetManager::getFactoryPresetName(index);
 }
 
 void PluginV3AudioProcessor::changeProgramName (int index, const juce::String& newName)
@@ -260,6 +653,9 @@ void PluginV3AudioProcessor::prepareToPlay (double newSampleRate, int samplesPer
     // Store sample rate for phase offset calculations
     sampleRate = static_cast<float>(newSampleRate);
     
+    // Pick the widest instruction set this machine supports for the kernels
+    DspKernels::selectInstructionSet();
+    
     // Initialize level smoothing with appropriate ramp length
     leftChannelLevel.reset(sampleRate, 0.5);  // 500ms smoothing
     rightChannelLevel.reset(sampleRate, 0.5); // 500ms smoothing
@@ -267,14 +663,52 @@ void PluginV3AudioProcessor::prepareToPlay (double newSampleRate, int samplesPer
     leftChannelLevel.setCurrentAndTargetValue(0.0f);
     rightChannelLevel.setCurrentAndTargetValue(0.0f);
     
-    // Initialize delay buffer for phase offset
-    updateDelayBufferSize(samplesPerBlock);
+    // Loudness matching starts from unity
+    autoGain.prepare(sampleRate);
+    
+    // Momentary loudness for the metering bus
+    meterBus.prepare(sampleRate);
+    
+    // Mono compatibility works on a decimated copy of the output
+    monoAnalyser.prepare(sampleRate);
+    spectrumAnalyser.prepare(sampleRate);
+    
+    // True peak and loudness for the meter log
+    for (auto& detector : logTruePeaks)
+        detector.prepare(sampleRate);
+    
+    logLoudness.prepare(sampleRate);
+    wasLogging = false;
+    
+    // Low cut coefficients depend on the sample rate
+    lowCutFilter.setMode(lowCutMode, lowCutFrequency);
+    lowCutFilter.prepare(sampleRate);
+    
+    // Start at the current settings rather than ramping to them
+    appliedLeftGain = getTargetLeftGain();
+    appliedRightGain = getTargetRightGain();
+    appliedMidGain = useMidSideProcessing ? midGain : 1.0f;
+    appliedSideGain = useMidSideProcessing ? sideGain : 1.0f;
+    widthCorrelation = 1.0f;
+    widthSafetyGain = 1.0f;
+    
+    // The delay line for the channel delays, phase offset and width, and the
+    // safety stage, whose oversampling filters are sized for the largest block
+    maximumBlockSize = juce::jmax(1, samplesPerBlock);
+    prepareArena();
+    
+    delayRangeChanged = false;
+    safetyChanged = false;
+    isPrepared = true;
 }
 
 void PluginV3AudioProcessor::releaseResources()
 {
     // When playback stops, you can use this as an opportunity to free up any
     // spare memory, etc.
+    delayAligner.release();
+    monoAnalyser.release();
+    isPrepared = false;
 }
 
 bool PluginV3AudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) const
@@ -295,6 +729,16 @@ bool PluginV3AudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts)
    #if ! JucePlugin_IsSynth
     if (layouts.getMainOutputChannelSet() != layouts.getMainInputChannelSet())
         return false;
+    
+    // The optional sidechain reference can be disabled, mono or stereo
+    if (layouts.inputBuses.size() > 1)
+    {
+        const auto sidechainSet = layouts.getChannelSet(true, 1);
+        if (! sidechainSet.isDisabled()
+         && sidechainSet != juce::AudioChannelSet::mono()
+         && sidechainSet != juce::AudioChannelSet::stereo())
+            return false;
+    }
    #endif
 
     return true;
@@ -305,9 +749,21 @@ void PluginV3AudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juc
 {
     juce::ignoreUnused(midiMessages);
 
+    // Compiles to nothing unless real-time safety instrumentation is enabled
+    const RealtimeSafetyMonitor::ScopedAudioCallback realtimeSafetyCheck(buffer.getNumSamples(), sampleRate);
+    
+    // Per-stage timing for the diagnostics panel
+    const StageProfiler::ScopedBlock profiledBlock(stageProfiler);
+    
+    // A snapshot switch arrives as one complete set, ahead of the parameter updates
+    PresetManager::SnapshotValues snapshotValues;
+    if (presetManager.popPendingValues(snapshotValues))
+        applySnapshot(snapshotValues);
+
     juce::ScopedNoDenormals noDenormals;
-    auto totalNumInputChannels  = getTotalNumInputChannels();
-    auto totalNumOutputChannels = getTotalNumOutputChannels();
+    // Only the main bus is processed, the sidechain is an analysis reference
+    auto totalNumInputChannels  = getMainBusNumInputChannels();
+    auto totalNumOutputChannels = getMainBusNumOutputChannels();
 
     // In case we have more outputs than inputs, clear any output
     // channels that didn't contain input data
@@ -317,72 +773,156 @@ void PluginV3AudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juc
     // Actual processing of audio
     const int numSamples = buffer.getNumSamples();
     
-    // Apply Mid/Side processing if enabled (before other processing)
-    if (useMidSideProcessing && totalNumInputChannels > 1)
+    // Feed the alignment analysis with the unprocessed input (no-op unless capturing)
+    if (alignToSidechain)
     {
-        processMidSide(buffer, numSamples);
+        auto sidechain = getBusBuffer(buffer, true, 1);
+        
+        if (sidechain.getNumChannels() > 0 && totalNumInputChannels > 0)
+            delayAligner.pushSamples(sidechain.getArrayOfReadPointers(), sidechain.getNumChannels(),
+                                     buffer.getArrayOfReadPointers(), totalNumInputChannels,
+                                     numSamples);
+    }
+    else if (totalNumInputChannels > 1)
+    {
+        const float* leftInput = buffer.getReadPointer(0);
+        const float* rightInput = buffer.getReadPointer(1);
+        delayAligner.pushSamples(&leftInput, 1, &rightInput, 1, numSamples);
     }
     
-    // Check if we need to apply phase offset
-    bool applyPhaseOffset = phaseOffset > 0.001f;
+    // Loudness matching measures the untouched input...
+    const bool autoGainActive = autoGainEnabled || autoGain.isCompensating();
     
-    if (applyPhaseOffset)
+    if (autoGainEnabled && totalNumInputChannels > 0)
     {
-        // Ensure the delay buffer is large enough
-        updateDelayBufferSize(numSamples);
+        const StageProfiler::ScopedStage profiledStage(stageProfiler, StageProfiler::autoGain);
+        autoGain.measureInput(buffer.getArrayOfReadPointers(), totalNumInputChannels, numSamples);
+    }
+    
+    // Remove DC and subsonic content first, so it never reaches the
+    // polarity and M/S stages (skipped entirely when off)
+    if (lowCutFilter.getMode() != lowCutMode || lowCutFilter.getFrequency() != lowCutFrequency)
+        lowCutFilter.setMode(lowCutMode, lowCutFrequency);
+    
+    if (lowCutFilter.isActive() && totalNumInputChannels > 0)
+    {
+        const StageProfiler::ScopedStage profiledStage(stageProfiler, StageProfiler::lowCut);
+        lowCutFilter.process(buffer.getWritePointer(0),
+                             totalNumInputChannels > 1 ? buffer.getWritePointer(1) : nullptr,
+                             numSamples);
+    }
+    
+    // Apply Mid/Side processing if enabled (before other processing).
+    // Turning it off ramps to unity mid/side gains before bypassing.
+    const float targetMidGain = useMidSideProcessing ? midGain : 1.0f;
+    const float targetSideGain = useMidSideProcessing ? sideGain : 1.0f;
+    
+    if (totalNumInputChannels > 1
+        && (useMidSideProcessing || appliedMidGain != targetMidGain || appliedSideGain != targetSideGain))
+    {
+        const StageProfiler::ScopedStage profiledStage(stageProfiler, StageProfiler::midSide);
+        processMidSide(buffer, numSamples, targetMidGain, targetSideGain);
+    }
+    
+    appliedMidGain = targetMidGain;
+    appliedSideGain = targetSideGain;
+    
+    // Apply the channel delays, plus the phase offset on the right channel,
+    // and the width in the same pass. Delays are limited to the selected
+    // range; changes crossfade.
+    if (totalNumInputChannels > 0)
+    {
+        const StageProfiler::ScopedStage profiledStage(stageProfiler, StageProfiler::delay);
+        const float rangeMs = getDelayRangeMs();
+        const float delaySamples[DelayLine::maxChannels] = {
+            juce::jmin(leftDelayMs, rangeMs) * sampleRate / 1000.0f,
+            juce::jmin(rightDelayMs, rangeMs) * sampleRate / 1000.0f + getPhaseOffsetDelaySamples()
+        };
         
-        // Calculate delay in samples for current phase offset
-        float delaySamples = getPhaseOffsetDelaySamples();
-        int delayIntegerSamples = static_cast<int>(delaySamples);
-        float delayFraction = delaySamples - delayIntegerSamples;
+        DelayLine::Width width;
+        width.mode = widthMode;
+        width.amount = widthAmount * widthSafetyGain.load(std::memory_order_relaxed);
+        width.delaySamples = widthTimeMs * sampleRate / 1000.0f;
         
-        // Copy input to delay buffer (we'll process directly from there)
-        for (int channel = 0; channel < totalNumInputChannels; ++channel)
+        delayLine.process(buffer.getArrayOfWritePointers(), totalNumInputChannels, numSamples, delaySamples, width);
+    }
+    
+    // ...and the processed signal ahead of the channel gains, which then
+    // absorb the compensation at no extra per-sample cost
+    float compensationGain = 1.0f;
+    
+    if (autoGainActive)
+    {
+        const StageProfiler::ScopedStage profiledStage(stageProfiler, StageProfiler::autoGain);
+        
+        if (autoGainEnabled && totalNumInputChannels > 0)
         {
-            // Only delay the right channel (assuming stereo)
-            if (channel == 1)
-            {
-                auto* inData = buffer.getReadPointer(channel);
-                
-                // Copy current input to delay buffer
-                for (int i = 0; i < numSamples; ++i)
-                {
-                    int bufIndex = (delayBufferPos + i) % delayBufferLength;
-                    delayBuffer->setSample(channel, bufIndex, inData[i]);
-                }
-            }
+            const float channelGains[AutoGainCompensator::maxChannels] = { getTargetLeftGain(), getTargetRightGain() };
+            autoGain.measureOutput(buffer.getArrayOfReadPointers(), totalNumInputChannels, numSamples, channelGains);
         }
+        
+        compensationGain = autoGain.getNextGain(autoGainEnabled, numSamples);
     }
     
-    // Process left channel (0)
+    // Apply phase inversion and gain in a single pass per channel
     if (totalNumInputChannels > 0)
     {
-        auto* channelData = buffer.getWritePointer(0);
+        const StageProfiler::ScopedStage profiledStage(stageProfiler, StageProfiler::polarityGain);
+        applyChannelGain(buffer.getWritePointer(0), numSamples, getTargetLeftGain() * compensationGain, appliedLeftGain);
         
-        // Apply phase inversion if needed
-        if (invertLeftPhase)
-        {
-            for (int sample = 0; sample < numSamples; ++sample)
-            {
-                channelData[sample] = -channelData[sample];
-            }
-        }
+        if (totalNumInputChannels > 1)
+            applyChannelGain(buffer.getWritePointer(1), numSamples, getTargetRightGain() * compensationGain, appliedRightGain);
+    }
+    
+    // Soft clip or limit the final signal against the ceiling (off by default)
+    if (outputSafety.getMode() != OutputSafetyStage::off && totalNumInputChannels > 0)
+    {
+        const StageProfiler::ScopedStage profiledStage(stageProfiler, StageProfiler::outputSafety);
+        outputSafety.process(buffer, totalNumInputChannels, numSamples, safetyCeilingDb);
+    }
+    
+    if (totalNumInputChannels > 0)
+    {
+        const StageProfiler::ScopedStage profiledStage(stageProfiler, StageProfiler::metering);
         
-        // Apply gain
-        float combinedGain = leftGain * masterGain;
-        for (int sample = 0; sample < numSamples; ++sample)
-        {
-            channelData[sample] *= combinedGain;
-        }
+        // Peak, RMS and correlation AFTER applying gain, in one pass
+        auto frame = MeterFrame::measure(buffer.getReadPointer(0),
+                                         totalNumInputChannels > 1 ? buffer.getReadPointer(1) : nullptr,
+                                         numSamples);
+        frame.samplePosition = processedSamples;
+        frame.sampleRate = sampleRate;
         
-        // Find peak level AFTER applying gain
-        float leftPeak = 0.0f;
-        for (int sample = 0; sample < numSamples; ++sample)
-        {
-            leftPeak = std::max(leftPeak, std::abs(channelData[sample]));
-        }
+        // The history view drops frames rather than hold up the audio thread
+        meterFrames.push(frame);
+        
+        // Other instances read this through the shared metering bus; an
+        // offline bounce runs faster than real time, so it isn't published
+        if (! isNonRealtime())
+            meterBus.process(buffer.getReadPointer(0),
+                             totalNumInputChannels > 1 ? buffer.getReadPointer(1) : nullptr,
+                             frame);
+        
+        // Mono safety for the width stage, from this block's correlation
+        if (totalNumInputChannels > 1)
+            updateWidthSafety(frame, numSamples);
+        
+        // Mono compatibility analysis (no-op unless its overlay is open)
+        if (totalNumInputChannels > 1)
+            monoAnalyser.pushSamples(buffer.getReadPointer(0), buffer.getReadPointer(1), numSamples);
+        
+        // Spectrum display (no-op unless a spectrum view is showing)
+        spectrumAnalyser.pushSamples(buffer.getReadPointer(0),
+                                     buffer.getReadPointer(totalNumInputChannels > 1 ? 1 : 0),
+                                     numSamples);
         
-        // Convert peak to a dB value
+        // Offline QA log, only while recording
+        if (meterLog.isRecording())
+            logMeterFrame(buffer, totalNumInputChannels, frame);
+        else
+            wasLogging = false;
+        
+        // Convert the left peak to a dB value
+        const float leftPeak = frame.peak[0];
         float leftDb = 0.0f;
         if (leftPeak > 0.0f)
         {
@@ -396,82 +936,103 @@ void PluginV3AudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juc
             // Set to minimum when no signal is present
             leftChannelLevel.setTargetValue(0.0f);
         }
-    }
-    
-    // Process right channel (1)
-    if (totalNumInputChannels > 1)
-    {
-        auto* channelData = buffer.getWritePointer(1);
         
-        // Apply phase offset if needed
-        if (applyPhaseOffset)
+        // Same for the right channel
+        if (totalNumInputChannels > 1)
         {
-            // Calculate delay in samples for current phase offset
-            float delaySamples = getPhaseOffsetDelaySamples();
-            int delayIntegerSamples = static_cast<int>(delaySamples);
-            float delayFraction = delaySamples - delayIntegerSamples;
-            
-            // Read delayed samples
-            for (int i = 0; i < numSamples; ++i)
+            const float rightPeak = frame.peak[1];
+            float rightDb = 0.0f;
+            if (rightPeak > 0.0f)
             {
-                int readPos = delayBufferPos - delayIntegerSamples + i;
-                // Wrap around if negative
-                if (readPos < 0)
-                    readPos += delayBufferLength;
-                // Wrap around if past end
-                readPos = readPos % delayBufferLength;
-                
-                // Get delayed sample (simple linear interpolation for fractional delays)
-                int readPos2 = (readPos + 1) % delayBufferLength;
-                float sample1 = delayBuffer->getSample(1, readPos);
-                float sample2 = delayBuffer->getSample(1, readPos2);
-                
-                // Apply linear interpolation for fractional delay
-                channelData[i] = sample1 + delayFraction * (sample2 - sample1);
+                rightDb = juce::Decibels::gainToDecibels(rightPeak, -60.0f);
+                // Map to 0-1 range for meter display (-60dB to 0dB)
+                float rightMeterValue = juce::jmap(rightDb, -60.0f, 0.0f, 0.0f, 1.0f);
+                rightChannelLevel.setTargetValue(rightMeterValue);
             }
-            
-            // Update delay buffer position
-            delayBufferPos = (delayBufferPos + numSamples) % delayBufferLength;
-        }
-        
-        // Apply phase inversion if needed
-        if (invertRightPhase)
-        {
-            for (int sample = 0; sample < numSamples; ++sample)
+            else
             {
-                channelData[sample] = -channelData[sample];
+                // Set to minimum when no signal is present
+                rightChannelLevel.setTargetValue(0.0f);
             }
         }
+    }
+    
+    processedSamples += numSamples;
+}
+
+void PluginV3AudioProcessor::updateWidthSafety(const MeterFrame& frame, int numSamples) noexcept
+{
+    const float blockSeconds = static_cast<float>(numSamples) / sampleRate;
+    
+    // Correlation smoothed over about 300ms, so a single transient doesn't duck
+    widthCorrelation += (frame.correlation - widthCorrelation) * (1.0f - std::exp(-blockSeconds / 0.3f));
+    
+    float gain = widthSafetyGain.load(std::memory_order_relaxed);
+    
+    // Decorrelated material hovers around 0, which is what widening is for,
+    // so the width is only pulled back once the correlation is clearly
+    // negative, and held between the two thresholds
+    if (! widthMonoSafe || widthMode == DelayLine::Width::off)
+        gain = 1.0f;
+    else if (widthCorrelation < -0.2f)
+        gain = juce::jmax(0.0f, gain - blockSeconds / 0.1f);    // Out of phase: fully back within 100ms
+    else if (widthCorrelation > 0.0f)
+        gain = juce::jmin(1.0f, gain + blockSeconds / 2.0f);    // Recover over 2s
+    
+    widthSafetyGain.store(gain, std::memory_order_relaxed);
+}
+
+bool PluginV3AudioProcessor::startMeterLog(const juce::File& file, juce::String& error)
+{
+    const int numChannels = juce::jlimit(1, MeterFrame::maxChannels, getTotalNumInputChannels());
+    return meterLog.start(file, getSampleRate() > 0.0 ? getSampleRate() : sampleRate, numChannels, error);
+}
+
+void PluginV3AudioProcessor::logMeterFrame(const juce::AudioBuffer<float>& buffer, int numChannels, const MeterFrame& frame) noexcept
+{
+    // Each recording measures from silence
+    if (! wasLogging)
+    {
+        for (auto& detector : logTruePeaks)
+            detector.reset();
         
-        // Apply gain
-        float combinedGain = rightGain * masterGain;
-        for (int sample = 0; sample < numSamples; ++sample)
-        {
-            channelData[sample] *= combinedGain;
-        }
+        logLoudness.reset();
+        wasLogging = true;
+    }
+    
+    const int numLogChannels = juce::jmin(numChannels, MeterFrame::maxChannels);
+    const int numSamples = frame.numSamples;
+    
+    MeterLogWriter::Record record;
+    record.samplePosition = frame.samplePosition;
+    record.numSamples = numSamples;
+    record.correlation = frame.correlation;
+    
+    for (int channel = 0; channel < MeterFrame::maxChannels; ++channel)
+    {
+        // Mono repeats the left channel, as the meter frame does
+        const int sourceChannel = juce::jmin(channel, numLogChannels - 1);
+        const float* samples = buffer.getReadPointer(sourceChannel);
         
-        // Find peak level AFTER applying gain
-        float rightPeak = 0.0f;
-        for (int sample = 0; sample < numSamples; ++sample)
-        {
-            rightPeak = std::max(rightPeak, std::abs(channelData[sample]));
-        }
+        auto& detector = logTruePeaks[static_cast<size_t>(channel)];
+        detector.process(&samples, 1, numSamples);
         
-        // Convert peak to a dB value
-        float rightDb = 0.0f;
-        if (rightPeak > 0.0f)
-        {
-            rightDb = juce::Decibels::gainToDecibels(rightPeak, -60.0f);
-            // Map to 0-1 range for meter display (-60dB to 0dB)
-            float rightMeterValue = juce::jmap(rightDb, -60.0f, 0.0f, 0.0f, 1.0f);
-            rightChannelLevel.setTargetValue(rightMeterValue);
-        }
-        else
-        {
-            // Set to minimum when no signal is present
-            rightChannelLevel.setTargetValue(0.0f);
-        }
+        record.peak[channel] = frame.peak[channel];
+        record.rms[channel] = frame.rms[channel];
+        record.truePeak[channel] = detector.getTruePeak();
+        detector.resetPeak();
     }
+    
+    logLoudness.process(buffer.getArrayOfReadPointers(), numLogChannels, numSamples);
+    record.momentaryLoudness = logLoudness.getMomentaryLoudness();
+    record.shortTermLoudness = logLoudness.getShortTermLoudness();
+    
+    if (auto* playHead = getPlayHead())
+        if (auto position = playHead->getPosition())
+            if (auto timeInSamples = position->getTimeInSamples())
+                record.hostTimeSamples = *timeInSamples;
+    
+    meterLog.push(record);
 }
 
 //==============================================================================
@@ -488,21 +1049,38 @@ juce::AudioProcessorEditor* PluginV3AudioProcessor::createEditor()
 //==============================================================================
 void PluginV3AudioProcessor::getStateInformation (juce::MemoryBlock& destData)
 {
-    // You should use this method to store your parameters in the memory block.
-    auto state = apvts.copyState();
-    std::unique_ptr<juce::XmlElement> xml(state.createXml());
-    copyXmlToBinary(*xml, destData);
+    // Parameters are stored in a compact binary form, see StateSerializer
+    StateSerializer::write(apvts, destData);
 }
 
 void PluginV3AudioProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
     // You should use this method to restore your parameters from this memory block,
     // whose contents will have been created by the getStateInformation() call.
+    if (StateSerializer::isBinaryState(data, sizeInBytes))
+    {
+        // A damaged state leaves the parameters as they were. The XML path
+        // can't help here: data with the binary header is never valid XML.
+        const bool restored = StateSerializer::read(apvts, data, sizeInBytes);
+        jassert(restored);
+        
+        if (restored)
+            stateJustRestored = true;
+        
+        return;
+    }
+    
+    // Sessions saved by older versions hold the parameter tree as XML
     std::unique_ptr<juce::XmlElement> xmlState(getXmlFromBinary(data, sizeInBytes));
     
     if (xmlState.get() != nullptr)
+    {
         if (xmlState->hasTagName(apvts.state.getType()))
+        {
             apvts.replaceState(juce::ValueTree::fromXml(*xmlState));
+            stateJustRestored = true;
+        }
+    }
 }
 
 //==============================================================================
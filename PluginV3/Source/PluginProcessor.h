@@ -1,12 +1,33 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "AlignedArena.h"
+#include "AutoGainCompensator.h"
+#include "DelayAligner.h"
+#include "DelayLine.h"
+#include "DspKernels.h"
+#include "LevelHistory.h"
+#include "LoudnessMeter.h"
+#include "MeterFrame.h"
+#include "MeterLogWriter.h"
+#include "MonoCompatAnalyser.h"
+#include "OutputSafetyStage.h"
+#include "PresetManager.h"
+#include "RealtimeSafetyMonitor.h"
+#include "SharedMeterBus.h"
+#include "SpectrumAnalyser.h"
+#include "StageProfiler.h"
+#include "StateSerializer.h"
+#include "SubsonicFilter.h"
+#include "TruePeakDetector.h"
 
 //==============================================================================
 /**
 */
 class PluginV3AudioProcessor  : public juce::AudioProcessor,
-                                public juce::AudioProcessorValueTreeState::Listener
+                                public juce::AudioProcessorValueTreeState::Listener,
+                                private juce::AsyncUpdater,
+                                private juce::Timer
 {
 public:
     //==============================================================================
@@ -45,12 +66,56 @@ public:
     void setStateInformation (const void* data, int sizeInBytes) override;
 
     void parameterChanged(const juce::String& parameterID, float newValue) override;
+    void updateTrackProperties(const TrackProperties& properties) override;
 
     juce::AudioProcessorValueTreeState& getAPVTS() { return apvts; }
     
     // Level meter values - return target values for immediate response
     float getLeftChannelLevel() const { return leftChannelLevel.getTargetValue(); }
     float getRightChannelLevel() const { return rightChannelLevel.getTargetValue(); }
+    
+    // Automatic L/R delay and polarity alignment
+    void analyseAlignment() { delayAligner.requestAnalysis(); }
+    bool isAlignmentAnalysisRunning() const { return delayAligner.isAnalysing(); }
+    CrossCorrelator::Result getLastAlignmentResult() const { return delayAligner.getLastResult(); }
+    bool isAligningToSidechain() const { return alignToSidechain; }
+    bool isSidechainConnected() const { return getBusCount(true) > 1 && getChannelCountOfBus(true, 1) > 0; }
+    
+    // Per-stage processBlock timing over the most recent blocks
+    StageProfiler::Statistics getStageStatistics(StageProfiler::Stage stage) const { return stageProfiler.getStatistics(stage); }
+    const StageProfiler& getStageProfiler() const { return stageProfiler; }
+    void resetStageProfile() { stageProfiler.reset(); }
+    
+    // Current loudness-matching gain in dB (0 when auto gain is off)
+    float getAutoGainDb() const { return autoGain.getCompensationDb(); }
+    
+    // Gain reduction of the output safety stage in dB (0 when off or idle)
+    float getSafetyGainReductionDb() const { return outputSafety.getGainReductionDb(); }
+    
+    // How far mono safety has pulled the width back, 0 to 1 (1 = no reduction)
+    float getWidthSafetyGain() const { return widthSafetyGain.load(std::memory_order_relaxed); }
+    
+    // Scrolling peak/RMS/correlation history; message thread only
+    const LevelHistory& getLevelHistory() const { return levelHistory; }
+    
+    // This instance's slot on the machine-wide metering bus
+    const MeterBusPublisher& getMeterBus() const { return meterBus; }
+    
+    // Streams per-block readings to a binary log for offline QA; message thread only
+    bool startMeterLog(const juce::File& file, juce::String& error);
+    void stopMeterLog() { meterLog.stop(); }
+    const MeterLogWriter& getMeterLog() const { return meterLog; }
+    
+    // Per-band mono compatibility of the output, analysed only while enabled
+    void setMonoAnalysisEnabled(bool shouldAnalyse) { monoAnalyser.setEnabled(shouldAnalyse); }
+    MonoCompatAnalyser::Result getMonoCompatResult() const { return monoAnalyser.getLastResult(); }
+    void applyMonoCompatRecommendation(const MonoCompatAnalyser::Result& result);
+    
+    // Output spectra for the editor; idle unless a spectrum view is showing
+    SpectrumAnalyser& getSpectrumAnalyser() { return spectrumAnalyser; }
+    
+    // A/B/C/D snapshots and the preset bank
+    PresetManager& getPresetManager() { return presetManager; }
 
 private:
     juce::AudioProcessorValueTreeState apvts;
@@ -68,27 +133,133 @@ private:
     // Phase offset (in degrees, 0-360)
     float phaseOffset { 0.0f }; 
     
+    // Per-channel delay (in milliseconds)
+    float leftDelayMs { 0.0f };
+    float rightDelayMs { 0.0f };
+    
     // Mid/Side gain values
     float midGain { 1.0f };
     float sideGain { 1.0f };
     bool useMidSideProcessing { false };
     
-    // For phase offset delay buffer
-    std::unique_ptr<juce::AudioBuffer<float>> delayBuffer;
-    int delayBufferPos { 0 };
-    int delayBufferLength { 0 };
+    // DC blocker / subsonic high-pass on the input
+    SubsonicFilter lowCutFilter;
+    SubsonicFilter::Mode lowCutMode { SubsonicFilter::off };
+    float lowCutFrequency { 20.0f };
+    
+    // Haas / diffuse width, mixed in by the delay line. Mono safety pulls the
+    // amount back while the output correlation is below -0.2, and lets it
+    // recover once the correlation is positive again.
+    DelayLine::Width::Mode widthMode { DelayLine::Width::off };
+    float widthAmount { 0.5f };
+    float widthTimeMs { 12.0f };
+    bool widthMonoSafe { true };
+    float widthCorrelation { 1.0f };
+    std::atomic<float> widthSafetyGain { 1.0f };
+    
+    // Gains applied at the end of the last block. When a parameter changes,
+    // processBlock ramps from these over one block instead of stepping.
+    float appliedLeftGain { 1.0f };
+    float appliedRightGain { 1.0f };
+    float appliedMidGain { 1.0f };
+    float appliedSideGain { 1.0f };
+    
+    // Loudness-matched output for level-matched A/B comparisons
+    AutoGainCompensator autoGain;
+    bool autoGainEnabled { false };
+    
+    // Oversampled soft clip / true-peak limiter on the output
+    OutputSafetyStage outputSafety;
+    float safetyCeilingDb { -1.0f };
+    int maximumBlockSize { 512 };
+    
+    // Delay line for the channel delays and phase offset, sized by the delay range
+    static constexpr int numDelayRanges = 5;
+    DelayLine delayLine;
+    
+    // The delay line's and the limiter's buffers, in one block laid out by
+    // prepareArena; the safety stage's part starts at safetyArenaMark
+    AlignedArena arena;
+    size_t safetyArenaMark { 0 };
+    int delayRangeIndex { 0 };
     float sampleRate { 44100.0f };
+    bool isPrepared { false };
+    
+    // What handleAsyncUpdate has to rebuild
+    std::atomic<bool> delayRangeChanged { false };
+    std::atomic<bool> safetyChanged { false };
     
     // Level meters for display - smoothed with ballistics to look natural
     juce::LinearSmoothedValue<float> leftChannelLevel { 0.0f };
     juce::LinearSmoothedValue<float> rightChannelLevel { 0.0f };
     
-    // Helper methods for phase processing
-    void updateDelayBufferSize(int samplesPerBlock);
+    // Per-block meter frames, queued by the audio thread and folded into the
+    // history on the message thread
+    MeterFrameFifo meterFrames;
+    LevelHistory levelHistory;
+    juce::int64 processedSamples { 0 };
+    
+    // Background cross-correlation used by the analyze & align feature
+    DelayAligner delayAligner;
+    bool alignToSidechain { false };
+    
+    // Background mono compatibility analysis of the output
+    MonoCompatAnalyser monoAnalyser;
+    
+    // Output spectra, analysed on a thread shared by all instances
+    SpectrumAnalyser spectrumAnalyser;
+    
+    // Always-on timing of the processBlock stages
+    StageProfiler stageProfiler;
+    
+    // Publishes the meter readings for other instances' track overview
+    MeterBusPublisher meterBus;
+    
+    // Meter log and the meters only it needs, reset when a recording starts
+    void logMeterFrame(const juce::AudioBuffer<float>& buffer, int numChannels, const MeterFrame& frame) noexcept;
+    MeterLogWriter meterLog;
+    std::array<TruePeakDetector, MeterFrame::maxChannels> logTruePeaks;
+    LoudnessMeter logLoudness;
+    bool wasLogging { false };
+    
+    // Snapshot slots and presets; snapshot switches reach processBlock directly
+    PresetManager presetManager { apvts };
+    
+    // Set by setStateInformation, so the program change some hosts send right
+    // after restoring a session doesn't replace the restored settings
+    std::atomic<bool> stateJustRestored { false };
+    
+   #if PLUGINV3_RT_CHECKS
+    // Allocation, lock and deadline checks for processBlock (instrumentation builds only)
+    juce::SharedResourcePointer<RealtimeSafetyMonitor> realtimeSafetyMonitor;
+   #endif
+    
+    // Helper methods for delay and phase processing
+    float getDelayRangeMs() const;
     float getPhaseOffsetDelaySamples() const;
+    int getMaximumDelaySamples() const;
+    int getMaximumWidthDelaySamples() const;
+    void prepareArena();
+    void prepareDelayLine();
+    void prepareSafetyStage();
+    void updateWidthSafety(const MeterFrame& frame, int numSamples) noexcept;
+    void handleAsyncUpdate() override;
+    void timerCallback() override;
     
     // Helper method for Mid/Side processing
-    void processMidSide(juce::AudioBuffer<float>& buffer, int numSamples);
+    void processMidSide(juce::AudioBuffer<float>& buffer, int numSamples, float targetMidGain, float targetSideGain);
+    
+    // Applies gain and polarity to a channel, ramping if the gain has changed
+    static void applyChannelGain(float* channelData, int numSamples, float targetGain, float& appliedGain) noexcept;
+    float getTargetLeftGain() const noexcept { return (invertLeftPhase ? -1.0f : 1.0f) * leftGain * masterGain; }
+    float getTargetRightGain() const noexcept { return (invertRightPhase ? -1.0f : 1.0f) * rightGain * masterGain; }
+    
+    // Takes over a complete set of snapshot values at the start of a block
+    void applySnapshot(const PresetManager::SnapshotValues& values) noexcept;
+    
+    // Applies a finished alignment analysis to the delay and polarity parameters
+    void applyAlignmentResult(const CrossCorrelator::Result& result);
+    void setParameterFromAnalysis(const juce::String& parameterID, float newValue);
     
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PluginV3AudioProcessor)
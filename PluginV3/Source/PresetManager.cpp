@@ -0,0 +1,286 @@
+#include "PresetManager.h"
+#include "StateSerializer.h"
+
+namespace
+{
+    constexpr const char* snapshotParameterIDs[] = {
+        "master_gain",
+        "left_gain",
+        "right_gain",
+        "invert_left",
+        "invert_right",
+        "phase_offset",
+        "left_delay",
+        "right_delay",
+        "mid_gain",
+        "side_gain",
+        "use_mid_side",
+        "auto_gain",
+        "safety_ceiling",
+        "hpf_mode",
+        "hpf_frequency",
+        "width_mode",
+        "width_amount",
+        "width_time",
+        "width_mono_safe"
+    };
+
+    static_assert(std::size(snapshotParameterIDs) == PresetManager::numSnapshotParameters,
+                  "Every snapshot parameter needs an ID");
+
+    //==============================================================================
+    struct FactoryPreset
+    {
+        const char* name;
+
+        // Values that differ from the parameter defaults
+        std::initializer_list<std::pair<PresetManager::SnapshotParameter, float>> values;
+    };
+
+    const FactoryPreset factoryPresets[] = {
+        { "Init",                {} },
+        { "Trim -6 dB",          { { PresetManager::masterGainValue, 0.501187f } } },
+        { "Mono Check",          { { PresetManager::useMidSideValue, 1.0f }, { PresetManager::sideGainValue, 0.0f } } },
+        { "Side Solo",           { { PresetManager::useMidSideValue, 1.0f }, { PresetManager::midGainValue, 0.0f } } },
+        { "Wider (+3 dB Side)",  { { PresetManager::useMidSideValue, 1.0f }, { PresetManager::sideGainValue, 1.412538f } } },
+        { "Narrower (-6 dB Side)", { { PresetManager::useMidSideValue, 1.0f }, { PresetManager::sideGainValue, 0.501187f } } },
+        { "Flip Left Polarity",  { { PresetManager::invertLeftValue, 1.0f } } },
+        { "Flip Right Polarity", { { PresetManager::invertRightValue, 1.0f } } },
+        { "Left Only",           { { PresetManager::rightGainValue, 0.0f } } },
+        { "Right Only",          { { PresetManager::leftGainValue, 0.0f } } }
+    };
+}
+
+//==============================================================================
+PresetManager::PresetManager(juce::AudioProcessorValueTreeState& stateToUse)
+    : juce::Thread("Preset Index"),
+      state(stateToUse)
+{
+    for (auto& value : pendingValues)
+        value.store(0.0f, std::memory_order_relaxed);
+}
+
+PresetManager::~PresetManager()
+{
+    stopThread(2000);
+}
+
+const char* PresetManager::getParameterID(int snapshotParameter) noexcept
+{
+    jassert(juce::isPositiveAndBelow(snapshotParameter, static_cast<int>(numSnapshotParameters)));
+    return snapshotParameterIDs[snapshotParameter];
+}
+
+//==============================================================================
+PresetManager::SnapshotValues PresetManager::getCurrentValues() const
+{
+    SnapshotValues values {};
+
+    for (int i = 0; i < numSnapshotParameters; ++i)
+        if (auto* value = state.getRawParameterValue(snapshotParameterIDs[i]))
+            values[static_cast<size_t>(i)] = value->load();
+
+    return values;
+}
+
+void PresetManager::applyValues(const SnapshotValues& values)
+{
+    // Hand the whole set to the audio thread first so it switches in one block...
+    for (size_t i = 0; i < values.size(); ++i)
+        pendingValues[i].store(values[i], std::memory_order_relaxed);
+
+    valuesPending.store(true, std::memory_order_release);
+
+    // ...then bring the parameters (and so the host and editor) in line
+    for (int i = 0; i < numSnapshotParameters; ++i)
+    {
+        if (auto* parameter = state.getParameter(snapshotParameterIDs[i]))
+        {
+            const float normalisedValue = parameter->convertTo0to1(values[static_cast<size_t>(i)]);
+
+            if (parameter->getValue() != normalisedValue)
+            {
+                parameter->beginChangeGesture();
+                parameter->setValueNotifyingHost(normalisedValue);
+                parameter->endChangeGesture();
+            }
+        }
+    }
+}
+
+bool PresetManager::popPendingValues(SnapshotValues& values) noexcept
+{
+    if (! valuesPending.exchange(false, std::memory_order_acquire))
+        return false;
+
+    for (size_t i = 0; i < values.size(); ++i)
+        values[i] = pendingValues[i].load(std::memory_order_relaxed);
+
+    return true;
+}
+
+//==============================================================================
+void PresetManager::selectSnapshot(int slot)
+{
+    if (! juce::isPositiveAndBelow(slot, numSnapshots) || slot == activeSnapshot)
+        return;
+
+    const auto currentValues = getCurrentValues();
+    snapshots[static_cast<size_t>(activeSnapshot)] = currentValues;
+    snapshotUsed[static_cast<size_t>(activeSnapshot)] = true;
+
+    if (! snapshotUsed[static_cast<size_t>(slot)])
+    {
+        snapshots[static_cast<size_t>(slot)] = currentValues;
+        snapshotUsed[static_cast<size_t>(slot)] = true;
+    }
+
+    activeSnapshot = slot;
+    applyValues(snapshots[static_cast<size_t>(slot)]);
+    sendChangeMessage();
+}
+
+void PresetManager::copyActiveSnapshotTo(int slot)
+{
+    if (! juce::isPositiveAndBelow(slot, numSnapshots) || slot == activeSnapshot)
+        return;
+
+    snapshots[static_cast<size_t>(slot)] = getCurrentValues();
+    snapshotUsed[static_cast<size_t>(slot)] = true;
+}
+
+//==============================================================================
+int PresetManager::getNumFactoryPresets() noexcept
+{
+    return static_cast<int>(std::size(factoryPresets));
+}
+
+juce::String PresetManager::getFactoryPresetName(int index)
+{
+    if (! juce::isPositiveAndBelow(index, getNumFactoryPresets()))
+        return {};
+
+    return factoryPresets[index].name;
+}
+
+void PresetManager::loadFactoryPreset(int index)
+{
+    if (! juce::isPositiveAndBelow(index, getNumFactoryPresets()))
+        return;
+
+    SnapshotValues values {};
+
+    for (int i = 0; i < numSnapshotParameters; ++i)
+        if (auto* parameter = state.getParameter(snapshotParameterIDs[i]))
+            values[static_cast<size_t>(i)] = parameter->convertFrom0to1(parameter->getDefaultValue());
+
+    for (const auto& [parameter, value] : factoryPresets[index].values)
+        values[static_cast<size_t>(parameter)] = value;
+
+    lastFactoryPreset = index;
+    applyValues(values);
+}
+
+//==============================================================================
+juce::File PresetManager::getUserPresetDirectory()
+{
+    return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+               .getChildFile(JucePlugin_Manufacturer)
+               .getChildFile(JucePlugin_Name)
+               .getChildFile("Presets");
+}
+
+juce::Array<PresetManager::PresetInfo> PresetManager::getPresets()
+{
+    if (! indexRequested)
+        refreshIndex();
+
+    juce::Array<PresetInfo> presets;
+
+    for (int i = 0; i < getNumFactoryPresets(); ++i)
+        presets.add({ factoryPresets[i].name, {}, i });
+
+    const juce::ScopedLock lock(indexLock);
+    presets.addArray(userPresets);
+    return presets;
+}
+
+void PresetManager::refreshIndex()
+{
+    indexRequested = true;
+    rescanRequested.store(true);
+
+    // The thread stays up once started and sleeps between scans; a notify()
+    // that arrives before it waits is kept, so no request can be missed
+    if (! isThreadRunning())
+        startThread(juce::Thread::Priority::low);
+    else
+        notify();
+}
+
+void PresetManager::run()
+{
+    // Only list the files here; presets are read when they're loaded
+    while (! threadShouldExit())
+    {
+        if (! rescanRequested.exchange(false))
+        {
+            wait(-1);
+            continue;
+        }
+
+        auto files = getUserPresetDirectory().findChildFiles(juce::File::findFiles, false,
+                                                             juce::String("*") + presetFileExtension);
+        files.sort();
+
+        juce::Array<PresetInfo> found;
+
+        for (const auto& file : files)
+            found.add({ file.getFileNameWithoutExtension(), file, -1 });
+
+        {
+            const juce::ScopedLock lock(indexLock);
+            userPresets.swapWith(found);
+        }
+
+        sendChangeMessage();
+    }
+}
+
+bool PresetManager::loadPreset(const PresetInfo& preset)
+{
+    if (preset.factoryIndex >= 0)
+    {
+        loadFactoryPreset(preset.factoryIndex);
+        return true;
+    }
+
+    juce::MemoryBlock data;
+
+    if (! preset.file.loadFileAsData(data))
+        return false;
+
+    return StateSerializer::read(state, data.getData(), static_cast<int>(data.getSize()));
+}
+
+bool PresetManager::saveUserPreset(const juce::String& name)
+{
+    const auto fileName = juce::File::createLegalFileName(name.trim());
+
+    if (fileName.isEmpty())
+        return false;
+
+    const auto directory = getUserPresetDirectory();
+
+    if (! directory.createDirectory())
+        return false;
+
+    juce::MemoryBlock data;
+    StateSerializer::write(state, data);
+
+    if (! directory.getChildFile(fileName + presetFileExtension).replaceWithData(data.getData(), data.getSize()))
+        return false;
+
+    refreshIndex();
+    return true;
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+ * A/B/C/D snapshots and the factory/user preset bank.
+ *
+ * Snapshots hold the sound-shaping parameters: everything except the delay
+ * range, which reallocates, the safety mode and oversampling, which set up
+ * new filters and change the latency, and the alignment settings. Switching slots
+ * hands the complete set of values to the audio thread in one go, so the
+ * next block picks them all up at once and ramps to them; the parameters
+ * are then updated for the host and editor. No ValueTree is rebuilt.
+ *
+ * Factory presets are compiled in. User presets are files in the user
+ * preset directory, listed by a background thread that starts the first
+ * time the index is asked for and then sleeps until a rescan is requested.
+ * Listeners are told when the index or the active snapshot changes.
+ */
+class PresetManager : public juce::ChangeBroadcaster,
+                      private juce::Thread
+{
+public:
+    //==============================================================================
+    /** The parameters a snapshot holds, in snapshot order. */
+    enum SnapshotParameter
+    {
+        masterGainValue,
+        leftGainValue,
+        rightGainValue,
+        invertLeftValue,
+        invertRightValue,
+        phaseOffsetValue,
+        leftDelayValue,
+        rightDelayValue,
+        midGainValue,
+        sideGainValue,
+        useMidSideValue,
+        autoGainValue,
+        safetyCeilingValue,
+        lowCutModeValue,
+        lowCutFrequencyValue,
+        widthModeValue,
+        widthAmountValue,
+        widthTimeValue,
+        widthMonoSafeValue,
+        numSnapshotParameters
+    };
+
+    /** Plain (not normalised) parameter values, indexed by SnapshotParameter. */
+    using SnapshotValues = std::array<float, numSnapshotParameters>;
+
+    static constexpr int numSnapshots = 4;
+
+    explicit PresetManager(juce::AudioProcessorValueTreeState& stateToUse);
+    ~PresetManager() override;
+
+    /** Returns the parameter ID of a snapshot parameter. */
+    static const char* getParameterID(int snapshotParameter) noexcept;
+
+    //==============================================================================
+    /** Returns the active snapshot slot, 0-3 for A-D. */
+    int getActiveSnapshot() const noexcept { return activeSnapshot; }
+
+    /** Stores the current settings in the active slot and switches to another.
+        A slot that hasn't been used yet starts as a copy of the current
+        settings. Message thread only. */
+    void selectSnapshot(int slot);
+
+    /** Copies the active slot's settings to another slot. Message thread only. */
+    void copyActiveSnapshotTo(int slot);
+
+    /** Called by the audio thread at the start of each block. Returns true,
+        with the values filled in, if new settings have been switched to. */
+    bool popPendingValues(SnapshotValues& values) noexcept;
+
+    //==============================================================================
+    struct PresetInfo
+    {
+        juce::String name;
+        juce::File file;        // User presets only
+        int factoryIndex = -1;  // Factory presets only
+    };
+
+    static int getNumFactoryPresets() noexcept;
+    static juce::String getFactoryPresetName(int index);
+
+    /** Loads a factory preset into the snapshot parameters. Message thread only. */
+    void loadFactoryPreset(int index);
+    int getLastFactoryPreset() const noexcept { return lastFactoryPreset; }
+
+    /** Returns the factory presets followed by the user presets found so far.
+        The first call starts the background scan of the user presets. */
+    juce::Array<PresetInfo> getPresets();
+
+    /** Rescans the user preset directory in the background. */
+    void refreshIndex();
+
+    /** Loads a preset from the bank. Returns false if a user preset can't be read. */
+    bool loadPreset(const PresetInfo& preset);
+
+    /** Saves all parameters as a user preset, replacing one of the same name. */
+    bool saveUserPreset(const juce::String& name);
+
+    static juce::File getUserPresetDirectory();
+    static constexpr const char* presetFileExtension = ".pv3preset";
+
+private:
+    //==============================================================================
+    void run() override;
+
+    SnapshotValues getCurrentValues() const;
+    void applyValues(const SnapshotValues& values);
+
+    juce::AudioProcessorValueTreeState& state;
+
+    // Slot contents, written and read on the message thread
+    std::array<SnapshotValues, numSnapshots> snapshots {};
+    std::array<bool, numSnapshots> snapshotUsed {};
+    int activeSnapshot { 0 };
+    int lastFactoryPreset { 0 };
+
+    // Values handed to the audio thread
+    std::array<std::atomic<float>, numSnapshotParameters> pendingValues;
+    std::atomic<bool> valuesPending { false };
+
+    // User preset index, filled in by the background scan
+    juce::CriticalSection indexLock;
+    juce::Array<PresetInfo> userPresets;
+    bool indexRequested { false };
+    std::atomic<bool> rescanRequested { false };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PresetManager)
+};
@@ -0,0 +1,377 @@
+/*
+  ==============================================================================
+
+    Interposed allocation and locking functions for RealtimeSafetyMonitor.
+
+    Only compiled into instrumentation builds (PLUGINV3_RT_CHECKS=1). Every
+    function reports to the monitor and then forwards to the real
+    implementation; reports are ignored unless the calling thread is inside
+    processBlock.
+
+    operator new/delete are replaced on every platform. On Linux malloc and
+    friends and the pthread mutex/rwlock lock functions are interposed as
+    well, forwarding through dlsym(RTLD_NEXT). In an executable (Standalone,
+    the command line tools) that applies process-wide; the instrumented VST3
+    is linked with -Bsymbolic so the plugin's own calls bind to these.
+
+  ==============================================================================
+*/
+
+#include "RealtimeSafetyMonitor.h"
+
+#if PLUGINV3_RT_CHECKS
+
+#include <new>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#if JUCE_LINUX
+ #include <dlfcn.h>
+ #include <malloc.h>
+ #include <pthread.h>
+#endif
+
+using ViolationType = RealtimeSafetyMonitor::ViolationType;
+
+#if JUCE_LINUX
+namespace
+{
+    //==============================================================================
+    struct RealFunctions
+    {
+        void* (*malloc)(size_t) = nullptr;
+        void* (*calloc)(size_t, size_t) = nullptr;
+        void* (*realloc)(void*, size_t) = nullptr;
+        void (*free)(void*) = nullptr;
+        int (*posixMemalign)(void**, size_t, size_t) = nullptr;
+        void* (*alignedAlloc)(size_t, size_t) = nullptr;
+        void* (*memalign)(size_t, size_t) = nullptr;
+        int (*mutexLock)(pthread_mutex_t*) = nullptr;
+        int (*rwlockReadLock)(pthread_rwlock_t*) = nullptr;
+        int (*rwlockWriteLock)(pthread_rwlock_t*) = nullptr;
+    };
+
+    RealFunctions realFunctions;
+
+    enum ResolveState
+    {
+        unresolved,
+        resolving,
+        resolved
+    };
+
+    std::atomic<int> resolveState { unresolved };
+
+    // dlsym can allocate while the real functions are being looked up, so
+    // those requests are served from a static arena that is never freed
+    alignas(64) char bootstrapArena[65536];
+    std::atomic<size_t> bootstrapUsed { 0 };
+
+    void* bootstrapAllocate(size_t size, size_t alignment = 16) noexcept
+    {
+        size_t offset = bootstrapUsed.load();
+        size_t aligned;
+
+        do
+        {
+            aligned = (offset + alignment - 1) & ~(alignment - 1);
+
+            if (aligned + size > sizeof(bootstrapArena))
+                return nullptr;
+        }
+        while (! bootstrapUsed.compare_exchange_weak(offset, aligned + size));
+
+        return bootstrapArena + aligned;
+    }
+
+    bool isBootstrapPointer(const void* pointer) noexcept
+    {
+        auto* bytes = static_cast<const char*>(pointer);
+        return bytes >= bootstrapArena && bytes < bootstrapArena + sizeof(bootstrapArena);
+    }
+
+    template <typename FunctionType>
+    void lookUp(FunctionType& function, const char* name) noexcept
+    {
+        function = reinterpret_cast<FunctionType>(dlsym(RTLD_NEXT, name));
+    }
+
+    /** Returns false while another call is still looking up the real functions. */
+    bool ensureResolved() noexcept
+    {
+        int state = resolveState.load(std::memory_order_acquire);
+
+        if (state == resolved)
+            return true;
+
+        if (state == resolving || ! resolveState.compare_exchange_strong(state, resolving))
+            return false;
+
+        lookUp(realFunctions.malloc, "malloc");
+        lookUp(realFunctions.calloc, "calloc");
+        lookUp(realFunctions.realloc, "realloc");
+        lookUp(realFunctions.free, "free");
+        lookUp(realFunctions.posixMemalign, "posix_memalign");
+        lookUp(realFunctions.alignedAlloc, "aligned_alloc");
+        lookUp(realFunctions.memalign, "memalign");
+        lookUp(realFunctions.mutexLock, "pthread_mutex_lock");
+        lookUp(realFunctions.rwlockReadLock, "pthread_rwlock_rdlock");
+        lookUp(realFunctions.rwlockWriteLock, "pthread_rwlock_wrlock");
+
+        resolveState.store(resolved, std::memory_order_release);
+        return true;
+    }
+
+    void waitUntilResolved() noexcept
+    {
+        while (! ensureResolved())
+        {
+        }
+    }
+
+    //==============================================================================
+    void* allocateUnreported(size_t size) noexcept
+    {
+        return ensureResolved() ? realFunctions.malloc(size) : bootstrapAllocate(size);
+    }
+
+    void* allocateAlignedUnreported(size_t size, size_t alignment) noexcept
+    {
+        if (! ensureResolved())
+            return bootstrapAllocate(size, alignment);
+
+        void* pointer = nullptr;
+        return realFunctions.posixMemalign(&pointer, juce::jmax(alignment, sizeof(void*)), size) == 0 ? pointer : nullptr;
+    }
+
+    void freeUnreported(void* pointer) noexcept
+    {
+        if (pointer != nullptr && ! isBootstrapPointer(pointer) && ensureResolved())
+            realFunctions.free(pointer);
+    }
+
+    void freeAlignedUnreported(void* pointer) noexcept
+    {
+        freeUnreported(pointer);
+    }
+}
+
+//==============================================================================
+extern "C"
+{
+    void* malloc(size_t size) noexcept
+    {
+        if (! ensureResolved())
+            return bootstrapAllocate(size);
+
+        RealtimeSafetyMonitor::reportViolation(ViolationType::allocation, size);
+        return realFunctions.malloc(size);
+    }
+
+    void* calloc(size_t count, size_t size) noexcept
+    {
+        // The arena is static storage, so bootstrap memory is already zeroed
+        if (! ensureResolved())
+            return bootstrapAllocate(count * size);
+
+        RealtimeSafetyMonitor::reportViolation(ViolationType::allocation, count * size);
+        return realFunctions.calloc(count, size);
+    }
+
+    void* realloc(void* pointer, size_t size) noexcept
+    {
+        if (isBootstrapPointer(pointer))
+        {
+            // Bootstrap blocks don't record their size; copy what could belong to it
+            auto* moved = malloc(size);
+            if (moved != nullptr)
+                std::memcpy(moved, pointer, juce::jmin(size, static_cast<size_t>(bootstrapArena + sizeof(bootstrapArena) - static_cast<char*>(pointer))));
+
+            return moved;
+        }
+
+        waitUntilResolved();
+        RealtimeSafetyMonitor::reportViolation(ViolationType::allocation, size);
+        return realFunctions.realloc(pointer, size);
+    }
+
+    void free(void* pointer) noexcept
+    {
+        if (pointer == nullptr || isBootstrapPointer(pointer) || ! ensureResolved())
+            return;
+
+        RealtimeSafetyMonitor::reportViolation(ViolationType::deallocation, 0);
+        realFunctions.free(pointer);
+    }
+
+    int posix_memalign(void** pointer, size_t alignment, size_t size) noexcept
+    {
+        if (! ensureResolved())
+        {
+            *pointer = bootstrapAllocate(size, alignment);
+            return *pointer != nullptr ? 0 : ENOMEM;
+        }
+
+        RealtimeSafetyMonitor::reportViolation(ViolationType::allocation, size);
+        return realFunctions.posixMemalign(pointer, alignment, size);
+    }
+
+    void* aligned_alloc(size_t alignment, size_t size) noexcept
+    {
+        if (! ensureResolved())
+            return bootstrapAllocate(size, alignment);
+
+        RealtimeSafetyMonitor::reportViolation(ViolationType::allocation, size);
+        return realFunctions.alignedAlloc(alignment, size);
+    }
+
+    void* memalign(size_t alignment, size_t size) noexcept
+    {
+        if (! ensureResolved())
+            return bootstrapAllocate(size, alignment);
+
+        RealtimeSafetyMonitor::reportViolation(ViolationType::allocation, size);
+        return realFunctions.memalign(alignment, size);
+    }
+
+    //==============================================================================
+    // Only blocking acquisition is reported; try-locks can't stall the audio thread
+    int pthread_mutex_lock(pthread_mutex_t* mutex) noexcept
+    {
+        waitUntilResolved();
+        RealtimeSafetyMonitor::reportViolation(ViolationType::lock, 0);
+        return realFunctions.mutexLock(mutex);
+    }
+
+    int pthread_rwlock_rdlock(pthread_rwlock_t* lock) noexcept
+    {
+        waitUntilResolved();
+        RealtimeSafetyMonitor::reportViolation(ViolationType::lock, 0);
+        return realFunctions.rwlockReadLock(lock);
+    }
+
+    int pthread_rwlock_wrlock(pthread_rwlock_t* lock) noexcept
+    {
+        waitUntilResolved();
+        RealtimeSafetyMonitor::reportViolation(ViolationType::lock, 0);
+        return realFunctions.rwlockWriteLock(lock);
+    }
+}
+
+#else
+
+namespace
+{
+    //==============================================================================
+    void* allocateUnreported(size_t size) noexcept
+    {
+        return std::malloc(size);
+    }
+
+    void* allocateAlignedUnreported(size_t size, size_t alignment) noexcept
+    {
+       #if JUCE_WINDOWS
+        return _aligned_malloc(size, alignment);
+       #else
+        void* pointer = nullptr;
+        return posix_memalign(&pointer, juce::jmax(alignment, sizeof(void*)), size) == 0 ? pointer : nullptr;
+       #endif
+    }
+
+    void freeUnreported(void* pointer) noexcept
+    {
+        std::free(pointer);
+    }
+
+    void freeAlignedUnreported(void* pointer) noexcept
+    {
+       #if JUCE_WINDOWS
+        _aligned_free(pointer);
+       #else
+        std::free(pointer);
+       #endif
+    }
+}
+
+#endif
+
+//==============================================================================
+const char* RealtimeSafetyMonitor::getInterceptedFunctions() noexcept
+{
+   #if JUCE_LINUX
+    return "operator new/delete, malloc/calloc/realloc/free, aligned allocation, pthread mutex and rwlock locking";
+   #else
+    return "operator new/delete";
+   #endif
+}
+
+namespace
+{
+    void* allocateReported(size_t size, bool throwOnFailure)
+    {
+        RealtimeSafetyMonitor::reportViolation(ViolationType::allocation, size);
+
+        auto* pointer = allocateUnreported(size == 0 ? 1 : size);
+
+        if (pointer == nullptr && throwOnFailure)
+            throw std::bad_alloc();
+
+        return pointer;
+    }
+
+    void* allocateAlignedReported(size_t size, std::align_val_t alignment, bool throwOnFailure)
+    {
+        RealtimeSafetyMonitor::reportViolation(ViolationType::allocation, size);
+
+        auto* pointer = allocateAlignedUnreported(size == 0 ? 1 : size, static_cast<size_t>(alignment));
+
+        if (pointer == nullptr && throwOnFailure)
+            throw std::bad_alloc();
+
+        return pointer;
+    }
+
+    void freeReported(void* pointer) noexcept
+    {
+        if (pointer == nullptr)
+            return;
+
+        RealtimeSafetyMonitor::reportViolation(ViolationType::deallocation, 0);
+        freeUnreported(pointer);
+    }
+
+    void freeAlignedReported(void* pointer) noexcept
+    {
+        if (pointer == nullptr)
+            return;
+
+        RealtimeSafetyMonitor::reportViolation(ViolationType::deallocation, 0);
+        freeAlignedUnreported(pointer);
+    }
+}
+
+//==============================================================================
+void* operator new(std::size_t size)                                               { return allocateReported(size, true); }
+void* operator new[](std::size_t size)                                             { return allocateReported(size, true); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept               { return allocateReported(size, false); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept             { return allocateReported(size, false); }
+void* operator new(std::size_t size, std::align_val_t alignment)                   { return allocateAlignedReported(size, alignment, true); }
+void* operator new[](std::size_t size, std::align_val_t alignment)                 { return allocateAlignedReported(size, alignment, true); }
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept   { return allocateAlignedReported(size, alignment, false); }
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return allocateAlignedReported(size, alignment, false); }
+
+void operator delete(void* pointer) noexcept                                       { freeReported(pointer); }
+void operator delete[](void* pointer) noexcept                                     { freeReported(pointer); }
+void operator delete(void* pointer, std::size_t) noexcept                          { freeReported(pointer); }
+void operator delete[](void* pointer, std::size_t) noexcept                        { freeReported(pointer); }
+void operator delete(void* pointer, const std::nothrow_t&) noexcept                { freeReported(pointer); }
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept              { freeReported(pointer); }
+void operator delete(void* pointer, std::align_val_t) noexcept                     { freeAlignedReported(pointer); }
+void operator delete[](void* pointer, std::align_val_t) noexcept                   { freeAlignedReported(pointer); }
+void operator delete(void* pointer, std::size_t, std::align_val_t) noexcept        { freeAlignedReported(pointer); }
+void operator delete[](void* pointer, std::size_t, std::align_val_t) noexcept      { freeAlignedReported(pointer); }
+void operator delete(void* pointer, std::align_val_t, const std::nothrow_t&) noexcept   { freeAlignedReported(pointer); }
+void operator delete[](void* pointer, std::align_val_t, const std::nothrow_t&) noexcept { freeAlignedReported(pointer); }
+
+#endif
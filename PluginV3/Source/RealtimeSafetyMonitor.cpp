@@ -0,0 +1,297 @@
+#include "RealtimeSafetyMonitor.h"
+
+#if PLUGINV3_RT_CHECKS
+
+#include "CycleCounter.h"
+
+#if JUCE_WINDOWS
+ #ifndef NOMINMAX
+  #define NOMINMAX
+ #endif
+ #include <windows.h>
+#elif JUCE_LINUX || JUCE_MAC
+ #include <execinfo.h>
+#endif
+
+#if JUCE_LINUX && (JUCE_GCC || JUCE_CLANG)
+ // Initial-exec TLS never allocates on first access, which matters when the
+ // allocator itself is what calls in here
+ #define PLUGINV3_THREAD_LOCAL __attribute__((tls_model("initial-exec"))) __thread
+#else
+ #define PLUGINV3_THREAD_LOCAL thread_local
+#endif
+
+namespace
+{
+    //==============================================================================
+    constexpr int maxFrames = 24;
+    constexpr int ringSize = 256;
+
+    enum SlotState
+    {
+        slotFree,
+        slotWriting,
+        slotReady
+    };
+
+    struct ViolationRecord
+    {
+        std::atomic<int> state { slotFree };
+        juce::uint64 sequence = 0;
+        RealtimeSafetyMonitor::ViolationType type = RealtimeSafetyMonitor::ViolationType::allocation;
+        size_t size = 0;
+        juce::int64 timeMs = 0;
+        juce::int64 blockIndex = 0;
+        float load = 0.0f;
+        int numFrames = 0;
+        void* frames[maxFrames] {};
+    };
+
+    // Written by any audio thread, drained by the logger thread
+    ViolationRecord violationRing[ringSize];
+    std::atomic<juce::uint64> nextSequence { 0 };
+
+    std::atomic<juce::int64> numBlocks { 0 };
+    std::atomic<juce::int64> numViolations { 0 };
+    std::atomic<juce::int64> numDropped { 0 };
+    std::atomic<float> worstLoad { 0.0f };
+    std::atomic<bool> monitorActive { false };
+    float deadlineFraction = 1.0f;
+
+    PLUGINV3_THREAD_LOCAL int callbackDepth = 0;
+    PLUGINV3_THREAD_LOCAL bool reporting = false;
+    PLUGINV3_THREAD_LOCAL juce::int64 currentBlock = 0;
+
+    //==============================================================================
+    int captureBacktrace(void** frames, int maxNumFrames) noexcept
+    {
+       #if JUCE_WINDOWS
+        return static_cast<int>(CaptureStackBackTrace(2, static_cast<DWORD>(maxNumFrames), frames, nullptr));
+       #elif JUCE_LINUX || JUCE_MAC
+        return backtrace(frames, maxNumFrames);
+       #else
+        juce::ignoreUnused(frames, maxNumFrames);
+        return 0;
+       #endif
+    }
+
+    void recordViolation(RealtimeSafetyMonitor::ViolationType type, size_t size, float load) noexcept
+    {
+        // Capturing the backtrace may itself call into the hooks
+        reporting = true;
+        numViolations.fetch_add(1, std::memory_order_relaxed);
+
+        const auto sequence = nextSequence.fetch_add(1, std::memory_order_relaxed);
+        auto& record = violationRing[sequence % ringSize];
+        int expected = slotFree;
+
+        // Never wait for the logger; if it has fallen behind, count the loss
+        if (record.state.compare_exchange_strong(expected, slotWriting, std::memory_order_acquire))
+        {
+            record.sequence = sequence;
+            record.type = type;
+            record.size = size;
+            record.timeMs = juce::Time::currentTimeMillis();
+            record.blockIndex = currentBlock;
+            record.load = load;
+            record.numFrames = type == RealtimeSafetyMonitor::ViolationType::deadline
+                                   ? 0
+                                   : captureBacktrace(record.frames, maxFrames);
+
+            record.state.store(slotReady, std::memory_order_release);
+        }
+        else
+        {
+            numDropped.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        reporting = false;
+    }
+
+    const char* getTypeName(RealtimeSafetyMonitor::ViolationType type) noexcept
+    {
+        switch (type)
+        {
+            case RealtimeSafetyMonitor::ViolationType::allocation:   return "allocation";
+            case RealtimeSafetyMonitor::ViolationType::deallocation: return "deallocation";
+            case RealtimeSafetyMonitor::ViolationType::lock:         return "lock";
+            case RealtimeSafetyMonitor::ViolationType::deadline:     return "deadline";
+        }
+
+        return "unknown";
+    }
+}
+
+//==============================================================================
+RealtimeSafetyMonitor::RealtimeSafetyMonitor()
+    : juce::Thread("RT Safety Monitor")
+{
+    // The first backtrace can load the unwinder, so get that out of the way here
+    void* frames[maxFrames];
+    captureBacktrace(frames, maxFrames);
+
+    deadlineFraction = juce::jmax(0.01f, juce::SystemStats::getEnvironmentVariable("PLUGINV3_RT_DEADLINE", "1.0").getFloatValue());
+
+    const auto logPath = juce::SystemStats::getEnvironmentVariable("PLUGINV3_RT_LOG", {});
+    logFile = logPath.isNotEmpty() ? juce::File(logPath)
+                                   : juce::File::getSpecialLocation(juce::File::tempDirectory)
+                                         .getChildFile("PluginV3_rt_violations.log");
+
+    logStream = std::make_unique<juce::FileOutputStream>(logFile);
+
+    if (logStream->failedToOpen())
+        logStream.reset();
+    else
+        *logStream << "=== PluginV3 real-time safety log, " << juce::Time::getCurrentTime().toString(true, true, true, true)
+                   << ", " << juce::File::getSpecialLocation(juce::File::hostApplicationPath).getFileName()
+                   << ", intercepting " << getInterceptedFunctions()
+                   << ", deadline at " << juce::String(deadlineFraction * 100.0f, 0) << "% of the buffer period\n";
+
+    monitorActive.store(true);
+    startThread(juce::Thread::Priority::low);
+}
+
+RealtimeSafetyMonitor::~RealtimeSafetyMonitor()
+{
+    monitorActive.store(false);
+    stopThread(2000);
+    writePendingViolations();
+
+    if (logStream != nullptr)
+    {
+        const auto statistics = getStatistics();
+        *logStream << "=== " << statistics.numBlocks << " blocks, " << statistics.numViolations << " violations ("
+                   << statistics.numDropped << " not logged), worst block at "
+                   << juce::String(statistics.worstLoad * 100.0f, 1) << "% of the buffer period\n";
+        logStream->flush();
+    }
+}
+
+//==============================================================================
+RealtimeSafetyMonitor::ScopedAudioCallback::ScopedAudioCallback(int numSamples, double sampleRate) noexcept
+    : startTime(CycleCounter::readNanoseconds()),
+      deadlineNanoseconds(sampleRate > 0.0 ? 1.0e9 * numSamples / sampleRate : 0.0)
+{
+    if (callbackDepth++ == 0)
+        currentBlock = numBlocks.fetch_add(1, std::memory_order_relaxed);
+}
+
+RealtimeSafetyMonitor::ScopedAudioCallback::~ScopedAudioCallback() noexcept
+{
+    if (callbackDepth == 1 && deadlineNanoseconds > 0.0 && monitorActive.load(std::memory_order_relaxed))
+    {
+        const auto elapsed = CycleCounter::readNanoseconds() - startTime;
+        const auto load = static_cast<float>(static_cast<double>(elapsed) / deadlineNanoseconds);
+
+        float worst = worstLoad.load(std::memory_order_relaxed);
+        while (load > worst && ! worstLoad.compare_exchange_weak(worst, load, std::memory_order_relaxed))
+        {
+        }
+
+        if (load > deadlineFraction)
+            recordViolation(ViolationType::deadline, static_cast<size_t>(elapsed), load);
+    }
+
+    --callbackDepth;
+}
+
+void RealtimeSafetyMonitor::reportViolation(ViolationType type, size_t size) noexcept
+{
+    if (callbackDepth == 0 || reporting || ! monitorActive.load(std::memory_order_relaxed))
+        return;
+
+    recordViolation(type, size, 0.0f);
+}
+
+RealtimeSafetyMonitor::Statistics RealtimeSafetyMonitor::getStatistics() const noexcept
+{
+    Statistics statistics;
+    statistics.numBlocks = numBlocks.load();
+    statistics.numViolations = numViolations.load();
+    statistics.numDropped = numDropped.load();
+    statistics.worstLoad = worstLoad.load();
+    return statistics;
+}
+
+//==============================================================================
+void RealtimeSafetyMonitor::run()
+{
+    while (! threadShouldExit())
+    {
+        wait(250);
+        writePendingViolations();
+    }
+}
+
+void RealtimeSafetyMonitor::writePendingViolations()
+{
+    struct Entry
+    {
+        juce::uint64 sequence;
+        ViolationType type;
+        size_t size;
+        juce::int64 timeMs;
+        juce::int64 blockIndex;
+        float load;
+        int numFrames;
+        void* frames[maxFrames];
+    };
+
+    juce::Array<Entry> entries;
+
+    for (auto& record : violationRing)
+    {
+        if (record.state.load(std::memory_order_acquire) != slotReady)
+            continue;
+
+        Entry entry { record.sequence, record.type, record.size, record.timeMs,
+                      record.blockIndex, record.load, record.numFrames, {} };
+        std::copy(record.frames, record.frames + record.numFrames, entry.frames);
+        entries.add(entry);
+
+        record.state.store(slotFree, std::memory_order_release);
+    }
+
+    if (entries.isEmpty() || logStream == nullptr)
+        return;
+
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.sequence < b.sequence; });
+
+    for (const auto& entry : entries)
+    {
+        auto& log = *logStream;
+        log << "[" << juce::Time(entry.timeMs).toString(true, true, true, true) << "] block " << entry.blockIndex << ": ";
+
+        if (entry.type == ViolationType::deadline)
+        {
+            log << "deadline missed, took " << juce::String(static_cast<double>(entry.size) / 1.0e6, 3) << " ms ("
+                << juce::String(entry.load * 100.0f, 1) << "% of the buffer period)\n";
+            continue;
+        }
+
+        log << getTypeName(entry.type);
+
+        if (entry.type != ViolationType::lock)
+            log << " of " << static_cast<juce::int64>(entry.size) << " bytes";
+
+        log << " on the audio thread\n";
+
+       #if JUCE_LINUX || JUCE_MAC
+        if (auto** symbols = backtrace_symbols(entry.frames, entry.numFrames))
+        {
+            for (int i = 0; i < entry.numFrames; ++i)
+                log << "    #" << i << " " << symbols[i] << "\n";
+
+            free(symbols);
+            continue;
+        }
+       #endif
+
+        for (int i = 0; i < entry.numFrames; ++i)
+            log << "    #" << i << " 0x" << juce::String::toHexString(reinterpret_cast<juce::pointer_sized_int>(entry.frames[i])) << "\n";
+    }
+
+    logStream->flush();
+}
+
+#endif
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+// Real-time safety instrumentation is opt-in (CMake: PLUGINV3_ENABLE_RT_CHECKS=ON).
+// When disabled, the checks in processBlock compile to nothing.
+#ifndef PLUGINV3_RT_CHECKS
+ #define PLUGINV3_RT_CHECKS 0
+#endif
+
+#if PLUGINV3_RT_CHECKS
+
+//==============================================================================
+/**
+ * Detects real-time safety violations inside processBlock.
+ *
+ * While a thread is inside a ScopedAudioCallback, allocations, frees and
+ * blocking lock calls are reported here by the interposed functions in
+ * RealtimeSafetyHooks.cpp, and each block's execution time is checked against
+ * its buffer period. The audio thread only captures a raw backtrace into a
+ * fixed ring; a logger thread symbolises and writes the violations to a log
+ * file (PLUGINV3_RT_LOG, or PluginV3_rt_violations.log in the temp directory).
+ *
+ * What is intercepted depends on the platform: operator new/delete
+ * everywhere, plus malloc, free and pthread mutex/rwlock locking on Linux.
+ *
+ * One monitor is shared by all instances; hold it through a
+ * juce::SharedResourcePointer.
+ */
+class RealtimeSafetyMonitor : private juce::Thread
+{
+public:
+    //==============================================================================
+    enum class ViolationType
+    {
+        allocation,
+        deallocation,
+        lock,
+        deadline
+    };
+
+    RealtimeSafetyMonitor();
+    ~RealtimeSafetyMonitor() override;
+
+    //==============================================================================
+    /** Marks the calling thread as running processBlock for the lifetime of
+        this object, and checks the block against its deadline at the end. */
+    class ScopedAudioCallback
+    {
+    public:
+        ScopedAudioCallback(int numSamples, double sampleRate) noexcept;
+        ~ScopedAudioCallback() noexcept;
+
+    private:
+        juce::int64 startTime;
+        double deadlineNanoseconds;
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedAudioCallback)
+    };
+
+    /** Records a violation if the calling thread is inside an audio callback.
+        Called from the interposed functions, so it must never allocate or lock. */
+    static void reportViolation(ViolationType type, size_t size) noexcept;
+
+    /** Describes which functions this build intercepts. */
+    static const char* getInterceptedFunctions() noexcept;
+
+    //==============================================================================
+    struct Statistics
+    {
+        juce::int64 numBlocks = 0;
+        juce::int64 numViolations = 0;
+        juce::int64 numDropped = 0;
+
+        /** Highest execution time seen, as a fraction of the buffer period. */
+        float worstLoad = 0.0f;
+    };
+
+    Statistics getStatistics() const noexcept;
+
+    juce::File getLogFile() const { return logFile; }
+
+private:
+    //==============================================================================
+    void run() override;
+    void writePendingViolations();
+
+    juce::File logFile;
+    std::unique_ptr<juce::FileOutputStream> logStream;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(RealtimeSafetyMonitor)
+};
+
+#else
+
+//==============================================================================
+// Instrumentation disabled: nothing to construct and nothing to check
+struct RealtimeSafetyMonitor
+{
+    struct ScopedAudioCallback
+    {
+        ScopedAudioCallback(int, double) noexcept {}
+    };
+};
+
+#endif
@@ -0,0 +1,388 @@
+#include "SharedMeterBus.h"
+
+namespace
+{
+    constexpr juce::uint32 magicNumber = 0x424d5650;   // "PVMB"
+    constexpr juce::uint32 layoutVersion = 1;
+    constexpr int nameWords = (SharedMeterBus::maxNameLength + 1) / 4;
+    constexpr int maxReadAttempts = 4;
+
+    static_assert(std::atomic<float>::is_always_lock_free && std::atomic<juce::int64>::is_always_lock_free,
+                  "the shared slots rely on lock-free atomics");
+
+    juce::File getRegistryFile()
+    {
+        return juce::File::getSpecialLocation(juce::File::tempDirectory).getChildFile("PluginV3MeterBus.bin");
+    }
+}
+
+//==============================================================================
+// The mapped layout. Only ever add fields to the end of a slot, and bump
+// layoutVersion whenever the size or order changes.
+struct SharedMeterBus::Header
+{
+    std::atomic<juce::uint32> magic;
+    std::atomic<juce::uint32> version;
+    std::atomic<juce::uint32> numSlots;
+    std::atomic<juce::uint32> slotSize;
+};
+
+struct alignas(64) SharedMeterBus::Slot
+{
+    std::atomic<juce::uint32> owner;            // Claim token, 0 when free
+    std::atomic<juce::uint32> sequence;         // Odd while the readings are being written
+    std::atomic<juce::int64> heartbeatTime;     // Milliseconds since the epoch
+    std::atomic<juce::int64> publishTime;
+
+    std::atomic<float> peakLeft;
+    std::atomic<float> peakRight;
+    std::atomic<float> loudness;
+    std::atomic<float> correlation;
+    std::atomic<float> balance;
+
+    std::atomic<juce::uint32> nameSequence;
+    std::atomic<juce::uint32> name[nameWords];  // UTF-8, null-terminated
+};
+
+//==============================================================================
+SharedMeterBus::SharedMeterBus()
+{
+    const auto file = getRegistryFile();
+    const auto requiredSize = static_cast<juce::int64>(sizeof(Slot) * (maxSlots + 1));
+
+    {
+        // Creating and sizing the file must not race with another process
+        juce::InterProcessLock lock("PluginV3MeterBus");
+        const juce::InterProcessLock::ScopedLockType scopedLock(lock);
+
+        if (file.getSize() < requiredSize)
+        {
+            juce::FileOutputStream stream(file);
+
+            if (! stream.openedOk())
+                return;
+
+            // Appending zeros keeps any slots already in use
+            stream.setPosition(file.getSize());
+            stream.writeRepeatedByte(0, static_cast<size_t>(requiredSize - file.getSize()));
+            stream.flush();
+        }
+    }
+
+    mappedFile = std::make_unique<juce::MemoryMappedFile>(file, juce::Range<juce::int64>(0, requiredSize),
+                                                          juce::MemoryMappedFile::readWrite, false);
+
+    if (mappedFile->getData() == nullptr || mappedFile->getSize() < static_cast<size_t>(requiredSize))
+    {
+        mappedFile.reset();
+        return;
+    }
+
+    // The header takes the first slot-sized block, so every slot stays aligned
+    header = static_cast<Header*>(mappedFile->getData());
+    auto* slotArray = reinterpret_cast<Slot*>(static_cast<char*>(mappedFile->getData()) + sizeof(Slot));
+
+    juce::uint32 expected = 0;
+    if (header->magic.compare_exchange_strong(expected, magicNumber))
+    {
+        header->version.store(layoutVersion);
+        header->numSlots.store(static_cast<juce::uint32>(maxSlots));
+        header->slotSize.store(static_cast<juce::uint32>(sizeof(Slot)));
+    }
+    else
+    {
+        // A creator may still be filling in the header
+        for (int attempt = 0; attempt < 100 && header->slotSize.load() == 0; ++attempt)
+            juce::Thread::sleep(1);
+    }
+
+    // Stay off a registry laid out by an incompatible build
+    if (header->magic.load() != magicNumber
+        || header->version.load() != layoutVersion
+        || header->numSlots.load() != static_cast<juce::uint32>(maxSlots)
+        || header->slotSize.load() != static_cast<juce::uint32>(sizeof(Slot)))
+    {
+        header = nullptr;
+        mappedFile.reset();
+        return;
+    }
+
+    slots = slotArray;
+}
+
+SharedMeterBus::~SharedMeterBus() = default;
+
+//==============================================================================
+int SharedMeterBus::claimSlot(juce::uint32 token) noexcept
+{
+    jassert(token != 0);
+
+    if (slots == nullptr)
+        return -1;
+
+    const auto now = juce::Time::currentTimeMillis();
+
+    for (int index = 0; index < maxSlots; ++index)
+    {
+        auto& slot = slots[index];
+        auto owner = slot.owner.load();
+        auto lastHeartbeat = slot.heartbeatTime.load();
+
+        const bool abandoned = owner != 0 && now - lastHeartbeat > staleMilliseconds;
+
+        if (owner != 0 && ! abandoned)
+            continue;
+
+        // The heartbeat is stamped before the slot is taken, so no other
+        // process can find it abandoned in between; of several processes
+        // reclaiming the same slot, only the one whose stamp lands goes on
+        if (! slot.heartbeatTime.compare_exchange_strong(lastHeartbeat, now))
+            continue;
+
+        if (slot.owner.compare_exchange_strong(owner, token))
+        {
+            slot.publishTime.store(0);
+            return index;
+        }
+    }
+
+    return -1;
+}
+
+void SharedMeterBus::releaseSlot(int index, juce::uint32 token) noexcept
+{
+    if (slots == nullptr || ! juce::isPositiveAndBelow(index, maxSlots))
+        return;
+
+    auto expected = token;
+    slots[index].owner.compare_exchange_strong(expected, 0);
+}
+
+bool SharedMeterBus::heartbeat(int index, juce::uint32 token) noexcept
+{
+    if (slots == nullptr || ! juce::isPositiveAndBelow(index, maxSlots))
+        return false;
+
+    auto& slot = slots[index];
+
+    if (slot.owner.load() != token)
+        return false;
+
+    slot.heartbeatTime.store(juce::Time::currentTimeMillis());
+    return true;
+}
+
+void SharedMeterBus::setName(int index, const juce::String& newName) noexcept
+{
+    if (slots == nullptr || ! juce::isPositiveAndBelow(index, maxSlots))
+        return;
+
+    char buffer[nameWords * 4] {};
+    newName.copyToUTF8(buffer, sizeof(buffer));
+
+    auto& slot = slots[index];
+    const auto sequence = slot.nameSequence.load(std::memory_order_relaxed);
+    slot.nameSequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    for (int word = 0; word < nameWords; ++word)
+    {
+        juce::uint32 packed;
+        std::memcpy(&packed, buffer + word * 4, 4);
+        slot.name[word].store(packed, std::memory_order_relaxed);
+    }
+
+    slot.nameSequence.store(sequence + 2, std::memory_order_release);
+}
+
+void SharedMeterBus::publish(int index, const Reading& reading) noexcept
+{
+    if (slots == nullptr || ! juce::isPositiveAndBelow(index, maxSlots))
+        return;
+
+    auto& slot = slots[index];
+
+    // Sequence lock, writer side: odd while the fields are inconsistent
+    const auto sequence = slot.sequence.load(std::memory_order_relaxed);
+    slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot.peakLeft.store(reading.peak[0], std::memory_order_relaxed);
+    slot.peakRight.store(reading.peak[1], std::memory_order_relaxed);
+    slot.loudness.store(reading.loudness, std::memory_order_relaxed);
+    slot.correlation.store(reading.correlation, std::memory_order_relaxed);
+    slot.balance.store(reading.balance, std::memory_order_relaxed);
+    slot.publishTime.store(juce::Time::currentTimeMillis(), std::memory_order_relaxed);
+
+    slot.sequence.store(sequence + 2, std::memory_order_release);
+}
+
+juce::Array<SharedMeterBus::Entry> SharedMeterBus::getEntries() const
+{
+    juce::Array<Entry> entries;
+
+    if (slots == nullptr)
+        return entries;
+
+    const auto now = juce::Time::currentTimeMillis();
+
+    for (int index = 0; index < maxSlots; ++index)
+    {
+        const auto& slot = slots[index];
+
+        if (slot.owner.load() == 0 || now - slot.heartbeatTime.load() > staleMilliseconds)
+            continue;
+
+        Entry entry;
+        entry.slot = index;
+        bool consistent = false;
+
+        // Sequence lock, reader side: retry a slot caught mid-write, and
+        // skip it for this poll if the writer keeps it busy
+        for (int attempt = 0; attempt < maxReadAttempts && ! consistent; ++attempt)
+        {
+            const auto before = slot.sequence.load(std::memory_order_acquire);
+
+            if ((before & 1) != 0)
+                continue;
+
+            entry.reading.peak[0] = slot.peakLeft.load(std::memory_order_relaxed);
+            entry.reading.peak[1] = slot.peakRight.load(std::memory_order_relaxed);
+            entry.reading.loudness = slot.loudness.load(std::memory_order_relaxed);
+            entry.reading.correlation = slot.correlation.load(std::memory_order_relaxed);
+            entry.reading.balance = slot.balance.load(std::memory_order_relaxed);
+            const auto publishTime = slot.publishTime.load(std::memory_order_relaxed);
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            consistent = slot.sequence.load(std::memory_order_relaxed) == before;
+            entry.ageMilliseconds = publishTime > 0 ? now - publishTime : now;
+        }
+
+        if (! consistent)
+            continue;
+
+        char buffer[nameWords * 4 + 1] {};
+
+        for (int attempt = 0; attempt < maxReadAttempts; ++attempt)
+        {
+            const auto before = slot.nameSequence.load(std::memory_order_acquire);
+
+            for (int word = 0; word < nameWords; ++word)
+            {
+                const auto packed = slot.name[word].load(std::memory_order_relaxed);
+                std::memcpy(buffer + word * 4, &packed, 4);
+            }
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+            if ((before & 1) == 0 && slot.nameSequence.load(std::memory_order_relaxed) == before)
+                break;
+        }
+
+        buffer[nameWords * 4] = 0;
+        entry.name = juce::String::fromUTF8(buffer);
+
+        if (entry.name.isEmpty())
+            entry.name = "Slot " + juce::String(index + 1);
+
+        entries.add(entry);
+    }
+
+    return entries;
+}
+
+//==============================================================================
+MeterBusPublisher::MeterBusPublisher(bool shouldPublish)
+    : token(static_cast<juce::uint32>(juce::Random::getSystemRandom().nextInt()) | 1u),
+      publishing(shouldPublish)
+{
+    // Only publishers map the registry file
+    if (publishing)
+    {
+        bus = std::make_unique<juce::SharedResourcePointer<SharedMeterBus>>();
+        slot.store((*bus)->claimSlot(token));
+    }
+}
+
+MeterBusPublisher::~MeterBusPublisher()
+{
+    if (bus != nullptr)
+        (*bus)->releaseSlot(slot.load(), token);
+}
+
+void MeterBusPublisher::prepare(double newSampleRate)
+{
+    sampleRate = newSampleRate;
+
+    for (auto& filter : weightingFilters)
+        filter.prepare(sampleRate);
+
+    loudnessEnergy = 0.0;
+}
+
+void MeterBusPublisher::process(const float* left, const float* right, const MeterFrame& frame) noexcept
+{
+    const int index = slot.load(std::memory_order_relaxed);
+
+    if (index < 0 || frame.numSamples <= 0)
+        return;
+
+    // BS.1770 sums the K-weighted channel energies
+    double blockEnergy = 0.0;
+    const float* channels[MeterFrame::maxChannels] = { left, right };
+
+    for (int channel = 0; channel < frame.numChannels; ++channel)
+    {
+        auto& filter = weightingFilters[static_cast<size_t>(channel)];
+
+        for (int sample = 0; sample < frame.numSamples; ++sample)
+        {
+            const double weighted = filter.processSample(channels[channel][sample]);
+            blockEnergy += weighted * weighted;
+        }
+    }
+
+    // Running mean square with the 400 ms momentary time constant
+    const double weight = 1.0 - std::exp(-frame.numSamples / (0.4 * sampleRate));
+    loudnessEnergy += weight * (blockEnergy / frame.numSamples - loudnessEnergy);
+
+    SharedMeterBus::Reading reading;
+    reading.peak[0] = frame.peak[0];
+    reading.peak[1] = frame.peak[1];
+    reading.loudness = loudnessEnergy > 1.0e-10 ? static_cast<float>(-0.691 + 10.0 * std::log10(loudnessEnergy)) : -100.0f;
+    reading.correlation = frame.correlation;
+
+    const double leftEnergy = static_cast<double>(frame.rms[0]) * frame.rms[0];
+    const double rightEnergy = static_cast<double>(frame.rms[1]) * frame.rms[1];
+    reading.balance = leftEnergy + rightEnergy > 0.0
+                          ? static_cast<float>((rightEnergy - leftEnergy) / (rightEnergy + leftEnergy))
+                          : 0.0f;
+
+    (*bus)->publish(index, reading);
+}
+
+void MeterBusPublisher::heartbeat()
+{
+    if (! publishing)
+        return;
+
+    const int index = slot.load();
+
+    if (index >= 0 && (*bus)->heartbeat(index, token))
+        return;
+
+    // Lost the slot (or never had one): try again, the table may have room now
+    const int newIndex = (*bus)->claimSlot(token);
+    slot.store(newIndex);
+
+    if (newIndex >= 0)
+        (*bus)->setName(newIndex, name);
+}
+
+void MeterBusPublisher::setName(const juce::String& newName)
+{
+    name = newName;
+
+    if (bus != nullptr)
+        (*bus)->setName(slot.load(), name);
+}
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "LoudnessMeter.h"
+#include "MeterFrame.h"
+
+//==============================================================================
+/**
+ * A registry of meter readings shared by every instance on the machine.
+ *
+ * The registry is a small file in the temp directory, memory-mapped by each
+ * process, holding a fixed table of slots. An instance claims a free slot
+ * with a compare-and-swap and keeps it alive with a heartbeat; slots whose
+ * heartbeat has stopped (a crashed host) are reclaimed. Each slot's readings
+ * are guarded by a sequence lock: the audio thread publishes without ever
+ * waiting, and readers poll at UI rate and retry a slot caught mid-write.
+ *
+ * One mapping is shared per process; hold it through a
+ * juce::SharedResourcePointer.
+ */
+class SharedMeterBus
+{
+public:
+    //==============================================================================
+    static constexpr int maxSlots = 64;
+    static constexpr int maxNameLength = 47;
+
+    /** Slots without a heartbeat for this long are treated as abandoned. */
+    static constexpr juce::int64 staleMilliseconds = 5000;
+
+    struct Reading
+    {
+        float peak[MeterFrame::maxChannels] {};
+        float loudness = -100.0f;       // Momentary, LUFS
+        float correlation = 0.0f;       // -1 to +1
+        float balance = 0.0f;           // -1 (left) to +1 (right), by energy
+    };
+
+    struct Entry
+    {
+        int slot = -1;
+        juce::String name;
+        Reading reading;
+        juce::int64 ageMilliseconds = 0;    // Since the last published reading
+    };
+
+    SharedMeterBus();
+    ~SharedMeterBus();
+
+    /** False if the registry file couldn't be mapped, in which case every
+        call below does nothing. */
+    bool isAvailable() const noexcept { return slots != nullptr; }
+
+    //==============================================================================
+    /** Claims a free or abandoned slot; returns its index, or -1 if the table
+        is full. token identifies the owner and must be non-zero. */
+    int claimSlot(juce::uint32 token) noexcept;
+
+    /** Frees a slot, if it is still owned by token. */
+    void releaseSlot(int slot, juce::uint32 token) noexcept;
+
+    /** Keeps a slot from being reclaimed. Returns false if the slot has been
+        taken over, in which case the owner should claim a new one. */
+    bool heartbeat(int slot, juce::uint32 token) noexcept;
+
+    /** Sets the name shown for a slot. Called from one thread at a time. */
+    void setName(int slot, const juce::String& name) noexcept;
+
+    /** Publishes a reading. Wait-free; safe to call from the audio thread. */
+    void publish(int slot, const Reading& reading) noexcept;
+
+    /** Takes a consistent copy of every live slot. */
+    juce::Array<Entry> getEntries() const;
+
+private:
+    //==============================================================================
+    struct Slot;
+    struct Header;
+
+    std::unique_ptr<juce::MemoryMappedFile> mappedFile;
+    Header* header { nullptr };
+    Slot* slots { nullptr };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SharedMeterBus)
+};
+
+//==============================================================================
+/**
+ * One instance's connection to the SharedMeterBus: owns a slot, measures
+ * momentary loudness and balance on the audio thread and publishes them
+ * with each meter frame.
+ *
+ * A publisher created with shouldPublish false (a processor the offline
+ * tools run, which no other instance could show) never maps the registry or
+ * claims a slot, and process() returns before any measuring.
+ */
+class MeterBusPublisher
+{
+public:
+    //==============================================================================
+    explicit MeterBusPublisher(bool shouldPublish);
+    ~MeterBusPublisher();
+
+    /** Resets the loudness measurement for a new sample rate. */
+    void prepare(double sampleRate);
+
+    /** Measures a processed block and publishes it with its frame. Wait-free;
+        right may be nullptr for mono. */
+    void process(const float* left, const float* right, const MeterFrame& frame) noexcept;
+
+    /** Keeps the slot alive, claiming a new one if it was lost. Call
+        regularly from the message thread. */
+    void heartbeat();
+
+    /** Sets the name other instances show for this one. */
+    void setName(const juce::String& newName);
+
+    int getSlot() const noexcept { return slot.load(std::memory_order_relaxed); }
+
+    /** The registry, or nullptr for a publisher that doesn't publish. */
+    const SharedMeterBus* getBus() const noexcept { return bus != nullptr ? bus->get() : nullptr; }
+
+private:
+    //==============================================================================
+    // Created only when publishing, so the offline tools never map the file
+    std::unique_ptr<juce::SharedResourcePointer<SharedMeterBus>> bus;
+    const juce::uint32 token;
+    const bool publishing;
+    std::atomic<int> slot { -1 };
+    juce::String name;
+
+    double sampleRate { 44100.0 };
+    std::array<KWeightingFilter, MeterFrame::maxChannels> weightingFilters;
+    double loudnessEnergy { 0.0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MeterBusPublisher)
+};
@@ -0,0 +1,67 @@
+#include "SharedTables.h"
+
+namespace
+{
+    // Weak references only: the holders own the tables
+    struct Cache
+    {
+        juce::CriticalSection lock;
+        std::map<juce::String, std::weak_ptr<const void>> tables;
+    };
+
+    Cache& getCache()
+    {
+        static Cache cache;
+        return cache;
+    }
+}
+
+//==============================================================================
+std::shared_ptr<const juce::dsp::FFT> SharedTables::getFft(int order)
+{
+    return get<juce::dsp::FFT>("fft " + juce::String(order), [order]()
+    {
+        return std::make_shared<juce::dsp::FFT>(order);
+    });
+}
+
+std::shared_ptr<const std::vector<float>> SharedTables::getHannWindow(int size)
+{
+    return get<std::vector<float>>("hann " + juce::String(size), [size]()
+    {
+        auto window = std::make_shared<std::vector<float>>(static_cast<size_t>(juce::jmax(1, size)));
+        juce::dsp::WindowingFunction<float>::fillWindowingTables(window->data(), window->size(),
+                                                                 juce::dsp::WindowingFunction<float>::hann,
+                                                                 false);
+        return window;
+    });
+}
+
+//==============================================================================
+std::shared_ptr<const void> SharedTables::find(const juce::String& key)
+{
+    auto& cache = getCache();
+    const juce::ScopedLock scopedLock(cache.lock);
+
+    const auto entry = cache.tables.find(key);
+    return entry != cache.tables.end() ? entry->second.lock() : nullptr;
+}
+
+std::shared_ptr<const void> SharedTables::insert(const juce::String& key, std::shared_ptr<const void> table)
+{
+    auto& cache = getCache();
+    const juce::ScopedLock scopedLock(cache.lock);
+
+    auto& entry = cache.tables[key];
+
+    if (auto existing = entry.lock())
+        return existing;
+
+    entry = table;
+
+    // Drop the entries of tables nobody holds any more
+    for (auto it = cache.tables.begin(); it != cache.tables.end();)
+        it = it->second.expired() ? cache.tables.erase(it) : std::next(it);
+
+    return table;
+}
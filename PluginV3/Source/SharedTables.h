@@ -0,0 +1,45 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+ * A process-wide cache of immutable DSP tables: FFT plans, analysis windows
+ * and interpolator coefficients. Every instance asking for the same table
+ * gets the same copy. A table is built on first use and freed when its last
+ * holder lets go of it, so no memory outlives the instances using it.
+ *
+ * Lookups lock and may allocate, so they belong in prepare(), not on the
+ * audio thread. The tables never change, so any number of threads can read
+ * one at the same time.
+ */
+class SharedTables
+{
+public:
+    //==============================================================================
+    /** A forward FFT plan; juce::dsp::FFT keeps no state between transforms. */
+    static std::shared_ptr<const juce::dsp::FFT> getFft(int order);
+
+    /** A Hann window of size values, as filled in by
+        juce::dsp::WindowingFunction without normalisation. */
+    static std::shared_ptr<const std::vector<float>> getHannWindow(int size);
+
+    /** Returns the table stored under key, calling create() to build it if no
+        one holds it. Keys have to be unique across table types, so start them
+        with the kind of table. create() returns a std::shared_ptr<Table>. */
+    template <typename Table, typename CreateFunction>
+    static std::shared_ptr<const Table> get(const juce::String& key, CreateFunction&& create)
+    {
+        if (auto existing = find(key))
+            return std::static_pointer_cast<const Table>(existing);
+
+        // Built outside the lock; if another thread got there first, its copy wins
+        std::shared_ptr<const Table> table = create();
+        return std::static_pointer_cast<const Table>(insert(key, std::move(table)));
+    }
+
+private:
+    //==============================================================================
+    static std::shared_ptr<const void> find(const juce::String& key);
+    static std::shared_ptr<const void> insert(const juce::String& key, std::shared_ptr<const void> table);
+};
@@ -0,0 +1,319 @@
+#include "SpectrumAnalyser.h"
+#include "SharedTables.h"
+
+namespace
+{
+    constexpr int numOrders = SpectrumAnalyser::maximumOrder - SpectrumAnalyser::minimumOrder + 1;
+    constexpr int maxFftSize = 1 << SpectrumAnalyser::maximumOrder;
+
+    // Room for two of the largest windows at any overlap
+    constexpr int captureSize = 4 * maxFftSize;
+
+    // Frames per analyser per pass, so one busy instance can't starve the others
+    constexpr int maxFramesPerPass = 4;
+
+    constexpr float minimumPower = 1.0e-12f;    // -120dBFS
+}
+
+//==============================================================================
+/** FFTs, windows and scratch space for every size, shared by all analysers
+    since only the worker thread touches them. The plans and windows come
+    from SharedTables, so other analysers of the same size use them too. */
+struct SpectrumAnalyser::Workspace
+{
+    Workspace()
+    {
+        for (int index = 0; index < numOrders; ++index)
+        {
+            const int size = 1 << (minimumOrder + index);
+            ffts[static_cast<size_t>(index)] = SharedTables::getFft(minimumOrder + index);
+
+            const auto& window = windows[static_cast<size_t>(index)] = SharedTables::getHannWindow(size);
+
+            // Scales magnitudes so a full-scale sine reads 0dBFS
+            float windowSum = 0.0f;
+            for (int i = 0; i < size; ++i)
+                windowSum += (*window)[static_cast<size_t>(i)];
+
+            magnitudeScales[static_cast<size_t>(index)] = 2.0f / windowSum;
+        }
+
+        // The frequency-only FFT works in place on buffers of twice the transform size
+        scratch.allocate(static_cast<size_t>(2 * maxFftSize), true);
+    }
+
+    std::array<std::shared_ptr<const juce::dsp::FFT>, numOrders> ffts;
+    std::array<std::shared_ptr<const std::vector<float>>, numOrders> windows;
+    std::array<float, numOrders> magnitudeScales {};
+    juce::HeapBlock<float> scratch;
+};
+
+//==============================================================================
+/** The background thread shared by every active analyser in the process. */
+class SpectrumAnalyser::Worker : private juce::Thread
+{
+public:
+    Worker()
+        : juce::Thread("Spectrum Analyser")
+    {
+        startThread(juce::Thread::Priority::low);
+    }
+
+    ~Worker() override
+    {
+        stopThread(2000);
+    }
+
+    void add(SpectrumAnalyser& analyser)
+    {
+        const juce::ScopedLock lock(analyserLock);
+        analysers.addIfNotAlreadyThere(&analyser);
+        notify();
+    }
+
+    /** Once this returns, the worker no longer touches the analyser. */
+    void remove(SpectrumAnalyser& analyser)
+    {
+        const juce::ScopedLock lock(analyserLock);
+        analysers.removeFirstMatchingValue(&analyser);
+    }
+
+private:
+    void run() override
+    {
+        while (! threadShouldExit())
+        {
+            bool didWork = false;
+
+            {
+                const juce::ScopedLock lock(analyserLock);
+
+                for (auto* analyser : analysers)
+                    didWork = analyser->processPending(workspace) || didWork;
+            }
+
+            if (! didWork)
+                wait(10);
+        }
+    }
+
+    Workspace workspace;
+    juce::CriticalSection analyserLock;
+    juce::Array<SpectrumAnalyser*> analysers;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Worker)
+};
+
+//==============================================================================
+SpectrumAnalyser::SpectrumAnalyser() = default;
+
+SpectrumAnalyser::~SpectrumAnalyser()
+{
+    setActive(false);
+}
+
+void SpectrumAnalyser::prepare(double sampleRate)
+{
+    currentSampleRate.store(sampleRate);
+    resetRequested.store(true);
+}
+
+void SpectrumAnalyser::setActive(bool shouldBeActive)
+{
+    if (shouldBeActive == active.load())
+        return;
+
+    if (shouldBeActive)
+    {
+        // Allocated on first use and kept, as the audio thread may still be
+        // writing when the analyser is switched off
+        if (captureBuffer.getNumSamples() == 0)
+        {
+            captureBuffer.setSize(2, captureSize);
+            captureFifo.setTotalSize(captureSize);
+            frameBuffer.setSize(2, maxFftSize);
+            averagedPower.setSize(2, maxNumBins);
+            publishedSpectra.setSize(2, maxNumBins);
+            publishedSpectra.clear();
+        }
+
+        resetRequested.store(true);
+        worker = std::make_unique<juce::SharedResourcePointer<Worker>>();
+        (*worker)->add(*this);
+        active.store(true, std::memory_order_release);
+    }
+    else
+    {
+        active.store(false, std::memory_order_release);
+        (*worker)->remove(*this);
+
+        // The last analyser to go takes the thread with it
+        worker.reset();
+    }
+}
+
+void SpectrumAnalyser::pushSamples(const float* left, const float* right, int numSamples) noexcept
+{
+    if (! active.load(std::memory_order_acquire))
+        return;
+
+    int start1, size1, start2, size2;
+    captureFifo.prepareToWrite(numSamples, start1, size1, start2, size2);
+
+    // Never wait for the worker; a gap just restarts frame assembly
+    if (size1 + size2 < numSamples)
+    {
+        captureOverflowed.store(true);
+        return;
+    }
+
+    captureBuffer.copyFrom(0, start1, left, size1);
+    captureBuffer.copyFrom(1, start1, right, size1);
+
+    if (size2 > 0)
+    {
+        captureBuffer.copyFrom(0, start2, left + size1, size2);
+        captureBuffer.copyFrom(1, start2, right + size1, size2);
+    }
+
+    captureFifo.finishedWrite(size1 + size2);
+}
+
+//==============================================================================
+bool SpectrumAnalyser::processPending(Workspace& workspace) noexcept
+{
+    const int order = fftOrder.load();
+
+    if (resetRequested.exchange(false) || order != analysisOrder)
+    {
+        captureFifo.finishedRead(captureFifo.getNumReady());
+        captureOverflowed.store(false);
+        analysisOrder = order;
+        frameFill = 0;
+        hasAverage = false;
+    }
+
+    if (captureOverflowed.exchange(false))
+        frameFill = 0;
+
+    const int fftSize = 1 << analysisOrder;
+    const int hopSize = fftSize / overlap.load();
+    int numFrames = 0;
+
+    while (numFrames < maxFramesPerPass && captureFifo.getNumReady() >= hopSize)
+    {
+        // Slide the frame by one hop and append the next
+        for (int channel = 0; channel < 2; ++channel)
+        {
+            auto* frame = frameBuffer.getWritePointer(channel);
+            std::memmove(frame, frame + hopSize, static_cast<size_t>(fftSize - hopSize) * sizeof(float));
+        }
+
+        int start1, size1, start2, size2;
+        captureFifo.prepareToRead(hopSize, start1, size1, start2, size2);
+
+        for (int channel = 0; channel < 2; ++channel)
+        {
+            auto* destination = frameBuffer.getWritePointer(channel, fftSize - hopSize);
+            juce::FloatVectorOperations::copy(destination, captureBuffer.getReadPointer(channel, start1), size1);
+            juce::FloatVectorOperations::copy(destination + size1, captureBuffer.getReadPointer(channel, start2), size2);
+        }
+
+        captureFifo.finishedRead(size1 + size2);
+        frameFill = juce::jmin(fftSize, frameFill + hopSize);
+
+        if (frameFill < fftSize)
+            continue;
+
+        analyseFrame(workspace);
+        ++numFrames;
+    }
+
+    if (numFrames > 0)
+        publish();
+
+    return numFrames > 0;
+}
+
+void SpectrumAnalyser::analyseFrame(Workspace& workspace) noexcept
+{
+    const auto index = static_cast<size_t>(analysisOrder - minimumOrder);
+    const int fftSize = 1 << analysisOrder;
+    const int numBins = fftSize / 2 + 1;
+    const float* window = workspace.windows[index]->data();
+    const float scale = workspace.magnitudeScales[index];
+    float* scratch = workspace.scratch.get();
+
+    const float* left = frameBuffer.getReadPointer(0);
+    const float* right = frameBuffer.getReadPointer(1);
+    const bool useMidSide = mode.load() == SpectrumAnalyser::midSide;
+
+    // The first frame seeds the average, so the display doesn't fade in
+    const float weight = hasAverage ? averaging.load() : 0.0f;
+
+    for (int trace = 0; trace < 2; ++trace)
+    {
+        if (useMidSide)
+        {
+            const float sign = trace == 0 ? 1.0f : -1.0f;
+            for (int i = 0; i < fftSize; ++i)
+                scratch[i] = 0.5f * (left[i] + sign * right[i]) * window[i];
+        }
+        else
+        {
+            juce::FloatVectorOperations::multiply(scratch, trace == 0 ? left : right, window, fftSize);
+        }
+
+        juce::FloatVectorOperations::clear(scratch + fftSize, fftSize);
+        workspace.ffts[index]->performFrequencyOnlyForwardTransform(scratch, true);
+
+        auto* average = averagedPower.getWritePointer(trace);
+
+        for (int bin = 0; bin < numBins; ++bin)
+        {
+            const float magnitude = scratch[bin] * scale;
+            average[bin] = weight * average[bin] + (1.0f - weight) * magnitude * magnitude;
+        }
+    }
+
+    hasAverage = true;
+}
+
+void SpectrumAnalyser::publish() noexcept
+{
+    const int numBins = (1 << analysisOrder) / 2 + 1;
+
+    {
+        const juce::SpinLock::ScopedLockType lock(spectrumLock);
+
+        for (int trace = 0; trace < 2; ++trace)
+        {
+            const auto* average = averagedPower.getReadPointer(trace);
+            auto* spectrum = publishedSpectra.getWritePointer(trace);
+
+            for (int bin = 0; bin < numBins; ++bin)
+                spectrum[bin] = 10.0f * std::log10(juce::jmax(minimumPower, average[bin]));
+        }
+
+        publishedInfo.numBins = numBins;
+        publishedInfo.fftSize = 1 << analysisOrder;
+        publishedInfo.sampleRate = currentSampleRate.load();
+    }
+
+    version.fetch_add(1, std::memory_order_release);
+}
+
+bool SpectrumAnalyser::copySpectra(float* first, float* second, SpectrumInfo& info, juce::uint32& lastVersion) const
+{
+    const auto currentVersion = version.load(std::memory_order_acquire);
+
+    if (currentVersion == lastVersion || publishedSpectra.getNumSamples() == 0)
+        return false;
+
+    const juce::SpinLock::ScopedLockType lock(spectrumLock);
+    info = publishedInfo;
+    juce::FloatVectorOperations::copy(first, publishedSpectra.getReadPointer(0), info.numBins);
+    juce::FloatVectorOperations::copy(second, publishedSpectra.getReadPointer(1), info.numBins);
+    lastVersion = currentVersion;
+    return true;
+}
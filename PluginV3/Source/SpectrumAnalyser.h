@@ -0,0 +1,111 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+ * Averaged L/R or M/S power spectra of a stereo signal, for display.
+ *
+ * The audio thread pushes into a lock-free FIFO, and only while a display is
+ * active; an inactive analyser costs a single atomic load per block and
+ * allocates nothing until it is first shown. Every active analyser in the
+ * process is serviced by one shared background thread, a few frames at a
+ * time in turn, so many open editors share one thread and one set of
+ * preallocated FFTs, windows and scratch buffers. The thread only exists
+ * while at least one analyser is active.
+ */
+class SpectrumAnalyser
+{
+public:
+    //==============================================================================
+    enum Mode
+    {
+        leftRight,
+        midSide
+    };
+
+    static constexpr int minimumOrder = 10;     // 1024-point FFT
+    static constexpr int maximumOrder = 14;     // 16384-point FFT
+    static constexpr int maxNumBins = (1 << maximumOrder) / 2 + 1;
+
+    SpectrumAnalyser();
+    ~SpectrumAnalyser();
+
+    /** Sets the rate of the pushed audio and restarts the averages. */
+    void prepare(double sampleRate);
+
+    /** Starts or stops the analysis. Message thread only. */
+    void setActive(bool shouldBeActive);
+
+    bool isActive() const noexcept { return active.load(std::memory_order_relaxed); }
+
+    /** Adds a stereo block while active; right may be the same as left.
+        Wait-free; safe to call from the audio thread. */
+    void pushSamples(const float* left, const float* right, int numSamples) noexcept;
+
+    //==============================================================================
+    /** Analysis settings, which take effect with the next frame. Safe to call
+        from any thread. overlap is 1, 2, 4 or 8 frames per window; averaging
+        is the weight of the previous average, 0 to 0.99. */
+    void setMode(Mode newMode) noexcept                 { mode.store(newMode); }
+    void setFftOrder(int newOrder) noexcept             { fftOrder.store(juce::jlimit(minimumOrder, maximumOrder, newOrder)); }
+    void setOverlap(int newOverlap) noexcept            { overlap.store(juce::jlimit(1, 8, newOverlap)); }
+    void setAveraging(float newAveraging) noexcept      { averaging.store(juce::jlimit(0.0f, 0.99f, newAveraging)); }
+
+    Mode getMode() const noexcept                       { return static_cast<Mode>(mode.load()); }
+    int getFftOrder() const noexcept                    { return fftOrder.load(); }
+    int getOverlap() const noexcept                     { return overlap.load(); }
+    float getAveraging() const noexcept                 { return averaging.load(); }
+
+    //==============================================================================
+    struct SpectrumInfo
+    {
+        int numBins = 0;
+        int fftSize = 0;
+        double sampleRate = 0.0;
+    };
+
+    /** Copies the latest spectra in dBFS (L and R, or M and S) into arrays of
+        maxNumBins values. Returns false, copying nothing, if no new spectra
+        have been published since lastVersion. */
+    bool copySpectra(float* first, float* second, SpectrumInfo& info, juce::uint32& lastVersion) const;
+
+private:
+    //==============================================================================
+    class Worker;
+    struct Workspace;
+
+    bool processPending(Workspace& workspace) noexcept;
+    void analyseFrame(Workspace& workspace) noexcept;
+    void publish() noexcept;
+
+    std::atomic<bool> active { false };
+    std::atomic<double> currentSampleRate { 44100.0 };
+    std::unique_ptr<juce::SharedResourcePointer<Worker>> worker;
+
+    std::atomic<int> mode { leftRight };
+    std::atomic<int> fftOrder { 12 };
+    std::atomic<int> overlap { 2 };
+    std::atomic<float> averaging { 0.8f };
+
+    // Written by the audio thread, read by the worker
+    juce::AbstractFifo captureFifo { 1 };
+    juce::AudioBuffer<float> captureBuffer;
+    std::atomic<bool> captureOverflowed { false };
+    std::atomic<bool> resetRequested { true };
+
+    // Worker state
+    juce::AudioBuffer<float> frameBuffer;
+    juce::AudioBuffer<float> averagedPower;
+    int analysisOrder { 0 };
+    int frameFill { 0 };
+    bool hasAverage { false };
+
+    // Published spectra
+    mutable juce::SpinLock spectrumLock;
+    juce::AudioBuffer<float> publishedSpectra;
+    SpectrumInfo publishedInfo;
+    std::atomic<juce::uint32> version { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SpectrumAnalyser)
+};
@@ -0,0 +1,306 @@
+#include "SpectrumView.h"
+
+namespace
+{
+    constexpr float minimumFrequency = 20.0f;
+    constexpr float maximumFrequency = 20000.0f;
+    constexpr float minimumLevel = -96.0f;
+
+    // Columns that move less than this keep their cached pixels
+    constexpr float redrawThreshold = 0.5f;
+
+    const juce::Colour traceColours[] = { juce::Colours::cyan, juce::Colours::orange };
+
+    // Averaging weights offered in the menu
+    constexpr float averagingWeights[] = { 0.0f, 0.5f, 0.8f, 0.95f };
+}
+
+//==============================================================================
+SpectrumView::SpectrumView(SpectrumAnalyser& analyserToShow)
+    : analyser(analyserToShow)
+{
+    for (auto& spectrum : spectra)
+        spectrum.allocate(static_cast<size_t>(SpectrumAnalyser::maxNumBins), true);
+
+    modeBox.addItem("L/R", 1);
+    modeBox.addItem("M/S", 2);
+    modeBox.setSelectedId(analyser.getMode() == SpectrumAnalyser::midSide ? 2 : 1, juce::dontSendNotification);
+    modeBox.onChange = [this]() {
+        analyser.setMode(modeBox.getSelectedId() == 2 ? SpectrumAnalyser::midSide : SpectrumAnalyser::leftRight);
+        repaint();
+    };
+    addAndMakeVisible(modeBox);
+
+    for (int order = SpectrumAnalyser::minimumOrder; order <= SpectrumAnalyser::maximumOrder; ++order)
+        sizeBox.addItem(juce::String(1 << order), order);
+
+    sizeBox.setSelectedId(analyser.getFftOrder(), juce::dontSendNotification);
+    sizeBox.setTooltip("FFT size: larger sizes resolve low frequencies better but respond more slowly");
+    sizeBox.onChange = [this]() { analyser.setFftOrder(sizeBox.getSelectedId()); };
+    addAndMakeVisible(sizeBox);
+
+    overlapBox.addItem("No overlap", 1);
+    overlapBox.addItem("50% overlap", 2);
+    overlapBox.addItem("75% overlap", 4);
+    overlapBox.addItem("87.5% overlap", 8);
+    overlapBox.setSelectedId(analyser.getOverlap(), juce::dontSendNotification);
+    overlapBox.onChange = [this]() { analyser.setOverlap(overlapBox.getSelectedId()); };
+    addAndMakeVisible(overlapBox);
+
+    averagingBox.addItem("No averaging", 1);
+    averagingBox.addItem("Short average", 2);
+    averagingBox.addItem("Medium average", 3);
+    averagingBox.addItem("Long average", 4);
+
+    int closestAveraging = 0;
+    for (int index = 1; index < 4; ++index)
+        if (std::abs(averagingWeights[index] - analyser.getAveraging()) < std::abs(averagingWeights[closestAveraging] - analyser.getAveraging()))
+            closestAveraging = index;
+
+    averagingBox.setSelectedId(closestAveraging + 1, juce::dontSendNotification);
+    averagingBox.onChange = [this]() { analyser.setAveraging(averagingWeights[averagingBox.getSelectedId() - 1]); };
+    addAndMakeVisible(averagingBox);
+}
+
+SpectrumView::~SpectrumView()
+{
+    analyser.setActive(false);
+}
+
+void SpectrumView::visibilityChanged()
+{
+    analyser.setActive(isVisible());
+
+    if (isVisible())
+        invalidateColumns();
+}
+
+//==============================================================================
+void SpectrumView::resized()
+{
+    auto area = getLocalBounds().reduced(6, 4);
+
+    auto controls = area.removeFromTop(22);
+    modeBox.setBounds(controls.removeFromLeft(60));
+    controls.removeFromLeft(4);
+    sizeBox.setBounds(controls.removeFromLeft(70));
+    controls.removeFromLeft(4);
+    overlapBox.setBounds(controls.removeFromLeft(110));
+    controls.removeFromLeft(4);
+    averagingBox.setBounds(controls.removeFromLeft(120));
+
+    area.removeFromTop(6);
+    area.removeFromBottom(14);      // Frequency labels
+    area.removeFromLeft(26);        // Level labels
+    plotArea = area;
+
+    traceImage = juce::Image(juce::Image::ARGB, juce::jmax(1, plotArea.getWidth()), juce::jmax(1, plotArea.getHeight()), true);
+
+    for (auto& columns : columnY)
+        columns.assign(static_cast<size_t>(plotArea.getWidth()), 0.0f);
+
+    dirtyColumns.assign(static_cast<size_t>(plotArea.getWidth()), false);
+    invalidateColumns();
+}
+
+void SpectrumView::invalidateColumns()
+{
+    // Impossible levels, so every column redraws with the next spectra
+    for (auto& columns : columnY)
+        std::fill(columns.begin(), columns.end(), -1.0f);
+
+    traceImage.clear(traceImage.getBounds());
+    spectrumVersion = 0;
+    repaint();
+}
+
+//==============================================================================
+float SpectrumView::getFrequencyForX(float x) const noexcept
+{
+    const float topFrequency = spectrumInfo.sampleRate > 0.0
+                                   ? juce::jmin(maximumFrequency, static_cast<float>(spectrumInfo.sampleRate * 0.5))
+                                   : maximumFrequency;
+
+    return minimumFrequency * std::pow(topFrequency / minimumFrequency, x / static_cast<float>(plotArea.getWidth()));
+}
+
+float SpectrumView::getYForLevel(float db) const noexcept
+{
+    return juce::jmap(juce::jlimit(minimumLevel, 0.0f, db), minimumLevel, 0.0f,
+                      static_cast<float>(plotArea.getHeight()), 0.0f);
+}
+
+float SpectrumView::getColumnLevel(const float* spectrum, int column) const noexcept
+{
+    const float binWidth = static_cast<float>(spectrumInfo.sampleRate / spectrumInfo.fftSize);
+    const float firstBin = getFrequencyForX(static_cast<float>(column)) / binWidth;
+    const float lastBin = getFrequencyForX(static_cast<float>(column + 1)) / binWidth;
+    const int maxBin = spectrumInfo.numBins - 1;
+
+    // Several columns per bin at the low end: interpolate between bins
+    if (lastBin - firstBin < 1.0f)
+    {
+        const float centre = juce::jmin(0.5f * (firstBin + lastBin), static_cast<float>(maxBin));
+        const int index = juce::jmin(static_cast<int>(centre), maxBin - 1);
+        const float fraction = centre - static_cast<float>(index);
+        return spectrum[index] + fraction * (spectrum[index + 1] - spectrum[index]);
+    }
+
+    // Several bins per column at the top: show the loudest
+    const int first = juce::jlimit(0, maxBin, juce::roundToInt(firstBin));
+    const int last = juce::jlimit(first, maxBin, juce::roundToInt(lastBin));
+    float level = spectrum[first];
+
+    for (int bin = first + 1; bin <= last; ++bin)
+        level = juce::jmax(level, spectrum[bin]);
+
+    return level;
+}
+
+//==============================================================================
+void SpectrumView::refresh()
+{
+    const double previousSampleRate = spectrumInfo.sampleRate;
+
+    if (plotArea.isEmpty() || ! analyser.copySpectra(spectra[0], spectra[1], spectrumInfo, spectrumVersion)
+        || spectrumInfo.numBins < 2)
+        return;
+
+    // A new sample rate moves the frequency axis
+    if (spectrumInfo.sampleRate != previousSampleRate)
+    {
+        for (auto& columns : columnY)
+            std::fill(columns.begin(), columns.end(), -1.0f);
+
+        repaint();
+    }
+
+    const int numColumns = plotArea.getWidth();
+    int firstDirty = numColumns, lastDirty = -1;
+
+    for (int column = 0; column < numColumns; ++column)
+    {
+        for (int trace = 0; trace < numTraces; ++trace)
+        {
+            auto& cachedY = columnY[trace][static_cast<size_t>(column)];
+            const float y = getYForLevel(getColumnLevel(spectra[trace].get(), column));
+
+            if (std::abs(y - cachedY) < redrawThreshold)
+                continue;
+
+            cachedY = y;
+
+            // Each column's outline joins it to the previous one, so the next column follows
+            dirtyColumns[static_cast<size_t>(column)] = true;
+
+            if (column + 1 < numColumns)
+                dirtyColumns[static_cast<size_t>(column + 1)] = true;
+
+            firstDirty = juce::jmin(firstDirty, column);
+            lastDirty = juce::jmax(lastDirty, juce::jmin(column + 1, numColumns - 1));
+        }
+    }
+
+    if (lastDirty < firstDirty)
+        return;
+
+    {
+        juce::Graphics g(traceImage);
+
+        for (int column = firstDirty; column <= lastDirty; ++column)
+        {
+            if (! dirtyColumns[static_cast<size_t>(column)])
+                continue;
+
+            redrawColumn(g, column);
+            dirtyColumns[static_cast<size_t>(column)] = false;
+        }
+    }
+
+    repaint(plotArea.getX() + firstDirty, plotArea.getY(), lastDirty - firstDirty + 1, plotArea.getHeight());
+}
+
+void SpectrumView::redrawColumn(juce::Graphics& g, int column)
+{
+    const float height = static_cast<float>(traceImage.getHeight());
+    const float x = static_cast<float>(column);
+
+    traceImage.clear({ column, 0, 1, traceImage.getHeight() });
+
+    for (int trace = 0; trace < numTraces; ++trace)
+    {
+        const auto& columns = columnY[trace];
+        const float y = columns[static_cast<size_t>(column)];
+        const float previousY = column > 0 ? columns[static_cast<size_t>(column - 1)] : y;
+
+        g.setColour(traceColours[trace].withAlpha(0.15f));
+        g.fillRect(x, y, 1.0f, height - y);
+
+        // Outline from the previous column's level to this one
+        const float top = juce::jmin(y, previousY);
+        const float bottom = juce::jmax(y, previousY);
+        g.setColour(traceColours[trace]);
+        g.fillRect(x, top, 1.0f, juce::jmax(1.0f, bottom - top));
+    }
+}
+
+//==============================================================================
+void SpectrumView::paint(juce::Graphics& g)
+{
+    auto bounds = getLocalBounds().toFloat();
+
+    g.setColour(juce::Colours::black.withAlpha(0.85f));
+    g.fillRoundedRectangle(bounds, 5.0f);
+    g.setColour(juce::Colours::white.withAlpha(0.3f));
+    g.drawRoundedRectangle(bounds.reduced(0.5f), 5.0f, 1.0f);
+
+    if (plotArea.isEmpty())
+        return;
+
+    g.setFont(10.0f);
+
+    // Level grid every 12dB
+    for (float db = 0.0f; db >= minimumLevel; db -= 12.0f)
+    {
+        const int y = plotArea.getY() + juce::roundToInt(getYForLevel(db));
+        g.setColour(juce::Colours::white.withAlpha(0.1f));
+        g.drawHorizontalLine(y, static_cast<float>(plotArea.getX()), static_cast<float>(plotArea.getRight()));
+        g.setColour(juce::Colours::grey);
+        g.drawText(juce::String(juce::roundToInt(db)), plotArea.getX() - 26, y - 6, 22, 12, juce::Justification::centredRight, false);
+    }
+
+    // Frequency grid at 1-2-5 steps
+    const float topFrequency = getFrequencyForX(static_cast<float>(plotArea.getWidth()));
+
+    for (float decade = 10.0f; decade <= 10000.0f; decade *= 10.0f)
+    {
+        for (float step : { 1.0f, 2.0f, 5.0f })
+        {
+            const float frequency = decade * step;
+
+            if (frequency < minimumFrequency || frequency > topFrequency)
+                continue;
+
+            const float proportion = std::log(frequency / minimumFrequency) / std::log(topFrequency / minimumFrequency);
+            const int x = plotArea.getX() + juce::roundToInt(proportion * static_cast<float>(plotArea.getWidth()));
+
+            g.setColour(juce::Colours::white.withAlpha(0.1f));
+            g.drawVerticalLine(x, static_cast<float>(plotArea.getY()), static_cast<float>(plotArea.getBottom()));
+            g.setColour(juce::Colours::grey);
+            g.drawText(frequency >= 1000.0f ? juce::String(juce::roundToInt(frequency / 1000.0f)) + "k"
+                                            : juce::String(juce::roundToInt(frequency)),
+                       x - 15, plotArea.getBottom() + 2, 30, 12, juce::Justification::centred, false);
+        }
+    }
+
+    g.drawImageAt(traceImage, plotArea.getX(), plotArea.getY());
+
+    // Legend
+    const bool midSide = analyser.getMode() == SpectrumAnalyser::midSide;
+    auto legend = plotArea.withHeight(14).removeFromRight(50);
+    g.setFont(12.0f);
+    g.setColour(traceColours[0]);
+    g.drawText(midSide ? "M" : "L", legend.removeFromLeft(25), juce::Justification::centred, false);
+    g.setColour(traceColours[1]);
+    g.drawText(midSide ? "S" : "R", legend, juce::Justification::centred, false);
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "SpectrumAnalyser.h"
+
+//==============================================================================
+/**
+ * L/R or M/S spectra drawn over each other on a log frequency axis, with the
+ * analyser's mode, FFT size, overlap and averaging selectable.
+ *
+ * Traces are drawn one pixel column at a time into a cached image. When new
+ * spectra arrive, each column's level is recomputed but only the columns
+ * that moved by at least half a pixel are redrawn and repainted, so a
+ * steady signal costs next to nothing to display.
+ *
+ * The analyser runs while the view is visible.
+ */
+class SpectrumView : public juce::Component
+{
+public:
+    //==============================================================================
+    explicit SpectrumView(SpectrumAnalyser& analyser);
+    ~SpectrumView() override;
+
+    void paint(juce::Graphics& g) override;
+    void resized() override;
+    void visibilityChanged() override;
+
+    /** Fetches new spectra and redraws what changed. Call at UI rate. */
+    void refresh();
+
+private:
+    //==============================================================================
+    static constexpr int numTraces = 2;
+
+    float getFrequencyForX(float x) const noexcept;
+    float getYForLevel(float db) const noexcept;
+    float getColumnLevel(const float* spectrum, int column) const noexcept;
+    void redrawColumn(juce::Graphics& g, int column);
+    void invalidateColumns();
+
+    SpectrumAnalyser& analyser;
+
+    juce::ComboBox modeBox;
+    juce::ComboBox sizeBox;
+    juce::ComboBox overlapBox;
+    juce::ComboBox averagingBox;
+
+    juce::HeapBlock<float> spectra[numTraces];
+    SpectrumAnalyser::SpectrumInfo spectrumInfo;
+    juce::uint32 spectrumVersion { 0 };
+
+    // Plot area and its cached traces, one level per pixel column
+    juce::Rectangle<int> plotArea;
+    juce::Image traceImage;
+    std::vector<float> columnY[numTraces];
+    std::vector<bool> dirtyColumns;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SpectrumView)
+};
@@ -0,0 +1,84 @@
+#include "StageProfiler.h"
+
+namespace
+{
+    std::atomic<int> nextInstanceNumber { 1 };
+}
+
+//==============================================================================
+StageProfiler::StageProfiler()
+    : instanceNumber(nextInstanceNumber.fetch_add(1))
+{
+    for (auto& ring : history)
+        for (auto& entry : ring)
+            entry.store(0, std::memory_order_relaxed);
+}
+
+const char* StageProfiler::getStageName(Stage stage) noexcept
+{
+    switch (stage)
+    {
+        case lowCut:        return "Low cut";
+        case midSide:       return "M/S";
+        case delay:         return "Delay";
+        case polarityGain:  return "Polarity/gain";
+        case autoGain:      return "Auto gain";
+        case outputSafety:  return "Output safety";
+        case metering:      return "Metering";
+        case total:         return "Total";
+        case numStages:     break;
+    }
+
+    return "";
+}
+
+//==============================================================================
+void StageProfiler::publishBlock() noexcept
+{
+    if (resetRequested.exchange(false))
+    {
+        numRecorded.store(0, std::memory_order_relaxed);
+        writeIndex.store(0, std::memory_order_relaxed);
+    }
+
+    const int index = writeIndex.load(std::memory_order_relaxed);
+
+    for (size_t stage = 0; stage < numStages; ++stage)
+    {
+        const auto ticks = juce::jmin(pendingTicks[stage], static_cast<juce::uint64>(std::numeric_limits<juce::uint32>::max()));
+        history[stage][static_cast<size_t>(index)].store(static_cast<juce::uint32>(ticks), std::memory_order_relaxed);
+    }
+
+    writeIndex.store((index + 1) % historySize, std::memory_order_relaxed);
+
+    if (numRecorded.load(std::memory_order_relaxed) < historySize)
+        numRecorded.fetch_add(1, std::memory_order_release);
+}
+
+StageProfiler::Statistics StageProfiler::getStatistics(Stage stage) const
+{
+    Statistics statistics;
+    statistics.numBlocks = numRecorded.load(std::memory_order_acquire);
+
+    if (statistics.numBlocks == 0 || stage >= numStages)
+        return statistics;
+
+    // A block may be written while we copy; one stale entry doesn't matter here
+    juce::Array<juce::uint32> ticks;
+    ticks.ensureStorageAllocated(statistics.numBlocks);
+
+    const auto& ring = history[static_cast<size_t>(stage)];
+    for (int i = 0; i < statistics.numBlocks; ++i)
+        ticks.add(ring[static_cast<size_t>(i)].load(std::memory_order_relaxed));
+
+    ticks.sort();
+
+    double sum = 0.0;
+    for (const auto value : ticks)
+        sum += value;
+
+    statistics.minTicks = ticks.getFirst();
+    statistics.meanTicks = sum / statistics.numBlocks;
+    statistics.p99Ticks = ticks[juce::jmin(statistics.numBlocks - 1, (statistics.numBlocks * 99) / 100)];
+    return statistics;
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "CycleCounter.h"
+
+//==============================================================================
+/**
+ * Always-on timing of the stages of processBlock.
+ *
+ * Each stage accumulates its ticks over a block (a stage may run once per
+ * channel); at the end of the block the totals go into per-stage rings of
+ * the most recent blocks. Ticks are TSC cycles where available and
+ * nanoseconds otherwise. The audio thread only reads the counter and does
+ * relaxed atomic stores, and statistics are computed on demand from another
+ * thread.
+ */
+class StageProfiler
+{
+public:
+    //==============================================================================
+    enum Stage
+    {
+        lowCut,
+        midSide,
+        delay,
+        polarityGain,
+        autoGain,
+        outputSafety,
+        metering,
+        total,
+        numStages
+    };
+
+    static constexpr int historySize = 1024;
+
+    StageProfiler();
+
+    /** Returns a short display name for a stage. */
+    static const char* getStageName(Stage stage) noexcept;
+
+    /** Returns "cycles" or "ns", the unit of all tick values. */
+    static const char* getTickUnit() noexcept { return CycleCounter::isAvailable ? "cycles" : "ns"; }
+
+    /** A number identifying this instance, so several can be told apart. */
+    int getInstanceNumber() const noexcept { return instanceNumber; }
+
+    //==============================================================================
+    /** Times a whole block and publishes the stage totals when it ends. */
+    class ScopedBlock
+    {
+    public:
+        explicit ScopedBlock(StageProfiler& profilerToUse) noexcept
+            : profiler(profilerToUse), start(readTicks())
+        {
+            profiler.pendingTicks.fill(0);
+        }
+
+        ~ScopedBlock() noexcept
+        {
+            profiler.pendingTicks[total] = readTicks() - start;
+            profiler.publishBlock();
+        }
+
+    private:
+        StageProfiler& profiler;
+        juce::uint64 start;
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedBlock)
+    };
+
+    /** Adds the time until it goes out of scope to a stage. */
+    class ScopedStage
+    {
+    public:
+        ScopedStage(StageProfiler& profilerToUse, Stage stageToTime) noexcept
+            : profiler(profilerToUse), stage(stageToTime), start(readTicks())
+        {
+        }
+
+        ~ScopedStage() noexcept
+        {
+            profiler.pendingTicks[static_cast<size_t>(stage)] += readTicks() - start;
+        }
+
+    private:
+        StageProfiler& profiler;
+        Stage stage;
+        juce::uint64 start;
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedStage)
+    };
+
+    //==============================================================================
+    struct Statistics
+    {
+        int numBlocks = 0;
+        double minTicks = 0.0;
+        double meanTicks = 0.0;
+        double p99Ticks = 0.0;
+    };
+
+    /** Summarises a stage over the recorded blocks. Not real-time safe. */
+    Statistics getStatistics(Stage stage) const;
+
+    /** Forgets all recorded blocks. Safe to call from any thread. */
+    void reset() noexcept { resetRequested.store(true); }
+
+private:
+    //==============================================================================
+    static juce::uint64 readTicks() noexcept
+    {
+        return CycleCounter::isAvailable ? CycleCounter::readCycles()
+                                         : static_cast<juce::uint64>(CycleCounter::readNanoseconds());
+    }
+
+    void publishBlock() noexcept;
+
+    const int instanceNumber;
+
+    // Audio thread only
+    std::array<juce::uint64, numStages> pendingTicks {};
+
+    // Written by the audio thread, read by anyone
+    std::array<std::array<std::atomic<juce::uint32>, historySize>, numStages> history;
+    std::atomic<int> numRecorded { 0 };
+    std::atomic<int> writeIndex { 0 };
+    std::atomic<bool> resetRequested { false };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(StageProfiler)
+};
@@ -0,0 +1,167 @@
+#include "StateSerializer.h"
+
+namespace
+{
+    constexpr int magicNumber = 0x53335650;   // "PV3S"
+    constexpr int formatVersion = 1;
+
+    // The fixed parameter order. Only ever append to this list.
+    constexpr const char* parameterOrder[] = {
+        "master_gain",
+        "left_gain",
+        "right_gain",
+        "invert_left",
+        "invert_right",
+        "phase_offset",
+        "left_delay",
+        "right_delay",
+        "delay_range",
+        "mid_gain",
+        "side_gain",
+        "use_mid_side",
+        "auto_gain",
+        "safety_mode",
+        "safety_oversampling",
+        "safety_ceiling",
+        "hpf_mode",
+        "hpf_frequency",
+        "width_mode",
+        "width_amount",
+        "width_time",
+        "width_mono_safe"
+    };
+
+    constexpr int numFixedParameters = static_cast<int>(std::size(parameterOrder));
+
+    // Optional chunk holding the alignment analysis settings
+    constexpr int analysisChunkTag = 0x4e474c41;   // "ALGN"
+
+    constexpr const char* analysisParameters[] = {
+        "align_tracking",
+        "align_source"
+    };
+
+    constexpr int numAnalysisParameters = static_cast<int>(std::size(analysisParameters));
+
+    constexpr int headerSize = 8;
+
+    //==============================================================================
+    void setPlainValue(juce::AudioProcessorValueTreeState& apvts, const char* parameterID, float value)
+    {
+        if (auto* parameter = apvts.getParameter(parameterID))
+            parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+    }
+
+    void setDefaultValue(juce::AudioProcessorValueTreeState& apvts, const char* parameterID)
+    {
+        if (auto* parameter = apvts.getParameter(parameterID))
+            parameter->setValueNotifyingHost(parameter->getDefaultValue());
+    }
+}
+
+//==============================================================================
+void StateSerializer::write(juce::AudioProcessorValueTreeState& apvts, juce::MemoryBlock& destData)
+{
+    // Every parameter needs a place in the format
+    jassert(apvts.processor.getParameters().size() == numFixedParameters + numAnalysisParameters);
+
+    destData.reset();
+    juce::MemoryOutputStream stream(destData, false);
+
+    stream.writeInt(magicNumber);
+    stream.writeShort(static_cast<short>(formatVersion));
+    stream.writeShort(static_cast<short>(numFixedParameters));
+
+    for (const auto* parameterID : parameterOrder)
+    {
+        auto* value = apvts.getRawParameterValue(parameterID);
+        jassert(value != nullptr);
+        stream.writeFloat(value != nullptr ? value->load() : 0.0f);
+    }
+
+    stream.writeInt(analysisChunkTag);
+    stream.writeInt(numAnalysisParameters * static_cast<int>(sizeof(float)));
+
+    for (const auto* parameterID : analysisParameters)
+    {
+        auto* value = apvts.getRawParameterValue(parameterID);
+        jassert(value != nullptr);
+        stream.writeFloat(value != nullptr ? value->load() : 0.0f);
+    }
+}
+
+bool StateSerializer::isBinaryState(const void* data, int sizeInBytes) noexcept
+{
+    return data != nullptr
+        && sizeInBytes >= headerSize
+        && static_cast<int>(juce::ByteOrder::littleEndianInt(data)) == magicNumber;
+}
+
+bool StateSerializer::read(juce::AudioProcessorValueTreeState& apvts, const void* data, int sizeInBytes)
+{
+    if (! isBinaryState(data, sizeInBytes))
+        return false;
+
+    juce::MemoryInputStream stream(data, static_cast<size_t>(sizeInBytes), false);
+    stream.readInt();
+
+    // Future versions stay readable as long as they only add to the layout
+    const int version = stream.readShort();
+    const int numValues = static_cast<juce::uint16>(stream.readShort());
+
+    if (version < 1 || stream.getNumBytesRemaining() < numValues * static_cast<juce::int64>(sizeof(float)))
+        return false;
+
+    // Parse everything before touching a parameter, so a damaged state changes nothing
+    float fixedValues[numFixedParameters] {};
+    float analysisValues[numAnalysisParameters] {};
+    int numAnalysisValues = 0;
+
+    for (int i = 0; i < numValues; ++i)
+    {
+        const float value = stream.readFloat();
+
+        if (i < numFixedParameters)
+            fixedValues[i] = value;
+    }
+
+    while (stream.getNumBytesRemaining() >= 8)
+    {
+        const int tag = stream.readInt();
+        const int chunkSize = stream.readInt();
+
+        if (chunkSize < 0 || chunkSize > stream.getNumBytesRemaining())
+            return false;
+
+        const auto chunkEnd = stream.getPosition() + chunkSize;
+
+        if (tag == analysisChunkTag)
+        {
+            numAnalysisValues = juce::jmin(numAnalysisParameters, chunkSize / static_cast<int>(sizeof(float)));
+
+            for (int i = 0; i < numAnalysisValues; ++i)
+                analysisValues[i] = stream.readFloat();
+        }
+
+        stream.setPosition(chunkEnd);
+    }
+
+    //==============================================================================
+    for (int i = 0; i < numFixedParameters; ++i)
+    {
+        if (i < numValues && std::isfinite(fixedValues[i]))
+            setPlainValue(apvts, parameterOrder[i], fixedValues[i]);
+        else
+            setDefaultValue(apvts, parameterOrder[i]);
+    }
+
+    for (int i = 0; i < numAnalysisParameters; ++i)
+    {
+        if (i < numAnalysisValues && std::isfinite(analysisValues[i]))
+            setPlainValue(apvts, analysisParameters[i], analysisValues[i]);
+        else
+            setDefaultValue(apvts, analysisParameters[i]);
+    }
+
+    return true;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+ * Compact binary form of the plugin state, read and written without going
+ * through XML.
+ *
+ * Layout (little-endian):
+ *   int32   magic "PV3S"
+ *   int16   format version
+ *   int16   number of parameter values that follow
+ *   float   parameter values, plain (not normalised), in a fixed order
+ *   chunks  optional settings, each an int32 tag, an int32 size and the data
+ *
+ * Parameters are only ever appended to the fixed order and unknown chunks
+ * are skipped, so older builds can read newer states and vice versa.
+ * Anything missing keeps its default value.
+ */
+namespace StateSerializer
+{
+    /** Writes all parameters of the state in the binary format. */
+    void write(juce::AudioProcessorValueTreeState& apvts, juce::MemoryBlock& destData);
+
+    /** Returns true if the data starts like a binary state. */
+    bool isBinaryState(const void* data, int sizeInBytes) noexcept;
+
+    /** Loads a binary state into the parameters. Returns false, and leaves
+        the parameters untouched, if the data isn't a valid binary state. */
+    bool read(juce::AudioProcessorValueTreeState& apvts, const void* data, int sizeInBytes);
+}
@@ -0,0 +1,209 @@
+#include "SubsonicFilter.h"
+
+#if defined (__SSE2__) || defined (_M_X64) || (defined (_M_IX86_FP) && _M_IX86_FP >= 2)
+ #define PLUGINV3_SUBSONIC_SSE2 1
+ #include <emmintrin.h>
+#elif defined (__aarch64__) || defined (_M_ARM64)
+ #define PLUGINV3_SUBSONIC_NEON 1
+ #include <arm_neon.h>
+#endif
+
+namespace
+{
+    // Exactly two double lanes, one per channel, whatever instruction set the
+    // build targets: juce::dsp::SIMDRegister<double> widens to four under AVX
+   #if PLUGINV3_SUBSONIC_SSE2
+    struct LanePair
+    {
+        __m128d value;
+
+        static LanePair expand(double newValue) noexcept              { return { _mm_set1_pd(newValue) }; }
+        static LanePair fromRawArray(const double* values) noexcept   { return { _mm_load_pd(values) }; }
+        void copyToRawArray(double* values) const noexcept            { _mm_store_pd(values, value); }
+
+        LanePair operator+(LanePair other) const noexcept { return { _mm_add_pd(value, other.value) }; }
+        LanePair operator-(LanePair other) const noexcept { return { _mm_sub_pd(value, other.value) }; }
+        LanePair operator*(LanePair other) const noexcept { return { _mm_mul_pd(value, other.value) }; }
+    };
+   #elif PLUGINV3_SUBSONIC_NEON
+    struct LanePair
+    {
+        float64x2_t value;
+
+        static LanePair expand(double newValue) noexcept              { return { vdupq_n_f64(newValue) }; }
+        static LanePair fromRawArray(const double* values) noexcept   { return { vld1q_f64(values) }; }
+        void copyToRawArray(double* values) const noexcept            { vst1q_f64(values, value); }
+
+        LanePair operator+(LanePair other) const noexcept { return { vaddq_f64(value, other.value) }; }
+        LanePair operator-(LanePair other) const noexcept { return { vsubq_f64(value, other.value) }; }
+        LanePair operator*(LanePair other) const noexcept { return { vmulq_f64(value, other.value) }; }
+    };
+   #else
+    struct LanePair
+    {
+        double lanes[2];
+
+        static LanePair expand(double value) noexcept                 { return { { value, value } }; }
+        static LanePair fromRawArray(const double* values) noexcept   { return { { values[0], values[1] } }; }
+        void copyToRawArray(double* values) const noexcept            { values[0] = lanes[0]; values[1] = lanes[1]; }
+
+        LanePair operator+(LanePair other) const noexcept { return { { lanes[0] + other.lanes[0], lanes[1] + other.lanes[1] } }; }
+        LanePair operator-(LanePair other) const noexcept { return { { lanes[0] - other.lanes[0], lanes[1] - other.lanes[1] } }; }
+        LanePair operator*(LanePair other) const noexcept { return { { lanes[0] * other.lanes[0], lanes[1] * other.lanes[1] } }; }
+    };
+   #endif
+
+    /** One biquad section with its coefficients broadcast to both lanes. */
+    struct Section
+    {
+        LanePair b0, b1, b2, a1, a2;
+        LanePair z1, z2;
+
+        // Transposed direct form II
+        inline LanePair process(LanePair x) noexcept
+        {
+            const LanePair y = b0 * x + z1;
+            z1 = b1 * x - a1 * y + z2;
+            z2 = b2 * x - a2 * y;
+            return y;
+        }
+    };
+}
+
+//==============================================================================
+void SubsonicFilter::prepare(double newSampleRate)
+{
+    sampleRate = newSampleRate;
+    updateCoefficients();
+    reset();
+}
+
+void SubsonicFilter::reset() noexcept
+{
+    for (int section = 0; section < maxSections; ++section)
+        for (int lane = 0; lane < 2; ++lane)
+            z1[section][lane] = z2[section][lane] = 0.0;
+}
+
+void SubsonicFilter::setMode(Mode newMode, float frequencyHz) noexcept
+{
+    // Moving the cutoff keeps the state; a different cascade would ring from it
+    if (newMode != mode)
+        reset();
+
+    mode = newMode;
+    frequency = frequencyHz;
+    updateCoefficients();
+}
+
+void SubsonicFilter::updateCoefficients() noexcept
+{
+    const double cutoff = mode == dcBlock ? dcBlockFrequency : static_cast<double>(frequency);
+    const double k = std::tan(juce::MathConstants<double>::pi * juce::jmin(cutoff, sampleRate * 0.45) / sampleRate);
+
+    // Bilinear-transformed first-order high-pass, as a degenerate biquad
+    auto firstOrder = [k]()
+    {
+        Coefficients c;
+        const double norm = 1.0 / (1.0 + k);
+        c.b0 = norm;
+        c.b1 = -norm;
+        c.a1 = (k - 1.0) * norm;
+        return c;
+    };
+
+    // Second-order high-pass with the given pole Q
+    auto secondOrder = [k](double q)
+    {
+        Coefficients c;
+        const double norm = 1.0 / (1.0 + k / q + k * k);
+        c.b0 = norm;
+        c.b1 = -2.0 * norm;
+        c.b2 = norm;
+        c.a1 = 2.0 * (k * k - 1.0) * norm;
+        c.a2 = (1.0 - k / q + k * k) * norm;
+        return c;
+    };
+
+    // Butterworth pole Qs for each order
+    switch (mode)
+    {
+        case dcBlock:
+        case slope6:
+            coefficients[0] = firstOrder();
+            numSections = 1;
+            break;
+
+        case slope12:
+            coefficients[0] = secondOrder(0.70710678118654752);
+            numSections = 1;
+            break;
+
+        case slope18:
+            coefficients[0] = firstOrder();
+            coefficients[1] = secondOrder(1.0);
+            numSections = 2;
+            break;
+
+        case slope24:
+            coefficients[0] = secondOrder(0.54119610014619698);
+            coefficients[1] = secondOrder(1.30656296487637653);
+            numSections = 2;
+            break;
+
+        case off:
+        default:
+            numSections = 0;
+            break;
+    }
+}
+
+//==============================================================================
+void SubsonicFilter::process(float* left, float* right, int numSamples) noexcept
+{
+    if (numSections == 0)
+        return;
+
+    // A mono input runs through both lanes and only the left is written back
+    const float* rightInput = right != nullptr ? right : left;
+
+    Section sections[maxSections];
+
+    for (int index = 0; index < numSections; ++index)
+    {
+        const auto& c = coefficients[static_cast<size_t>(index)];
+        auto& section = sections[index];
+        section.b0 = LanePair::expand(c.b0);
+        section.b1 = LanePair::expand(c.b1);
+        section.b2 = LanePair::expand(c.b2);
+        section.a1 = LanePair::expand(c.a1);
+        section.a2 = LanePair::expand(c.a2);
+        section.z1 = LanePair::fromRawArray(z1[index]);
+        section.z2 = LanePair::fromRawArray(z2[index]);
+    }
+
+    alignas(16) double frame[2];
+
+    for (int sample = 0; sample < numSamples; ++sample)
+    {
+        frame[0] = left[sample];
+        frame[1] = rightInput[sample];
+
+        LanePair x = LanePair::fromRawArray(frame);
+
+        for (int index = 0; index < numSections; ++index)
+            x = sections[index].process(x);
+
+        x.copyToRawArray(frame);
+        left[sample] = static_cast<float>(frame[0]);
+
+        if (right != nullptr)
+            right[sample] = static_cast<float>(frame[1]);
+    }
+
+    for (int index = 0; index < numSections; ++index)
+    {
+        sections[index].z1.copyToRawArray(z1[index]);
+        sections[index].z2.copyToRawArray(z2[index]);
+    }
+}
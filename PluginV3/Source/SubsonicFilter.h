@@ -0,0 +1,70 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+ * DC blocker / subsonic high-pass for a stereo pair.
+ *
+ * A cascade of up to two transposed direct form II biquads in double
+ * precision, Butterworth from 6 to 24 dB/oct (the odd orders use a
+ * first-order section). Left and right share the coefficients and run
+ * together as the two lanes of one SSE2 or NEON register (two doubles on
+ * any build target), so a stereo section costs the same as a mono one.
+ * When off, process() is never called and the stage costs nothing.
+ */
+class SubsonicFilter
+{
+public:
+    //==============================================================================
+    enum Mode
+    {
+        off,
+        dcBlock,
+        slope6,
+        slope12,
+        slope18,
+        slope24
+    };
+
+    static constexpr int maxSections = 2;
+
+    /** Cutoff of the DC blocker, which ignores the frequency setting. */
+    static constexpr double dcBlockFrequency = 5.0;
+
+    void prepare(double sampleRate);
+
+    /** Clears the filter state. */
+    void reset() noexcept;
+
+    /** Recalculates the coefficients. Cheap and real-time safe; the state is
+        cleared only when the mode changes. */
+    void setMode(Mode newMode, float frequencyHz) noexcept;
+
+    Mode getMode() const noexcept { return mode; }
+    float getFrequency() const noexcept { return frequency; }
+    bool isActive() const noexcept { return mode != off; }
+
+    /** Filters a channel pair in place. right may be nullptr for mono. */
+    void process(float* left, float* right, int numSamples) noexcept;
+
+private:
+    //==============================================================================
+    struct Coefficients
+    {
+        double b0 = 1.0, b1 = 0.0, b2 = 0.0, a1 = 0.0, a2 = 0.0;
+    };
+
+    void updateCoefficients() noexcept;
+
+    double sampleRate { 44100.0 };
+    Mode mode { off };
+    float frequency { 20.0f };
+
+    int numSections { 0 };
+    std::array<Coefficients, maxSections> coefficients;
+
+    // Per-section state, left and right interleaved as the two lanes
+    alignas(16) double z1[maxSections][2] {};
+    alignas(16) double z2[maxSections][2] {};
+};
@@ -0,0 +1,152 @@
+#include "TruePeakDetector.h"
+
+namespace
+{
+    // Zeroth-order modified Bessel function of the first kind, for the Kaiser window
+    double besselI0(double x) noexcept
+    {
+        double sum = 1.0;
+        double term = 1.0;
+
+        for (int k = 1; k < 32; ++k)
+        {
+            const double factor = x / (2.0 * static_cast<double>(k));
+            term *= factor * factor;
+            sum += term;
+
+            if (term < sum * 1.0e-12)
+                break;
+        }
+
+        return sum;
+    }
+
+    std::shared_ptr<std::vector<float>> designInterpolator(int oversamplingFactor)
+    {
+        constexpr int tapsPerPhase = TruePeakDetector::tapsPerPhase;
+        const int numTaps = oversamplingFactor * tapsPerPhase;
+        auto table = std::make_shared<std::vector<float>>(static_cast<size_t>(numTaps), 0.0f);
+        float* coefficients = table->data();
+
+        // Kaiser-windowed sinc with its cutoff at the original Nyquist frequency
+        const double centre = 0.5 * static_cast<double>(numTaps - 1);
+        const double beta = 7.0;
+        const double besselBeta = besselI0(beta);
+
+        for (int tap = 0; tap < numTaps; ++tap)
+        {
+            const double x = (static_cast<double>(tap) - centre) / static_cast<double>(oversamplingFactor);
+            const double sinc = std::abs(x) < 1.0e-9 ? 1.0
+                                                      : std::sin(juce::MathConstants<double>::pi * x)
+                                                            / (juce::MathConstants<double>::pi * x);
+
+            const double ratio = (static_cast<double>(tap) - centre) / (centre + 1.0);
+            const double window = besselI0(beta * std::sqrt(1.0 - ratio * ratio)) / besselBeta;
+
+            // Stored phase-major, taps within a phase newest first
+            const int phase = tap % oversamplingFactor;
+            const int index = tap / oversamplingFactor;
+            coefficients[phase * tapsPerPhase + index] = static_cast<float>(sinc * window);
+        }
+
+        // Normalise each phase to unity DC gain
+        for (int phase = 0; phase < oversamplingFactor; ++phase)
+        {
+            float* phaseCoefficients = coefficients + phase * tapsPerPhase;
+            float sum = 0.0f;
+
+            for (int k = 0; k < tapsPerPhase; ++k)
+                sum += phaseCoefficients[k];
+
+            if (sum != 0.0f)
+                juce::FloatVectorOperations::multiply(phaseCoefficients, 1.0f / sum, tapsPerPhase);
+        }
+
+        return table;
+    }
+}
+
+//==============================================================================
+int TruePeakDetector::getOversamplingFactorForRate(double sampleRate) noexcept
+{
+    return sampleRate < 88200.0 ? 4 : (sampleRate < 176400.0 ? 2 : 1);
+}
+
+std::shared_ptr<const std::vector<float>> TruePeakDetector::getInterpolator(int oversamplingFactor)
+{
+    return SharedTables::get<std::vector<float>>("true peak " + juce::String(oversamplingFactor), [oversamplingFactor]()
+    {
+        return designInterpolator(oversamplingFactor);
+    });
+}
+
+void TruePeakDetector::prepare(double sampleRate)
+{
+    oversamplingFactor = getOversamplingFactorForRate(sampleRate);
+    coefficients = getInterpolator(oversamplingFactor);
+    reset();
+}
+
+void TruePeakDetector::reset() noexcept
+{
+    for (auto& channelHistory : history)
+        channelHistory.fill(0.0f);
+
+    historyPosition = 0;
+    truePeak = 0.0f;
+}
+
+//==============================================================================
+void TruePeakDetector::process(const float* const* channels, int numChannels, int numSamples) noexcept
+{
+    numChannels = juce::jmin(numChannels, maxChannels);
+
+    if (oversamplingFactor == 1)
+    {
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            const auto range = juce::FloatVectorOperations::findMinAndMax(channels[channel], numSamples);
+            truePeak = juce::jmax(truePeak, std::abs(range.getStart()), std::abs(range.getEnd()));
+        }
+
+        return;
+    }
+
+    const float* allCoefficients = coefficients->data();
+    float peak = truePeak;
+    int position = historyPosition;
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        auto& channelHistory = history[static_cast<size_t>(channel)];
+        const float* data = channels[channel];
+        position = historyPosition;
+
+        for (int sample = 0; sample < numSamples; ++sample)
+        {
+            // Walk backwards so history[position + k] is the sample k steps ago
+            position = (position == 0 ? tapsPerPhase : position) - 1;
+            channelHistory[static_cast<size_t>(position)] = data[sample];
+            channelHistory[static_cast<size_t>(position + tapsPerPhase)] = data[sample];
+
+            const float* window = channelHistory.data() + position;
+
+            for (int phase = 0; phase < oversamplingFactor; ++phase)
+            {
+                const float* phaseCoefficients = allCoefficients + phase * tapsPerPhase;
+                float sum = 0.0f;
+
+                for (int k = 0; k < tapsPerPhase; ++k)
+                    sum += phaseCoefficients[k] * window[k];
+
+                peak = juce::jmax(peak, std::abs(sum));
+            }
+
+            // The true peak is never below the sample peak
+            peak = juce::jmax(peak, std::abs(data[sample]));
+        }
+    }
+
+    historyPosition = position;
+    truePeak = peak;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "SharedTables.h"
+
+//==============================================================================
+/**
+ * Inter-sample peak detector following ITU-R BS.1770 Annex 2.
+ *
+ * The signal is oversampled with a polyphase windowed-sinc interpolator
+ * (4x below 88.2kHz, 2x below 176.4kHz, none above) and the largest absolute
+ * value of any phase is held until resetPeak(). The interpolator for each
+ * oversampling factor is designed once and shared through SharedTables.
+ */
+class TruePeakDetector
+{
+public:
+    //==============================================================================
+    static constexpr int maxChannels = 2;
+    static constexpr int tapsPerPhase = 12;
+
+    TruePeakDetector() = default;
+
+    /** Picks up the interpolator for the given rate. Not real-time safe. */
+    void prepare(double sampleRate);
+
+    /** Clears the filter history and the held peak. */
+    void reset() noexcept;
+
+    /** Measures a block of audio. */
+    void process(const float* const* channels, int numChannels, int numSamples) noexcept;
+
+    /** Returns the held true peak as a linear gain. */
+    float getTruePeak() const noexcept { return truePeak; }
+
+    /** Clears the held peak but keeps the filter history. */
+    void resetPeak() noexcept { truePeak = 0.0f; }
+
+    int getOversamplingFactor() const noexcept { return oversamplingFactor; }
+
+    //==============================================================================
+    /** The oversampling factor used at a sample rate. */
+    static int getOversamplingFactorForRate(double sampleRate) noexcept;
+
+    /** The shared interpolator for an oversampling factor above 1, phase-major:
+        phase p uses [p * tapsPerPhase + k] on the sample k steps ago. */
+    static std::shared_ptr<const std::vector<float>> getInterpolator(int oversamplingFactor);
+
+private:
+    //==============================================================================
+    int oversamplingFactor { 1 };
+
+    // Phase-major coefficients: phase p uses coefficients[p * tapsPerPhase + k]
+    std::shared_ptr<const std::vector<float>> coefficients;
+
+    // History is written twice so each phase reads a contiguous window
+    std::array<std::array<float, 2 * tapsPerPhase>, maxChannels> history {};
+    int historyPosition { 0 };
+
+    float truePeak { 0.0f };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TruePeakDetector)
+};
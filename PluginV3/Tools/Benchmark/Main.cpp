@@ -0,0 +1,785 @@
+/*
+  ==============================================================================
+
+    PluginV3Benchmark - times processBlock and its individual DSP stages.
+
+    Every measurement copies a block of fixed-seed noise into a work buffer
+    and processes it. The cost of the copy alone is measured for each block
+    size and subtracted, trials are repeated and the median is reported, so
+    results are comparable between runs and machines. Times are per sample
+    frame (both channels of a stereo block).
+
+    The batch rows compare the offline renderer's two ways of rendering
+    several files with the same settings: a processor and meters per file,
+    or one BatchProcessor lane per file. Their times are per sample frame of
+    each file.
+
+    With --isa the whole run is repeated for each kernel instruction set, so
+    the dispatched variants can be compared in one report.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include <iostream>
+#include "../../Source/PluginProcessor.h"
+#include "../../Source/DspKernels.h"
+#include "../../Source/DelayLine.h"
+#include "../../Source/MeterFrame.h"
+#include "../../Source/CycleCounter.h"
+#include "../../Source/BatchProcessor.h"
+
+namespace
+{
+    //==============================================================================
+    struct BenchmarkSettings
+    {
+        juce::Array<int> blockSizes { 16, 32, 64, 128, 256, 512, 1024, 2048, 4096 };
+        juce::Array<double> sampleRates { 44100.0, 48000.0, 88200.0, 96000.0, 176400.0, 192000.0 };
+        int numTrials { 7 };
+        int samplesPerTrial { 1 << 18 };
+        bool runStages { true };
+        bool runProcessBlock { true };
+        bool csv { false };
+        juce::File outputFile;
+
+        // Empty runs the kernels selected for this machine
+        juce::Array<DspKernels::InstructionSet> instructionSets;
+    };
+
+    struct Measurement
+    {
+        double nsPerSample { 0.0 };
+        double nsPerSampleMin { 0.0 };
+        double cyclesPerSample { 0.0 };
+    };
+
+    struct ResultRow
+    {
+        juce::String benchmark;
+        juce::String name;
+        double sampleRate { 0.0 };
+        int blockSize { 0 };
+        Measurement measurement;
+        juce::String instructionSet;
+    };
+
+    constexpr juce::int64 randomSeed = 0x5eed;
+
+    //==============================================================================
+    /** A stereo block of noise at -12dBFS, a few blocks long so successive
+        iterations don't process identical data. */
+    class SourceSignal
+    {
+    public:
+        explicit SourceSignal(int blockSize)
+            : numBlocks(8),
+              source(2, blockSize * numBlocks),
+              work(2, blockSize)
+        {
+            juce::Random random(randomSeed);
+
+            for (int channel = 0; channel < 2; ++channel)
+                for (int sample = 0; sample < source.getNumSamples(); ++sample)
+                    source.setSample(channel, sample, (random.nextFloat() * 2.0f - 1.0f) * 0.25f);
+        }
+
+        /** Copies the next source block into the work buffer and returns it. */
+        juce::AudioBuffer<float>& nextBlock() noexcept
+        {
+            const int blockSize = work.getNumSamples();
+            const int offset = blockIndex * blockSize;
+            blockIndex = (blockIndex + 1) % numBlocks;
+
+            for (int channel = 0; channel < 2; ++channel)
+                juce::FloatVectorOperations::copy(work.getWritePointer(channel), source.getReadPointer(channel, offset), blockSize);
+
+            return work;
+        }
+
+    private:
+        int numBlocks;
+        int blockIndex { 0 };
+        juce::AudioBuffer<float> source;
+        juce::AudioBuffer<float> work;
+    };
+
+    //==============================================================================
+    /** Runs the given per-block function for a warm-up period and then a
+        number of timed trials, returning the median and fastest trial. */
+    template <typename ProcessFunction>
+    Measurement measure(SourceSignal& signal, int blockSize, const BenchmarkSettings& settings,
+                        ProcessFunction&& process)
+    {
+        juce::ScopedNoDenormals noDenormals;
+
+        const int iterations = juce::jmax(1, settings.samplesPerTrial / blockSize);
+
+        // Warm caches and branch predictors, and let any crossfades settle
+        for (int i = 0; i < juce::jmax(iterations / 4, 64); ++i)
+            process(signal.nextBlock());
+
+        juce::Array<double> nanoseconds, cycles;
+
+        for (int trial = 0; trial < settings.numTrials; ++trial)
+        {
+            const auto startCycles = CycleCounter::readCycles();
+            const auto startTime = CycleCounter::readNanoseconds();
+
+            for (int i = 0; i < iterations; ++i)
+                process(signal.nextBlock());
+
+            const auto elapsedTime = CycleCounter::readNanoseconds() - startTime;
+            const auto elapsedCycles = CycleCounter::readCycles() - startCycles;
+
+            const double numSamples = static_cast<double>(iterations) * blockSize;
+            nanoseconds.add(static_cast<double>(elapsedTime) / numSamples);
+            cycles.add(static_cast<double>(elapsedCycles) / numSamples);
+        }
+
+        nanoseconds.sort();
+        cycles.sort();
+
+        Measurement result;
+        result.nsPerSample = nanoseconds[nanoseconds.size() / 2];
+        result.nsPerSampleMin = nanoseconds.getFirst();
+        result.cyclesPerSample = cycles[cycles.size() / 2];
+        return result;
+    }
+
+    /** Removes the cost of copying the source block. */
+    Measurement subtractBaseline(Measurement measurement, const Measurement& baseline)
+    {
+        measurement.nsPerSample = juce::jmax(0.0, measurement.nsPerSample - baseline.nsPerSample);
+        measurement.nsPerSampleMin = juce::jmax(0.0, measurement.nsPerSampleMin - baseline.nsPerSampleMin);
+        measurement.cyclesPerSample = juce::jmax(0.0, measurement.cyclesPerSample - baseline.cyclesPerSample);
+        return measurement;
+    }
+
+    //==============================================================================
+    /** Processor parameter configurations covering every processing path:
+        mid/side, polarity, the delay stage idle, delaying, or applying the
+        phase offset at each delay range, the low cut, and the output safety
+        stage. The "delay=off" rows are the low cut's off case. */
+    struct ProcessorConfiguration
+    {
+        juce::String name;
+        bool midSide { false };
+        bool invert { false };
+        float leftDelayMs { 0.0f };
+        float rightDelayMs { 0.0f };
+        float phaseOffset { 0.0f };
+        int delayRange { 0 };
+        int safetyMode { 0 };
+        int safetyOversampling { 0 };
+        int lowCutMode { 0 };
+    };
+
+    juce::Array<ProcessorConfiguration> createConfigurations()
+    {
+        juce::Array<ProcessorConfiguration> configurations;
+        const juce::StringArray rangeNames { "10ms", "100ms", "500ms", "1s", "2s" };
+
+        for (const bool midSide : { false, true })
+        {
+            for (const bool invert : { false, true })
+            {
+                auto base = juce::String("ms=") + (midSide ? "on" : "off") + ",invert=" + (invert ? "on" : "off");
+
+                configurations.add({ base + ",delay=off", midSide, invert });
+
+                for (int range = 0; range < rangeNames.size(); ++range)
+                {
+                    configurations.add({ base + ",delay=on,range=" + rangeNames[range], midSide, invert, 2.5f, 1.0f, 0.0f, range });
+                    configurations.add({ base + ",phase=on,range=" + rangeNames[range], midSide, invert, 0.0f, 0.0f, 90.0f, range });
+                }
+            }
+        }
+
+        configurations.add({ "lowcut=dc", false, false, 0.0f, 0.0f, 0.0f, 0, 0, 0, 1 });
+        configurations.add({ "lowcut=24dB", false, false, 0.0f, 0.0f, 0.0f, 0, 0, 0, 5 });
+
+        const juce::StringArray safetyModeNames { "off", "clip", "limit" };
+        const juce::StringArray oversamplingNames { "2x", "4x", "8x" };
+
+        for (int mode = 1; mode < safetyModeNames.size(); ++mode)
+            for (int oversampling = 0; oversampling < oversamplingNames.size(); ++oversampling)
+                configurations.add({ "safety=" + safetyModeNames[mode] + ",os=" + oversamplingNames[oversampling],
+                                     false, false, 0.0f, 0.0f, 0.0f, 0, mode, oversampling });
+
+        return configurations;
+    }
+
+    void setParameter(PluginV3AudioProcessor& processor, const juce::String& parameterID, float value)
+    {
+        auto* parameter = processor.getAPVTS().getParameter(parameterID);
+        jassert(parameter != nullptr);
+        parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+    }
+
+    //==============================================================================
+    void runStageBenchmarks(double sampleRate, int blockSize, const Measurement& baseline,
+                            const BenchmarkSettings& settings, juce::Array<ResultRow>& results)
+    {
+        SourceSignal signal(blockSize);
+        float peakSink = 0.0f;
+
+        auto addResult = [&](const juce::String& name, const Measurement& measurement)
+        {
+            results.add({ "stage", name, sampleRate, blockSize, subtractBaseline(measurement, baseline) });
+        };
+
+        addResult("gain", measure(signal, blockSize, settings, [](juce::AudioBuffer<float>& block)
+        {
+            DspKernels::applyGain(block.getWritePointer(0), block.getNumSamples(), 0.9f, false);
+            DspKernels::applyGain(block.getWritePointer(1), block.getNumSamples(), 1.1f, false);
+        }));
+
+        addResult("polarity_gain", measure(signal, blockSize, settings, [](juce::AudioBuffer<float>& block)
+        {
+            DspKernels::applyGain(block.getWritePointer(0), block.getNumSamples(), 0.9f, true);
+            DspKernels::applyGain(block.getWritePointer(1), block.getNumSamples(), 1.1f, true);
+        }));
+
+        addResult("mid_side", measure(signal, blockSize, settings, [](juce::AudioBuffer<float>& block)
+        {
+            DspKernels::applyMidSideGain(block.getWritePointer(0), block.getWritePointer(1),
+                                         block.getNumSamples(), 1.2f, 0.8f);
+        }));
+
+        addResult("peak_scan", measure(signal, blockSize, settings, [&peakSink](juce::AudioBuffer<float>& block)
+        {
+            peakSink += DspKernels::findPeak(block.getReadPointer(0), block.getNumSamples());
+            peakSink += DspKernels::findPeak(block.getReadPointer(1), block.getNumSamples());
+        }));
+
+        // What the metering stage runs: peaks, RMS and correlation in one pass
+        addResult("meter_frame", measure(signal, blockSize, settings, [&peakSink](juce::AudioBuffer<float>& block)
+        {
+            const auto frame = MeterFrame::measure(block.getReadPointer(0), block.getReadPointer(1), block.getNumSamples());
+            peakSink += frame.peak[0] + frame.rms[1] + frame.correlation;
+        }));
+
+        // Delay stage sized like the processor's largest range
+        DelayLine delayLine;
+        delayLine.prepare(juce::roundToInt(2010.0 * sampleRate / 1000.0), juce::roundToInt(sampleRate * 0.02),
+                          juce::roundToInt(sampleRate * 0.03) + 1);
+
+        const float noDelay[DelayLine::maxChannels] = { 0.0f, 0.0f };
+        addResult("delay_write", measure(signal, blockSize, settings, [&](juce::AudioBuffer<float>& block)
+        {
+            delayLine.process(block.getArrayOfWritePointers(), 2, block.getNumSamples(), noDelay);
+        }));
+
+        const float delays[DelayLine::maxChannels] = { static_cast<float>(2.5 * sampleRate / 1000.0) + 0.37f,
+                                                       static_cast<float>(1.0 * sampleRate / 1000.0) + 0.61f };
+        addResult("delay_read", measure(signal, blockSize, settings, [&](juce::AudioBuffer<float>& block)
+        {
+            delayLine.process(block.getArrayOfWritePointers(), 2, block.getNumSamples(), delays);
+        }));
+
+        // The same delays with the widener taps read in the fused loop
+        for (const auto mode : { DelayLine::Width::haas, DelayLine::Width::diffuse })
+        {
+            DelayLine::Width width;
+            width.mode = mode;
+            width.amount = 0.5f;
+            width.delaySamples = static_cast<float>(12.0 * sampleRate / 1000.0);
+
+            addResult(mode == DelayLine::Width::haas ? "delay_width_haas" : "delay_width_diffuse",
+                      measure(signal, blockSize, settings, [&](juce::AudioBuffer<float>& block)
+            {
+                delayLine.process(block.getArrayOfWritePointers(), 2, block.getNumSamples(), delays, width);
+            }));
+        }
+
+        // Keep the peak scans from being optimised away
+        if (peakSink < 0.0f)
+            std::cerr << peakSink;
+    }
+
+    void runProcessBlockBenchmarks(double sampleRate, const BenchmarkSettings& settings,
+                                   const juce::Array<Measurement>& baselines, juce::Array<ResultRow>& results)
+    {
+        for (const auto& configuration : createConfigurations())
+        {
+            PluginV3AudioProcessor processor;
+
+            setParameter(processor, "master_gain", 0.8f);
+            setParameter(processor, "left_gain", 1.1f);
+            setParameter(processor, "right_gain", 0.9f);
+            setParameter(processor, "use_mid_side", configuration.midSide ? 1.0f : 0.0f);
+            setParameter(processor, "mid_gain", 1.2f);
+            setParameter(processor, "side_gain", 0.8f);
+            setParameter(processor, "invert_left", configuration.invert ? 1.0f : 0.0f);
+            setParameter(processor, "invert_right", configuration.invert ? 1.0f : 0.0f);
+            setParameter(processor, "left_delay", configuration.leftDelayMs);
+            setParameter(processor, "right_delay", configuration.rightDelayMs);
+            setParameter(processor, "phase_offset", configuration.phaseOffset);
+            setParameter(processor, "delay_range", static_cast<float>(configuration.delayRange));
+            setParameter(processor, "safety_mode", static_cast<float>(configuration.safetyMode));
+            setParameter(processor, "safety_oversampling", static_cast<float>(configuration.safetyOversampling));
+            setParameter(processor, "hpf_mode", static_cast<float>(configuration.lowCutMode));
+
+            for (int i = 0; i < settings.blockSizes.size(); ++i)
+            {
+                const int blockSize = settings.blockSizes[i];
+
+                processor.setRateAndBufferSizeDetails(sampleRate, blockSize);
+                processor.prepareToPlay(sampleRate, blockSize);
+
+                SourceSignal signal(blockSize);
+                juce::MidiBuffer midi;
+
+                const auto measurement = measure(signal, blockSize, settings, [&](juce::AudioBuffer<float>& block)
+                {
+                    processor.processBlock(block, midi);
+                });
+
+                results.add({ "processBlock", configuration.name, sampleRate, blockSize,
+                              subtractBaseline(measurement, baselines[i]) });
+
+                processor.releaseResources();
+            }
+        }
+    }
+
+    //==============================================================================
+    /** The offline renderer's per-file meters: loudness, true peak, sample
+        peak and the correlation sums. */
+    struct FileMeters
+    {
+        void prepare(double sampleRate)
+        {
+            loudnessMeter.prepare(sampleRate);
+            truePeakDetector.prepare(sampleRate);
+        }
+
+        void process(const juce::AudioBuffer<float>& buffer, int numSamples) noexcept
+        {
+            const auto* const* channels = buffer.getArrayOfReadPointers();
+
+            loudnessMeter.process(channels, 2, numSamples);
+            truePeakDetector.process(channels, 2, numSamples);
+            samplePeak = juce::jmax(samplePeak, buffer.getMagnitude(0, 0, numSamples), buffer.getMagnitude(1, 0, numSamples));
+
+            for (int i = 0; i < numSamples; ++i)
+            {
+                const double left = channels[0][i];
+                const double right = channels[1][i];
+                sumLeftRight += left * right;
+                sumLeftSquared += left * left;
+                sumRightSquared += right * right;
+            }
+        }
+
+        LoudnessMeter loudnessMeter;
+        TruePeakDetector truePeakDetector;
+        float samplePeak { 0.0f };
+        double sumLeftRight { 0.0 }, sumLeftSquared { 0.0 }, sumRightSquared { 0.0 };
+    };
+
+    /** Renders and meters one block of BatchProcessor::numLanes files with the
+        same gain, polarity and mid/side settings, file by file and as one
+        batch, reporting the time per sample frame of each file. */
+    void runBatchBenchmarks(double sampleRate, const BenchmarkSettings& settings,
+                            const juce::Array<Measurement>& baselines, juce::Array<ResultRow>& results)
+    {
+        constexpr int numFiles = BatchProcessor::numLanes;
+
+        auto perFile = [](Measurement measurement)
+        {
+            measurement.nsPerSample /= numFiles;
+            measurement.nsPerSampleMin /= numFiles;
+            measurement.cyclesPerSample /= numFiles;
+            return measurement;
+        };
+
+        for (int i = 0; i < settings.blockSizes.size(); ++i)
+        {
+            const int blockSize = settings.blockSizes[i];
+            SourceSignal signal(blockSize);
+            juce::MidiBuffer midi;
+
+            juce::OwnedArray<PluginV3AudioProcessor> processors;
+            std::array<FileMeters, numFiles> meters;
+            std::array<juce::AudioBuffer<float>, numFiles> buffers;
+
+            for (int file = 0; file < numFiles; ++file)
+            {
+                auto* processor = processors.add(new PluginV3AudioProcessor());
+
+                setParameter(*processor, "master_gain", 0.8f);
+                setParameter(*processor, "left_gain", 1.1f);
+                setParameter(*processor, "right_gain", 0.9f);
+                setParameter(*processor, "use_mid_side", 1.0f);
+                setParameter(*processor, "mid_gain", 1.2f);
+                setParameter(*processor, "side_gain", 0.8f);
+                setParameter(*processor, "invert_left", 1.0f);
+
+                processor->setNonRealtime(true);
+                processor->setRateAndBufferSizeDetails(sampleRate, blockSize);
+                processor->prepareToPlay(sampleRate, blockSize);
+
+                meters[static_cast<size_t>(file)].prepare(sampleRate);
+                buffers[static_cast<size_t>(file)].setSize(2, blockSize);
+            }
+
+            const auto perFileMeasurement = measure(signal, blockSize, settings, [&](juce::AudioBuffer<float>& block)
+            {
+                for (int file = 0; file < numFiles; ++file)
+                {
+                    auto& buffer = buffers[static_cast<size_t>(file)];
+                    buffer.copyFrom(0, 0, block, 0, 0, blockSize);
+                    buffer.copyFrom(1, 0, block, 1, 0, blockSize);
+
+                    processors[file]->processBlock(buffer, midi);
+                    meters[static_cast<size_t>(file)].process(buffer, blockSize);
+                }
+            });
+
+            results.add({ "batch", "per_file,files=" + juce::String(numFiles), sampleRate, blockSize,
+                          perFile(subtractBaseline(perFileMeasurement, baselines[i])) });
+
+            BatchProcessor::Settings batchSettings;
+            juce::String reason;
+            const bool batchable = BatchProcessor::readSettings(processors[0]->getAPVTS(), batchSettings, reason);
+            jassert(batchable);
+            juce::ignoreUnused(batchable);
+
+            BatchProcessor batch;
+            batch.prepare(batchSettings, sampleRate, blockSize);
+
+            const auto batchMeasurement = measure(signal, blockSize, settings, [&](juce::AudioBuffer<float>& block)
+            {
+                for (int file = 0; file < numFiles; ++file)
+                    batch.setLaneInput(file, block.getReadPointer(0), block.getReadPointer(1), blockSize);
+
+                batch.process();
+
+                for (int file = 0; file < numFiles; ++file)
+                {
+                    auto& buffer = buffers[static_cast<size_t>(file)];
+                    batch.getLaneOutput(file, buffer.getWritePointer(0), buffer.getWritePointer(1), blockSize);
+                }
+            });
+
+            results.add({ "batch", "batch,files=" + juce::String(numFiles), sampleRate, blockSize,
+                          perFile(subtractBaseline(batchMeasurement, baselines[i])) });
+
+            for (auto* processor : processors)
+                processor->releaseResources();
+        }
+    }
+
+    //==============================================================================
+    /** Times every stage and configuration at each sample rate with the kernels
+        currently selected. */
+    void runBenchmarks(const BenchmarkSettings& settings, juce::Array<ResultRow>& results)
+    {
+        for (const auto sampleRate : settings.sampleRates)
+        {
+            std::cerr << DspKernels::getInstructionSetName(DspKernels::getActiveInstructionSet())
+                      << ", sample rate " << sampleRate << "...\n";
+
+            // Cost of supplying each block, removed from every measurement
+            juce::Array<Measurement> baselines;
+
+            for (const auto blockSize : settings.blockSizes)
+            {
+                SourceSignal signal(blockSize);
+                baselines.add(measure(signal, blockSize, settings, [](juce::AudioBuffer<float>&) {}));
+                results.add({ "baseline", "copy", sampleRate, blockSize, baselines.getLast() });
+            }
+
+            if (settings.runStages)
+                for (int i = 0; i < settings.blockSizes.size(); ++i)
+                    runStageBenchmarks(sampleRate, settings.blockSizes[i], baselines[i], settings, results);
+
+            if (settings.runProcessBlock)
+            {
+                runProcessBlockBenchmarks(sampleRate, settings, baselines, results);
+                runBatchBenchmarks(sampleRate, settings, baselines, results);
+            }
+        }
+    }
+
+    //==============================================================================
+    /** Estimates the time-stamp counter rate so cycles can be related to time. */
+    double measureCycleCounterGHz()
+    {
+        if (! CycleCounter::isAvailable)
+            return 0.0;
+
+        const auto startCycles = CycleCounter::readCycles();
+        const auto startTime = CycleCounter::readNanoseconds();
+        juce::Thread::sleep(200);
+        const auto elapsedCycles = CycleCounter::readCycles() - startCycles;
+        const auto elapsedTime = CycleCounter::readNanoseconds() - startTime;
+
+        return static_cast<double>(elapsedCycles) / static_cast<double>(elapsedTime);
+    }
+
+    juce::String formatCsv(const juce::Array<ResultRow>& results)
+    {
+        juce::String csv = "benchmark,name,sample_rate,block_size,ns_per_sample,ns_per_sample_min,cycles_per_sample,isa\n";
+
+        for (const auto& row : results)
+        {
+            csv << row.benchmark << ",\"" << row.name << "\"," << row.sampleRate << "," << row.blockSize << ","
+                << juce::String(row.measurement.nsPerSample, 4) << ","
+                << juce::String(row.measurement.nsPerSampleMin, 4) << ","
+                << (CycleCounter::isAvailable ? juce::String(row.measurement.cyclesPerSample, 4) : juce::String()) << ","
+                << row.instructionSet << "\n";
+        }
+
+        return csv;
+    }
+
+    juce::String formatJson(const juce::Array<ResultRow>& results, const BenchmarkSettings& settings, double cycleCounterGHz)
+    {
+        auto* machine = new juce::DynamicObject();
+        machine->setProperty("cpu", juce::SystemStats::getCpuModel());
+        machine->setProperty("cpuVendor", juce::SystemStats::getCpuVendor());
+        machine->setProperty("numCpus", juce::SystemStats::getNumCpus());
+        machine->setProperty("numPhysicalCpus", juce::SystemStats::getNumPhysicalCpus());
+        machine->setProperty("os", juce::SystemStats::getOperatingSystemName());
+        machine->setProperty("hasAVX2", juce::SystemStats::hasAVX2());
+        machine->setProperty("hasAVX512F", juce::SystemStats::hasAVX512F());
+        machine->setProperty("bestIsa", DspKernels::getInstructionSetName(DspKernels::getBestInstructionSet()));
+        machine->setProperty("cycleCounterGHz", CycleCounter::isAvailable ? juce::var(cycleCounterGHz) : juce::var());
+
+        auto* build = new juce::DynamicObject();
+        build->setProperty("juce", juce::SystemStats::getJUCEVersion());
+       #if JUCE_DEBUG
+        build->setProperty("configuration", "Debug");
+       #else
+        build->setProperty("configuration", "Release");
+       #endif
+       #ifdef PLUGINV3_BUILD_ARCH
+        build->setProperty("arch", PLUGINV3_BUILD_ARCH);
+       #else
+        build->setProperty("arch", "baseline");     // Projucer builds
+       #endif
+        build->setProperty("compiledOn", juce::String(__DATE__) + " " + __TIME__);
+
+        auto* method = new juce::DynamicObject();
+        method->setProperty("trials", settings.numTrials);
+        method->setProperty("samplesPerTrial", settings.samplesPerTrial);
+        method->setProperty("seed", static_cast<juce::int64>(randomSeed));
+        method->setProperty("statistic", "median of trials, copy baseline subtracted, per stereo sample frame");
+
+        juce::Array<juce::var> rows;
+
+        for (const auto& row : results)
+        {
+            auto* object = new juce::DynamicObject();
+            object->setProperty("benchmark", row.benchmark);
+            object->setProperty("name", row.name);
+            object->setProperty("sampleRate", row.sampleRate);
+            object->setProperty("blockSize", row.blockSize);
+            object->setProperty("nsPerSample", row.measurement.nsPerSample);
+            object->setProperty("nsPerSampleMin", row.measurement.nsPerSampleMin);
+            object->setProperty("cyclesPerSample", CycleCounter::isAvailable ? juce::var(row.measurement.cyclesPerSample) : juce::var());
+            object->setProperty("isa", row.instructionSet);
+            rows.add(juce::var(object));
+        }
+
+        auto* root = new juce::DynamicObject();
+        root->setProperty("machine", juce::var(machine));
+        root->setProperty("build", juce::var(build));
+        root->setProperty("method", juce::var(method));
+        root->setProperty("results", rows);
+
+        return juce::JSON::toString(juce::var(root));
+    }
+
+    //==============================================================================
+    void printUsage()
+    {
+        std::cout << "Usage: PluginV3Benchmark [options]\n"
+                     "\n"
+                     "Times processBlock, batch against per-file offline rendering, and each DSP stage,\n"
+                     "reporting ns and cycles per sample frame.\n"
+                     "\n"
+                     "Options:\n"
+                     "  --block-sizes <list>   Comma separated block sizes (default 16,32,...,4096)\n"
+                     "  --sample-rates <list>  Comma separated sample rates (default 44100,...,192000)\n"
+                     "  --stages-only          Only time the individual stages\n"
+                     "  --process-block-only   Only time processBlock and the batch rendering\n"
+                     "  --trials <n>           Timed trials per measurement (default 7)\n"
+                     "  --quick                Fewer and shorter trials, for smoke runs\n"
+                     "  --isa <list>           Kernel instruction sets to time: comma separated names\n"
+                     "                         (generic,sse2,avx2,avx512), or all this machine supports\n"
+                     "  --csv                  Write CSV instead of JSON\n"
+                     "  --output <file>        Write results to a file instead of stdout\n";
+    }
+
+    bool parseArguments(const juce::StringArray& args, BenchmarkSettings& settings, juce::String& error)
+    {
+        for (int i = 0; i < args.size(); ++i)
+        {
+            const auto& arg = args[i];
+            const auto value = i + 1 < args.size() ? args[i + 1] : juce::String();
+
+            if (arg == "--block-sizes" || arg == "--sample-rates")
+            {
+                const auto items = juce::StringArray::fromTokens(value, ",", {});
+                ++i;
+
+                if (arg == "--block-sizes")
+                {
+                    settings.blockSizes.clear();
+                    for (const auto& item : items)
+                        settings.blockSizes.add(juce::jlimit(1, 1 << 16, item.getIntValue()));
+                }
+                else
+                {
+                    settings.sampleRates.clear();
+                    for (const auto& item : items)
+                        settings.sampleRates.add(item.getDoubleValue());
+                }
+            }
+            else if (arg == "--trials")
+            {
+                settings.numTrials = juce::jmax(1, value.getIntValue());
+                ++i;
+            }
+            else if (arg == "--output")
+            {
+                settings.outputFile = juce::File::getCurrentWorkingDirectory().getChildFile(value);
+                ++i;
+            }
+            else if (arg == "--isa")
+            {
+                const auto best = DspKernels::getBestInstructionSet();
+                settings.instructionSets.clear();
+                ++i;
+
+                if (value == "all")
+                {
+                    for (int index = 0; index <= static_cast<int>(best); ++index)
+                        settings.instructionSets.add(static_cast<DspKernels::InstructionSet>(index));
+                }
+                else
+                {
+                    for (const auto& item : juce::StringArray::fromTokens(value, ",", {}))
+                    {
+                        DspKernels::InstructionSet instructionSet;
+
+                        if (! DspKernels::parseInstructionSet(item, instructionSet))
+                        {
+                            error = "Unknown instruction set " + item;
+                            return false;
+                        }
+
+                        if (instructionSet > best)
+                        {
+                            error = item + " is not supported on this machine";
+                            return false;
+                        }
+
+                        settings.instructionSets.addIfNotAlreadyThere(instructionSet);
+                    }
+                }
+            }
+            else if (arg == "--stages-only")
+                settings.runProcessBlock = false;
+            else if (arg == "--process-block-only")
+                settings.runStages = false;
+            else if (arg == "--quick")
+            {
+                settings.numTrials = 3;
+                settings.samplesPerTrial = 1 << 15;
+            }
+            else if (arg == "--csv")
+                settings.csv = true;
+            else
+            {
+                error = "Unknown option " + arg;
+                return false;
+            }
+        }
+
+        if (settings.blockSizes.isEmpty() || settings.sampleRates.isEmpty())
+        {
+            error = "No block sizes, sample rates or instruction sets to run";
+            return false;
+        }
+
+        for (const auto rate : settings.sampleRates)
+        {
+            if (rate < 8000.0 || rate > 384000.0)
+            {
+                error = "Sample rate out of range: " + juce::String(rate);
+                return false;
+            }
+        }
+
+        return true;
+    }
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    // Parameters and their listeners expect a message manager to exist
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::StringArray args;
+    for (int i = 1; i < argc; ++i)
+        args.add(juce::CharPointer_UTF8(argv[i]));
+
+    if (args.contains("--help") || args.contains("-h"))
+    {
+        printUsage();
+        return 0;
+    }
+
+    BenchmarkSettings settings;
+    juce::String error;
+
+    if (! parseArguments(args, settings, error))
+    {
+        std::cerr << "Error: " << error << "\n\n";
+        printUsage();
+        return 2;
+    }
+
+    juce::Process::setPriority(juce::Process::HighPriority);
+
+    const double cycleCounterGHz = measureCycleCounterGHz();
+    juce::Array<ResultRow> results;
+
+    if (settings.instructionSets.isEmpty())
+        settings.instructionSets.add(DspKernels::selectInstructionSet());
+
+    for (const auto instructionSet : settings.instructionSets)
+    {
+        // prepareToPlay reselects the kernels, so the processor runs keep the forced set
+        DspKernels::forceInstructionSet(instructionSet);
+        DspKernels::selectInstructionSet();
+
+        const int firstRow = results.size();
+        runBenchmarks(settings, results);
+
+        for (int i = firstRow; i < results.size(); ++i)
+            results.getReference(i).instructionSet = DspKernels::getInstructionSetName(instructionSet);
+    }
+
+    DspKernels::clearForcedInstructionSet();
+
+    const auto output = settings.csv ? formatCsv(results) : formatJson(results, settings, cycleCounterGHz);
+
+    if (settings.outputFile == juce::File())
+    {
+        std::cout << output << "\n";
+    }
+    else if (! settings.outputFile.replaceWithText(output))
+    {
+        std::cerr << "Error: cannot write " << settings.outputFile.getFullPathName() << "\n";
+        return 1;
+    }
+
+    return 0;
+}
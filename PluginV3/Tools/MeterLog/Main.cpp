@@ -0,0 +1,223 @@
+/*
+  ==============================================================================
+
+    PluginV3MeterLog - summarises and converts meter logs recorded by the
+    plugin's Log button.
+
+    A log holds one record per processed block: sample peak, true peak and
+    RMS per channel, momentary and short-term loudness and L/R correlation.
+    The summary reports the extremes and any gaps left by dropped records;
+    --csv writes every record out for spreadsheets and scripts.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include <iostream>
+#include "../../Source/MeterLogWriter.h"
+
+namespace
+{
+    //==============================================================================
+    struct Options
+    {
+        juce::File logFile;
+        juce::String csvPath;
+    };
+
+    void printUsage()
+    {
+        std::cout << "Usage: PluginV3MeterLog [options] <log.pv3meter>\n"
+                     "\n"
+                     "Summarises a PluginV3 meter log.\n"
+                     "\n"
+                     "Options:\n"
+                     "  --csv <file>          Also convert the log to CSV (- for standard output)\n"
+                     "  --help                Show this message\n";
+    }
+
+    bool parseArguments(const juce::StringArray& args, Options& options, juce::String& error)
+    {
+        for (int i = 0; i < args.size(); ++i)
+        {
+            const auto& arg = args[i];
+
+            auto nextValue = [&]() -> juce::String
+            {
+                if (i + 1 >= args.size())
+                {
+                    error = "Missing value for " + arg;
+                    return {};
+                }
+
+                return args[++i];
+            };
+
+            if (arg == "--csv")
+                options.csvPath = nextValue();
+            else if (arg.startsWith("--"))
+            {
+                error = "Unknown option " + arg;
+                return false;
+            }
+            else if (options.logFile == juce::File())
+                options.logFile = juce::File::getCurrentWorkingDirectory().getChildFile(arg);
+            else
+            {
+                error = "Only one log can be read at a time";
+                return false;
+            }
+
+            if (error.isNotEmpty())
+                return false;
+        }
+
+        if (options.logFile == juce::File())
+        {
+            error = "No log given";
+            return false;
+        }
+
+        return true;
+    }
+
+    juce::String toDecibelText(float level, const char* unit)
+    {
+        return juce::String(juce::Decibels::gainToDecibels(level, -200.0f), 1) + " " + unit;
+    }
+
+    //==============================================================================
+    /** Prints the extremes of a log and counts the gaps between records. */
+    bool printSummary(const juce::File& logFile, juce::String& error)
+    {
+        juce::FileInputStream input(logFile);
+
+        if (! input.openedOk())
+        {
+            error = "Couldn't open " + logFile.getFullPathName();
+            return false;
+        }
+
+        juce::BufferedInputStream bufferedInput(input, 1 << 20);
+        MeterLogWriter::Header header;
+
+        if (! MeterLogWriter::readHeader(bufferedInput, header))
+        {
+            error = logFile.getFileName() + " is not a PluginV3 meter log";
+            return false;
+        }
+
+        MeterLogWriter::Record record;
+        juce::int64 numRecords = 0, numGaps = 0, numSamples = 0;
+        juce::int64 nextPosition = -1;
+        float peak = 0.0f, truePeak = 0.0f;
+        float maxShortTerm = -100.0f, minCorrelation = 1.0f;
+
+        while (MeterLogWriter::readRecord(bufferedInput, header, record))
+        {
+            if (nextPosition >= 0 && record.samplePosition != nextPosition)
+                ++numGaps;
+
+            nextPosition = record.samplePosition + record.numSamples;
+            numSamples += record.numSamples;
+            ++numRecords;
+
+            for (int channel = 0; channel < MeterFrame::maxChannels; ++channel)
+            {
+                peak = juce::jmax(peak, record.peak[channel]);
+                truePeak = juce::jmax(truePeak, record.truePeak[channel]);
+            }
+
+            maxShortTerm = juce::jmax(maxShortTerm, record.shortTermLoudness);
+
+            // Correlation of silence means nothing
+            if (record.rms[0] > 0.0f)
+                minCorrelation = juce::jmin(minCorrelation, record.correlation);
+        }
+
+        std::cout << logFile.getFileName() << "\n"
+                  << "  Recorded:          " << juce::Time(header.startTime).toString(true, true) << "\n"
+                  << "  Sample rate:       " << juce::String(header.sampleRate, 0) << " Hz, "
+                  << header.numChannels << (header.numChannels == 1 ? " channel\n" : " channels\n")
+                  << "  Duration:          " << juce::String(numSamples / header.sampleRate, 2) << " s in "
+                  << numRecords << " blocks\n"
+                  << "  Dropped:           " << header.numDropped << " blocks, " << numGaps << " gaps\n"
+                  << "  Peak:              " << toDecibelText(peak, "dBFS") << "\n"
+                  << "  True peak:         " << toDecibelText(truePeak, "dBTP") << "\n"
+                  << "  Max short-term:    " << juce::String(maxShortTerm, 1) << " LUFS\n"
+                  << "  Min correlation:   " << juce::String(minCorrelation, 2) << "\n";
+        return true;
+    }
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::StringArray args;
+    for (int i = 1; i < argc; ++i)
+        args.add(juce::CharPointer_UTF8(argv[i]));
+
+    if (args.isEmpty() || args.contains("--help") || args.contains("-h"))
+    {
+        printUsage();
+        return args.isEmpty() ? 2 : 0;
+    }
+
+    Options options;
+    juce::String error;
+
+    if (! parseArguments(args, options, error))
+    {
+        std::cerr << "Error: " << error << "\n\n";
+        printUsage();
+        return 2;
+    }
+
+    const bool csvToStandardOutput = options.csvPath == "-";
+
+    // Keep standard output clean for the CSV
+    if (! csvToStandardOutput && ! printSummary(options.logFile, error))
+    {
+        std::cerr << "Error: " << error << "\n";
+        return 1;
+    }
+
+    if (options.csvPath.isEmpty())
+        return 0;
+
+    std::unique_ptr<juce::OutputStream> csv;
+
+    if (csvToStandardOutput)
+    {
+        csv = std::make_unique<juce::MemoryOutputStream>();
+    }
+    else
+    {
+        const auto csvFile = juce::File::getCurrentWorkingDirectory().getChildFile(options.csvPath);
+        csvFile.deleteFile();
+        auto fileStream = std::make_unique<juce::FileOutputStream>(csvFile, 1 << 20);
+
+        if (! fileStream->openedOk())
+        {
+            std::cerr << "Error: cannot write " << csvFile.getFullPathName() << "\n";
+            return 1;
+        }
+
+        csv = std::move(fileStream);
+    }
+
+    if (! MeterLogWriter::convertToCsv(options.logFile, *csv, error))
+    {
+        std::cerr << "Error: " << error << "\n";
+        return 1;
+    }
+
+    if (auto* memory = dynamic_cast<juce::MemoryOutputStream*>(csv.get()))
+        std::cout << memory->toString();
+    else
+        std::cout << "CSV written to " << options.csvPath << "\n";
+
+    return 0;
+}
@@ -0,0 +1,1370 @@
+/*
+  ==============================================================================
+
+    PluginV3Render - runs PluginV3AudioProcessor over audio files offline.
+
+    Each input file gets its own processor instance on a thread pool, so many
+    files render in parallel. Audio is streamed through processBlock in large
+    blocks and the processed output is metered (sample peak, true peak,
+    integrated loudness and L/R correlation) into a JSON report. The
+    processor's latency is compensated, so the output lines up with the input.
+
+    WAV, RF64 and AIFF inputs are memory-mapped and converted block by block
+    into aligned staging buffers that each pool thread keeps from file to
+    file, so the processor runs on them without further copies.
+
+    With --batch, stereo files sharing a sample rate run through the lanes of
+    a BatchProcessor instead, several files per thread, when the settings
+    allow it. The output and the report are the same either way.
+
+    With --analyze-only, long files are split into segments that are analysed
+    on the pool like separate files, each after a warm-up that settles the
+    processor and meter states, and the readings are merged per file. With
+    --verify-segments those files are also analysed in one pass, and the
+    differences between the two are reported.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include <iostream>
+#include "../../Source/PluginProcessor.h"
+#include "../../Source/AlignedArena.h"
+#include "../../Source/AudioFileInput.h"
+#include "../../Source/BatchProcessor.h"
+#include "../../Source/LoudnessMeter.h"
+#include "../../Source/TruePeakDetector.h"
+
+namespace
+{
+    //==============================================================================
+    struct RenderJob
+    {
+        juce::File input;
+        juce::File output;
+    };
+
+    struct RenderOptions
+    {
+        juce::Array<RenderJob> jobs;
+
+        // Saved plugin state, either the form hosts store (binary or older XML-based) or XML
+        juce::MemoryBlock stateData;
+        bool stateIsXml { false };
+
+        // Parameter ID -> value text, applied after the state
+        juce::StringPairArray parameterOverrides;
+
+        juce::File outputDirectory;
+        juce::String outputFormat { "wav" };
+        int bitDepth { 24 };
+        int blockSize { 8192 };
+        int numThreads { juce::SystemStats::getNumCpus() };
+        bool analyseOnly { false };
+        bool batch { false };
+        double segmentSeconds { 60.0 };
+        bool verifySegments { false };
+        juce::File reportFile;
+    };
+
+    struct FileReport
+    {
+        juce::File input;
+        juce::File output;
+        double sampleRate { 0.0 };
+        int numChannels { 0 };
+        juce::int64 lengthInSamples { 0 };
+        float samplePeak { 0.0f };
+        float truePeak { 0.0f };
+        float integratedLoudness { 0.0f };
+        double correlation { 0.0 };
+        bool correlationValid { false };
+        juce::String error;
+    };
+
+    //==============================================================================
+    /** What a pool thread keeps from one file to the next, so files don't
+        allocate readers, formats or block buffers of their own. */
+    struct WorkerResources
+    {
+        WorkerResources()
+        {
+            formatManager.registerBasicFormats();
+        }
+
+        static WorkerResources& forThisThread()
+        {
+            thread_local WorkerResources resources;
+            return resources;
+        }
+
+        /** The block buffer, pointing into cache-line-aligned staging memory
+            that only grows and is kept for the thread's next file. */
+        juce::AudioBuffer<float>& getBuffer(int numChannels, int numSamples)
+        {
+            if (numSamples > stagingCapacity)
+            {
+                staging.allocate(maxChannels * AlignedArena::getBytes<float>(numSamples));
+
+                for (auto& channel : stagingChannels)
+                    channel = staging.take<float>(numSamples);
+
+                stagingCapacity = numSamples;
+            }
+
+            buffer.setDataToReferTo(stagingChannels, numChannels, numSamples);
+            return buffer;
+        }
+
+        static constexpr int maxChannels = 2;
+
+        AudioFileInput input;
+        juce::AudioFormatManager formatManager;     // For the writers
+
+        AlignedArena staging;
+        float* stagingChannels[maxChannels] {};
+        int stagingCapacity { 0 };
+        juce::AudioBuffer<float> buffer;
+    };
+
+    /** Audio processed and metered before each segment and then discarded. It
+        covers the longest delay range (2s), lets the low cut, K-weighting and
+        true-peak filters and the output safety release settle, and fills the
+        sub-blocks the segment's first gating blocks reach back into. */
+    constexpr double segmentWarmUpSeconds = 5.0;
+
+    //==============================================================================
+    void printUsage()
+    {
+        std::cout << "Usage: PluginV3Render [options] <file or directory>...\n"
+                     "\n"
+                     "Renders WAV/FLAC files through PluginV3 and writes a JSON metering report.\n"
+                     "Directories are searched recursively.\n"
+                     "\n"
+                     "Options:\n"
+                     "  --output <dir>        Directory for rendered files (required unless --analyze-only)\n"
+                     "  --state <file>        Plugin state to load (binary host state, old XML-based\n"
+                     "                        host state or XML)\n"
+                     "  --set <id>=<value>    Override a parameter, e.g. --set master_gain=0.5\n"
+                     "                        (repeatable, applied after --state)\n"
+                     "  --format wav|flac     Output format (default wav)\n"
+                     "  --bits <n>            Output bit depth (default 24)\n"
+                     "  --block-size <n>      Samples per processBlock call (default 8192)\n"
+                     "  --threads <n>         Files rendered in parallel (default: number of CPUs)\n"
+                     "  --analyze-only        Meter the processed audio without writing files\n"
+                     "  --batch               Process stereo files of the same sample rate together,\n"
+                     "                        several per thread in vector lanes (gain, polarity and\n"
+                     "                        mid/side settings only; others render file by file)\n"
+                     "  --segment <seconds>   With --analyze-only, files longer than this are analysed\n"
+                     "                        in segments of this length in parallel (default 60,\n"
+                     "                        0 analyses every file in one pass)\n"
+                     "  --verify-segments     Also analyse segmented files in one pass and report the\n"
+                     "                        largest loudness, true peak and correlation differences\n"
+                     "  --report <file>       JSON report path (default <output>/report.json)\n"
+                     "  --help                Show this message\n";
+    }
+
+    juce::String toDisplayName(const juce::File& file)
+    {
+        return file.getRelativePathFrom(juce::File::getCurrentWorkingDirectory());
+    }
+
+    //==============================================================================
+    bool parseArguments(const juce::StringArray& args, RenderOptions& options, juce::String& error)
+    {
+        juce::StringArray inputs;
+        juce::File stateFile;
+
+        for (int i = 0; i < args.size(); ++i)
+        {
+            const auto& arg = args[i];
+
+            // Every option except the flags takes a value
+            auto nextValue = [&]() -> juce::String
+            {
+                if (i + 1 >= args.size())
+                {
+                    error = "Missing value for " + arg;
+                    return {};
+                }
+
+                return args[++i];
+            };
+
+            if (arg == "--output")
+                options.outputDirectory = juce::File::getCurrentWorkingDirectory().getChildFile(nextValue());
+            else if (arg == "--state")
+                stateFile = juce::File::getCurrentWorkingDirectory().getChildFile(nextValue());
+            else if (arg == "--set")
+            {
+                const auto assignment = nextValue();
+                if (! assignment.contains("="))
+                {
+                    error = "Expected <id>=<value> after --set, got \"" + assignment + "\"";
+                    return false;
+                }
+
+                options.parameterOverrides.set(assignment.upToFirstOccurrenceOf("=", false, false).trim(),
+                                               assignment.fromFirstOccurrenceOf("=", false, false).trim());
+            }
+            else if (arg == "--format")
+                options.outputFormat = nextValue().toLowerCase();
+            else if (arg == "--bits")
+                options.bitDepth = nextValue().getIntValue();
+            else if (arg == "--block-size")
+                options.blockSize = nextValue().getIntValue();
+            else if (arg == "--threads")
+                options.numThreads = nextValue().getIntValue();
+            else if (arg == "--segment")
+                options.segmentSeconds = nextValue().getDoubleValue();
+            else if (arg == "--report")
+                options.reportFile = juce::File::getCurrentWorkingDirectory().getChildFile(nextValue());
+            else if (arg == "--analyze-only")
+                options.analyseOnly = true;
+            else if (arg == "--batch")
+                options.batch = true;
+            else if (arg == "--verify-segments")
+                options.verifySegments = true;
+            else if (arg.startsWith("--"))
+            {
+                error = "Unknown option " + arg;
+                return false;
+            }
+            else
+                inputs.add(arg);
+
+            if (error.isNotEmpty())
+                return false;
+        }
+
+        if (inputs.isEmpty())
+        {
+            error = "No input files given";
+            return false;
+        }
+
+        if (options.outputFormat != "wav" && options.outputFormat != "flac")
+        {
+            error = "Unsupported output format " + options.outputFormat;
+            return false;
+        }
+
+        if (options.blockSize < 32 || options.numThreads < 1)
+        {
+            error = "Block size must be at least 32 and at least one thread is needed";
+            return false;
+        }
+
+        if (options.segmentSeconds != 0.0 && options.segmentSeconds < 2.0 * segmentWarmUpSeconds)
+        {
+            error = "Segments must be at least " + juce::String(2.0 * segmentWarmUpSeconds) + " seconds long";
+            return false;
+        }
+
+        if (options.verifySegments && (! options.analyseOnly || options.segmentSeconds == 0.0))
+        {
+            error = "--verify-segments needs --analyze-only and segmenting turned on";
+            return false;
+        }
+
+        if (! options.analyseOnly && options.outputDirectory == juce::File())
+        {
+            error = "--output is required unless --analyze-only is given";
+            return false;
+        }
+
+        if (options.reportFile == juce::File())
+        {
+            options.reportFile = options.analyseOnly && options.outputDirectory == juce::File()
+                                     ? juce::File::getCurrentWorkingDirectory().getChildFile("report.json")
+                                     : options.outputDirectory.getChildFile("report.json");
+        }
+
+        //==============================================================================
+        if (stateFile != juce::File())
+        {
+            if (! stateFile.loadFileAsData(options.stateData))
+            {
+                error = "Cannot read state file " + stateFile.getFullPathName();
+                return false;
+            }
+
+            options.stateIsXml = options.stateData.getSize() > 0
+                              && static_cast<const char*>(options.stateData.getData())[0] == '<';
+        }
+
+        //==============================================================================
+        // Directory inputs keep their layout below the output directory
+        const auto extension = "." + options.outputFormat;
+
+        for (const auto& input : inputs)
+        {
+            const auto file = juce::File::getCurrentWorkingDirectory().getChildFile(input);
+
+            if (file.isDirectory())
+            {
+                auto found = file.findChildFiles(juce::File::findFiles, true, "*.wav;*.flac;*.aif;*.aiff");
+                found.sort();
+
+                for (const auto& child : found)
+                    options.jobs.add({ child, options.outputDirectory.getChildFile(child.getRelativePathFrom(file))
+                                                                     .withFileExtension(extension) });
+            }
+            else if (file.existsAsFile())
+                options.jobs.add({ file, options.outputDirectory.getChildFile(file.getFileName())
+                                                                .withFileExtension(extension) });
+            else
+            {
+                error = "Input not found: " + input;
+                return false;
+            }
+        }
+
+        if (! options.analyseOnly)
+        {
+            for (const auto& job : options.jobs)
+            {
+                if (job.output == job.input)
+                {
+                    error = "Refusing to overwrite input " + job.input.getFullPathName();
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    //==============================================================================
+    /** Loads the saved state and parameter overrides into a processor. */
+    bool applySettings(PluginV3AudioProcessor& processor, const RenderOptions& options, juce::String& error)
+    {
+        auto& apvts = processor.getAPVTS();
+
+        if (options.stateData.getSize() > 0)
+        {
+            if (options.stateIsXml)
+            {
+                const auto xml = juce::parseXML(options.stateData.toString());
+
+                if (xml == nullptr || ! xml->hasTagName(apvts.state.getType()))
+                {
+                    error = "State file is not a PluginV3 state";
+                    return false;
+                }
+
+                apvts.replaceState(juce::ValueTree::fromXml(*xml));
+            }
+            else
+            {
+                const auto* data = options.stateData.getData();
+                const int size = static_cast<int>(options.stateData.getSize());
+
+                if (! StateSerializer::isBinaryState(data, size)
+                    && juce::AudioProcessor::getXmlFromBinary(data, size) == nullptr)
+                {
+                    error = "State file is not a PluginV3 state";
+                    return false;
+                }
+
+                processor.setStateInformation(data, size);
+            }
+        }
+
+        const auto& ids = options.parameterOverrides.getAllKeys();
+        const auto& values = options.parameterOverrides.getAllValues();
+
+        for (int i = 0; i < ids.size(); ++i)
+        {
+            auto* parameter = apvts.getParameter(ids[i]);
+
+            if (parameter == nullptr)
+            {
+                error = "Unknown parameter " + ids[i];
+                return false;
+            }
+
+            // Values are given in the parameter's own units; choices also accept an index
+            float normalisedValue = parameter->getValueForText(values[i]);
+
+            if (auto* choice = dynamic_cast<juce::AudioParameterChoice*>(parameter))
+                if (values[i].containsOnly("0123456789"))
+                    normalisedValue = choice->convertTo0to1(static_cast<float>(values[i].getIntValue()));
+
+            parameter->setValueNotifyingHost(normalisedValue);
+        }
+
+        return true;
+    }
+
+    //==============================================================================
+    /** Creates the writer for a job's output, or sets the report's error. */
+    std::unique_ptr<juce::AudioFormatWriter> createWriter(const RenderJob& job, const RenderOptions& options,
+                                                          juce::AudioFormatManager& formatManager,
+                                                          const juce::AudioFormatReader& reader, FileReport& report)
+    {
+        auto* format = formatManager.findFormatForFileExtension(options.outputFormat);
+
+        if (format == nullptr || ! format->getPossibleBitDepths().contains(options.bitDepth))
+        {
+            report.error = juce::String(options.bitDepth) + "-bit " + options.outputFormat + " output is not supported";
+            return nullptr;
+        }
+
+        job.output.getParentDirectory().createDirectory();
+        job.output.deleteFile();
+
+        std::unique_ptr<juce::OutputStream> stream(job.output.createOutputStream());
+        std::unique_ptr<juce::AudioFormatWriter> writer;
+
+        if (stream != nullptr)
+            writer.reset(format->createWriterFor(stream.get(), report.sampleRate,
+                                                 static_cast<unsigned int>(report.numChannels),
+                                                 options.bitDepth, reader.metadataValues, 0));
+
+        if (writer == nullptr)
+        {
+            report.error = "Cannot create " + job.output.getFullPathName();
+            return nullptr;
+        }
+
+        // The writer owns the stream once it has been created
+        stream.release();
+        report.output = job.output;
+        return writer;
+    }
+
+    /** Fills in the correlation from sums over the whole processed file. */
+    void setCorrelation(FileReport& report, double sumLeftRight, double sumLeftSquared, double sumRightSquared)
+    {
+        if (report.numChannels == 1)
+        {
+            report.correlation = 1.0;
+            report.correlationValid = true;
+        }
+        else if (sumLeftSquared > 0.0 && sumRightSquared > 0.0)
+        {
+            report.correlation = sumLeftRight / std::sqrt(sumLeftSquared * sumRightSquared);
+            report.correlationValid = true;
+        }
+    }
+
+    //==============================================================================
+    /** Sets a processor up for a file's layout and rate with the render settings. */
+    bool prepareProcessor(PluginV3AudioProcessor& processor, const FileReport& report,
+                          const RenderOptions& options, juce::String& error)
+    {
+        // Match the main bus to the file and leave the sidechain disabled
+        const auto channelSet = juce::AudioChannelSet::canonicalChannelSet(report.numChannels);
+        juce::AudioProcessor::BusesLayout layout;
+        layout.inputBuses.add(channelSet);
+        layout.inputBuses.add(juce::AudioChannelSet::disabled());
+        layout.outputBuses.add(channelSet);
+
+        if (! processor.setBusesLayout(layout))
+        {
+            error = "Processor rejected the channel layout";
+            return false;
+        }
+
+        if (! applySettings(processor, options, error))
+            return false;
+
+        processor.setNonRealtime(true);
+        processor.setRateAndBufferSizeDetails(report.sampleRate, options.blockSize);
+        processor.prepareToPlay(report.sampleRate, options.blockSize);
+        return true;
+    }
+
+    /** Fills a block with the input from position on, and with silence past
+        the end of the file, where a processor with latency is flushed. */
+    bool readBlock(AudioFileInput& input, juce::AudioBuffer<float>& buffer, int numSamples,
+                   juce::int64 position, juce::int64 lengthInSamples)
+    {
+        const int numToRead = static_cast<int>(juce::jlimit(static_cast<juce::int64>(0),
+                                                            static_cast<juce::int64>(numSamples),
+                                                            lengthInSamples - position));
+
+        if (numToRead > 0 && ! input.read(buffer, numToRead, position))
+            return false;
+
+        for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+            buffer.clear(channel, numToRead, numSamples - numToRead);
+
+        return true;
+    }
+
+    //==============================================================================
+    /** The report's meters on the processed signal. */
+    struct OutputMeters
+    {
+        void prepare(double sampleRate)
+        {
+            loudnessMeter.prepare(sampleRate);
+            truePeakDetector.prepare(sampleRate);
+        }
+
+        void process(const juce::AudioBuffer<float>& buffer, int numChannels, int numSamples) noexcept
+        {
+            const auto* const* channels = buffer.getArrayOfReadPointers();
+
+            loudnessMeter.process(channels, numChannels, numSamples);
+            truePeakDetector.process(channels, numChannels, numSamples);
+
+            for (int channel = 0; channel < numChannels; ++channel)
+                samplePeak = juce::jmax(samplePeak, buffer.getMagnitude(channel, 0, numSamples));
+
+            if (numChannels == 2)
+            {
+                for (int i = 0; i < numSamples; ++i)
+                {
+                    const double left = channels[0][i];
+                    const double right = channels[1][i];
+                    sumLeftRight += left * right;
+                    sumLeftSquared += left * left;
+                    sumRightSquared += right * right;
+                }
+            }
+        }
+
+        /** Drops the readings so far but keeps the filter histories, for a
+            segment whose warm-up has just finished. */
+        void restart() noexcept
+        {
+            loudnessMeter.resetIntegrated();
+            truePeakDetector.resetPeak();
+            samplePeak = 0.0f;
+            sumLeftRight = sumLeftSquared = sumRightSquared = 0.0;
+        }
+
+        LoudnessMeter loudnessMeter;
+        TruePeakDetector truePeakDetector;
+        float samplePeak { 0.0f };
+        double sumLeftRight { 0.0 }, sumLeftSquared { 0.0 }, sumRightSquared { 0.0 };
+    };
+
+    //==============================================================================
+    FileReport renderFile(const RenderJob& job, const RenderOptions& options)
+    {
+        FileReport report;
+        report.input = job.input;
+
+        auto& resources = WorkerResources::forThisThread();
+        auto& input = resources.input;
+
+        if (! input.open(job.input))
+        {
+            report.error = "Unsupported or unreadable audio file";
+            return report;
+        }
+
+        const juce::ScopeGuard closeInput { [&input] { input.close(); } };
+        const auto& reader = *input.getReader();
+
+        report.sampleRate = reader.sampleRate;
+        report.numChannels = static_cast<int>(reader.numChannels);
+        report.lengthInSamples = reader.lengthInSamples;
+
+        if (report.numChannels < 1 || report.numChannels > 2)
+        {
+            report.error = "Only mono and stereo files are supported";
+            return report;
+        }
+
+        //==============================================================================
+        PluginV3AudioProcessor processor;
+
+        if (! prepareProcessor(processor, report, options, report.error))
+            return report;
+
+        //==============================================================================
+        std::unique_ptr<juce::AudioFormatWriter> writer;
+
+        if (! options.analyseOnly)
+        {
+            writer = createWriter(job, options, resources.formatManager, reader, report);
+
+            if (writer == nullptr)
+                return report;
+        }
+
+        //==============================================================================
+        OutputMeters meters;
+        meters.prepare(report.sampleRate);
+
+        juce::MidiBuffer midi;
+
+        // The output lags the input by the processor's latency (the safety
+        // stage's oversampling filters), so the first latency samples are
+        // dropped and as many samples of silence flush out the end
+        const juce::int64 latency = processor.getLatencySamples();
+        const juce::int64 processEnd = report.lengthInSamples + latency;
+
+        for (juce::int64 position = 0; position < processEnd; position += options.blockSize)
+        {
+            const int numSamples = static_cast<int>(juce::jmin(static_cast<juce::int64>(options.blockSize),
+                                                               processEnd - position));
+
+            auto& buffer = resources.getBuffer(report.numChannels, numSamples);
+
+            if (! readBlock(input, buffer, numSamples, position, report.lengthInSamples))
+            {
+                report.error = "Read error at sample " + juce::String(position);
+                break;
+            }
+
+            processor.processBlock(buffer, midi);
+
+            const int skip = static_cast<int>(juce::jlimit(static_cast<juce::int64>(0),
+                                                           static_cast<juce::int64>(numSamples), latency - position));
+
+            if (skip == numSamples)
+                continue;
+
+            // Meter the processed signal
+            juce::AudioBuffer<float> output(buffer.getArrayOfWritePointers(), report.numChannels, skip, numSamples - skip);
+            meters.process(output, report.numChannels, output.getNumSamples());
+
+            if (writer != nullptr && ! writer->writeFromAudioSampleBuffer(output, 0, output.getNumSamples()))
+            {
+                report.error = "Write error at sample " + juce::String(position - latency + skip);
+                break;
+            }
+        }
+
+        processor.releaseResources();
+        writer.reset();
+
+        report.samplePeak = meters.samplePeak;
+        report.truePeak = meters.truePeakDetector.getTruePeak();
+        report.integratedLoudness = meters.loudnessMeter.getIntegratedLoudness();
+        setCorrelation(report, meters.sumLeftRight, meters.sumLeftSquared, meters.sumRightSquared);
+
+        return report;
+    }
+
+    //==============================================================================
+    /** Stereo jobs at one sample rate, shared by the batch workers rendering them. */
+    struct BatchGroup
+    {
+        double sampleRate { 0.0 };
+        juce::Array<int> jobIndices;
+        std::atomic<int> nextJob { 0 };
+    };
+
+    /** Renders jobs of a group in the lanes of one BatchProcessor until none
+        are left. Every file starts on a block of its own, so it is processed
+        and metered in the same blocks as renderFile() would use. */
+    void renderBatch(BatchGroup& group, const RenderOptions& options, const BatchProcessor::Settings& settings,
+                     juce::Array<FileReport>& reports, const std::function<void(const FileReport&)>& onFinished)
+    {
+        auto& resources = WorkerResources::forThisThread();
+
+        struct Lane
+        {
+            FileReport* report = nullptr;
+            AudioFileInput input;
+            std::unique_ptr<juce::AudioFormatWriter> writer;
+            juce::int64 position = 0;
+            int numSamples = 0;
+        };
+
+        std::array<Lane, BatchProcessor::numLanes> lanes;
+
+        BatchProcessor batch;
+        batch.prepare(settings, group.sampleRate, options.blockSize);
+
+        auto finishLane = [&](int laneIndex)
+        {
+            auto& lane = lanes[static_cast<size_t>(laneIndex)];
+            auto& report = *lane.report;
+
+            lane.writer.reset();
+            lane.input.close();
+            lane.report = nullptr;
+
+            if (report.error.isEmpty())
+            {
+                const auto result = batch.getLaneResult(laneIndex);
+                report.samplePeak = result.samplePeak;
+                report.truePeak = result.truePeak;
+                report.integratedLoudness = result.integratedLoudness;
+                setCorrelation(report, result.sumLeftRight, result.sumLeftSquared, result.sumRightSquared);
+            }
+
+            onFinished(report);
+        };
+
+        // Opens the group's next file in a lane; false once the group is used up
+        auto startNextFile = [&](int laneIndex)
+        {
+            const int next = group.nextJob++;
+
+            if (next >= group.jobIndices.size())
+                return false;
+
+            const int jobIndex = group.jobIndices[next];
+            const auto& job = options.jobs.getReference(jobIndex);
+            auto& report = reports.getReference(jobIndex);
+            report.input = job.input;
+
+            auto& lane = lanes[static_cast<size_t>(laneIndex)];
+
+            if (! lane.input.open(job.input))
+            {
+                report.error = "Unsupported or unreadable audio file";
+                onFinished(report);
+                return true;
+            }
+
+            const auto& reader = *lane.input.getReader();
+            report.sampleRate = reader.sampleRate;
+            report.numChannels = static_cast<int>(reader.numChannels);
+            report.lengthInSamples = reader.lengthInSamples;
+
+            if (report.numChannels != 2 || report.sampleRate != group.sampleRate)
+            {
+                report.error = "File changed while rendering";
+                lane.input.close();
+                onFinished(report);
+                return true;
+            }
+
+            if (! options.analyseOnly)
+            {
+                lane.writer = createWriter(job, options, resources.formatManager, reader, report);
+
+                if (lane.writer == nullptr)
+                {
+                    lane.input.close();
+                    onFinished(report);
+                    return true;
+                }
+            }
+
+            lane.report = &report;
+            lane.position = 0;
+            batch.startLane(laneIndex);
+
+            if (report.lengthInSamples <= 0)
+                finishLane(laneIndex);
+
+            return true;
+        };
+
+        bool groupHasFiles = true;
+
+        for (;;)
+        {
+            bool anyLaneBusy = false;
+
+            for (int laneIndex = 0; laneIndex < BatchProcessor::numLanes; ++laneIndex)
+            {
+                auto& lane = lanes[static_cast<size_t>(laneIndex)];
+
+                while (lane.report == nullptr && groupHasFiles)
+                    groupHasFiles = startNextFile(laneIndex);
+
+                anyLaneBusy = anyLaneBusy || lane.report != nullptr;
+            }
+
+            if (! anyLaneBusy)
+                break;
+
+            for (int laneIndex = 0; laneIndex < BatchProcessor::numLanes; ++laneIndex)
+            {
+                auto& lane = lanes[static_cast<size_t>(laneIndex)];
+
+                if (lane.report == nullptr)
+                    continue;
+
+                lane.numSamples = static_cast<int>(juce::jmin(static_cast<juce::int64>(options.blockSize),
+                                                              lane.report->lengthInSamples - lane.position));
+
+                auto& buffer = resources.getBuffer(2, lane.numSamples);
+
+                if (! lane.input.read(buffer, lane.numSamples, lane.position))
+                {
+                    lane.report->error = "Read error at sample " + juce::String(lane.position);
+                    finishLane(laneIndex);
+                    continue;
+                }
+
+                batch.setLaneInput(laneIndex, buffer.getReadPointer(0), buffer.getReadPointer(1), lane.numSamples);
+            }
+
+            batch.process();
+
+            for (int laneIndex = 0; laneIndex < BatchProcessor::numLanes; ++laneIndex)
+            {
+                auto& lane = lanes[static_cast<size_t>(laneIndex)];
+
+                if (lane.report == nullptr)
+                    continue;
+
+                auto& buffer = resources.getBuffer(2, lane.numSamples);
+                batch.getLaneOutput(laneIndex, buffer.getWritePointer(0), buffer.getWritePointer(1), lane.numSamples);
+
+                if (lane.writer != nullptr && ! lane.writer->writeFromAudioSampleBuffer(buffer, 0, lane.numSamples))
+                {
+                    lane.report->error = "Write error at sample " + juce::String(lane.position);
+                    finishLane(laneIndex);
+                    continue;
+                }
+
+                lane.position += lane.numSamples;
+
+                if (lane.position >= lane.report->lengthInSamples)
+                    finishLane(laneIndex);
+            }
+        }
+    }
+
+    //==============================================================================
+    /** Readings of one segment of a long file, merged once every segment is done. */
+    struct SegmentResult
+    {
+        LoudnessHistogram histogram;
+        float samplePeak { 0.0f };
+        float truePeak { 0.0f };
+        double sumLeftRight { 0.0 }, sumLeftSquared { 0.0 }, sumRightSquared { 0.0 };
+        juce::String error;
+    };
+
+    /** A long file analysed in segments on the thread pool. Segments and the
+        metered warm-up before each are whole loudness sub-blocks, so every
+        segment's gating blocks sit on the same grid as in a single pass. */
+    struct SegmentedFile
+    {
+        int jobIndex { 0 };
+        juce::int64 segmentLength { 0 };
+        juce::int64 warmUpLength { 0 };
+        std::vector<SegmentResult> results;
+        std::atomic<int> segmentsLeft { 0 };
+    };
+
+    /** Returns false, with the reason, if the processed signal depends on more
+        of the file than a segment's warm-up covers. */
+    bool canAnalyseInSegments(juce::AudioProcessorValueTreeState& apvts, juce::String& reason)
+    {
+        auto value = [&apvts](const char* parameterID)
+        {
+            const auto* parameter = apvts.getRawParameterValue(parameterID);
+            return parameter != nullptr ? parameter->load() : 0.0f;
+        };
+
+        if (value("auto_gain") > 0.5f)
+            reason = "auto gain depends on everything before it";
+        else if (juce::roundToInt(value("width_mode")) != 0 && value("width_amount") > 0.0f
+                 && value("width_mono_safe") > 0.5f)
+            reason = "the width mono safety depends on everything before it";
+
+        return reason.isEmpty();
+    }
+
+    /** Splits a file into segments, or returns nullptr if it fits in one. */
+    std::unique_ptr<SegmentedFile> planSegments(int jobIndex, const FileReport& report, const RenderOptions& options)
+    {
+        const juce::int64 subBlockLength = LoudnessMeter::getSamplesPerSubBlock(report.sampleRate);
+
+        auto toSubBlocks = [&](double seconds)
+        {
+            const auto numSubBlocks = static_cast<juce::int64>(std::ceil(seconds * report.sampleRate / static_cast<double>(subBlockLength)));
+            return juce::jmax(static_cast<juce::int64>(1), numSubBlocks) * subBlockLength;
+        };
+
+        const auto segmentLength = toSubBlocks(options.segmentSeconds);
+        const auto numSegments = (report.lengthInSamples + segmentLength - 1) / segmentLength;
+
+        if (numSegments < 2)
+            return nullptr;
+
+        auto file = std::make_unique<SegmentedFile>();
+        file->jobIndex = jobIndex;
+        file->segmentLength = segmentLength;
+        file->warmUpLength = toSubBlocks(segmentWarmUpSeconds);
+        file->results.resize(static_cast<size_t>(numSegments));
+        file->segmentsLeft = static_cast<int>(numSegments);
+        return file;
+    }
+
+    /** Processes one segment, from the start of its warm-up, with a processor
+        and meters of its own. Only the segment itself is counted.
+
+        The processor gets the same blocks as in a single pass: it starts on
+        the block grid before the warm-up and runs whole blocks up to the
+        first grid point after the segment. The meters start on the loudness
+        grid inside the warm-up; blocks are split for them where they start,
+        where the segment starts and where it ends. */
+    void analyseSegment(SegmentedFile& file, int segmentIndex, const FileReport& report, const RenderOptions& options)
+    {
+        auto& result = file.results[static_cast<size_t>(segmentIndex)];
+
+        PluginV3AudioProcessor processor;
+
+        if (! prepareProcessor(processor, report, options, result.error))
+            return;
+
+        // Processing runs on the input's block grid; the metered bounds are
+        // output samples, which come out latency samples later, and the end of
+        // the file is followed by silence to flush them, as in a single pass
+        const juce::int64 blockSize = options.blockSize;
+        const juce::int64 latency = processor.getLatencySamples();
+        const juce::int64 start = segmentIndex * file.segmentLength;
+        const juce::int64 end = juce::jmin(start + file.segmentLength, report.lengthInSamples);
+        const juce::int64 meterStart = juce::jmax(static_cast<juce::int64>(0), start - file.warmUpLength);
+        const juce::int64 processStart = meterStart / blockSize * blockSize;
+        const juce::int64 processEnd = juce::jmin((end + latency + blockSize - 1) / blockSize * blockSize,
+                                                  report.lengthInSamples + latency);
+
+        // Each segment maps just its own part of the file
+        auto& resources = WorkerResources::forThisThread();
+        auto& input = resources.input;
+
+        const bool opened = input.open(report.input, { processStart, juce::jmin(processEnd, report.lengthInSamples) });
+        const juce::ScopeGuard closeInput { [&input] { input.close(); } };
+        const auto* reader = input.getReader();
+
+        if (! opened || reader->sampleRate != report.sampleRate
+            || static_cast<int>(reader->numChannels) != report.numChannels
+            || reader->lengthInSamples != report.lengthInSamples)
+        {
+            result.error = "File changed while analysing";
+            return;
+        }
+
+        OutputMeters meters;
+        meters.prepare(report.sampleRate);
+
+        juce::MidiBuffer midi;
+
+        for (juce::int64 position = processStart; position < processEnd; position += blockSize)
+        {
+            const juce::int64 blockEnd = juce::jmin(position + blockSize, processEnd);
+            const int numSamples = static_cast<int>(blockEnd - position);
+
+            auto& buffer = resources.getBuffer(report.numChannels, numSamples);
+
+            if (! readBlock(input, buffer, numSamples, position, report.lengthInSamples))
+            {
+                result.error = "Read error at sample " + juce::String(position);
+                break;
+            }
+
+            processor.processBlock(buffer, midi);
+
+            auto meterRange = [&](juce::int64 from, juce::int64 to)
+            {
+                if (to <= from)
+                    return;
+
+                juce::AudioBuffer<float> part(buffer.getArrayOfWritePointers(), report.numChannels,
+                                              static_cast<int>(from - position), static_cast<int>(to - from));
+                meters.process(part, report.numChannels, part.getNumSamples());
+            };
+
+            meterRange(juce::jmax(position, meterStart + latency), juce::jmin(blockEnd, start + latency));
+
+            if (position <= start + latency && start + latency < blockEnd)
+                meters.restart();
+
+            meterRange(juce::jmax(position, start + latency), juce::jmin(blockEnd, end + latency));
+        }
+
+        processor.releaseResources();
+
+        result.histogram = meters.loudnessMeter.getHistogram();
+        result.samplePeak = meters.samplePeak;
+        result.truePeak = meters.truePeakDetector.getTruePeak();
+        result.sumLeftRight = meters.sumLeftRight;
+        result.sumLeftSquared = meters.sumLeftSquared;
+        result.sumRightSquared = meters.sumRightSquared;
+    }
+
+    /** Merges the segments into the file's report, in file order so the sums
+        come out the same however the segments were scheduled. */
+    void finishSegmentedFile(const SegmentedFile& file, FileReport& report)
+    {
+        LoudnessHistogram histogram;
+        double sumLeftRight = 0.0, sumLeftSquared = 0.0, sumRightSquared = 0.0;
+
+        for (const auto& result : file.results)
+        {
+            if (result.error.isNotEmpty())
+            {
+                report.error = result.error;
+                return;
+            }
+
+            histogram.merge(result.histogram);
+            report.samplePeak = juce::jmax(report.samplePeak, result.samplePeak);
+            report.truePeak = juce::jmax(report.truePeak, result.truePeak);
+            sumLeftRight += result.sumLeftRight;
+            sumLeftSquared += result.sumLeftSquared;
+            sumRightSquared += result.sumRightSquared;
+        }
+
+        report.integratedLoudness = histogram.getIntegratedLoudness();
+        setCorrelation(report, sumLeftRight, sumLeftSquared, sumRightSquared);
+    }
+
+    //==============================================================================
+    /** How far a segmented analysis is from a single pass over the same file. */
+    struct SegmentDifference
+    {
+        double loudness { 0.0 };      // LU
+        double truePeak { 0.0 };      // dB
+        double correlation { 0.0 };
+    };
+
+    /** Differences between two readings that are silence or undefined in both
+        count as none, and in only one as infinite. */
+    double getDifference(double a, double b, bool validA, bool validB)
+    {
+        if (! validA && ! validB)
+            return 0.0;
+
+        if (validA != validB)
+            return std::numeric_limits<double>::infinity();
+
+        return std::abs(a - b);
+    }
+
+    SegmentDifference compareWithSinglePass(const FileReport& segmented, const FileReport& singlePass)
+    {
+        SegmentDifference difference;
+
+        difference.loudness = getDifference(segmented.integratedLoudness, singlePass.integratedLoudness,
+                                            std::isfinite(segmented.integratedLoudness),
+                                            std::isfinite(singlePass.integratedLoudness));
+
+        difference.truePeak = getDifference(juce::Decibels::gainToDecibels(static_cast<double>(segmented.truePeak)),
+                                            juce::Decibels::gainToDecibels(static_cast<double>(singlePass.truePeak)),
+                                            segmented.truePeak > 0.0f, singlePass.truePeak > 0.0f);
+
+        difference.correlation = getDifference(segmented.correlation, singlePass.correlation,
+                                               segmented.correlationValid, singlePass.correlationValid);
+        return difference;
+    }
+
+    //==============================================================================
+    /** Decibel values that are -inf for silence are written as null. */
+    juce::var decibelsOrNull(float gain)
+    {
+        if (gain <= 0.0f)
+            return {};
+
+        return juce::Decibels::gainToDecibels(gain, -1000.0f);
+    }
+
+    juce::var loudnessOrNull(float loudness)
+    {
+        if (! std::isfinite(loudness))
+            return {};
+
+        return loudness;
+    }
+
+    juce::var toJson(const FileReport& report)
+    {
+        auto* object = new juce::DynamicObject();
+
+        object->setProperty("input", report.input.getFullPathName());
+        object->setProperty("output", report.output == juce::File() ? juce::var() : juce::var(report.output.getFullPathName()));
+        object->setProperty("sampleRate", report.sampleRate);
+        object->setProperty("channels", report.numChannels);
+        object->setProperty("lengthSeconds", report.sampleRate > 0.0 ? static_cast<double>(report.lengthInSamples) / report.sampleRate : 0.0);
+
+        if (report.error.isNotEmpty())
+        {
+            object->setProperty("error", report.error);
+            return juce::var(object);
+        }
+
+        object->setProperty("samplePeakDbfs", decibelsOrNull(report.samplePeak));
+        object->setProperty("truePeakDbtp", decibelsOrNull(report.truePeak));
+        object->setProperty("integratedLufs", loudnessOrNull(report.integratedLoudness));
+        object->setProperty("correlation", report.correlationValid ? juce::var(report.correlation) : juce::var());
+
+        return juce::var(object);
+    }
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    // Parameters and their listeners expect a message manager to exist
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::StringArray args;
+    for (int i = 1; i < argc; ++i)
+        args.add(juce::CharPointer_UTF8(argv[i]));
+
+    if (args.isEmpty() || args.contains("--help") || args.contains("-h"))
+    {
+        printUsage();
+        return args.isEmpty() ? 2 : 0;
+    }
+
+    RenderOptions options;
+    juce::String error;
+
+    if (! parseArguments(args, options, error))
+    {
+        std::cerr << "Error: " << error << "\n\n";
+        printUsage();
+        return 2;
+    }
+
+    // Check the state and overrides once up front rather than failing every file
+    bool useBatch = false;
+    BatchProcessor::Settings batchSettings;
+    bool useSegments = false;
+
+    {
+        PluginV3AudioProcessor probe;
+
+        if (! applySettings(probe, options, error))
+        {
+            std::cerr << "Error: " << error << "\n";
+            return 2;
+        }
+
+        if (options.batch)
+        {
+            juce::String reason;
+            useBatch = BatchProcessor::readSettings(probe.getAPVTS(), batchSettings, reason);
+
+            if (! useBatch)
+                std::cout << "Rendering file by file, " << reason << "\n";
+        }
+
+        if (options.analyseOnly && options.segmentSeconds > 0.0)
+        {
+            juce::String reason;
+            useSegments = canAnalyseInSegments(probe.getAPVTS(), reason);
+
+            if (! useSegments)
+                std::cout << "Analysing long files in one pass, " << reason << "\n";
+        }
+    }
+
+    //==============================================================================
+    const int numJobs = options.jobs.size();
+    juce::Array<FileReport> reports;
+    reports.resize(numJobs);
+
+    juce::CriticalSection consoleLock;
+    std::atomic<int> numFinished { 0 };
+
+    auto reportFinished = [&](const FileReport& report)
+    {
+        const juce::ScopedLock lock(consoleLock);
+        std::cout << "[" << ++numFinished << "/" << numJobs << "] "
+                  << toDisplayName(report.input) << ": ";
+
+        if (report.error.isNotEmpty())
+            std::cout << "error: " << report.error << "\n";
+        else
+            std::cout << juce::String(report.integratedLoudness, 1) << " LUFS, "
+                      << juce::String(juce::Decibels::gainToDecibels(report.truePeak), 1) << " dBTP\n";
+    };
+
+    // Long files are split into segments; in batch mode the other stereo
+    // files are grouped by sample rate for the batch workers. Everything
+    // else, and unreadable files, gets a processor each
+    juce::Array<int> singleJobs;
+    std::map<double, BatchGroup> batchGroups;
+    std::vector<std::unique_ptr<SegmentedFile>> segmentedFiles;
+
+    if (useBatch || useSegments)
+    {
+        juce::AudioFormatManager formatManager;
+        formatManager.registerBasicFormats();
+
+        for (int i = 0; i < numJobs; ++i)
+        {
+            std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(options.jobs.getReference(i).input));
+
+            if (reader != nullptr && useSegments && reader->numChannels >= 1 && reader->numChannels <= 2)
+            {
+                auto& report = reports.getReference(i);
+                report.input = options.jobs.getReference(i).input;
+                report.sampleRate = reader->sampleRate;
+                report.numChannels = static_cast<int>(reader->numChannels);
+                report.lengthInSamples = reader->lengthInSamples;
+
+                if (auto file = planSegments(i, report, options))
+                {
+                    segmentedFiles.push_back(std::move(file));
+                    continue;
+                }
+            }
+
+            if (reader != nullptr && useBatch && reader->numChannels == 2)
+            {
+                auto& group = batchGroups[reader->sampleRate];
+                group.sampleRate = reader->sampleRate;
+                group.jobIndices.add(i);
+            }
+            else
+                singleJobs.add(i);
+        }
+    }
+    else
+    {
+        for (int i = 0; i < numJobs; ++i)
+            singleJobs.add(i);
+    }
+
+    // Enough workers per group to fill their lanes, but no more than threads
+    auto getNumBatchWorkers = [&](const BatchGroup& group)
+    {
+        return juce::jmin(options.numThreads, (group.jobIndices.size() + BatchProcessor::numLanes - 1) / BatchProcessor::numLanes);
+    };
+
+    int numTasks = singleJobs.size();
+
+    for (const auto& entry : batchGroups)
+        numTasks += getNumBatchWorkers(entry.second);
+
+    for (const auto& file : segmentedFiles)
+        numTasks += static_cast<int>(file->results.size()) + (options.verifySegments ? 1 : 0);
+
+    juce::ThreadPool pool(juce::jmin(options.numThreads, juce::jmax(1, numTasks)));
+
+    for (const int i : singleJobs)
+    {
+        pool.addJob([&, i]
+        {
+            auto& report = reports.getReference(i);
+            report = renderFile(options.jobs.getReference(i), options);
+            reportFinished(report);
+
+            return juce::ThreadPoolJob::jobHasFinished;
+        });
+    }
+
+    // With --verify-segments every segmented file is also analysed in one pass
+    std::vector<FileReport> singlePassReports(options.verifySegments ? segmentedFiles.size() : 0);
+
+    for (size_t i = 0; i < singlePassReports.size(); ++i)
+    {
+        pool.addJob([&, i]
+        {
+            singlePassReports[i] = renderFile(options.jobs.getReference(segmentedFiles[i]->jobIndex), options);
+            return juce::ThreadPoolJob::jobHasFinished;
+        });
+    }
+
+    for (auto& entry : batchGroups)
+    {
+        for (int worker = 0; worker < getNumBatchWorkers(entry.second); ++worker)
+        {
+            pool.addJob([&, &group = entry.second]
+            {
+                renderBatch(group, options, batchSettings, reports, reportFinished);
+                return juce::ThreadPoolJob::jobHasFinished;
+            });
+        }
+    }
+
+    // Segments go last: they are the smallest jobs, so they fill in around
+    // the whole files and keep every thread busy until the end. The last
+    // segment of a file to finish merges it
+    for (auto& segmentedFile : segmentedFiles)
+    {
+        for (int segment = 0; segment < static_cast<int>(segmentedFile->results.size()); ++segment)
+        {
+            pool.addJob([&, &file = *segmentedFile, segment]
+            {
+                auto& report = reports.getReference(file.jobIndex);
+                analyseSegment(file, segment, report, options);
+
+                if (--file.segmentsLeft == 0)
+                {
+                    finishSegmentedFile(file, report);
+                    reportFinished(report);
+                }
+
+                return juce::ThreadPoolJob::jobHasFinished;
+            });
+        }
+    }
+
+    while (pool.getNumJobs() > 0)
+        juce::Thread::sleep(50);
+
+    //==============================================================================
+    juce::Array<juce::var> files;
+    int numFailed = 0;
+
+    for (const auto& report : reports)
+    {
+        files.add(toJson(report));
+
+        if (report.error.isNotEmpty())
+            ++numFailed;
+    }
+
+    auto* root = new juce::DynamicObject();
+    root->setProperty("plugin", JucePlugin_Name);
+    root->setProperty("files", files);
+
+    if (options.verifySegments)
+    {
+        SegmentDifference worst;
+        int numCompared = 0;
+
+        for (size_t i = 0; i < singlePassReports.size(); ++i)
+        {
+            const auto& segmented = reports.getReference(segmentedFiles[i]->jobIndex);
+            const auto& singlePass = singlePassReports[i];
+
+            if (segmented.error.isNotEmpty() || singlePass.error.isNotEmpty())
+                continue;
+
+            const auto difference = compareWithSinglePass(segmented, singlePass);
+            worst.loudness = juce::jmax(worst.loudness, difference.loudness);
+            worst.truePeak = juce::jmax(worst.truePeak, difference.truePeak);
+            worst.correlation = juce::jmax(worst.correlation, difference.correlation);
+            ++numCompared;
+
+            std::cout << "Segments vs single pass, " << toDisplayName(segmented.input) << ": "
+                      << juce::String(difference.loudness, 6) << " LU, "
+                      << juce::String(difference.truePeak, 6) << " dB TP, "
+                      << juce::String(difference.correlation, 9) << " correlation\n";
+        }
+
+        std::cout << "Largest differences over " << numCompared << " segmented files: "
+                  << juce::String(worst.loudness, 6) << " LU, "
+                  << juce::String(worst.truePeak, 6) << " dB TP, "
+                  << juce::String(worst.correlation, 9) << " correlation\n";
+
+        // A reading that is silent or undefined in only one of the two has no finite difference
+        auto finiteOrNull = [](double difference)
+        {
+            return std::isfinite(difference) ? juce::var(difference) : juce::var();
+        };
+
+        auto* check = new juce::DynamicObject();
+        check->setProperty("filesCompared", numCompared);
+        check->setProperty("maxLoudnessDifferenceLu", finiteOrNull(worst.loudness));
+        check->setProperty("maxTruePeakDifferenceDb", finiteOrNull(worst.truePeak));
+        check->setProperty("maxCorrelationDifference", finiteOrNull(worst.correlation));
+        root->setProperty("segmentCheck", juce::var(check));
+    }
+
+    options.reportFile.getParentDirectory().createDirectory();
+
+    if (! options.reportFile.replaceWithText(juce::JSON::toString(juce::var(root))))
+    {
+        std::cerr << "Error: cannot write " << options.reportFile.getFullPathName() << "\n";
+        return 1;
+    }
+
+    std::cout << "Rendered " << (numJobs - numFailed) << " of " << numJobs << " files, report written to "
+              << options.reportFile.getFullPathName() << "\n";
+
+    return numFailed == 0 ? 0 : 1;
+}
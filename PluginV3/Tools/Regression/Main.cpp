@@ -0,0 +1,787 @@
+/*
+  ==============================================================================
+
+    PluginV3Regression - proves processBlock output against golden renders.
+
+    A fixed-seed test signal is rendered through PluginV3AudioProcessor for
+    a matrix of parameter states, block sizes and sample rates. Each render
+    is compared against a stored golden render of the same state and sample
+    rate, so every block size must also agree with every other one. At the
+    default settings the processor has to null bit for bit against its
+    input, in both mono and stereo. For the states the offline renderer's
+    batch mode can run, every lane of a BatchProcessor has to match its own
+    processor render and meters bit for bit.
+
+    Record goldens with a trusted build, then run the check against a
+    rewrite before shipping it. Run it once per --isa to prove each kernel
+    variant against the same goldens.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include <iostream>
+#include "../../Source/PluginProcessor.h"
+#include "../../Source/DspKernels.h"
+#include "../../Source/BatchProcessor.h"
+
+namespace
+{
+    //==============================================================================
+    struct ParameterValue
+    {
+        const char* parameterID;
+        float value;
+    };
+
+    struct ParameterState
+    {
+        juce::String name;
+        juce::Array<ParameterValue> values;
+
+        // Set for stages that update once per block by design, whose output
+        // depends on the block size; these are only compared at the size the
+        // golden was rendered with
+        bool blockGranular { false };
+    };
+
+    /** Parameter states covering every processing path. Names are used for
+        the golden file names, so don't rename them without re-recording.
+        Every state is rendered at each block pattern and compared against
+        the same golden, so the stateful stages (the safety stage's
+        oversampling and limiter envelope among them) are also checked for
+        independence from the block size. Auto gain and width mono safety
+        compute their gains per block, so those states are block granular and
+        only checked at the reference block size. */
+    juce::Array<ParameterState> createParameterStates()
+    {
+        return {
+            { "gain",             { { "master_gain", 0.5f }, { "left_gain", 1.3f }, { "right_gain", 0.7f } } },
+            { "invert_left",      { { "invert_left", 1.0f }, { "right_gain", 0.8f } } },
+            { "invert_both",      { { "invert_left", 1.0f }, { "invert_right", 1.0f } } },
+            { "mid_side",         { { "use_mid_side", 1.0f }, { "mid_gain", 1.2f }, { "side_gain", 0.6f } } },
+            { "mid_side_unity",   { { "use_mid_side", 1.0f } } },
+            { "delay",            { { "left_delay", 2.5f }, { "right_delay", 1.0f } } },
+            { "delay_fractional", { { "left_delay", 0.372f } } },
+            { "delay_clamped",    { { "right_delay", 50.0f } } },
+            { "delay_long",       { { "delay_range", 3.0f }, { "right_delay", 750.0f } } },
+            { "phase",            { { "phase_offset", 90.0f } } },
+            { "auto_gain",        { { "auto_gain", 1.0f }, { "master_gain", 0.5f }, { "use_mid_side", 1.0f },
+                                    { "side_gain", 1.4f } }, true },
+            { "low_cut_dc",       { { "hpf_mode", 1.0f } } },
+            { "low_cut_24",       { { "hpf_mode", 5.0f }, { "hpf_frequency", 80.0f } } },
+            { "width_haas",       { { "width_mode", 1.0f }, { "width_amount", 60.0f }, { "width_time", 12.0f },
+                                    { "width_mono_safe", 1.0f } }, true },
+            { "width_diffuse",    { { "width_mode", 2.0f }, { "width_amount", 80.0f }, { "width_mono_safe", 1.0f } }, true },
+            { "soft_clip_2x",     { { "safety_mode", 1.0f }, { "safety_oversampling", 0.0f },
+                                    { "safety_ceiling", -3.0f }, { "master_gain", 2.5f } } },
+            { "soft_clip_8x",     { { "safety_mode", 1.0f }, { "safety_oversampling", 2.0f },
+                                    { "safety_ceiling", -3.0f }, { "master_gain", 2.5f } } },
+            { "limiter_2x",       { { "safety_mode", 2.0f }, { "safety_oversampling", 0.0f },
+                                    { "safety_ceiling", -3.0f }, { "master_gain", 2.5f } } },
+            { "limiter_8x",       { { "safety_mode", 2.0f }, { "safety_oversampling", 2.0f },
+                                    { "safety_ceiling", -3.0f }, { "master_gain", 2.5f } } },
+            { "combined",         { { "master_gain", 0.8f }, { "left_gain", 1.1f }, { "invert_right", 1.0f },
+                                    { "use_mid_side", 1.0f }, { "side_gain", 1.4f }, { "delay_range", 1.0f },
+                                    { "left_delay", 12.5f }, { "phase_offset", 200.0f } } }
+        };
+    }
+
+    //==============================================================================
+    /** Block sizes for one render. The sizes are used in turn, so an
+        irregular pattern mimics hosts that vary the buffer size. */
+    struct BlockPattern
+    {
+        juce::String name;
+        juce::Array<int> sizes;
+
+        int getMaximumBlockSize() const
+        {
+            int maximum = 1;
+            for (const auto size : sizes)
+                maximum = juce::jmax(maximum, size);
+
+            return maximum;
+        }
+    };
+
+    BlockPattern createFixedPattern(int blockSize)
+    {
+        return { juce::String(blockSize), { blockSize } };
+    }
+
+    BlockPattern createVariablePattern()
+    {
+        return { "variable", { 1, 7, 64, 333, 512, 4096, 31, 128 } };
+    }
+
+    //==============================================================================
+    struct RegressionSettings
+    {
+        juce::Array<double> sampleRates { 44100.0, 48000.0, 96000.0 };
+        juce::Array<BlockPattern> blockPatterns { createFixedPattern(1), createFixedPattern(32), createFixedPattern(100),
+                                                  createFixedPattern(512), createFixedPattern(4096), createVariablePattern() };
+        juce::File goldenDirectory;
+        bool record { false };
+
+        // Largest sample difference still accepted, in dBFS; -inf only accepts identical output
+        float toleranceDb { -120.0f };
+        juce::String filter;
+    };
+
+    constexpr juce::int64 randomSeed = 0x5eed;
+    constexpr double signalLengthSeconds = 1.5;
+
+    // Goldens are rendered with this block size
+    constexpr int referenceBlockSize = 512;
+
+    //==============================================================================
+    /** Noise at -12dBFS with a silent gap and full-scale impulses, different
+        on each channel. Only integer-seeded random numbers are used, so the
+        signal is identical on every platform and compiler. */
+    juce::AudioBuffer<float> createTestSignal(int numChannels, double sampleRate)
+    {
+        const int numSamples = juce::roundToInt(signalLengthSeconds * sampleRate);
+        juce::AudioBuffer<float> signal(numChannels, numSamples);
+        juce::Random random(randomSeed);
+
+        const int gapStart = juce::roundToInt(0.5 * sampleRate);
+        const int gapEnd = juce::roundToInt(0.6 * sampleRate);
+        const int impulseSpacing = juce::roundToInt(0.25 * sampleRate);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            auto* data = signal.getWritePointer(channel);
+
+            for (int sample = 0; sample < numSamples; ++sample)
+            {
+                const float noise = (random.nextFloat() * 2.0f - 1.0f) * 0.25f;
+                data[sample] = sample >= gapStart && sample < gapEnd ? 0.0f : noise;
+            }
+
+            for (int sample = impulseSpacing / 2 + channel * 17; sample < numSamples; sample += impulseSpacing)
+                data[sample] = (sample / impulseSpacing) % 2 == 0 ? 0.9f : -0.9f;
+        }
+
+        return signal;
+    }
+
+    void setParameter(PluginV3AudioProcessor& processor, const juce::String& parameterID, float value)
+    {
+        auto* parameter = processor.getAPVTS().getParameter(parameterID);
+        jassert(parameter != nullptr);
+        parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+    }
+
+    /** Runs the input through a fresh processor in the given state. */
+    bool render(const ParameterState& state, const juce::AudioBuffer<float>& input, double sampleRate,
+                const BlockPattern& pattern, juce::AudioBuffer<float>& output, juce::String& error)
+    {
+        PluginV3AudioProcessor processor;
+
+        const auto channelSet = juce::AudioChannelSet::canonicalChannelSet(input.getNumChannels());
+        juce::AudioProcessor::BusesLayout layout;
+        layout.inputBuses.add(channelSet);
+        layout.inputBuses.add(juce::AudioChannelSet::disabled());
+        layout.outputBuses.add(channelSet);
+
+        if (! processor.setBusesLayout(layout))
+        {
+            error = "Processor rejected the channel layout";
+            return false;
+        }
+
+        for (const auto& parameterValue : state.values)
+            setParameter(processor, parameterValue.parameterID, parameterValue.value);
+
+        const int maximumBlockSize = pattern.getMaximumBlockSize();
+        processor.setNonRealtime(true);
+        processor.setRateAndBufferSizeDetails(sampleRate, maximumBlockSize);
+        processor.prepareToPlay(sampleRate, maximumBlockSize);
+
+        output.makeCopyOf(input);
+        juce::MidiBuffer midi;
+
+        const int numSamples = output.getNumSamples();
+        int patternIndex = 0;
+
+        for (int position = 0; position < numSamples;)
+        {
+            const int blockSize = juce::jmin(pattern.sizes[patternIndex], numSamples - position);
+            patternIndex = (patternIndex + 1) % pattern.sizes.size();
+
+            // Process the output in place, one block at a time
+            juce::AudioBuffer<float> block(output.getArrayOfWritePointers(), output.getNumChannels(), position, blockSize);
+            processor.processBlock(block, midi);
+
+            position += blockSize;
+        }
+
+        processor.releaseResources();
+        return true;
+    }
+
+    //==============================================================================
+    /** True if both buffers hold exactly the same bits. */
+    bool isBitIdentical(const juce::AudioBuffer<float>& a, const juce::AudioBuffer<float>& b)
+    {
+        if (a.getNumChannels() != b.getNumChannels() || a.getNumSamples() != b.getNumSamples())
+            return false;
+
+        for (int channel = 0; channel < a.getNumChannels(); ++channel)
+            if (std::memcmp(a.getReadPointer(channel), b.getReadPointer(channel),
+                            sizeof(float) * static_cast<size_t>(a.getNumSamples())) != 0)
+                return false;
+
+        return true;
+    }
+
+    /** Largest absolute sample difference, or a negative value if the
+        buffers don't have the same shape. NaNs count as infinitely different. */
+    float getMaximumDifference(const juce::AudioBuffer<float>& a, const juce::AudioBuffer<float>& b)
+    {
+        if (a.getNumChannels() != b.getNumChannels() || a.getNumSamples() != b.getNumSamples())
+            return -1.0f;
+
+        float maximum = 0.0f;
+
+        for (int channel = 0; channel < a.getNumChannels(); ++channel)
+        {
+            const auto* dataA = a.getReadPointer(channel);
+            const auto* dataB = b.getReadPointer(channel);
+
+            for (int sample = 0; sample < a.getNumSamples(); ++sample)
+            {
+                const float difference = std::abs(dataA[sample] - dataB[sample]);
+                maximum = std::isnan(difference) ? std::numeric_limits<float>::infinity()
+                                                 : juce::jmax(maximum, difference);
+            }
+        }
+
+        return maximum;
+    }
+
+    juce::String formatDifference(float difference)
+    {
+        if (difference < 0.0f)
+            return "length/channel mismatch";
+
+        if (difference == 0.0f)
+            return "identical";
+
+        return juce::String(juce::Decibels::gainToDecibels(difference, -1000.0f), 1) + " dBFS";
+    }
+
+    //==============================================================================
+    juce::File getGoldenFile(const RegressionSettings& settings, const ParameterState& state, double sampleRate)
+    {
+        return settings.goldenDirectory.getChildFile(state.name + "_" + juce::String(juce::roundToInt(sampleRate)) + ".wav");
+    }
+
+    /** Goldens are 32-bit float WAV, so they hold the render exactly. */
+    bool writeGolden(const juce::File& file, const juce::AudioBuffer<float>& buffer, double sampleRate)
+    {
+        file.getParentDirectory().createDirectory();
+        file.deleteFile();
+
+        std::unique_ptr<juce::OutputStream> stream(file.createOutputStream());
+
+        if (stream == nullptr)
+            return false;
+
+        juce::WavAudioFormat format;
+        std::unique_ptr<juce::AudioFormatWriter> writer(format.createWriterFor(stream.get(), sampleRate,
+                                                                               static_cast<unsigned int>(buffer.getNumChannels()),
+                                                                               32, {}, 0));
+
+        if (writer == nullptr)
+            return false;
+
+        // The writer owns the stream once it has been created
+        stream.release();
+        return writer->writeFromAudioSampleBuffer(buffer, 0, buffer.getNumSamples());
+    }
+
+    bool readGolden(const juce::File& file, juce::AudioBuffer<float>& buffer, double expectedSampleRate)
+    {
+        juce::WavAudioFormat format;
+        std::unique_ptr<juce::AudioFormatReader> reader(format.createReaderFor(file.createInputStream().release(), true));
+
+        if (reader == nullptr || reader->sampleRate != expectedSampleRate || reader->lengthInSamples > (1 << 24))
+            return false;
+
+        buffer.setSize(static_cast<int>(reader->numChannels), static_cast<int>(reader->lengthInSamples));
+        return reader->read(&buffer, 0, buffer.getNumSamples(), 0, true, true);
+    }
+
+    //==============================================================================
+    class ResultPrinter
+    {
+    public:
+        void add(bool passed, const juce::String& test, double sampleRate, const juce::String& blockPattern,
+                 const juce::String& detail)
+        {
+            ++numRun;
+
+            if (! passed)
+                ++numFailed;
+
+            std::cout << (passed ? "PASS  " : "FAIL  ") << test.paddedRight(' ', 20)
+                      << juce::String(juce::roundToInt(sampleRate)).paddedLeft(' ', 6) << " Hz  block "
+                      << blockPattern.paddedRight(' ', 10) << detail << "\n";
+        }
+
+        int getNumRun() const noexcept    { return numRun; }
+        int getNumFailed() const noexcept { return numFailed; }
+
+    private:
+        int numRun { 0 };
+        int numFailed { 0 };
+    };
+
+    //==============================================================================
+    /** At the default settings the output must be the input, bit for bit. */
+    void runNullTests(double sampleRate, const RegressionSettings& settings, ResultPrinter& results)
+    {
+        const ParameterState defaults { "null", {} };
+
+        for (const int numChannels : { 1, 2 })
+        {
+            const auto name = juce::String("null_") + (numChannels == 1 ? "mono" : "stereo");
+
+            if (! name.contains(settings.filter))
+                continue;
+
+            const auto input = createTestSignal(numChannels, sampleRate);
+
+            for (const auto& pattern : settings.blockPatterns)
+            {
+                juce::AudioBuffer<float> output;
+                juce::String error;
+
+                if (! render(defaults, input, sampleRate, pattern, output, error))
+                    results.add(false, name, sampleRate, pattern.name, error);
+                else if (isBitIdentical(input, output))
+                    results.add(true, name, sampleRate, pattern.name, "bit-exact");
+                else
+                    results.add(false, name, sampleRate, pattern.name,
+                                "not bit-exact, max difference " + formatDifference(getMaximumDifference(input, output)));
+            }
+        }
+    }
+
+    /** A different stretch of the test signal for each batch lane, each of a
+        different length, so the lanes run out in different blocks. */
+    juce::AudioBuffer<float> createLaneSignal(const juce::AudioBuffer<float>& signal, int lane)
+    {
+        const int offset = lane * 1013;
+        const int numSamples = signal.getNumSamples() - offset - lane * 577;
+        juce::AudioBuffer<float> laneSignal(signal.getNumChannels(), numSamples);
+
+        for (int channel = 0; channel < signal.getNumChannels(); ++channel)
+            laneSignal.copyFrom(channel, 0, signal, channel, offset, numSamples);
+
+        return laneSignal;
+    }
+
+    /** Runs one file per lane through a BatchProcessor the way the offline
+        renderer's batch mode does, returning the outputs and meter readings. */
+    void renderBatch(const BatchProcessor::Settings& batchSettings, const juce::Array<juce::AudioBuffer<float>>& inputs,
+                     double sampleRate, int blockSize, juce::Array<juce::AudioBuffer<float>>& outputs,
+                     juce::Array<BatchProcessor::LaneResult>& laneResults)
+    {
+        jassert(inputs.size() <= BatchProcessor::numLanes);
+
+        BatchProcessor batch;
+        batch.prepare(batchSettings, sampleRate, blockSize);
+
+        int longest = 0;
+        outputs.clear();
+
+        for (const auto& input : inputs)
+        {
+            outputs.add(juce::AudioBuffer<float>(2, input.getNumSamples()));
+            longest = juce::jmax(longest, input.getNumSamples());
+        }
+
+        for (int position = 0; position < longest; position += blockSize)
+        {
+            // Lanes whose file has ended get no input, as in the renderer
+            for (int lane = 0; lane < inputs.size(); ++lane)
+            {
+                const auto& input = inputs.getReference(lane);
+                const int numSamples = juce::jmin(blockSize, input.getNumSamples() - position);
+
+                if (numSamples > 0)
+                    batch.setLaneInput(lane, input.getReadPointer(0, position), input.getReadPointer(1, position), numSamples);
+            }
+
+            batch.process();
+
+            for (int lane = 0; lane < inputs.size(); ++lane)
+            {
+                auto& output = outputs.getReference(lane);
+                const int numSamples = juce::jmin(blockSize, output.getNumSamples() - position);
+
+                if (numSamples > 0)
+                    batch.getLaneOutput(lane, output.getWritePointer(0, position), output.getWritePointer(1, position), numSamples);
+            }
+        }
+
+        laneResults.clear();
+
+        for (int lane = 0; lane < inputs.size(); ++lane)
+            laneResults.add(batch.getLaneResult(lane));
+    }
+
+    /** Meters a render block by block as the offline renderer's per-file path
+        does, for comparison with a batch lane. */
+    BatchProcessor::LaneResult measureRender(const juce::AudioBuffer<float>& buffer, double sampleRate, int blockSize)
+    {
+        LoudnessMeter loudnessMeter;
+        TruePeakDetector truePeakDetector;
+        loudnessMeter.prepare(sampleRate);
+        truePeakDetector.prepare(sampleRate);
+
+        BatchProcessor::LaneResult result;
+        const auto* const* channels = buffer.getArrayOfReadPointers();
+
+        for (int position = 0; position < buffer.getNumSamples(); position += blockSize)
+        {
+            const int numSamples = juce::jmin(blockSize, buffer.getNumSamples() - position);
+            const float* block[] = { channels[0] + position, channels[1] + position };
+
+            loudnessMeter.process(block, 2, numSamples);
+            truePeakDetector.process(block, 2, numSamples);
+
+            result.samplePeak = juce::jmax(result.samplePeak, buffer.getMagnitude(0, position, numSamples),
+                                           buffer.getMagnitude(1, position, numSamples));
+
+            for (int i = 0; i < numSamples; ++i)
+            {
+                const double left = block[0][i];
+                const double right = block[1][i];
+                result.sumLeftRight += left * right;
+                result.sumLeftSquared += left * left;
+                result.sumRightSquared += right * right;
+            }
+        }
+
+        result.truePeak = truePeakDetector.getTruePeak();
+        result.integratedLoudness = loudnessMeter.getIntegratedLoudness();
+        return result;
+    }
+
+    bool isBitIdentical(const BatchProcessor::LaneResult& a, const BatchProcessor::LaneResult& b)
+    {
+        return std::memcmp(&a.samplePeak, &b.samplePeak, sizeof(float)) == 0
+            && std::memcmp(&a.truePeak, &b.truePeak, sizeof(float)) == 0
+            && std::memcmp(&a.integratedLoudness, &b.integratedLoudness, sizeof(float)) == 0
+            && std::memcmp(&a.sumLeftRight, &b.sumLeftRight, sizeof(double)) == 0
+            && std::memcmp(&a.sumLeftSquared, &b.sumLeftSquared, sizeof(double)) == 0
+            && std::memcmp(&a.sumRightSquared, &b.sumRightSquared, sizeof(double)) == 0;
+    }
+
+    /** Every lane of the offline renderer's batch mode has to give exactly the
+        output and readings of a processor rendering that file on its own at
+        the same block size. Only states the batch can run are checked, and
+        only fixed block sizes, since the batch gives every lane the same. */
+    void runBatchTests(double sampleRate, const RegressionSettings& settings, ResultPrinter& results)
+    {
+        const auto signal = createTestSignal(2, sampleRate);
+        juce::Array<juce::AudioBuffer<float>> inputs;
+
+        for (int lane = 0; lane < BatchProcessor::numLanes; ++lane)
+            inputs.add(createLaneSignal(signal, lane));
+
+        for (const auto& state : createParameterStates())
+        {
+            const auto name = "batch_" + state.name;
+
+            if (! name.contains(settings.filter))
+                continue;
+
+            PluginV3AudioProcessor probe;
+
+            for (const auto& parameterValue : state.values)
+                setParameter(probe, parameterValue.parameterID, parameterValue.value);
+
+            BatchProcessor::Settings batchSettings;
+            juce::String reason;
+
+            if (! BatchProcessor::readSettings(probe.getAPVTS(), batchSettings, reason))
+                continue;
+
+            for (const auto& pattern : settings.blockPatterns)
+            {
+                if (pattern.sizes.size() != 1)
+                    continue;
+
+                const int blockSize = pattern.sizes.getFirst();
+                juce::Array<juce::AudioBuffer<float>> batchOutputs;
+                juce::Array<BatchProcessor::LaneResult> laneResults;
+                renderBatch(batchSettings, inputs, sampleRate, blockSize, batchOutputs, laneResults);
+
+                juce::String failure;
+
+                for (int lane = 0; lane < inputs.size() && failure.isEmpty(); ++lane)
+                {
+                    juce::AudioBuffer<float> expected;
+                    juce::String error;
+
+                    if (! render(state, inputs.getReference(lane), sampleRate, pattern, expected, error))
+                        failure = "lane " + juce::String(lane) + ": " + error;
+                    else if (! isBitIdentical(expected, batchOutputs.getReference(lane)))
+                        failure = "lane " + juce::String(lane) + " not bit-exact, max difference "
+                                + formatDifference(getMaximumDifference(expected, batchOutputs.getReference(lane)));
+                    else if (! isBitIdentical(measureRender(expected, sampleRate, blockSize), laneResults.getReference(lane)))
+                        failure = "lane " + juce::String(lane) + " meter readings differ";
+                }
+
+                results.add(failure.isEmpty(), name, sampleRate, pattern.name,
+                            failure.isEmpty() ? juce::String(inputs.size()) + " lanes bit-exact" : failure);
+            }
+        }
+    }
+
+    /** Compares every block pattern against the golden render of each state,
+        or records the goldens first when asked to. */
+    void runGoldenTests(double sampleRate, const RegressionSettings& settings, ResultPrinter& results)
+    {
+        const auto input = createTestSignal(2, sampleRate);
+        const float tolerance = juce::Decibels::decibelsToGain(settings.toleranceDb, -1000.0f);
+
+        for (const auto& state : createParameterStates())
+        {
+            if (! state.name.contains(settings.filter))
+                continue;
+
+            const auto goldenFile = getGoldenFile(settings, state, sampleRate);
+            juce::AudioBuffer<float> golden;
+            juce::String error;
+
+            if (settings.record)
+            {
+                if (! render(state, input, sampleRate, createFixedPattern(referenceBlockSize), golden, error))
+                {
+                    results.add(false, state.name, sampleRate, "record", error);
+                    continue;
+                }
+
+                if (! writeGolden(goldenFile, golden, sampleRate))
+                {
+                    results.add(false, state.name, sampleRate, "record", "cannot write " + goldenFile.getFullPathName());
+                    continue;
+                }
+            }
+            else if (! goldenFile.existsAsFile() || ! readGolden(goldenFile, golden, sampleRate))
+            {
+                results.add(false, state.name, sampleRate, "-", "missing or unreadable golden " + goldenFile.getFullPathName());
+                continue;
+            }
+
+            for (const auto& pattern : settings.blockPatterns)
+            {
+                if (state.blockGranular && pattern.sizes != juce::Array<int> { referenceBlockSize })
+                    continue;
+
+                juce::AudioBuffer<float> output;
+
+                if (! render(state, input, sampleRate, pattern, output, error))
+                {
+                    results.add(false, state.name, sampleRate, pattern.name, error);
+                    continue;
+                }
+
+                const float difference = getMaximumDifference(golden, output);
+                const bool passed = difference >= 0.0f && (difference == 0.0f || difference <= tolerance);
+                results.add(passed, state.name, sampleRate, pattern.name, "max difference " + formatDifference(difference));
+            }
+        }
+    }
+
+    //==============================================================================
+    void printUsage()
+    {
+        std::cout << "Usage: PluginV3Regression [options]\n"
+                     "\n"
+                     "Renders a test signal through PluginV3 for a matrix of parameter states, block sizes\n"
+                     "and sample rates, compares the output against golden renders and checks that the\n"
+                     "default settings null bit-exactly against the input. Lanes of the offline\n"
+                     "renderer's batch mode must match per-file renders bit-exactly.\n"
+                     "\n"
+                     "Options:\n"
+                     "  --golden <dir>         Directory of golden renders (required unless --null-only\n"
+                     "                         or --batch-only)\n"
+                     "  --record               Render and store the goldens with this build, then check\n"
+                     "  --tolerance <dB>       Largest accepted sample difference in dBFS (default -120)\n"
+                     "  --exact                Only accept bit-identical output\n"
+                     "  --null-only            Only run the bit-exact null tests\n"
+                     "  --batch-only           Only run the batch lane against per-file render tests\n"
+                     "  --block-sizes <list>   Comma separated block sizes, \"variable\" for an irregular\n"
+                     "                         pattern (default 1,32,100,512,4096,variable)\n"
+                     "  --sample-rates <list>  Comma separated sample rates (default 44100,48000,96000)\n"
+                     "  --filter <text>        Only run tests whose name contains the text\n"
+                     "  --isa <name>           Kernel instruction set: generic, sse2, avx2 or avx512\n"
+                     "                         (default: the best this machine supports)\n"
+                     "  --help                 Show this message\n";
+    }
+
+    bool parseArguments(const juce::StringArray& args, RegressionSettings& settings, bool& nullOnly, bool& batchOnly,
+                        juce::String& error)
+    {
+        for (int i = 0; i < args.size(); ++i)
+        {
+            const auto& arg = args[i];
+
+            // Every option except the flags takes a value
+            auto nextValue = [&]() -> juce::String
+            {
+                if (i + 1 >= args.size())
+                {
+                    error = "Missing value for " + arg;
+                    return {};
+                }
+
+                return args[++i];
+            };
+
+            if (arg == "--golden")
+                settings.goldenDirectory = juce::File::getCurrentWorkingDirectory().getChildFile(nextValue());
+            else if (arg == "--record")
+                settings.record = true;
+            else if (arg == "--tolerance")
+                settings.toleranceDb = nextValue().getFloatValue();
+            else if (arg == "--exact")
+                settings.toleranceDb = -std::numeric_limits<float>::infinity();
+            else if (arg == "--null-only")
+                nullOnly = true;
+            else if (arg == "--batch-only")
+                batchOnly = true;
+            else if (arg == "--filter")
+                settings.filter = nextValue();
+            else if (arg == "--isa")
+            {
+                const auto name = nextValue();
+                auto instructionSet = DspKernels::InstructionSet::generic;
+
+                if (! DspKernels::parseInstructionSet(name, instructionSet))
+                    error = error.isEmpty() ? "Unknown instruction set " + name : error;
+                else if (instructionSet > DspKernels::getBestInstructionSet())
+                    error = name + " is not supported on this machine";
+                else
+                    DspKernels::forceInstructionSet(instructionSet);
+            }
+            else if (arg == "--block-sizes")
+            {
+                settings.blockPatterns.clear();
+
+                for (const auto& item : juce::StringArray::fromTokens(nextValue(), ",", {}))
+                {
+                    if (item.trim() == "variable")
+                        settings.blockPatterns.add(createVariablePattern());
+                    else
+                        settings.blockPatterns.add(createFixedPattern(juce::jlimit(1, 1 << 16, item.getIntValue())));
+                }
+            }
+            else if (arg == "--sample-rates")
+            {
+                settings.sampleRates.clear();
+
+                for (const auto& item : juce::StringArray::fromTokens(nextValue(), ",", {}))
+                    settings.sampleRates.add(item.getDoubleValue());
+            }
+            else
+            {
+                error = "Unknown option " + arg;
+                return false;
+            }
+
+            if (error.isNotEmpty())
+                return false;
+        }
+
+        if (settings.blockPatterns.isEmpty() || settings.sampleRates.isEmpty())
+        {
+            error = "No block sizes or sample rates to run";
+            return false;
+        }
+
+        for (const auto rate : settings.sampleRates)
+        {
+            if (rate < 8000.0 || rate > 384000.0)
+            {
+                error = "Sample rate out of range: " + juce::String(rate);
+                return false;
+            }
+        }
+
+        if (nullOnly && batchOnly)
+        {
+            error = "--null-only and --batch-only can't be combined";
+            return false;
+        }
+
+        if (! nullOnly && ! batchOnly && settings.goldenDirectory == juce::File())
+        {
+            error = "--golden is required unless --null-only or --batch-only is given";
+            return false;
+        }
+
+        return true;
+    }
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    // Parameters and their listeners expect a message manager to exist
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::StringArray args;
+    for (int i = 1; i < argc; ++i)
+        args.add(juce::CharPointer_UTF8(argv[i]));
+
+    if (args.contains("--help") || args.contains("-h"))
+    {
+        printUsage();
+        return 0;
+    }
+
+    RegressionSettings settings;
+    bool nullOnly = false, batchOnly = false;
+    juce::String error;
+
+    if (! parseArguments(args, settings, nullOnly, batchOnly, error))
+    {
+        std::cerr << "Error: " << error << "\n\n";
+        printUsage();
+        return 2;
+    }
+
+    // prepareToPlay selects the kernels again, and keeps any forced set
+    std::cout << "Kernels: " << DspKernels::getInstructionSetName(DspKernels::selectInstructionSet()) << "\n\n";
+
+    ResultPrinter results;
+
+    for (const auto sampleRate : settings.sampleRates)
+    {
+        if (! batchOnly)
+            runNullTests(sampleRate, settings, results);
+
+        if (! nullOnly)
+            runBatchTests(sampleRate, settings, results);
+
+        if (! nullOnly && ! batchOnly)
+            runGoldenTests(sampleRate, settings, results);
+    }
+
+    std::cout << "\n" << (results.getNumRun() - results.getNumFailed()) << " of " << results.getNumRun() << " passed";
+
+    if (settings.record)
+        std::cout << ", goldens written to " << settings.goldenDirectory.getFullPathName();
+
+    std::cout << "\n";
+
+    return results.getNumFailed() == 0 && results.getNumRun() > 0 ? 0 : 1;
+}